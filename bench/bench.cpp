@@ -0,0 +1,203 @@
+#include "bench.h"
+#include <algorithm.h>
+#include <clock.h>
+#include <cstring.h>
+#include <string_view.h>
+#include <vector.h>
+#include <unistd.h>
+
+// Usage: std_bench [--csv] [--reps=N] [--warmup=N] [--filter=TEXT]
+namespace
+{
+struct options
+{
+    bool csv = false;
+    unsigned long reps = 25;
+    unsigned long warmup = 3;
+    const char *filter = nullptr;
+} config;
+
+void print(const char *str)
+{
+    write(STDOUT_FILENO, str, strlen(str));
+}
+
+// A line of output, built without allocating
+struct line
+{
+    char text[256];
+    unsigned long length = 0;
+
+    line &operator<<(const char *str)
+    {
+        for (; *str != '\0' && length < sizeof(text) - 1; ++str)
+        {
+            text[length++] = *str;
+        }
+        return *this;
+    }
+
+    line &operator<<(unsigned long long value)
+    {
+        char digits[24];
+        unsigned long count = 0;
+        do
+        {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        while (count > 0 && length < sizeof(text) - 1)
+        {
+            text[length++] = digits[--count];
+        }
+        return *this;
+    }
+
+    // value / ops with two decimals
+    line &per_op(unsigned long long value, unsigned long ops)
+    {
+        unsigned long long hundredths = value * 100 / ops;
+        *this << hundredths / 100 << ".";
+        if (hundredths % 100 < 10)
+        {
+            *this << "0";
+        }
+        return *this << hundredths % 100;
+    }
+
+    line &pad_to(unsigned long column)
+    {
+        // At least one space, so a field that ran past column stays apart from the next
+        unsigned long end = length < column ? column : length + 1;
+        while (length < end && length < sizeof(text) - 1)
+        {
+            text[length++] = ' ';
+        }
+        return *this;
+    }
+
+    void flush()
+    {
+        text[length] = '\0';
+        print(text);
+        length = 0;
+    }
+};
+
+bool has_prefix(const char *arg, const char *prefix)
+{
+    return std::u8string_view(arg).starts_with(std::u8string_view(prefix));
+}
+
+bool parse_number(const char *arg, const char *prefix, unsigned long &out)
+{
+    if (!has_prefix(arg, prefix))
+    {
+        return false;
+    }
+    std::size_t length = strlen(prefix);
+    unsigned long value = 0;
+    for (const char *digit = arg + length; *digit >= '0' && *digit <= '9'; ++digit)
+    {
+        value = value * 10 + static_cast<unsigned long>(*digit - '0');
+    }
+    out = value > 0 ? value : out;
+    return true;
+}
+
+// The sample at quantile numerator / denominator of sorted samples
+unsigned long long quantile(const std::vector<unsigned long long> &sorted, unsigned long numerator,
+                            unsigned long denominator)
+{
+    unsigned long index = (sorted.size() * numerator + denominator - 1) / denominator;
+    return sorted[index == 0 ? 0 : index - 1];
+}
+} // namespace
+
+void bench::run(const char *name, const char *implementation, unsigned long ops, void (*fn)())
+{
+    if (config.filter != nullptr && std::u8string_view(name).find(std::u8string_view(config.filter)) ==
+                                        std::u8string_view::npos)
+    {
+        return;
+    }
+    for (unsigned long i = 0; i < config.warmup; i++)
+    {
+        fn();
+    }
+    std::vector<unsigned long long> times;
+    std::vector<unsigned long long> cycles;
+    times.reserve(config.reps);
+    cycles.reserve(config.reps);
+    for (unsigned long i = 0; i < config.reps; i++)
+    {
+        unsigned long long start = os::clock_ns();
+        unsigned long long start_cycles = std::detail::cycle_count();
+        fn();
+        cycles.push_back(std::detail::cycle_count() - start_cycles);
+        times.push_back(os::clock_ns() - start);
+    }
+    std::sort(times.begin(), times.end());
+    std::sort(cycles.begin(), cycles.end());
+
+    line out;
+    if (config.csv)
+    {
+        out << name << "," << implementation << "," << static_cast<unsigned long long>(ops) << ","
+            << static_cast<unsigned long long>(config.reps) << ",";
+        out.per_op(quantile(times, 1, 2), ops) << ",";
+        out.per_op(quantile(times, 99, 100), ops) << ",";
+        out.per_op(quantile(cycles, 1, 2), ops) << "\n";
+    }
+    else
+    {
+        out << name;
+        out.pad_to(28) << implementation;
+        out.pad_to(44).per_op(quantile(times, 1, 2), ops);
+        out.pad_to(60).per_op(quantile(times, 99, 100), ops);
+        out.pad_to(76).per_op(quantile(cycles, 1, 2), ops) << "\n";
+    }
+    out.flush();
+}
+
+int main(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (std::u8string_view(arg) == std::u8string_view("--csv"))
+        {
+            config.csv = true;
+        }
+        else if (has_prefix(arg, "--filter="))
+        {
+            config.filter = arg + 9;
+        }
+        else if (!parse_number(arg, "--reps=", config.reps) && !parse_number(arg, "--warmup=", config.warmup))
+        {
+            print("usage: std_bench [--csv] [--reps=N] [--warmup=N] [--filter=TEXT]\n");
+            return 1;
+        }
+    }
+
+    if (config.csv)
+    {
+        print("benchmark,implementation,ops,reps,median_ns_per_op,p99_ns_per_op,median_cycles_per_op\n");
+    }
+    else
+    {
+        line header;
+        header << "benchmark";
+        header.pad_to(28) << "implementation";
+        header.pad_to(44) << "median ns/op";
+        header.pad_to(60) << "p99 ns/op";
+        header.pad_to(76) << "cycles/op\n";
+        header.flush();
+    }
+    // The linker will place all the function pointers into a contiguous block.
+    for (BenchFunc *f = __start_mybench_funcs; f != __stop_mybench_funcs; ++f)
+    {
+        (*f)();
+    }
+    return 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "host.h"
+using BenchFunc = void (*)();
+
+extern "C"
+{
+    extern BenchFunc __start_mybench_funcs[];
+    extern BenchFunc __stop_mybench_funcs[];
+}
+
+namespace bench
+{
+    /*!
+     * @brief Times fn, which performs ops operations, over the warmup and repetitions set on the command line and
+     * prints the median and 99th percentile per operation.
+     */
+    void run(const char *name, const char *implementation, unsigned long ops, void (*fn)());
+
+    //! Makes the compiler assume value is read, so the work producing it is not optimised away.
+    template<typename T> inline void keep(const T &value)
+    {
+        __asm__ __volatile__("" : : "r"(&value) : "memory");
+    }
+} // namespace bench
+
+// Registers a benchmark run once on this library and once on the host standard library
+#define BENCH(name, v_name, ops, func, host_func) __attribute__((used, section("mybench_funcs"))) \
+    static BenchFunc v_name = []() { \
+    bench::run(name, "portable_std", ops, func); \
+    bench::run(name, "host", ops, host_func); };
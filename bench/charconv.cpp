@@ -0,0 +1,68 @@
+#include <charconv.h>
+#include <format.h>
+#include "bench.h"
+
+namespace
+{
+double numbers[bench::number_count];
+char texts[bench::number_count][32];
+char *text_ends[bench::number_count];
+
+void fill_numbers()
+{
+    static bool filled = false;
+    if (!filled)
+    {
+        unsigned int state = 3;
+        for (unsigned long i = 0; i < bench::number_count; i++)
+        {
+            numbers[i] = bench::next_number(state);
+            text_ends[i] = std::to_chars(texts[i], texts[i] + sizeof(texts[i]), numbers[i]).ptr;
+        }
+        filled = true;
+    }
+}
+
+void discard(void *, const char *data, std::size_t)
+{
+    bench::keep(data);
+}
+
+void bench_to_chars()
+{
+    fill_numbers();
+    char buffer[32];
+    for (unsigned long i = 0; i < bench::number_count; i++)
+    {
+        bench::keep(std::to_chars(buffer, buffer + sizeof(buffer), numbers[i]).ptr);
+    }
+}
+
+void bench_from_chars()
+{
+    fill_numbers();
+    double sum = 0;
+    for (unsigned long i = 0; i < bench::number_count; i++)
+    {
+        double value;
+        std::from_chars(texts[i], text_ends[i], value);
+        sum += value;
+    }
+    bench::keep(sum);
+}
+
+void bench_format()
+{
+    fill_numbers();
+    for (unsigned long i = 0; i < bench::number_count; i++)
+    {
+        std::buffered_sink<256> sink(discard);
+        std::format_to(sink, "[{:>6}] request {} served in {} ms\n", "info", i, numbers[i]);
+    }
+}
+} // namespace
+
+BENCH("to_chars double", to_chars_double, bench::number_count, bench_to_chars, host_bench::to_chars_double);
+BENCH("from_chars double", from_chars_double, bench::number_count, bench_from_chars, host_bench::from_chars_double);
+// The host side formats the same line with snprintf, whose %g keeps six significant digits rather than the shortest
+BENCH("format log line", format_log_line, bench::number_count, bench_format, host_bench::format_log_line);
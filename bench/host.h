@@ -0,0 +1,77 @@
+#pragma once
+// Shared by the benchmarks built on this library and bench/host, which is built against the compiler's own standard
+// library. Nothing here may include a header, as the two sides resolve the same include names differently.
+
+namespace bench
+{
+    //! Deterministic inputs, so both sides of a benchmark work on the same data.
+    inline unsigned int next_random(unsigned int &state)
+    {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    /*!
+     * @brief Fills out with size - 1 bytes of lowercase words, a two-byte UTF-8 character every 64 bytes and the word
+     * "needle" at the end, then a terminator.
+     */
+    inline void fill_text(char *out, unsigned long size)
+    {
+        unsigned int state = 7;
+        const char needle[] = "needle";
+        unsigned long body = size - sizeof(needle);
+        for (unsigned long i = 0; i < body; i++)
+        {
+            if (i % 64 == 62 && i + 1 < body)
+            {
+                out[i++] = static_cast<char>(0xC3);
+                out[i] = static_cast<char>(0xA9);
+                continue;
+            }
+            unsigned int pick = next_random(state) % 27;
+            out[i] = pick == 26 ? ' ' : static_cast<char>('a' + pick);
+        }
+        for (unsigned long i = 0; i < sizeof(needle); i++)
+        {
+            out[body + i] = needle[i];
+        }
+    }
+
+    //! A number with anywhere from a few to 17 significant digits, drawn the same way on both sides.
+    inline double next_number(unsigned int &state)
+    {
+        double numerator = static_cast<double>(next_random(state));
+        return numerator / static_cast<double>(1 + next_random(state) % 1000);
+    }
+
+    //! Sizes of the inputs, shared so both sides do the same work per operation.
+    inline constexpr unsigned long block_bytes = 4096;
+    inline constexpr unsigned long block_copies = 64;
+    inline constexpr unsigned long text_bytes = 1024;
+    inline constexpr unsigned long push_count = 10000;
+    inline constexpr unsigned long insert_count = 1000;
+    inline constexpr unsigned long grow_count = 1000;
+    inline constexpr unsigned long sort_count = 10000;
+    inline constexpr unsigned long string_count = 100;
+    inline constexpr unsigned long number_count = 1000;
+} // namespace bench
+
+// The host standard library counterparts of the benchmarks, one operation batch per call
+namespace host_bench
+{
+    void memcpy_block();
+    void memcmp_block();
+    void strlen_text();
+    void vector_push_back();
+    void vector_insert_front();
+    void vector_erase_front();
+    void vector_grow_strings();
+    void string_from_utf8();
+    void string_find();
+    void string_to_utf8();
+    void sort_ints();
+    void sort_with_compare();
+    void to_chars_double();
+    void from_chars_double();
+    void format_log_line();
+} // namespace host_bench
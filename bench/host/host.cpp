@@ -0,0 +1,222 @@
+// Built against the compiler's standard library, without this library's headers on the include path
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../host.h"
+
+namespace
+{
+template<typename T> inline void keep(const T &value)
+{
+    __asm__ __volatile__("" : : "r"(&value) : "memory");
+}
+
+unsigned char block_source[bench::block_bytes];
+unsigned char block_target[bench::block_bytes];
+
+const char *text()
+{
+    static char buffer[bench::text_bytes];
+    static bool filled = false;
+    if (!filled)
+    {
+        bench::fill_text(buffer, sizeof(buffer));
+        filled = true;
+    }
+    return buffer;
+}
+
+const std::vector<int> &input()
+{
+    static std::vector<int> numbers;
+    if (numbers.empty())
+    {
+        unsigned int state = 1;
+        for (unsigned long i = 0; i < bench::sort_count; i++)
+        {
+            numbers.push_back(static_cast<int>(bench::next_random(state)));
+        }
+    }
+    return numbers;
+}
+
+double numbers[bench::number_count];
+char texts[bench::number_count][32];
+char *text_ends[bench::number_count];
+
+void fill_numbers()
+{
+    static bool filled = false;
+    if (!filled)
+    {
+        unsigned int state = 3;
+        for (unsigned long i = 0; i < bench::number_count; i++)
+        {
+            numbers[i] = bench::next_number(state);
+            text_ends[i] = std::to_chars(texts[i], texts[i] + sizeof(texts[i]), numbers[i]).ptr;
+        }
+        filled = true;
+    }
+}
+} // namespace
+
+namespace host_bench
+{
+    void memcpy_block()
+    {
+        for (unsigned long i = 0; i < bench::block_copies; i++)
+        {
+            std::memcpy(block_target, block_source, sizeof(block_target));
+            keep(block_target);
+        }
+    }
+
+    void memcmp_block()
+    {
+        int sum = 0;
+        for (unsigned long i = 0; i < bench::block_copies; i++)
+        {
+            keep(block_target);
+            sum += std::memcmp(block_source, block_target, sizeof(block_target));
+        }
+        keep(sum);
+    }
+
+    void strlen_text()
+    {
+        const char *str = text();
+        unsigned long sum = 0;
+        for (unsigned long i = 0; i < bench::block_copies; i++)
+        {
+            keep(str);
+            sum += std::strlen(str);
+        }
+        keep(sum);
+    }
+
+    void vector_push_back()
+    {
+        std::vector<int> numbers;
+        for (unsigned long i = 0; i < bench::push_count; i++)
+        {
+            numbers.push_back(static_cast<int>(i));
+        }
+        keep(numbers.data());
+    }
+
+    void vector_insert_front()
+    {
+        std::vector<int> numbers;
+        for (unsigned long i = 0; i < bench::insert_count; i++)
+        {
+            numbers.insert(numbers.begin(), static_cast<int>(i));
+        }
+        keep(numbers.data());
+    }
+
+    void vector_erase_front()
+    {
+        std::vector<int> numbers(bench::insert_count, 1);
+        while (!numbers.empty())
+        {
+            numbers.erase(numbers.begin());
+            keep(numbers.data());
+        }
+    }
+
+    void vector_grow_strings()
+    {
+        std::vector<std::string> names;
+        for (unsigned long i = 0; i < bench::grow_count; i++)
+        {
+            names.push_back(i % 2 == 0 ? std::string("short") : std::string("a name long enough to live on the heap"));
+        }
+        keep(names.data());
+    }
+
+    void string_from_utf8()
+    {
+        const char *utf8 = text();
+        for (unsigned long i = 0; i < bench::string_count; i++)
+        {
+            std::string str(utf8);
+            keep(str);
+        }
+    }
+
+    void string_find()
+    {
+        static const std::string haystack(text());
+        static const std::string needle("needle");
+        unsigned long sum = 0;
+        for (unsigned long i = 0; i < bench::string_count; i++)
+        {
+            keep(haystack);
+            sum += haystack.find(needle);
+        }
+        keep(sum);
+    }
+
+    void string_to_utf8()
+    {
+        static const std::string str(text());
+        for (unsigned long i = 0; i < bench::string_count; i++)
+        {
+            std::string copy(str);
+            keep(copy);
+        }
+    }
+
+    void sort_ints()
+    {
+        std::vector<int> numbers = input();
+        std::sort(numbers.begin(), numbers.end());
+        keep(numbers.data());
+    }
+
+    void sort_with_compare()
+    {
+        std::vector<int> numbers = input();
+        std::sort(numbers.begin(), numbers.end(), [](int a, int b) { return a > b; });
+        keep(numbers.data());
+    }
+
+    void to_chars_double()
+    {
+        fill_numbers();
+        char buffer[32];
+        for (unsigned long i = 0; i < bench::number_count; i++)
+        {
+            keep(std::to_chars(buffer, buffer + sizeof(buffer), numbers[i]).ptr);
+        }
+    }
+
+    void from_chars_double()
+    {
+        fill_numbers();
+        double sum = 0;
+        for (unsigned long i = 0; i < bench::number_count; i++)
+        {
+            double value;
+            std::from_chars(texts[i], text_ends[i], value);
+            sum += value;
+        }
+        keep(sum);
+    }
+
+    void format_log_line()
+    {
+        fill_numbers();
+        for (unsigned long i = 0; i < bench::number_count; i++)
+        {
+            char line[256];
+            int length =
+                std::snprintf(line, sizeof(line), "[%6s] request %lu served in %g ms\n", "info", i, numbers[i]);
+            keep(line);
+            keep(length);
+        }
+    }
+} // namespace host_bench
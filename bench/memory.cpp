@@ -0,0 +1,54 @@
+#include <algorithm.h>
+#include <cstring.h>
+#include "bench.h"
+
+static unsigned char block_source[bench::block_bytes];
+static unsigned char block_target[bench::block_bytes];
+
+static void bench_memcpy()
+{
+    for (unsigned long i = 0; i < bench::block_copies; i++)
+    {
+        std::memcpy(block_target, block_source, sizeof(block_target));
+        bench::keep(block_target);
+    }
+}
+
+static void bench_memcmp()
+{
+    int sum = 0;
+    for (unsigned long i = 0; i < bench::block_copies; i++)
+    {
+        bench::keep(block_target);
+        sum += std::memcmp(block_source, block_target, sizeof(block_target));
+    }
+    bench::keep(sum);
+}
+
+static const char *text()
+{
+    static char buffer[bench::text_bytes];
+    static bool filled = false;
+    if (!filled)
+    {
+        bench::fill_text(buffer, sizeof(buffer));
+        filled = true;
+    }
+    return buffer;
+}
+
+static void bench_strlen()
+{
+    const char *str = text();
+    unsigned long sum = 0;
+    for (unsigned long i = 0; i < bench::block_copies; i++)
+    {
+        bench::keep(str);
+        sum += strlen(str);
+    }
+    bench::keep(sum);
+}
+
+BENCH("memcpy 4 KiB", memcpy_block, bench::block_copies, bench_memcpy, host_bench::memcpy_block);
+BENCH("memcmp 4 KiB", memcmp_block, bench::block_copies, bench_memcmp, host_bench::memcmp_block);
+BENCH("strlen 1 KiB", strlen_text, bench::block_copies, bench_strlen, host_bench::strlen_text);
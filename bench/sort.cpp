@@ -0,0 +1,35 @@
+#include <algorithm.h>
+#include <functional.h>
+#include <vector.h>
+#include "bench.h"
+
+static const std::vector<int> &input()
+{
+    static std::vector<int> numbers;
+    if (numbers.empty())
+    {
+        unsigned int state = 1;
+        for (unsigned long i = 0; i < bench::sort_count; i++)
+        {
+            numbers.push_back(static_cast<int>(bench::next_random(state)));
+        }
+    }
+    return numbers;
+}
+
+static void bench_sort()
+{
+    std::vector<int> numbers = input();
+    std::sort(numbers.begin(), numbers.end());
+    bench::keep(numbers.data());
+}
+
+static void bench_quicksort()
+{
+    std::vector<int> numbers = input();
+    std::quicksort(numbers.begin(), numbers.end(), [](int a, int b) { return a > b; });
+    bench::keep(numbers.data());
+}
+
+BENCH("sort ints", sort_ints, bench::sort_count, bench_sort, host_bench::sort_ints);
+BENCH("quicksort with compare", sort_with_compare, bench::sort_count, bench_quicksort, host_bench::sort_with_compare);
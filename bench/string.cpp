@@ -0,0 +1,52 @@
+#include <string.h>
+#include "bench.h"
+
+static const char *text()
+{
+    static char buffer[bench::text_bytes];
+    static bool filled = false;
+    if (!filled)
+    {
+        bench::fill_text(buffer, sizeof(buffer));
+        filled = true;
+    }
+    return buffer;
+}
+
+static void bench_from_utf8()
+{
+    const char *utf8 = text();
+    for (unsigned long i = 0; i < bench::string_count; i++)
+    {
+        std::string str(utf8);
+        bench::keep(str);
+    }
+}
+
+static void bench_find()
+{
+    static const std::string haystack(text());
+    static const std::string needle("needle");
+    unsigned long sum = 0;
+    for (unsigned long i = 0; i < bench::string_count; i++)
+    {
+        bench::keep(haystack);
+        sum += haystack.find(needle.view());
+    }
+    bench::keep(sum);
+}
+
+static void bench_to_utf8()
+{
+    static const std::string str(text());
+    for (unsigned long i = 0; i < bench::string_count; i++)
+    {
+        std::throw_away_string utf8 = str.throw_away();
+        bench::keep(utf8);
+    }
+}
+
+// The host side has no UTF-16 string, so it copies UTF-8 bytes where this library converts them
+BENCH("string from utf8", string_from_utf8, bench::string_count, bench_from_utf8, host_bench::string_from_utf8);
+BENCH("string find", string_find, bench::string_count, bench_find, host_bench::string_find);
+BENCH("string throw_away", string_to_utf8, bench::string_count, bench_to_utf8, host_bench::string_to_utf8);
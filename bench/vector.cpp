@@ -0,0 +1,51 @@
+#include <string.h>
+#include <vector.h>
+#include "bench.h"
+
+static void bench_push_back()
+{
+    std::vector<int> numbers;
+    for (unsigned long i = 0; i < bench::push_count; i++)
+    {
+        numbers.push_back(static_cast<int>(i));
+    }
+    bench::keep(numbers.data());
+}
+
+static void bench_insert_front()
+{
+    std::vector<int> numbers;
+    for (unsigned long i = 0; i < bench::insert_count; i++)
+    {
+        numbers.insert(numbers.begin(), static_cast<int>(i));
+    }
+    bench::keep(numbers.data());
+}
+
+static void bench_erase_front()
+{
+    std::vector<int> numbers(bench::insert_count, 1);
+    while (!numbers.empty())
+    {
+        numbers.erase(numbers.begin());
+        bench::keep(numbers.data());
+    }
+}
+
+static void bench_grow_strings()
+{
+    // Every growth relocates the strings, half of which own a heap buffer
+    std::vector<std::string> names;
+    for (unsigned long i = 0; i < bench::grow_count; i++)
+    {
+        names.push_back(i % 2 == 0 ? std::string("short") : std::string("a name long enough to live on the heap"));
+    }
+    bench::keep(names.data());
+}
+
+BENCH("vector push_back", vector_push_back, bench::push_count, bench_push_back, host_bench::vector_push_back);
+BENCH("vector insert front", vector_insert_front, bench::insert_count, bench_insert_front,
+      host_bench::vector_insert_front);
+BENCH("vector erase front", vector_erase_front, bench::insert_count, bench_erase_front, host_bench::vector_erase_front);
+BENCH("vector grow strings", vector_grow_strings, bench::grow_count, bench_grow_strings,
+      host_bench::vector_grow_strings);
@@ -5,7 +5,29 @@
  */
 #ifndef ALGORITHM_H
 #define ALGORITHM_H
+#include <functional.h>
+#include <new.h>
+#include <stddef.h>
+#include <trace.h>
 #include <utility.h>
+
+/*
+ * The memory kernels below pick the widest vector unit the target is compiled for. Define STD_NO_SIMD to force the
+ * portable word-at-a-time kernels, e.g. for kernels that must not touch vector registers.
+ */
+#if !defined(STD_NO_SIMD)
+#    if defined(__AVX2__)
+#        include <immintrin.h>
+#        define STD_SIMD_AVX2 1
+#        define STD_SIMD_SSE2 1
+#    elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#        include <emmintrin.h>
+#        define STD_SIMD_SSE2 1
+#    elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#        include <arm_neon.h>
+#        define STD_SIMD_NEON 1
+#    endif
+#endif
 namespace std
 {
 /*!
@@ -89,9 +111,9 @@ template<typename T> constexpr T sign(T a) noexcept
  */
 template<typename T> constexpr void swap(T &a, T &b) noexcept
 {
-    T tmp = a;
-    a = b;
-    b = tmp;
+    T tmp = std::move(a);
+    a = std::move(b);
+    b = std::move(tmp);
 }
 
 /*!
@@ -149,8 +171,672 @@ template<typename Iterator, typename Compare> Iterator partition(Iterator beg, I
     swap(*(i + 1), *pivot);
     return i + 1; // Return the pivot's new position
 }
+/*!
+ * @brief Swaps the values two iterators point to
+ */
+template<typename Iterator> constexpr void iter_swap(Iterator a, Iterator b) noexcept
+{
+    swap(*a, *b);
+}
+
+namespace detail
+{
+/*
+ * The sorting core is pattern-defeating quicksort (Orson Peters, https://github.com/orlp/pdqsort): introsort with
+ * ninther pivots, an insertion sort cutoff, a heapsort fallback once too many partitions came out unbalanced, and a
+ * check that finishes already sorted runs in linear time. Plain comparisons of arithmetic keys partition with the
+ * branchless block scheme of BlockQuicksort, which does not stall on mispredicted compares.
+ */
+inline constexpr std::ptrdiff_t sort_insertion_threshold = 24;
+inline constexpr std::ptrdiff_t sort_ninther_threshold = 128;
+inline constexpr std::ptrdiff_t sort_partial_insertion_limit = 8;
+inline constexpr std::size_t sort_block_size = 64;
+
+template<typename Iterator> using iter_value_t = typename std::iterator_traits<Iterator>::value_type;
+
+template<typename Compare> struct is_plain_compare : false_type
+{
+};
+template<typename T> struct is_plain_compare<std::less<T>> : true_type
+{
+};
+template<typename T> struct is_plain_compare<std::greater<T>> : true_type
+{
+};
+
+template<typename Iterator, typename Compare>
+inline constexpr bool sort_branchless = is_arithmetic_v<iter_value_t<Iterator>> && is_plain_compare<Compare>::value;
+
+constexpr inline int floor_log2(std::size_t n) noexcept
+{
+    int log = 0;
+    while (n >>= 1)
+    {
+        ++log;
+    }
+    return log;
+}
+
+template<typename Iterator, typename Compare> void insertion_sort(Iterator begin, Iterator end, Compare &comp)
+{
+    if (begin == end)
+    {
+        return;
+    }
+    for (Iterator cur = begin + 1; cur != end; ++cur)
+    {
+        Iterator sift = cur;
+        Iterator sift_1 = cur - 1;
+        if (comp(*sift, *sift_1))
+        {
+            iter_value_t<Iterator> tmp = std::move(*sift);
+            do
+            {
+                *sift-- = std::move(*sift_1);
+            } while (sift != begin && comp(tmp, *--sift_1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Requires an element not greater than any in [begin, end) right before begin, which stops the sift
+template<typename Iterator, typename Compare> void unguarded_insertion_sort(Iterator begin, Iterator end, Compare &comp)
+{
+    if (begin == end)
+    {
+        return;
+    }
+    for (Iterator cur = begin + 1; cur != end; ++cur)
+    {
+        Iterator sift = cur;
+        Iterator sift_1 = cur - 1;
+        if (comp(*sift, *sift_1))
+        {
+            iter_value_t<Iterator> tmp = std::move(*sift);
+            do
+            {
+                *sift-- = std::move(*sift_1);
+            } while (comp(tmp, *--sift_1));
+            *sift = std::move(tmp);
+        }
+    }
+}
+
+// Insertion sort that gives up once it has moved more than sort_partial_insertion_limit elements
+template<typename Iterator, typename Compare> bool partial_insertion_sort(Iterator begin, Iterator end, Compare &comp)
+{
+    if (begin == end)
+    {
+        return true;
+    }
+    std::ptrdiff_t moved = 0;
+    for (Iterator cur = begin + 1; cur != end; ++cur)
+    {
+        Iterator sift = cur;
+        Iterator sift_1 = cur - 1;
+        if (comp(*sift, *sift_1))
+        {
+            iter_value_t<Iterator> tmp = std::move(*sift);
+            do
+            {
+                *sift-- = std::move(*sift_1);
+            } while (sift != begin && comp(tmp, *--sift_1));
+            *sift = std::move(tmp);
+            moved += cur - sift;
+        }
+        if (moved > sort_partial_insertion_limit)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename Iterator, typename Compare> void sort2(Iterator a, Iterator b, Compare &comp)
+{
+    if (comp(*b, *a))
+    {
+        iter_swap(a, b);
+    }
+}
+
+template<typename Iterator, typename Compare> void sort3(Iterator a, Iterator b, Iterator c, Compare &comp)
+{
+    sort2(a, b, comp);
+    sort2(b, c, comp);
+    sort2(a, b, comp);
+}
+
+template<typename Iterator, typename Compare>
+void sift_down(Iterator first, std::ptrdiff_t length, std::ptrdiff_t hole, Compare &comp)
+{
+    iter_value_t<Iterator> value = std::move(*(first + hole));
+    std::ptrdiff_t child = 2 * hole + 1;
+    while (child < length)
+    {
+        if (child + 1 < length && comp(*(first + child), *(first + child + 1)))
+        {
+            ++child;
+        }
+        if (!comp(value, *(first + child)))
+        {
+            break;
+        }
+        *(first + hole) = std::move(*(first + child));
+        hole = child;
+        child = 2 * hole + 1;
+    }
+    *(first + hole) = std::move(value);
+}
+
+template<typename Iterator, typename Compare> void make_heap(Iterator first, Iterator last, Compare &comp)
+{
+    std::ptrdiff_t length = last - first;
+    for (std::ptrdiff_t parent = length / 2; parent-- > 0;)
+    {
+        sift_down(first, length, parent, comp);
+    }
+}
+
+template<typename Iterator, typename Compare> void sort_heap(Iterator first, Iterator last, Compare &comp)
+{
+    for (std::ptrdiff_t length = last - first; length > 1; --length)
+    {
+        iter_swap(first, first + (length - 1));
+        sift_down(first, length - 1, 0, comp);
+    }
+}
+
+template<typename Iterator> struct partition_result
+{
+    Iterator pivot;
+    bool already_partitioned;
+};
+
+/*!
+ * @brief Partitions [begin, end) around *begin into elements less than the pivot and the rest
+ * @details Requires an element not less than the pivot at the end of the range, which median selection provides.
+ */
+template<typename Iterator, typename Compare>
+partition_result<Iterator> partition_right(Iterator begin, Iterator end, Compare &comp)
+{
+    iter_value_t<Iterator> pivot = std::move(*begin);
+    Iterator first = begin;
+    Iterator last = end;
+
+    while (comp(*++first, pivot))
+    {
+    }
+    // Without an element less than the pivot before first, the scan from the right needs a bound
+    if (first - 1 == begin)
+    {
+        while (first < last && !comp(*--last, pivot))
+        {
+        }
+    }
+    else
+    {
+        while (!comp(*--last, pivot))
+        {
+        }
+    }
+
+    bool already_partitioned = first >= last;
+    while (first < last)
+    {
+        iter_swap(first, last);
+        while (comp(*++first, pivot))
+        {
+        }
+        while (!comp(*--last, pivot))
+        {
+        }
+    }
+
+    Iterator pivot_pos = first - 1;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return {pivot_pos, already_partitioned};
+}
+
+template<typename Iterator>
+void swap_offsets(Iterator first, Iterator last, const unsigned char *offsets_l, const unsigned char *offsets_r,
+                  std::size_t count, bool use_swaps)
+{
+    if (use_swaps)
+    {
+        // With equal counts a cyclic permutation would not be reversible, so swap pairwise
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            iter_swap(first + offsets_l[i], last - offsets_r[i]);
+        }
+    }
+    else if (count > 0)
+    {
+        Iterator l = first + offsets_l[0];
+        Iterator r = last - offsets_r[0];
+        iter_value_t<Iterator> tmp = std::move(*l);
+        *l = std::move(*r);
+        for (std::size_t i = 1; i < count; ++i)
+        {
+            l = first + offsets_l[i];
+            *r = std::move(*l);
+            r = last - offsets_r[i];
+            *l = std::move(*r);
+        }
+        *r = std::move(tmp);
+    }
+}
+
+/*!
+ * @brief partition_right() without data-dependent branches
+ * @details Each side records the offsets of misplaced elements for a block of sort_block_size elements, storing the
+ * offset unconditionally and advancing the count by the comparison result, then the recorded pairs are swapped.
+ */
+template<typename Iterator, typename Compare>
+partition_result<Iterator> partition_right_branchless(Iterator begin, Iterator end, Compare &comp)
+{
+    iter_value_t<Iterator> pivot = std::move(*begin);
+    Iterator first = begin;
+    Iterator last = end;
+
+    while (comp(*++first, pivot))
+    {
+    }
+    if (first - 1 == begin)
+    {
+        while (first < last && !comp(*--last, pivot))
+        {
+        }
+    }
+    else
+    {
+        while (!comp(*--last, pivot))
+        {
+        }
+    }
+
+    bool already_partitioned = first >= last;
+    if (!already_partitioned)
+    {
+        iter_swap(first, last);
+        ++first;
+
+        alignas(64) unsigned char offsets_l_storage[sort_block_size];
+        alignas(64) unsigned char offsets_r_storage[sort_block_size];
+        unsigned char *offsets_l = offsets_l_storage;
+        unsigned char *offsets_r = offsets_r_storage;
+        Iterator offsets_l_base = first;
+        Iterator offsets_r_base = last;
+        std::size_t num_l = 0;
+        std::size_t num_r = 0;
+        std::size_t start_l = 0;
+        std::size_t start_r = 0;
+
+        while (first < last)
+        {
+            // Fill whichever offset buffers are empty, splitting what is left when both are
+            std::size_t num_unknown = static_cast<std::size_t>(last - first);
+            std::size_t left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+            std::size_t right_split = num_r == 0 ? (num_unknown - left_split) : 0;
+
+            std::size_t left_count = left_split < sort_block_size ? left_split : sort_block_size;
+            for (std::size_t i = 0; i < left_count; ++i)
+            {
+                offsets_l[num_l] = static_cast<unsigned char>(i);
+                num_l += !comp(*first, pivot);
+                ++first;
+            }
+            std::size_t right_count = right_split < sort_block_size ? right_split : sort_block_size;
+            for (std::size_t i = 0; i < right_count;)
+            {
+                offsets_r[num_r] = static_cast<unsigned char>(++i);
+                num_r += comp(*--last, pivot);
+            }
+
+            std::size_t count = num_l < num_r ? num_l : num_r;
+            swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l, offsets_r + start_r, count,
+                         num_l == num_r);
+            num_l -= count;
+            num_r -= count;
+            start_l += count;
+            start_r += count;
+            if (num_l == 0)
+            {
+                start_l = 0;
+                offsets_l_base = first;
+            }
+            if (num_r == 0)
+            {
+                start_r = 0;
+                offsets_r_base = last;
+            }
+        }
+
+        // One side may still have misplaced elements; move them to the boundary
+        if (num_l)
+        {
+            offsets_l += start_l;
+            while (num_l--)
+            {
+                iter_swap(offsets_l_base + offsets_l[num_l], --last);
+            }
+            first = last;
+        }
+        if (num_r)
+        {
+            offsets_r += start_r;
+            while (num_r--)
+            {
+                iter_swap(offsets_r_base - offsets_r[num_r], first);
+                ++first;
+            }
+            last = first;
+        }
+    }
+
+    Iterator pivot_pos = first - 1;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return {pivot_pos, already_partitioned};
+}
+
+/*!
+ * @brief Puts elements equal to the pivot *begin on the left, used when the pivot equals the element before begin
+ * @return The last position of the elements equal to the pivot
+ */
+template<typename Iterator, typename Compare> Iterator partition_left(Iterator begin, Iterator end, Compare &comp)
+{
+    iter_value_t<Iterator> pivot = std::move(*begin);
+    Iterator first = begin;
+    Iterator last = end;
+
+    while (comp(pivot, *--last))
+    {
+    }
+    if (last + 1 == end)
+    {
+        while (first < last && !comp(pivot, *++first))
+        {
+        }
+    }
+    else
+    {
+        while (!comp(pivot, *++first))
+        {
+        }
+    }
+
+    while (first < last)
+    {
+        iter_swap(first, last);
+        while (comp(pivot, *--last))
+        {
+        }
+        while (!comp(pivot, *++first))
+        {
+        }
+    }
+
+    Iterator pivot_pos = last;
+    *begin = std::move(*pivot_pos);
+    *pivot_pos = std::move(pivot);
+    return pivot_pos;
+}
+
+/*!
+ * @brief Moves the median of a ninther (large ranges) or of three to *begin
+ */
+template<typename Iterator, typename Compare> void choose_pivot(Iterator begin, Iterator end, Compare &comp)
+{
+    std::ptrdiff_t size = end - begin;
+    std::ptrdiff_t half = size / 2;
+    if (size > sort_ninther_threshold)
+    {
+        sort3(begin, begin + half, end - 1, comp);
+        sort3(begin + 1, begin + (half - 1), end - 2, comp);
+        sort3(begin + 2, begin + (half + 1), end - 3, comp);
+        sort3(begin + (half - 1), begin + half, begin + (half + 1), comp);
+        iter_swap(begin, begin + half);
+    }
+    else
+    {
+        sort3(begin + half, begin, end - 1, comp);
+    }
+}
+
+/*!
+ * @brief Swaps a few elements of a badly unbalanced partition so the next pivot lands elsewhere
+ */
+template<typename Iterator>
+void break_patterns(Iterator begin, Iterator pivot_pos, Iterator end, std::ptrdiff_t l_size, std::ptrdiff_t r_size)
+{
+    if (l_size >= sort_insertion_threshold)
+    {
+        iter_swap(begin, begin + l_size / 4);
+        iter_swap(pivot_pos - 1, pivot_pos - l_size / 4);
+        if (l_size > sort_ninther_threshold)
+        {
+            iter_swap(begin + 1, begin + (l_size / 4 + 1));
+            iter_swap(begin + 2, begin + (l_size / 4 + 2));
+            iter_swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+            iter_swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+        }
+    }
+    if (r_size >= sort_insertion_threshold)
+    {
+        iter_swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+        iter_swap(end - 1, end - r_size / 4);
+        if (r_size > sort_ninther_threshold)
+        {
+            iter_swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+            iter_swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+            iter_swap(end - 2, end - (1 + r_size / 4));
+            iter_swap(end - 3, end - (2 + r_size / 4));
+        }
+    }
+}
+
+/*!
+ * @brief The pdqsort loop. Recurses into the smaller partition and loops on the larger, so the stack depth is
+ * logarithmic whatever the input.
+ * @param bad_allowed Unbalanced partitions left before switching to heapsort
+ * @param leftmost False if the element before begin may be used as a sentinel
+ */
+template<typename Iterator, typename Compare, bool Branchless>
+void pdqsort_loop(Iterator begin, Iterator end, Compare &comp, int bad_allowed, bool leftmost)
+{
+    for (;;)
+    {
+        std::ptrdiff_t size = end - begin;
+        if (size < sort_insertion_threshold)
+        {
+            if (leftmost)
+            {
+                insertion_sort(begin, end, comp);
+            }
+            else
+            {
+                unguarded_insertion_sort(begin, end, comp);
+            }
+            return;
+        }
+
+        choose_pivot(begin, end, comp);
+
+        // A pivot equal to the element before the range means the range holds many equal elements; group them on
+        // the left and skip them, since they are already in place
+        if (!leftmost && !comp(*(begin - 1), *begin))
+        {
+            begin = partition_left(begin, end, comp) + 1;
+            continue;
+        }
+
+        partition_result<Iterator> part;
+        if constexpr (Branchless)
+        {
+            part = partition_right_branchless(begin, end, comp);
+        }
+        else
+        {
+            part = partition_right(begin, end, comp);
+        }
+        Iterator pivot_pos = part.pivot;
+
+        std::ptrdiff_t l_size = pivot_pos - begin;
+        std::ptrdiff_t r_size = end - (pivot_pos + 1);
+        if (l_size < size / 8 || r_size < size / 8)
+        {
+            if (--bad_allowed == 0)
+            {
+                make_heap(begin, end, comp);
+                sort_heap(begin, end, comp);
+                return;
+            }
+            break_patterns(begin, pivot_pos, end, l_size, r_size);
+        }
+        else if (part.already_partitioned && partial_insertion_sort(begin, pivot_pos, comp) &&
+                 partial_insertion_sort(pivot_pos + 1, end, comp))
+        {
+            return;
+        }
+
+        if (l_size < r_size)
+        {
+            pdqsort_loop<Iterator, Compare, Branchless>(begin, pivot_pos, comp, bad_allowed, leftmost);
+            begin = pivot_pos + 1;
+            leftmost = false;
+        }
+        else
+        {
+            pdqsort_loop<Iterator, Compare, Branchless>(pivot_pos + 1, end, comp, bad_allowed, false);
+            end = pivot_pos;
+        }
+    }
+}
+
+/*!
+ * @brief Merges the sorted runs [first, middle) and [middle, last) in place
+ * @details The left run is moved out to buffer, which must have room for middle - first elements, and merged back.
+ * Ties take the left element, which keeps the merge stable.
+ */
+template<typename Iterator, typename Compare>
+void merge_adjacent(Iterator first, Iterator middle, Iterator last, iter_value_t<Iterator> *buffer, Compare &comp)
+{
+    if (first == middle || middle == last || !comp(*middle, *(middle - 1)))
+    {
+        return;
+    }
+    using value_type = iter_value_t<Iterator>;
+    value_type *buffer_end = buffer;
+    for (Iterator it = first; it != middle; ++it, ++buffer_end)
+    {
+        ::new (static_cast<void *>(buffer_end)) value_type(std::move(*it));
+    }
+    value_type *left = buffer;
+    Iterator right = middle;
+    Iterator out = first;
+    while (left != buffer_end && right != last)
+    {
+        if (comp(*right, *left))
+        {
+            *out++ = std::move(*right++);
+        }
+        else
+        {
+            *out++ = std::move(*left++);
+        }
+    }
+    while (left != buffer_end)
+    {
+        *out++ = std::move(*left++);
+    }
+    for (value_type *it = buffer; it != buffer_end; ++it)
+    {
+        it->~value_type();
+    }
+}
+
+template<typename Iterator, typename Compare>
+void merge_sort(Iterator first, Iterator last, iter_value_t<Iterator> *buffer, Compare &comp)
+{
+    std::ptrdiff_t length = last - first;
+    if (length <= sort_insertion_threshold)
+    {
+        insertion_sort(first, last, comp);
+        return;
+    }
+    Iterator middle = first + length / 2;
+    merge_sort(first, middle, buffer, comp);
+    merge_sort(middle, last, buffer, comp);
+    merge_adjacent(first, middle, last, buffer, comp);
+}
+
+/*!
+ * @brief Raw storage for the stable_sort() merge buffer, released however the sort ends
+ */
+template<typename T> struct sort_buffer
+{
+    T *data;
+
+    explicit sort_buffer(std::size_t count)
+    {
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            data = static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+        }
+        else
+        {
+            data = static_cast<T *>(::operator new(count * sizeof(T)));
+        }
+    }
+
+    sort_buffer(const sort_buffer &) = delete;
+    sort_buffer &operator=(const sort_buffer &) = delete;
+
+    ~sort_buffer()
+    {
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            ::operator delete(static_cast<void *>(data), std::align_val_t(alignof(T)));
+        }
+        else
+        {
+            ::operator delete(static_cast<void *>(data));
+        }
+    }
+};
+} // namespace detail
+
+/*!
+ * @brief Sorts [first, last) so that comp(*(it + 1), *it) is false everywhere
+ * @details Pattern-defeating quicksort: O(n log n) worst case, linear on sorted and all-equal input, and
+ * logarithmic stack depth. The order of equal elements is not preserved, use stable_sort() for that.
+ * @tparam Iterator A random access iterator
+ * @tparam Compare A strict weak ordering
+ * @param first Beginning of the range
+ * @param last End of the range
+ * @param comp The comparison
+ */
+template<typename Iterator, typename Compare> void sort(Iterator first, Iterator last, Compare comp)
+{
+    if (last - first < 2)
+    {
+        return;
+    }
+    STD_TRACE_SCOPE_VALUE("sort", static_cast<std::size_t>(last - first));
+    detail::pdqsort_loop<Iterator, Compare, detail::sort_branchless<Iterator, Compare>>(
+        first, last, comp, detail::floor_log2(static_cast<std::size_t>(last - first)), true);
+}
+
+template<typename Iterator> void sort(Iterator first, Iterator last)
+{
+    sort(first, last, std::less<>());
+}
+
 /*!
  * @brief Performs quicksort on a range
+ * @details Kept for existing callers; this is std::sort under its old name.
  * @tparam Iterator The iterator type
  * @tparam Compare The comparison function type
  * @param beg Beginning iterator
@@ -159,16 +845,565 @@ template<typename Iterator, typename Compare> Iterator partition(Iterator beg, I
  */
 template<typename Iterator, typename Compare> void quicksort(Iterator beg, Iterator end, Compare cmp)
 {
-    if (beg >= end)
+    sort(beg, end, cmp);
+}
+
+/*!
+ * @brief Sorts [first, last) and keeps equal elements in their original order
+ * @details Merge sort over insertion sorted runs. Allocates a buffer of half the range with the global operator new.
+ * @tparam Iterator A random access iterator
+ * @tparam Compare A strict weak ordering
+ */
+template<typename Iterator, typename Compare> void stable_sort(Iterator first, Iterator last, Compare comp)
+{
+    std::ptrdiff_t length = last - first;
+    if (length <= detail::sort_insertion_threshold)
+    {
+        detail::insertion_sort(first, last, comp);
+        return;
+    }
+    detail::sort_buffer<detail::iter_value_t<Iterator>> buffer(static_cast<std::size_t>(length / 2));
+    detail::merge_sort(first, last, buffer.data, comp);
+}
+
+template<typename Iterator> void stable_sort(Iterator first, Iterator last)
+{
+    stable_sort(first, last, std::less<>());
+}
+
+/*!
+ * @brief Places the smallest middle - first elements of [first, last), sorted, in [first, middle)
+ * @details Heap selection, O(n log k) for k = middle - first. The order of the remaining elements is unspecified.
+ */
+template<typename Iterator, typename Compare>
+void partial_sort(Iterator first, Iterator middle, Iterator last, Compare comp)
+{
+    if (first == middle)
+    {
+        return;
+    }
+    detail::make_heap(first, middle, comp);
+    std::ptrdiff_t length = middle - first;
+    for (Iterator it = middle; it != last; ++it)
+    {
+        if (comp(*it, *first))
+        {
+            iter_swap(it, first);
+            detail::sift_down(first, length, 0, comp);
+        }
+    }
+    detail::sort_heap(first, middle, comp);
+}
+
+template<typename Iterator> void partial_sort(Iterator first, Iterator middle, Iterator last)
+{
+    partial_sort(first, middle, last, std::less<>());
+}
+
+/*!
+ * @brief Reorders [first, last) so that *nth is the element a full sort would put there, with no greater element
+ * before it and no smaller one after it
+ * @details Quickselect on the sort partitioning, O(n) on average. After too many unbalanced partitions it falls
+ * back to partial_sort(), which bounds the worst case at O(n log n).
+ */
+template<typename Iterator, typename Compare>
+void nth_element(Iterator first, Iterator nth, Iterator last, Compare comp)
+{
+    if (nth == last)
+    {
+        return;
+    }
+    int bad_allowed = detail::floor_log2(static_cast<std::size_t>(last - first));
+    while (last - first > detail::sort_insertion_threshold)
+    {
+        std::ptrdiff_t size = last - first;
+        detail::choose_pivot(first, last, comp);
+        Iterator pivot_pos = detail::partition_right(first, last, comp).pivot;
+        if (pivot_pos == nth)
+        {
+            return;
+        }
+        std::ptrdiff_t l_size = pivot_pos - first;
+        std::ptrdiff_t r_size = last - (pivot_pos + 1);
+        if ((l_size < size / 8 || r_size < size / 8) && --bad_allowed <= 0)
+        {
+            if (nth < pivot_pos)
+            {
+                partial_sort(first, nth + 1, pivot_pos, comp);
+            }
+            else
+            {
+                partial_sort(pivot_pos + 1, nth + 1, last, comp);
+            }
+            return;
+        }
+        if (nth < pivot_pos)
+        {
+            last = pivot_pos;
+        }
+        else
+        {
+            first = pivot_pos + 1;
+        }
+    }
+    detail::insertion_sort(first, last, comp);
+}
+
+template<typename Iterator> void nth_element(Iterator first, Iterator nth, Iterator last)
+{
+    nth_element(first, nth, last, std::less<>());
+}
+
+/*!
+ * @brief Calls f on every element of [first, last) in order
+ * @return f
+ */
+template<typename InputIt, typename UnaryFunc> constexpr UnaryFunc for_each(InputIt first, InputIt last, UnaryFunc f)
+{
+    for (; first != last; ++first)
+    {
+        f(*first);
+    }
+    return f;
+}
+
+/*!
+ * @brief Writes op(x) for every x in [first, last) to the range starting at d_first
+ * @return The end of the written range
+ */
+template<typename InputIt, typename OutputIt, typename UnaryOp>
+constexpr OutputIt transform(InputIt first, InputIt last, OutputIt d_first, UnaryOp op)
+{
+    for (; first != last; (void)++first, (void)++d_first)
+    {
+        *d_first = op(*first);
+    }
+    return d_first;
+}
+namespace detail
+{
+#if defined(__GNUC__) || defined(__clang__)
+// Unaligned, alias-everything views used by the memory kernels so a word load never breaks strict aliasing
+typedef std::size_t __attribute__((__may_alias__, __aligned__(1))) unaligned_word;
+typedef unsigned int __attribute__((__may_alias__, __aligned__(1))) unaligned_u32;
+typedef unsigned short __attribute__((__may_alias__, __aligned__(1))) unaligned_u16;
+#else
+typedef std::size_t unaligned_word;
+typedef unsigned int unaligned_u32;
+typedef unsigned short unaligned_u16;
+#endif
+
+#if defined(STD_SIMD_AVX2) || defined(STD_SIMD_SSE2) || defined(STD_SIMD_NEON)
+#    define STD_SIMD_VECTOR 1
+#endif
+
+/*
+ * Scanning kernels read whole aligned blocks that may extend past the end of a string. An aligned block never
+ * crosses a page so this can not fault, but address sanitizer would still report it.
+ */
+#if defined(__GNUC__) || defined(__clang__)
+#    define STD_NO_SANITIZE_ADDRESS __attribute__((no_sanitize_address))
+#elif defined(_MSC_VER)
+#    define STD_NO_SANITIZE_ADDRESS __declspec(no_sanitize_address)
+#else
+#    define STD_NO_SANITIZE_ADDRESS
+#endif
+
+/*!
+ * @brief Index of the lowest set bit
+ * @param value A non-zero value
+ */
+constexpr inline unsigned int count_trailing_zeros(unsigned long long value) noexcept
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned int>(__builtin_ctzll(value));
+#else
+    unsigned int count = 0;
+    while ((value & 1u) == 0)
+    {
+        value >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+/*!
+ * @brief True if any byte of the word is zero (exact as a yes/no answer, not as a position)
+ */
+constexpr inline bool word_has_zero_byte(std::size_t word) noexcept
+{
+    constexpr std::size_t ones = static_cast<std::size_t>(-1) / 0xFF;
+    constexpr std::size_t highs = ones * 0x80;
+    return ((word - ones) & ~word & highs) != 0;
+}
+
+/*!
+ * @brief Vector register operations for the widest instruction set enabled at compile time
+ * @details Only one definition is active. Every load and store is unaligned, the kernels align the destination
+ *          themselves so the stores hit whole cache lines.
+ */
+#if defined(STD_SIMD_AVX2)
+struct simd_ops
+{
+    using type = __m256i;
+    static constexpr std::size_t width = 32;
+    static inline type load(const unsigned char *p) noexcept
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    }
+    // Load used by the string scanners, which may read past the end of the object within an aligned block
+    STD_NO_SANITIZE_ADDRESS static inline type scan_load(const unsigned char *p) noexcept
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+    }
+    static inline void store(unsigned char *p, type v) noexcept
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+    }
+    static inline type splat(unsigned char c) noexcept
+    {
+        return _mm256_set1_epi8(static_cast<char>(c));
+    }
+    using mask_type = unsigned int;
+    static constexpr unsigned int mask_bits_per_byte = 1;
+    static constexpr mask_type all_lanes = 0xFFFFFFFFu;
+    static inline mask_type eq_mask(type a, type b) noexcept
+    {
+        return static_cast<mask_type>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b)));
+    }
+    // 16-bit lanes, used to scan UTF-16 text; each lane sets two adjacent mask bits
+    static inline type splat16(unsigned short c) noexcept
+    {
+        return _mm256_set1_epi16(static_cast<short>(c));
+    }
+    static inline mask_type eq_mask16(type a, type b) noexcept
+    {
+        return static_cast<mask_type>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(a, b)));
+    }
+};
+#elif defined(STD_SIMD_SSE2)
+struct simd_ops
+{
+    using type = __m128i;
+    static constexpr std::size_t width = 16;
+    static inline type load(const unsigned char *p) noexcept
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    }
+    // Load used by the string scanners, which may read past the end of the object within an aligned block
+    STD_NO_SANITIZE_ADDRESS static inline type scan_load(const unsigned char *p) noexcept
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    }
+    static inline void store(unsigned char *p, type v) noexcept
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+    }
+    static inline type splat(unsigned char c) noexcept
+    {
+        return _mm_set1_epi8(static_cast<char>(c));
+    }
+    using mask_type = unsigned int;
+    static constexpr unsigned int mask_bits_per_byte = 1;
+    static constexpr mask_type all_lanes = 0xFFFFu;
+    static inline mask_type eq_mask(type a, type b) noexcept
+    {
+        return static_cast<mask_type>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)));
+    }
+    // 16-bit lanes, used to scan UTF-16 text; each lane sets two adjacent mask bits
+    static inline type splat16(unsigned short c) noexcept
+    {
+        return _mm_set1_epi16(static_cast<short>(c));
+    }
+    static inline mask_type eq_mask16(type a, type b) noexcept
+    {
+        return static_cast<mask_type>(_mm_movemask_epi8(_mm_cmpeq_epi16(a, b)));
+    }
+};
+#elif defined(STD_SIMD_NEON)
+struct simd_ops
+{
+    using type = uint8x16_t;
+    static constexpr std::size_t width = 16;
+    static inline type load(const unsigned char *p) noexcept
+    {
+        return vld1q_u8(p);
+    }
+    // Load used by the string scanners, which may read past the end of the object within an aligned block
+    STD_NO_SANITIZE_ADDRESS static inline type scan_load(const unsigned char *p) noexcept
+    {
+        return vld1q_u8(p);
+    }
+    static inline void store(unsigned char *p, type v) noexcept
+    {
+        vst1q_u8(p, v);
+    }
+    static inline type splat(unsigned char c) noexcept
+    {
+        return vdupq_n_u8(c);
+    }
+    // NEON has no movemask, narrowing the compare result keeps four bits per byte instead
+    using mask_type = unsigned long long;
+    static constexpr unsigned int mask_bits_per_byte = 4;
+    static constexpr mask_type all_lanes = ~0ull;
+    static inline mask_type eq_mask(type a, type b) noexcept
+    {
+        uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(a, b)), 4);
+        return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+    }
+    // 16-bit lanes, used to scan UTF-16 text; each lane sets eight adjacent mask bits
+    static inline type splat16(unsigned short c) noexcept
+    {
+        return vreinterpretq_u8_u16(vdupq_n_u16(c));
+    }
+    static inline mask_type eq_mask16(type a, type b) noexcept
+    {
+        uint16x8_t equal = vceqq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b));
+        uint8x8_t narrowed = vshrn_n_u16(equal, 4);
+        return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+    }
+};
+#else
+struct simd_ops
+{
+    using type = std::size_t;
+    static constexpr std::size_t width = sizeof(std::size_t);
+    static inline type load(const unsigned char *p) noexcept
+    {
+        return *reinterpret_cast<const unaligned_word *>(p);
+    }
+    static inline void store(unsigned char *p, type v) noexcept
+    {
+        *reinterpret_cast<unaligned_word *>(p) = v;
+    }
+    static inline type splat(unsigned char c) noexcept
+    {
+        return static_cast<std::size_t>(-1) / 0xFF * c;
+    }
+};
+#endif
+
+/*!
+ * @brief Moves fewer than simd_ops::width bytes
+ * @details Both halves of the range are loaded before either is stored, which makes this safe for overlapping
+ *          ranges in either direction.
+ */
+inline void move_small(unsigned char *dst, const unsigned char *src, std::size_t size) noexcept
+{
+#if defined(STD_SIMD_AVX2)
+    if (size >= 16)
+    {
+        __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + size - 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), head);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + size - 16), tail);
+        return;
+    }
+#endif
+    if (size >= sizeof(std::size_t))
+    {
+        std::size_t head = *reinterpret_cast<const unaligned_word *>(src);
+        std::size_t tail = *reinterpret_cast<const unaligned_word *>(src + size - sizeof(std::size_t));
+        *reinterpret_cast<unaligned_word *>(dst) = head;
+        *reinterpret_cast<unaligned_word *>(dst + size - sizeof(std::size_t)) = tail;
+        return;
+    }
+    if (size >= 4)
+    {
+        unsigned int head = *reinterpret_cast<const unaligned_u32 *>(src);
+        unsigned int tail = *reinterpret_cast<const unaligned_u32 *>(src + size - 4);
+        *reinterpret_cast<unaligned_u32 *>(dst) = head;
+        *reinterpret_cast<unaligned_u32 *>(dst + size - 4) = tail;
+        return;
+    }
+    if (size >= 2)
+    {
+        unsigned short head = *reinterpret_cast<const unaligned_u16 *>(src);
+        unsigned short tail = *reinterpret_cast<const unaligned_u16 *>(src + size - 2);
+        *reinterpret_cast<unaligned_u16 *>(dst) = head;
+        *reinterpret_cast<unaligned_u16 *>(dst + size - 2) = tail;
+        return;
+    }
+    if (size == 1)
+        *dst = *src;
+}
+
+/*!
+ * @brief Copies non-overlapping memory, aligning the destination to the vector width
+ */
+inline void copy_bytes(unsigned char *dst, const unsigned char *src, std::size_t size) noexcept
+{
+    constexpr std::size_t width = simd_ops::width;
+    if (size < width)
+    {
+        move_small(dst, src, size);
+        return;
+    }
+    if (size <= 2 * width)
+    {
+        simd_ops::type head = simd_ops::load(src);
+        simd_ops::type tail = simd_ops::load(src + size - width);
+        simd_ops::store(dst, head);
+        simd_ops::store(dst + size - width, tail);
+        return;
+    }
+
+    // Store an unaligned head, then advance so every following store is aligned
+    simd_ops::type tail = simd_ops::load(src + size - width);
+    simd_ops::store(dst, simd_ops::load(src));
+    std::size_t skip = width - (reinterpret_cast<std::uintptr_t>(dst) & (width - 1));
+    dst += skip;
+    src += skip;
+    size -= skip;
+
+    for (; size > 4 * width; size -= 4 * width, dst += 4 * width, src += 4 * width)
+    {
+        simd_ops::type a = simd_ops::load(src);
+        simd_ops::type b = simd_ops::load(src + width);
+        simd_ops::type c = simd_ops::load(src + 2 * width);
+        simd_ops::type d = simd_ops::load(src + 3 * width);
+        simd_ops::store(dst, a);
+        simd_ops::store(dst + width, b);
+        simd_ops::store(dst + 2 * width, c);
+        simd_ops::store(dst + 3 * width, d);
+    }
+    for (; size > width; size -= width, dst += width, src += width)
+        simd_ops::store(dst, simd_ops::load(src));
+
+    // The final block overlaps whatever the loops left behind
+    simd_ops::store(dst + size - width, tail);
+}
+
+/*!
+ * @brief Copies possibly overlapping memory front to back, for use when dst < src
+ */
+inline void move_bytes_forward(unsigned char *dst, const unsigned char *src, std::size_t size) noexcept
+{
+    constexpr std::size_t width = simd_ops::width;
+    if (size < width)
+    {
+        move_small(dst, src, size);
         return;
+    }
+    // Each block is loaded before any store can reach it, the tail is captured up front for the same reason
+    simd_ops::type tail = simd_ops::load(src + size - width);
+    std::size_t i = 0;
+    for (; i + 2 * width <= size; i += 2 * width)
+    {
+        simd_ops::type a = simd_ops::load(src + i);
+        simd_ops::type b = simd_ops::load(src + i + width);
+        simd_ops::store(dst + i, a);
+        simd_ops::store(dst + i + width, b);
+    }
+    for (; i + width <= size; i += width)
+        simd_ops::store(dst + i, simd_ops::load(src + i));
+    simd_ops::store(dst + size - width, tail);
+}
 
-    // Partition the range [beg, end) and get the pivot element's position
-    Iterator pivot = partition(beg, end, cmp);
+/*!
+ * @brief Copies possibly overlapping memory back to front, for use when dst > src
+ */
+inline void move_bytes_backward(unsigned char *dst, const unsigned char *src, std::size_t size) noexcept
+{
+    constexpr std::size_t width = simd_ops::width;
+    if (size < width)
+    {
+        move_small(dst, src, size);
+        return;
+    }
+    simd_ops::type head = simd_ops::load(src);
+    std::size_t i = size;
+    for (; i >= 2 * width; i -= 2 * width)
+    {
+        simd_ops::type a = simd_ops::load(src + i - width);
+        simd_ops::type b = simd_ops::load(src + i - 2 * width);
+        simd_ops::store(dst + i - width, a);
+        simd_ops::store(dst + i - 2 * width, b);
+    }
+    for (; i >= width; i -= width)
+        simd_ops::store(dst + i - width, simd_ops::load(src + i - width));
+    simd_ops::store(dst, head);
+}
 
-    // Recursively sort the two halves
-    quicksort(beg, pivot, cmp);     // Sort the left half
-    quicksort(pivot + 1, end, cmp); // Sort the right half
+/*!
+ * @brief Fills memory with a byte value, aligning the destination to the vector width
+ */
+inline void set_bytes(unsigned char *dst, unsigned char value, std::size_t size) noexcept
+{
+    constexpr std::size_t width = simd_ops::width;
+    if (size < width)
+    {
+        if (size >= sizeof(std::size_t))
+        {
+            std::size_t word = static_cast<std::size_t>(-1) / 0xFF * value;
+            for (std::size_t i = 0; i + sizeof(std::size_t) <= size; i += sizeof(std::size_t))
+                *reinterpret_cast<unaligned_word *>(dst + i) = word;
+            *reinterpret_cast<unaligned_word *>(dst + size - sizeof(std::size_t)) = word;
+            return;
+        }
+        for (std::size_t i = 0; i < size; i++)
+            dst[i] = value;
+        return;
+    }
+    simd_ops::type v = simd_ops::splat(value);
+    simd_ops::store(dst, v);
+    simd_ops::store(dst + size - width, v);
+    std::size_t skip = width - (reinterpret_cast<std::uintptr_t>(dst) & (width - 1));
+    unsigned char *end = dst + size - width;
+    for (dst += skip; dst + 4 * width <= end; dst += 4 * width)
+    {
+        simd_ops::store(dst, v);
+        simd_ops::store(dst + width, v);
+        simd_ops::store(dst + 2 * width, v);
+        simd_ops::store(dst + 3 * width, v);
+    }
+    for (; dst < end; dst += width)
+        simd_ops::store(dst, v);
 }
+
+/*!
+ * @brief Compares two memory blocks a vector (or word) at a time
+ * @details Equal blocks are skipped with a single compare, the first mismatching lane is then located from the
+ *          compare mask so only one byte pair is ever compared individually.
+ */
+inline int compare_bytes(const unsigned char *a, const unsigned char *b, std::size_t size) noexcept
+{
+    std::size_t i = 0;
+#if defined(STD_SIMD_VECTOR)
+    constexpr std::size_t width = simd_ops::width;
+    if (size >= width)
+    {
+        for (;; i += width)
+        {
+            // The last block is realigned to end at size, re-comparing a few already equal bytes
+            if (i + width > size)
+                i = size - width;
+            simd_ops::mask_type eq = simd_ops::eq_mask(simd_ops::load(a + i), simd_ops::load(b + i));
+            if (eq != simd_ops::all_lanes)
+            {
+                std::size_t lane = count_trailing_zeros(~eq) / simd_ops::mask_bits_per_byte;
+                return a[i + lane] < b[i + lane] ? -1 : 1;
+            }
+            if (i + width == size)
+                return 0;
+        }
+    }
+#endif
+    for (; i + sizeof(std::size_t) <= size; i += sizeof(std::size_t))
+    {
+        if (*reinterpret_cast<const unaligned_word *>(a + i) != *reinterpret_cast<const unaligned_word *>(b + i))
+            break;
+    }
+    for (; i < size; i++)
+    {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+} // namespace detail
+
 /*!
  * @brief Compares two memory blocks
  * @param aptr Pointer to first memory block
@@ -176,71 +1411,103 @@ template<typename Iterator, typename Compare> void quicksort(Iterator beg, Itera
  * @param size Number of bytes to compare
  * @return -1 if first block is less, 1 if second block is less, 0 if equal
  */
-inline int memcmp(const void *aptr, const void *bptr, unsigned long size)
+constexpr inline int memcmp(const void *aptr, const void *bptr, unsigned long size)
 {
     const unsigned char *a = static_cast<const unsigned char *>(aptr);
     const unsigned char *b = static_cast<const unsigned char *>(bptr);
-    for (unsigned long i = 0; i < size; i++)
+    if (__builtin_is_constant_evaluated())
     {
-        if (a[i] < b[i])
-            return -1;
-        else if (b[i] < a[i])
-            return 1;
+        for (unsigned long i = 0; i < size; i++)
+        {
+            if (a[i] < b[i])
+                return -1;
+            else if (b[i] < a[i])
+                return 1;
+        }
+        return 0;
     }
-    return 0;
+    return detail::compare_bytes(a, b, size);
 }
 /*!
  * @brief Copies memory from source to destination
+ * @details Large copies are performed with the widest vector registers selected at compile time, with the
+ *          destination aligned to the vector width. Small copies use overlapping word moves and constant
+ *          evaluation falls back to a plain byte loop.
  * @param dstptr Destination pointer
  * @param srcptr Source pointer
  * @param size Number of bytes to copy
  * @return Pointer to the destination memory
+ * @note The source and destination ranges must not overlap, use memmove() for overlapping ranges
  */
-inline void *memcpy(void *dstptr, const void *srcptr, unsigned long size)
+constexpr inline void *memcpy(void *dstptr, const void *srcptr, unsigned long size)
 {
     if (!dstptr || !srcptr)
         return nullptr; // Check for null pointers
     unsigned char *dst = static_cast<unsigned char *>(dstptr);
     const unsigned char *src = static_cast<const unsigned char *>(srcptr);
-    for (unsigned long i = 0; i < size; i++)
-        dst[i] = src[i];
+    if (__builtin_is_constant_evaluated())
+    {
+        for (unsigned long i = 0; i < size; i++)
+            dst[i] = src[i];
+        return dstptr;
+    }
+    detail::copy_bytes(dst, src, size);
     return dstptr;
 }
 /*!
  * @brief Sets a block of memory to a specific value
+ * @details The value is broadcast into a vector register and written with aligned stores, the unaligned head and
+ *          tail of the block are covered by overlapping stores.
  * @param bufptr Pointer to the memory block
  * @param value Value to set
  * @param size Number of bytes to set
  * @return Pointer to the memory block
  */
-inline void *memset(void *bufptr, int value, unsigned long size)
+constexpr inline void *memset(void *bufptr, int value, unsigned long size)
 {
     unsigned char *buf = static_cast<unsigned char *>(bufptr);
-    for (unsigned long i = 0; i < size; i++)
-        buf[i] = static_cast<unsigned char>(value);
+    if (__builtin_is_constant_evaluated())
+    {
+        for (unsigned long i = 0; i < size; i++)
+            buf[i] = static_cast<unsigned char>(value);
+        return bufptr;
+    }
+    detail::set_bytes(buf, static_cast<unsigned char>(value), size);
     return bufptr;
 }
 /*!
  * @brief Moves memory from source to destination, handling overlapping regions
+ * @details Every block is loaded before the store that could overwrite it, copying forwards when the destination
+ *          is below the source and backwards otherwise.
  * @param dstptr Destination pointer
  * @param srcptr Source pointer
  * @param size Number of bytes to move
  * @return Pointer to the destination memory
  */
-inline void *memmove(void *dstptr, const void *srcptr, unsigned long size)
+constexpr inline void *memmove(void *dstptr, const void *srcptr, unsigned long size)
 {
     unsigned char *dst = static_cast<unsigned char *>(dstptr);
     const unsigned char *src = static_cast<const unsigned char *>(srcptr);
-    if (dst < src)
+    if (__builtin_is_constant_evaluated())
     {
-        for (unsigned long i = 0; i < size; i++)
-            dst[i] = src[i];
+        if (dst < src)
+        {
+            for (unsigned long i = 0; i < size; i++)
+                dst[i] = src[i];
+        }
+        else
+        {
+            for (unsigned long i = size; i != 0; i--)
+                dst[i - 1] = src[i - 1];
+        }
+        return dstptr;
     }
+    if (dst == src || size == 0)
+        return dstptr;
+    if (dst < src)
+        detail::move_bytes_forward(dst, src, size);
     else
-    {
-        for (unsigned long i = size; i != 0; i--)
-            dst[i - 1] = src[i - 1];
-    }
+        detail::move_bytes_backward(dst, src, size);
     return dstptr;
 }
 } // namespace std
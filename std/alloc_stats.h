@@ -0,0 +1,498 @@
+/*!
+ * @file alloc_stats.h
+ * @brief Allocation accounting between the global operator new/delete and the allocator below them
+ * @details Enabled by defining STD_ENABLE_ALLOC_STATS for the whole program, which the ENABLE_ALLOC_STATS CMake option
+ * does. new.h then sends every global operator new and delete through this layer before the memory pool or the os::
+ * hooks. Each block gets a small header holding its size and tag, so a freed block is accounted without asking the
+ * allocator for its size; memory allocated with the layer must never be released by a translation unit built
+ * without it. The os realloc hooks are not used in this mode, as they would not see the header.
+ *
+ * The layer counts bytes in use and their peak, allocations and frees, and a histogram of requested sizes in
+ * power-of-two classes. vector and basic_string report every change of their capacity, so the counters also show how
+ * often containers grow, how many bytes growth moves, and how much capacity it hands out beyond what was needed.
+ *
+ * Allocations are attributed to the tag current on the calling thread, set for a scope by STD_ALLOC_TAG("name").
+ * Tags are matched by their text, and up to max_tags - 1 distinct ones are kept; allocations after that, and those
+ * made without a tag, count as untagged. Counters are updated with relaxed atomics, so a snapshot taken while other
+ * threads allocate is consistent per counter but not across them.
+ *
+ * @section usage Reading the counters
+ * std::alloc_stats::snapshot() and std::alloc_stats::tag() return copies of the counters, and
+ * std::alloc_stats::dump() writes them as text through a print function such as the test runner's print().
+ *
+ * @note This header is included by new.h and is not meant to be included directly.
+ */
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+#if !defined(NEW_H)
+#    error "alloc_stats.h is included through new.h"
+#endif
+#include <stddef.h>
+
+namespace std
+{
+namespace alloc_stats
+{
+inline constexpr std::size_t histogram_buckets = 32; //!< Size classes of the histogram, see bucket_of().
+inline constexpr std::size_t max_tags = 64;          //!< Tags kept, including the untagged row 0.
+
+/*!
+ * @brief Copy of the global counters
+ */
+struct counters
+{
+    std::size_t current_bytes;    //!< Bytes requested by blocks not freed yet.
+    std::size_t peak_bytes;       //!< Highest current_bytes seen since the start or the last reset().
+    std::size_t total_bytes;      //!< Bytes requested by all allocations.
+    std::size_t allocations;      //!< Calls to operator new.
+    std::size_t frees;            //!< Calls to operator delete with a block.
+    std::size_t growths;          //!< Capacity changes of vectors and strings, first allocations included.
+    std::size_t in_place_growths; //!< Growths that extended the block where it was.
+    std::size_t moved_bytes;      //!< Bytes of elements moved to a new block by growth.
+    std::size_t slack_bytes;      //!< Capacity beyond the elements held, summed over growths.
+    std::size_t histogram[histogram_buckets]; //!< Allocations by requested size, see bucket_of().
+};
+
+/*!
+ * @brief Copy of the counters of one tag
+ */
+struct tag_counters
+{
+    const char *name; //!< The tag, "untagged" for row 0, nullptr for an unused row.
+    std::size_t current_bytes;
+    std::size_t total_bytes;
+    std::size_t allocations;
+    std::size_t frees;
+    std::size_t growths;
+};
+
+/*!
+ * @brief Histogram bucket of a request of size bytes
+ * @details Bucket 0 holds requests of up to 1 byte and bucket i those of 2^(i-1) + 1 to 2^i bytes; the last bucket
+ * also takes everything larger.
+ */
+constexpr std::size_t bucket_of(std::size_t size) noexcept
+{
+    std::size_t bucket = 0;
+    for (std::size_t limit = 1; limit < size && bucket < histogram_buckets - 1; limit <<= 1)
+    {
+        ++bucket;
+    }
+    return bucket;
+}
+} // namespace alloc_stats
+
+namespace detail
+{
+/*!
+ * @brief Written in front of every block handed out by the global operator new.
+ */
+struct alloc_header
+{
+    std::size_t size;    //!< Bytes requested.
+    unsigned int tag;    //!< Row of the tag that allocated the block.
+    unsigned int offset; //!< Distance from the start of the underlying block to the caller's block.
+};
+
+//! Bytes kept in front of a block of default alignment, which keeps the caller's block aligned as well.
+inline constexpr std::size_t alloc_header_space = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+static_assert(sizeof(alloc_header) <= alloc_header_space);
+
+struct alloc_tag_row
+{
+    const char *name;
+    std::size_t current_bytes;
+    std::size_t total_bytes;
+    std::size_t allocations;
+    std::size_t frees;
+    std::size_t growths;
+};
+
+struct alloc_state
+{
+    std::size_t current_bytes;
+    std::size_t peak_bytes;
+    std::size_t total_bytes;
+    std::size_t allocations;
+    std::size_t frees;
+    std::size_t growths;
+    std::size_t in_place_growths;
+    std::size_t moved_bytes;
+    std::size_t slack_bytes;
+    std::size_t histogram[alloc_stats::histogram_buckets];
+    alloc_tag_row tags[alloc_stats::max_tags];
+};
+
+inline alloc_state alloc_global{};
+
+//! Row of the tag current on this thread, 0 when there is none.
+inline thread_local unsigned int alloc_current_tag = 0;
+
+inline void alloc_add(std::size_t &counter, std::size_t value) noexcept
+{
+    __atomic_fetch_add(&counter, value, __ATOMIC_RELAXED);
+}
+
+inline void alloc_sub(std::size_t &counter, std::size_t value) noexcept
+{
+    __atomic_fetch_sub(&counter, value, __ATOMIC_RELAXED);
+}
+
+inline std::size_t alloc_load(const std::size_t &counter) noexcept
+{
+    return __atomic_load_n(&counter, __ATOMIC_RELAXED);
+}
+
+inline bool alloc_same_name(const char *a, const char *b) noexcept
+{
+    for (; *a != '\0' && *a == *b; ++a, ++b)
+    {
+    }
+    return *a == *b;
+}
+
+/*!
+ * @brief Finds or claims the row of the tag name, falling back to the untagged row once every row is taken.
+ */
+inline unsigned int alloc_tag_row_of(const char *name) noexcept
+{
+    for (unsigned int row = 1; row < alloc_stats::max_tags; ++row)
+    {
+        const char *existing = __atomic_load_n(&alloc_global.tags[row].name, __ATOMIC_ACQUIRE);
+        if (existing == nullptr &&
+            __atomic_compare_exchange_n(&alloc_global.tags[row].name, &existing, name, false, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE))
+        {
+            return row;
+        }
+        // A failed claim left the winning name in existing
+        if (alloc_same_name(existing, name))
+        {
+            return row;
+        }
+    }
+    return 0;
+}
+
+/*!
+ * @brief Where the global operator new and delete get their memory when the layer is off.
+ */
+enum class alloc_form : unsigned char
+{
+    single,
+    array,
+    aligned
+};
+
+inline void *alloc_backend_allocate(std::size_t size, std::size_t alignment, alloc_form form) noexcept
+{
+#if defined(STD_ENABLE_MEMORY_POOL)
+    (void)form;
+    return memory_pool::allocate(size, alignment);
+#else
+    switch (form)
+    {
+    case alloc_form::single:
+        return os::operator_new(size);
+    case alloc_form::array:
+        return os::operator_new_array(size);
+    case alloc_form::aligned:
+        break;
+    }
+    return os::operator_new_aligned(size, alignment);
+#endif
+}
+
+inline void alloc_backend_deallocate(void *ptr, alloc_form form) noexcept
+{
+#if defined(STD_ENABLE_MEMORY_POOL)
+    (void)form;
+    memory_pool::deallocate(ptr);
+#else
+    if (form == alloc_form::array)
+    {
+        os::operator_delete_array(ptr);
+    }
+    else
+    {
+        os::operator_delete(ptr);
+    }
+#endif
+}
+
+inline alloc_header *alloc_header_of(void *ptr) noexcept
+{
+    return reinterpret_cast<alloc_header *>(static_cast<unsigned char *>(ptr) - sizeof(alloc_header));
+}
+
+/*!
+ * @brief Allocates size bytes with a header in front and accounts for them.
+ * @return The block, or nullptr if the allocator below is out of memory.
+ */
+inline void *alloc_tracked_allocate(std::size_t size, std::size_t alignment, alloc_form form) noexcept
+{
+    std::size_t offset = alignment > alloc_header_space ? alignment : alloc_header_space;
+    if (size > static_cast<std::size_t>(-1) - offset)
+    {
+        return nullptr;
+    }
+    void *base = alloc_backend_allocate(size + offset, alignment, form);
+    if (base == nullptr)
+    {
+        return nullptr;
+    }
+    void *ptr = static_cast<unsigned char *>(base) + offset;
+    unsigned int tag = alloc_current_tag;
+    *alloc_header_of(ptr) = alloc_header{size, tag, static_cast<unsigned int>(offset)};
+
+    alloc_add(alloc_global.allocations, 1);
+    alloc_add(alloc_global.total_bytes, size);
+    alloc_add(alloc_global.histogram[alloc_stats::bucket_of(size)], 1);
+    std::size_t current = __atomic_add_fetch(&alloc_global.current_bytes, size, __ATOMIC_RELAXED);
+    std::size_t peak = alloc_load(alloc_global.peak_bytes);
+    while (current > peak && !__atomic_compare_exchange_n(&alloc_global.peak_bytes, &peak, current, true,
+                                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+
+    alloc_tag_row &row = alloc_global.tags[tag];
+    alloc_add(row.allocations, 1);
+    alloc_add(row.total_bytes, size);
+    alloc_add(row.current_bytes, size);
+    return ptr;
+}
+
+/*!
+ * @brief Accounts for and releases a block from alloc_tracked_allocate(). Does nothing for nullptr.
+ */
+inline void alloc_tracked_deallocate(void *ptr, alloc_form form) noexcept
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    alloc_header header = *alloc_header_of(ptr);
+    alloc_add(alloc_global.frees, 1);
+    alloc_sub(alloc_global.current_bytes, header.size);
+    alloc_tag_row &row = alloc_global.tags[header.tag];
+    alloc_add(row.frees, 1);
+    alloc_sub(row.current_bytes, header.size);
+    alloc_backend_deallocate(static_cast<unsigned char *>(ptr) - header.offset, form);
+}
+
+/*!
+ * @brief Records a container changing its capacity from old_bytes to new_bytes while holding used_bytes.
+ * @param in_place Whether the block was extended where it was, so no element moved.
+ */
+inline void alloc_note_growth(std::size_t used_bytes, std::size_t old_bytes, std::size_t new_bytes,
+                              bool in_place) noexcept
+{
+    (void)old_bytes;
+    alloc_add(alloc_global.growths, 1);
+    alloc_add(alloc_global.tags[alloc_current_tag].growths, 1);
+    if (in_place)
+    {
+        alloc_add(alloc_global.in_place_growths, 1);
+    }
+    else
+    {
+        alloc_add(alloc_global.moved_bytes, used_bytes);
+    }
+    alloc_add(alloc_global.slack_bytes, new_bytes > used_bytes ? new_bytes - used_bytes : 0);
+}
+
+/*!
+ * @brief Fixed-size line buffer for dump(), which must not allocate.
+ */
+struct alloc_line
+{
+    char text[160];
+    std::size_t length = 0;
+
+    alloc_line &operator<<(const char *str) noexcept
+    {
+        for (; *str != '\0' && length < sizeof(text) - 1; ++str)
+        {
+            text[length++] = *str;
+        }
+        return *this;
+    }
+
+    alloc_line &operator<<(std::size_t value) noexcept
+    {
+        char digits[24];
+        std::size_t count = 0;
+        do
+        {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        while (count > 0 && length < sizeof(text) - 1)
+        {
+            text[length++] = digits[--count];
+        }
+        return *this;
+    }
+
+    const char *finish() noexcept
+    {
+        text[length] = '\0';
+        length = 0;
+        return text;
+    }
+};
+} // namespace detail
+
+namespace alloc_stats
+{
+inline counters snapshot() noexcept
+{
+    const detail::alloc_state &state = detail::alloc_global;
+    counters result{};
+    result.current_bytes = detail::alloc_load(state.current_bytes);
+    result.peak_bytes = detail::alloc_load(state.peak_bytes);
+    result.total_bytes = detail::alloc_load(state.total_bytes);
+    result.allocations = detail::alloc_load(state.allocations);
+    result.frees = detail::alloc_load(state.frees);
+    result.growths = detail::alloc_load(state.growths);
+    result.in_place_growths = detail::alloc_load(state.in_place_growths);
+    result.moved_bytes = detail::alloc_load(state.moved_bytes);
+    result.slack_bytes = detail::alloc_load(state.slack_bytes);
+    for (std::size_t bucket = 0; bucket < histogram_buckets; ++bucket)
+    {
+        result.histogram[bucket] = detail::alloc_load(state.histogram[bucket]);
+    }
+    return result;
+}
+
+/*!
+ * @brief Counters of tag row index, which must be below max_tags
+ */
+inline tag_counters tag(std::size_t index) noexcept
+{
+    const detail::alloc_tag_row &row = detail::alloc_global.tags[index];
+    const char *name = index == 0 ? "untagged" : __atomic_load_n(&row.name, __ATOMIC_ACQUIRE);
+    return tag_counters{name,
+                        detail::alloc_load(row.current_bytes),
+                        detail::alloc_load(row.total_bytes),
+                        detail::alloc_load(row.allocations),
+                        detail::alloc_load(row.frees),
+                        detail::alloc_load(row.growths)};
+}
+
+/*!
+ * @brief Counters of the tag name, or all zeros if no allocation was ever made under it
+ */
+inline tag_counters tag(const char *name) noexcept
+{
+    for (std::size_t index = 1; index < max_tags; ++index)
+    {
+        tag_counters result = tag(index);
+        if (result.name != nullptr && detail::alloc_same_name(result.name, name))
+        {
+            return result;
+        }
+    }
+    return tag_counters{name, 0, 0, 0, 0, 0};
+}
+
+/*!
+ * @brief Zeroes the running totals and sets the peak to the bytes in use now
+ * @details Bytes in use are left alone, as the blocks behind them are still to be freed.
+ */
+inline void reset() noexcept
+{
+    detail::alloc_state &state = detail::alloc_global;
+    std::size_t *totals[] = {&state.total_bytes, &state.allocations,      &state.frees,
+                             &state.growths,     &state.in_place_growths, &state.moved_bytes,
+                             &state.slack_bytes};
+    for (std::size_t *counter : totals)
+    {
+        __atomic_store_n(counter, 0, __ATOMIC_RELAXED);
+    }
+    for (std::size_t &bucket : state.histogram)
+    {
+        __atomic_store_n(&bucket, 0, __ATOMIC_RELAXED);
+    }
+    for (detail::alloc_tag_row &row : state.tags)
+    {
+        __atomic_store_n(&row.total_bytes, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&row.allocations, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&row.frees, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&row.growths, 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&state.peak_bytes, detail::alloc_load(state.current_bytes), __ATOMIC_RELAXED);
+}
+
+/*!
+ * @brief Writes the counters as text, one line per call of print
+ * @details Empty histogram buckets and unused tags are left out. Nothing is allocated, so dump() may be called from
+ * anywhere, including while tracking down a leak.
+ */
+inline void dump(void (*print)(const char *)) noexcept
+{
+    counters totals = snapshot();
+    detail::alloc_line line;
+    print((line << "alloc stats: current " << totals.current_bytes << " B, peak " << totals.peak_bytes
+                << " B, total " << totals.total_bytes << " B in " << totals.allocations << " allocations, "
+                << totals.frees << " frees\n")
+              .finish());
+    print((line << "  container growth: " << totals.growths << " (" << totals.in_place_growths << " in place), moved "
+                << totals.moved_bytes << " B, slack " << totals.slack_bytes << " B\n")
+              .finish());
+    for (std::size_t bucket = 0; bucket < histogram_buckets; ++bucket)
+    {
+        if (totals.histogram[bucket] != 0)
+        {
+            print((line << "  size <= " << (std::size_t(1) << bucket) << (bucket == histogram_buckets - 1 ? "+" : "")
+                        << ": " << totals.histogram[bucket] << "\n")
+                      .finish());
+        }
+    }
+    for (std::size_t index = 0; index < max_tags; ++index)
+    {
+        tag_counters row = tag(index);
+        if (row.name != nullptr && row.allocations + row.growths != 0)
+        {
+            print((line << "  tag " << row.name << ": current " << row.current_bytes << " B, total "
+                        << row.total_bytes << " B in " << row.allocations << " allocations, " << row.frees
+                        << " frees, " << row.growths << " growths\n")
+                      .finish());
+        }
+    }
+}
+
+/*!
+ * @brief Attributes the allocations of the calling thread to a tag until the end of the scope
+ * @details Scopes nest; the previous tag comes back when the inner one ends. name must outlive the program's last
+ * use of the counters, a string literal in practice. Use it through STD_ALLOC_TAG, which compiles to nothing when
+ * the layer is off.
+ */
+class scoped_tag
+{
+  public:
+    explicit scoped_tag(const char *name) noexcept
+        : _previous(detail::alloc_current_tag)
+    {
+        detail::alloc_current_tag = detail::alloc_tag_row_of(name);
+    }
+
+    scoped_tag(const scoped_tag &) = delete;
+    scoped_tag &operator=(const scoped_tag &) = delete;
+
+    ~scoped_tag()
+    {
+        detail::alloc_current_tag = _previous;
+    }
+
+  private:
+    unsigned int _previous;
+};
+} // namespace alloc_stats
+} // namespace std
+
+#define STD_ALLOC_TAG_JOIN2(a, b) a##b
+#define STD_ALLOC_TAG_JOIN(a, b) STD_ALLOC_TAG_JOIN2(a, b)
+#define STD_ALLOC_TAG(name) std::alloc_stats::scoped_tag STD_ALLOC_TAG_JOIN(std_alloc_tag_, __LINE__)(name)
+#endif
@@ -0,0 +1,576 @@
+/*!
+ * @file atomic.h
+ * @brief Atomic objects and references built on the compiler's __atomic builtins
+ * @namespace std
+ * @note This header is a part of the C++ standard library.
+ * Modeled after https://en.cppreference.com/w/cpp/atomic/atomic. Needs no runtime support: every operation is a
+ * builtin, which compiles to the target's atomic instructions when T is lock-free and to calls into libatomic
+ * otherwise. atomic<T> holds any trivially copyable T; integers get the fetch-and-modify operations and pointers
+ * fetch_add() and fetch_sub() in elements. atomic_ref<T> applies the same operations to an object it does not own.
+ */
+#ifndef ATOMIC_H
+#define ATOMIC_H
+#include <stddef.h>
+#include <type_traits.h>
+
+namespace std
+{
+enum class memory_order : int
+{
+    relaxed,
+    consume,
+    acquire,
+    release,
+    acq_rel,
+    seq_cst
+};
+
+inline constexpr memory_order memory_order_relaxed = memory_order::relaxed;
+inline constexpr memory_order memory_order_consume = memory_order::consume;
+inline constexpr memory_order memory_order_acquire = memory_order::acquire;
+inline constexpr memory_order memory_order_release = memory_order::release;
+inline constexpr memory_order memory_order_acq_rel = memory_order::acq_rel;
+inline constexpr memory_order memory_order_seq_cst = memory_order::seq_cst;
+
+namespace detail
+{
+/*!
+ * @brief The distance two objects written by different threads keep so they never share a cache line
+ * @details 128 where cores fetch lines in adjacent pairs or use 128-byte lines, 64 elsewhere. A constant of the
+ * library's own, unlike std::hardware_destructive_interference_size, so it cannot change with the tuning flags.
+ */
+#if (defined(__aarch64__) && defined(__APPLE__)) || defined(__powerpc64__)
+inline constexpr std::size_t cache_line_size = 128;
+#else
+inline constexpr std::size_t cache_line_size = 64;
+#endif
+
+//! The __ATOMIC_ constant for order; constant-folds when order is a constant.
+constexpr int builtin_order(memory_order order) noexcept
+{
+    switch (order)
+    {
+    case memory_order::relaxed:
+        return __ATOMIC_RELAXED;
+    case memory_order::consume:
+        return __ATOMIC_CONSUME;
+    case memory_order::acquire:
+        return __ATOMIC_ACQUIRE;
+    case memory_order::release:
+        return __ATOMIC_RELEASE;
+    case memory_order::acq_rel:
+        return __ATOMIC_ACQ_REL;
+    case memory_order::seq_cst:
+        break;
+    }
+    return __ATOMIC_SEQ_CST;
+}
+
+//! The order a failed compare-exchange loads with when only the success order is given.
+constexpr memory_order failure_order(memory_order order) noexcept
+{
+    switch (order)
+    {
+    case memory_order::release:
+        return memory_order::relaxed;
+    case memory_order::acq_rel:
+        return memory_order::acquire;
+    default:
+        return order;
+    }
+}
+
+/*!
+ * @brief The reads atomic and atomic_ref share, on the object Derived::object() points to
+ * @details Values are copied whole through the generic builtins, so T may be any trivially copyable type.
+ */
+template<typename T, typename Derived> class atomic_load_operations
+{
+    static_assert(is_trivially_copyable_v<T>, "atomic needs a trivially copyable type");
+
+  public:
+    using value_type = T;
+
+    static constexpr bool is_always_lock_free = __atomic_always_lock_free(sizeof(T), 0);
+
+    //! Alignment the object needs for the operations to be lock-free whenever they can be.
+    static constexpr std::size_t required_alignment =
+        (sizeof(T) & (sizeof(T) - 1)) == 0 && sizeof(T) <= 16 && sizeof(T) > alignof(T) ? sizeof(T) : alignof(T);
+
+    bool is_lock_free() const noexcept
+    {
+        return __atomic_is_lock_free(sizeof(T), source());
+    }
+
+    T load(memory_order order = memory_order::seq_cst) const noexcept
+    {
+        alignas(T) unsigned char result[sizeof(T)];
+        __atomic_load(source(), reinterpret_cast<T *>(result), builtin_order(order));
+        return *reinterpret_cast<T *>(result);
+    }
+
+    operator T() const noexcept
+    {
+        return load();
+    }
+
+  private:
+    const T *source() const noexcept
+    {
+        return static_cast<const Derived *>(this)->object();
+    }
+};
+
+/*!
+ * @brief The modifications atomic and atomic_ref share, on top of the reads
+ * @details Shared is whether the object is owned elsewhere. An atomic_ref only refers to its object, so its
+ * operations are const, like the standard's; an atomic is only modified through a non-const reference. Each
+ * operation is therefore written in both forms, of which a given Derived gets exactly one.
+ */
+template<typename T, typename Derived, bool Shared> class atomic_operations : public atomic_load_operations<T, Derived>
+{
+  public:
+    void store(T value, memory_order order = memory_order::seq_cst) noexcept
+        requires(!Shared)
+    {
+        __atomic_store(target(), &value, builtin_order(order));
+    }
+
+    void store(T value, memory_order order = memory_order::seq_cst) const noexcept
+        requires(Shared)
+    {
+        __atomic_store(target(), &value, builtin_order(order));
+    }
+
+    T exchange(T value, memory_order order = memory_order::seq_cst) noexcept
+        requires(!Shared)
+    {
+        alignas(T) unsigned char result[sizeof(T)];
+        __atomic_exchange(target(), &value, reinterpret_cast<T *>(result), builtin_order(order));
+        return *reinterpret_cast<T *>(result);
+    }
+
+    T exchange(T value, memory_order order = memory_order::seq_cst) const noexcept
+        requires(Shared)
+    {
+        alignas(T) unsigned char result[sizeof(T)];
+        __atomic_exchange(target(), &value, reinterpret_cast<T *>(result), builtin_order(order));
+        return *reinterpret_cast<T *>(result);
+    }
+
+    /*!
+     * @brief Replaces the value with desired if it equals expected, or loads it into expected otherwise
+     * @details Compares the object representations, so padding bits take part. The weak form may fail spuriously
+     * and belongs in a retry loop.
+     */
+    bool compare_exchange_weak(T &expected, T desired, memory_order success, memory_order failure) noexcept
+        requires(!Shared)
+    {
+        return __atomic_compare_exchange(target(), &expected, &desired, true, builtin_order(success),
+                                         builtin_order(failure));
+    }
+
+    bool compare_exchange_weak(T &expected, T desired, memory_order success, memory_order failure) const noexcept
+        requires(Shared)
+    {
+        return __atomic_compare_exchange(target(), &expected, &desired, true, builtin_order(success),
+                                         builtin_order(failure));
+    }
+
+    bool compare_exchange_weak(T &expected, T desired, memory_order order = memory_order::seq_cst) noexcept
+        requires(!Shared)
+    {
+        return compare_exchange_weak(expected, desired, order, failure_order(order));
+    }
+
+    bool compare_exchange_weak(T &expected, T desired, memory_order order = memory_order::seq_cst) const noexcept
+        requires(Shared)
+    {
+        return compare_exchange_weak(expected, desired, order, failure_order(order));
+    }
+
+    bool compare_exchange_strong(T &expected, T desired, memory_order success, memory_order failure) noexcept
+        requires(!Shared)
+    {
+        return __atomic_compare_exchange(target(), &expected, &desired, false, builtin_order(success),
+                                         builtin_order(failure));
+    }
+
+    bool compare_exchange_strong(T &expected, T desired, memory_order success, memory_order failure) const noexcept
+        requires(Shared)
+    {
+        return __atomic_compare_exchange(target(), &expected, &desired, false, builtin_order(success),
+                                         builtin_order(failure));
+    }
+
+    bool compare_exchange_strong(T &expected, T desired, memory_order order = memory_order::seq_cst) noexcept
+        requires(!Shared)
+    {
+        return compare_exchange_strong(expected, desired, order, failure_order(order));
+    }
+
+    bool compare_exchange_strong(T &expected, T desired, memory_order order = memory_order::seq_cst) const noexcept
+        requires(Shared)
+    {
+        return compare_exchange_strong(expected, desired, order, failure_order(order));
+    }
+
+    // Integers: each returns the value before the operation, like the builtins it wraps
+
+    T fetch_add(T value, memory_order order = memory_order::seq_cst) noexcept
+        requires(!Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return __atomic_fetch_add(target(), value, builtin_order(order));
+    }
+
+    T fetch_add(T value, memory_order order = memory_order::seq_cst) const noexcept
+        requires(Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return __atomic_fetch_add(target(), value, builtin_order(order));
+    }
+
+    T fetch_sub(T value, memory_order order = memory_order::seq_cst) noexcept
+        requires(!Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return __atomic_fetch_sub(target(), value, builtin_order(order));
+    }
+
+    T fetch_sub(T value, memory_order order = memory_order::seq_cst) const noexcept
+        requires(Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return __atomic_fetch_sub(target(), value, builtin_order(order));
+    }
+
+    T fetch_and(T value, memory_order order = memory_order::seq_cst) noexcept
+        requires(!Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return __atomic_fetch_and(target(), value, builtin_order(order));
+    }
+
+    T fetch_and(T value, memory_order order = memory_order::seq_cst) const noexcept
+        requires(Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return __atomic_fetch_and(target(), value, builtin_order(order));
+    }
+
+    T fetch_or(T value, memory_order order = memory_order::seq_cst) noexcept
+        requires(!Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return __atomic_fetch_or(target(), value, builtin_order(order));
+    }
+
+    T fetch_or(T value, memory_order order = memory_order::seq_cst) const noexcept
+        requires(Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return __atomic_fetch_or(target(), value, builtin_order(order));
+    }
+
+    T fetch_xor(T value, memory_order order = memory_order::seq_cst) noexcept
+        requires(!Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return __atomic_fetch_xor(target(), value, builtin_order(order));
+    }
+
+    T fetch_xor(T value, memory_order order = memory_order::seq_cst) const noexcept
+        requires(Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return __atomic_fetch_xor(target(), value, builtin_order(order));
+    }
+
+    // Pointers: the builtins count in bytes, so the offsets are scaled to elements here
+
+    T fetch_add(std::ptrdiff_t offset, memory_order order = memory_order::seq_cst) noexcept
+        requires(!Shared && is_pointer_v<T>)
+    {
+        return __atomic_fetch_add(target(), offset * static_cast<std::ptrdiff_t>(sizeof(*std::declval<T>())),
+                                  builtin_order(order));
+    }
+
+    T fetch_add(std::ptrdiff_t offset, memory_order order = memory_order::seq_cst) const noexcept
+        requires(Shared && is_pointer_v<T>)
+    {
+        return __atomic_fetch_add(target(), offset * static_cast<std::ptrdiff_t>(sizeof(*std::declval<T>())),
+                                  builtin_order(order));
+    }
+
+    T fetch_sub(std::ptrdiff_t offset, memory_order order = memory_order::seq_cst) noexcept
+        requires(!Shared && is_pointer_v<T>)
+    {
+        return __atomic_fetch_sub(target(), offset * static_cast<std::ptrdiff_t>(sizeof(*std::declval<T>())),
+                                  builtin_order(order));
+    }
+
+    T fetch_sub(std::ptrdiff_t offset, memory_order order = memory_order::seq_cst) const noexcept
+        requires(Shared && is_pointer_v<T>)
+    {
+        return __atomic_fetch_sub(target(), offset * static_cast<std::ptrdiff_t>(sizeof(*std::declval<T>())),
+                                  builtin_order(order));
+    }
+
+    T operator+=(T value) noexcept
+        requires(!Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return static_cast<T>(fetch_add(value) + value);
+    }
+
+    T operator+=(T value) const noexcept
+        requires(Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return static_cast<T>(fetch_add(value) + value);
+    }
+
+    T operator-=(T value) noexcept
+        requires(!Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return static_cast<T>(fetch_sub(value) - value);
+    }
+
+    T operator-=(T value) const noexcept
+        requires(Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return static_cast<T>(fetch_sub(value) - value);
+    }
+
+    T operator+=(std::ptrdiff_t offset) noexcept
+        requires(!Shared && is_pointer_v<T>)
+    {
+        return fetch_add(offset) + offset;
+    }
+
+    T operator+=(std::ptrdiff_t offset) const noexcept
+        requires(Shared && is_pointer_v<T>)
+    {
+        return fetch_add(offset) + offset;
+    }
+
+    T operator-=(std::ptrdiff_t offset) noexcept
+        requires(!Shared && is_pointer_v<T>)
+    {
+        return fetch_sub(offset) - offset;
+    }
+
+    T operator-=(std::ptrdiff_t offset) const noexcept
+        requires(Shared && is_pointer_v<T>)
+    {
+        return fetch_sub(offset) - offset;
+    }
+
+    T operator&=(T value) noexcept
+        requires(!Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return static_cast<T>(fetch_and(value) & value);
+    }
+
+    T operator&=(T value) const noexcept
+        requires(Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return static_cast<T>(fetch_and(value) & value);
+    }
+
+    T operator|=(T value) noexcept
+        requires(!Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return static_cast<T>(fetch_or(value) | value);
+    }
+
+    T operator|=(T value) const noexcept
+        requires(Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return static_cast<T>(fetch_or(value) | value);
+    }
+
+    T operator^=(T value) noexcept
+        requires(!Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return static_cast<T>(fetch_xor(value) ^ value);
+    }
+
+    T operator^=(T value) const noexcept
+        requires(Shared && is_integral_v<T> && !is_same_v<T, bool>)
+    {
+        return static_cast<T>(fetch_xor(value) ^ value);
+    }
+
+    T operator++() noexcept
+        requires(!Shared && ((is_integral_v<T> && !is_same_v<T, bool>) || is_pointer_v<T>))
+    {
+        return static_cast<T>(fetch_add(1) + 1);
+    }
+
+    T operator++() const noexcept
+        requires(Shared && ((is_integral_v<T> && !is_same_v<T, bool>) || is_pointer_v<T>))
+    {
+        return static_cast<T>(fetch_add(1) + 1);
+    }
+
+    T operator++(int) noexcept
+        requires(!Shared && ((is_integral_v<T> && !is_same_v<T, bool>) || is_pointer_v<T>))
+    {
+        return fetch_add(1);
+    }
+
+    T operator++(int) const noexcept
+        requires(Shared && ((is_integral_v<T> && !is_same_v<T, bool>) || is_pointer_v<T>))
+    {
+        return fetch_add(1);
+    }
+
+    T operator--() noexcept
+        requires(!Shared && ((is_integral_v<T> && !is_same_v<T, bool>) || is_pointer_v<T>))
+    {
+        return static_cast<T>(fetch_sub(1) - 1);
+    }
+
+    T operator--() const noexcept
+        requires(Shared && ((is_integral_v<T> && !is_same_v<T, bool>) || is_pointer_v<T>))
+    {
+        return static_cast<T>(fetch_sub(1) - 1);
+    }
+
+    T operator--(int) noexcept
+        requires(!Shared && ((is_integral_v<T> && !is_same_v<T, bool>) || is_pointer_v<T>))
+    {
+        return fetch_sub(1);
+    }
+
+    T operator--(int) const noexcept
+        requires(Shared && ((is_integral_v<T> && !is_same_v<T, bool>) || is_pointer_v<T>))
+    {
+        return fetch_sub(1);
+    }
+
+  private:
+    T *target() noexcept
+        requires(!Shared)
+    {
+        return static_cast<Derived *>(this)->object();
+    }
+
+    T *target() const noexcept
+        requires(Shared)
+    {
+        return static_cast<const Derived *>(this)->object();
+    }
+};
+} // namespace detail
+
+/*!
+ * @brief An object of type T that threads can read and modify without a data race
+ * @details Like the standard one, an atomic is only modified through a non-const reference; a const atomic can
+ * only be loaded.
+ */
+template<typename T> class atomic : public detail::atomic_operations<T, atomic<T>, false>
+{
+    using base = detail::atomic_operations<T, atomic<T>, false>;
+    friend base;
+    friend detail::atomic_load_operations<T, atomic<T>>;
+
+  public:
+    constexpr atomic() noexcept = default;
+
+    constexpr atomic(T value) noexcept
+        : _value(value)
+    {
+    }
+
+    atomic(const atomic &) = delete;
+    atomic &operator=(const atomic &) = delete;
+
+    T operator=(T value) noexcept
+    {
+        this->store(value);
+        return value;
+    }
+
+  private:
+    alignas(base::required_alignment) T _value{};
+
+    T *object() noexcept
+    {
+        return &_value;
+    }
+
+    const T *object() const noexcept
+    {
+        return &_value;
+    }
+};
+
+/*!
+ * @brief Atomic access to an object it refers to but does not own
+ * @details While any atomic_ref to an object exists, every access to the object must go through one. The object
+ * must be aligned to required_alignment.
+ */
+template<typename T> class atomic_ref : public detail::atomic_operations<T, atomic_ref<T>, true>
+{
+    using base = detail::atomic_operations<T, atomic_ref<T>, true>;
+    friend base;
+    friend detail::atomic_load_operations<T, atomic_ref<T>>;
+
+  public:
+    explicit atomic_ref(T &object) noexcept
+        : _object(&object)
+    {
+    }
+
+    atomic_ref(const atomic_ref &) noexcept = default;
+    atomic_ref &operator=(const atomic_ref &) = delete;
+
+    T operator=(T value) const noexcept
+    {
+        this->store(value);
+        return value;
+    }
+
+  private:
+    T *_object;
+
+    T *object() const noexcept
+    {
+        return _object;
+    }
+};
+
+/*!
+ * @brief A flag with test-and-set and clear, the one type the standard guarantees is lock-free
+ */
+class atomic_flag
+{
+  public:
+    constexpr atomic_flag() noexcept = default;
+    atomic_flag(const atomic_flag &) = delete;
+    atomic_flag &operator=(const atomic_flag &) = delete;
+
+    //! Sets the flag and returns whether it was already set.
+    bool test_and_set(memory_order order = memory_order::seq_cst) noexcept
+    {
+        return __atomic_test_and_set(&_flag, detail::builtin_order(order));
+    }
+
+    bool test(memory_order order = memory_order::seq_cst) const noexcept
+    {
+        return __atomic_load_n(&_flag, detail::builtin_order(order));
+    }
+
+    void clear(memory_order order = memory_order::seq_cst) noexcept
+    {
+        __atomic_clear(&_flag, detail::builtin_order(order));
+    }
+
+  private:
+    bool _flag = false;
+};
+
+//! Orders the memory accesses around it as order says, with respect to other threads.
+inline void atomic_thread_fence(memory_order order) noexcept
+{
+    __atomic_thread_fence(detail::builtin_order(order));
+}
+
+//! Orders memory accesses only against a signal handler running on the same thread.
+inline void atomic_signal_fence(memory_order order) noexcept
+{
+    __atomic_signal_fence(detail::builtin_order(order));
+}
+} // namespace std
+#endif
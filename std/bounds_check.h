@@ -0,0 +1,64 @@
+/*!
+ * @file bounds_check.h
+ * @brief Compile-time policy for the bounds checks of at(), front(), back() and string indexing
+ * @namespace std
+ * @details STD_BOUNDS_CHECK picks what a failed check does, for the whole program:
+ *
+ * - STD_BOUNDS_NONE: nothing is checked; the accessors are as cheap as operator[] and a bad index is undefined.
+ * - STD_BOUNDS_ASSERT: checks trap in debug builds and compile to nothing when NDEBUG is defined.
+ * - STD_BOUNDS_TRAP: checks always trap, which needs no unwinding tables.
+ * - STD_BOUNDS_THROW: checks throw std::out_of_range, the default. Without exceptions this traps like
+ *   STD_BOUNDS_TRAP; see STD_THROW in stdexcept.h.
+ *
+ * vector::operator[] is never checked, so indexing in inner loops costs no branch under any policy. The same goes for
+ * string_view::operator[]. Code that must handle a bad index without exceptions can use try_at(), which returns an
+ * Expected holding a pointer to the element or the std::out_of_range that at() would throw.
+ */
+#ifndef BOUNDS_CHECK_H
+#define BOUNDS_CHECK_H
+#include <stdexcept.h>
+
+#define STD_BOUNDS_NONE 0
+#define STD_BOUNDS_ASSERT 1
+#define STD_BOUNDS_TRAP 2
+#define STD_BOUNDS_THROW 3
+
+#if !defined(STD_BOUNDS_CHECK)
+#    define STD_BOUNDS_CHECK STD_BOUNDS_THROW
+#endif
+
+namespace std
+{
+namespace detail
+{
+/*!
+ * @brief Whether a failed bounds check throws, and so whether the checked accessors can be noexcept.
+ */
+#if STD_BOUNDS_CHECK == STD_BOUNDS_THROW && defined(STD_HAS_EXCEPTIONS)
+inline constexpr bool bounds_check_throws = true;
+#else
+inline constexpr bool bounds_check_throws = false;
+#endif
+
+/*!
+ * @brief Fails as the policy says unless in_range holds
+ */
+constexpr void check_bounds(bool in_range) noexcept(!bounds_check_throws)
+{
+#if STD_BOUNDS_CHECK == STD_BOUNDS_THROW
+    if (__builtin_expect(!in_range, 0))
+    {
+        STD_THROW(std::out_of_range());
+    }
+#elif STD_BOUNDS_CHECK == STD_BOUNDS_TRAP || (STD_BOUNDS_CHECK == STD_BOUNDS_ASSERT && !defined(NDEBUG))
+    if (__builtin_expect(!in_range, 0))
+    {
+        __builtin_trap();
+    }
+#else
+    (void)in_range;
+#endif
+}
+} // namespace detail
+} // namespace std
+#endif
@@ -0,0 +1,1457 @@
+/*!
+ * @file charconv.h
+ * @brief Locale-independent conversions between numbers and characters
+ * @namespace std
+ * @note This header is a part of the C++ standard library.
+ * Modeled after https://en.cppreference.com/w/cpp/header/charconv. to_chars() writes a number into a caller's buffer
+ * and from_chars() parses one back, without allocating, consulting a locale or throwing.
+ *
+ * Integers are written two digits per division from a table of digit pairs. Floating-point values are written in the
+ * shortest form that parses back to the same value, found with Ryu (Adams, PLDI 2018), and parsed with the
+ * Eisel-Lemire algorithm (Lemire, "Number Parsing at a Gigabyte per Second", 2021), which settles nearly every input
+ * with one 128-bit multiplication and falls back to exact big-integer arithmetic for the few that lie too close to a
+ * rounding boundary. The tables of powers of five both algorithms need are computed at compile time.
+ *
+ * The precision overloads of to_chars(), chars_format::hex and long double are not provided.
+ */
+#ifndef CHARCONV_H
+#define CHARCONV_H
+#include <stddef.h>
+#include <type_traits.h>
+
+namespace std
+{
+//! The errors to_chars() and from_chars() report, with their POSIX values.
+enum class errc : int
+{
+    invalid_argument = 22,
+    result_out_of_range = 34,
+    value_too_large = 75
+};
+
+//! The floating-point notations to_chars() writes and from_chars() accepts.
+enum class chars_format : unsigned char
+{
+    scientific = 1,
+    fixed = 2,
+    general = 3 //!< fixed | scientific
+};
+
+struct to_chars_result
+{
+    char *ptr;
+    errc ec;
+
+    friend bool operator==(const to_chars_result &, const to_chars_result &) = default;
+};
+
+struct from_chars_result
+{
+    const char *ptr;
+    errc ec;
+
+    friend bool operator==(const from_chars_result &, const from_chars_result &) = default;
+};
+
+namespace detail
+{
+inline constexpr char digit_pairs[] = "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                                      "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                                      "8081828384858687888990919293949596979899";
+
+inline constexpr char digit_chars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+//! The integer types to_chars() and from_chars() take; bool is not one.
+template<typename T>
+concept charconv_integer = is_integral_v<T> && !is_same_v<remove_cv_t<T>, bool>;
+
+template<typename T> inline constexpr bool is_signed_integer = T(-1) < T(0);
+
+constexpr std::size_t decimal_length(unsigned long long value) noexcept
+{
+    std::size_t length = 1;
+    for (; value >= 100; value /= 100)
+    {
+        length += 2;
+    }
+    return length + (value >= 10 ? 1 : 0);
+}
+
+/*!
+ * @brief Writes the low length decimal digits of value to dst, two digits per division
+ * @details Positions beyond the digits of value are filled with zeros.
+ */
+inline void write_decimal(char *dst, unsigned long long value, std::size_t length) noexcept
+{
+    char *out = dst + length;
+    for (; out - dst >= 2; value /= 100)
+    {
+        out -= 2;
+        out[0] = digit_pairs[(value % 100) * 2];
+        out[1] = digit_pairs[(value % 100) * 2 + 1];
+    }
+    if (out != dst)
+    {
+        out[-1] = static_cast<char>('0' + value % 10);
+    }
+}
+
+//! Value of the digit c in bases up to 36, or 36 when c is not a digit.
+constexpr unsigned int digit_value(char c) noexcept
+{
+    if (c >= '0' && c <= '9')
+    {
+        return static_cast<unsigned int>(c - '0');
+    }
+    if (c >= 'a' && c <= 'z')
+    {
+        return static_cast<unsigned int>(c - 'a') + 10;
+    }
+    if (c >= 'A' && c <= 'Z')
+    {
+        return static_cast<unsigned int>(c - 'A') + 10;
+    }
+    return 36;
+}
+
+inline to_chars_result unsigned_to_chars(char *first, char *last, unsigned long long value, unsigned int base) noexcept
+{
+    std::size_t room = static_cast<std::size_t>(last - first);
+    if (base == 10)
+    {
+        std::size_t length = decimal_length(value);
+        if (room < length)
+        {
+            return {last, errc::value_too_large};
+        }
+        write_decimal(first, value, length);
+        return {first + length, errc{}};
+    }
+    std::size_t length = 1;
+    for (unsigned long long rest = value / base; rest != 0; rest /= base)
+    {
+        length++;
+    }
+    if (room < length)
+    {
+        return {last, errc::value_too_large};
+    }
+    char *out = first + length;
+    if ((base & (base - 1)) == 0)
+    {
+        unsigned int shift = static_cast<unsigned int>(__builtin_ctz(base));
+        for (; out != first; value >>= shift)
+        {
+            *--out = digit_chars[value & (base - 1)];
+        }
+    }
+    else
+    {
+        for (; out != first; value /= base)
+        {
+            *--out = digit_chars[value % base];
+        }
+    }
+    return {first + length, errc{}};
+}
+
+/*!
+ * @brief Parses digits in base into a magnitude no greater than limit
+ * @return The end of the digits, which is first if there are none; overflow is set if the digits exceed limit
+ */
+inline const char *unsigned_from_chars(const char *first, const char *last, unsigned long long &value,
+                                       unsigned long long limit, unsigned int base, bool &overflow) noexcept
+{
+    unsigned long long cutoff = limit / base;
+    unsigned int cutoff_digit = static_cast<unsigned int>(limit % base);
+    unsigned long long result = 0;
+    overflow = false;
+    const char *p = first;
+    for (; p != last; ++p)
+    {
+        unsigned int digit = digit_value(*p);
+        if (digit >= base)
+        {
+            break;
+        }
+        if (result > cutoff || (result == cutoff && digit > cutoff_digit))
+        {
+            overflow = true;
+        }
+        result = result * base + digit;
+    }
+    value = result;
+    return p;
+}
+
+/*
+ * Floating-point support. A binary value is its IEEE bits without the sign; a decimal value is digits * 10^exponent.
+ */
+template<typename T> struct float_format;
+
+template<> struct float_format<double>
+{
+    using bits_type = unsigned long long;
+    static constexpr int mantissa_bits = 52;
+    static constexpr int exponent_bias = 1023;
+    static constexpr int infinite_exponent = 0x7FF;
+    static constexpr int smallest_power = -342; //!< Every value below 10^smallest_power rounds to zero.
+    static constexpr int largest_power = 308;   //!< Every value from 10^(largest_power + 1) rounds to infinity.
+    static constexpr int max_exact_power = 22;  //!< Largest power of ten a double holds exactly.
+    static constexpr double exact_powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                              1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+};
+
+template<> struct float_format<float>
+{
+    using bits_type = unsigned int;
+    static constexpr int mantissa_bits = 23;
+    static constexpr int exponent_bias = 127;
+    static constexpr int infinite_exponent = 0xFF;
+    static constexpr int smallest_power = -65;
+    static constexpr int largest_power = 38;
+    static constexpr int max_exact_power = 10;
+    static constexpr float exact_powers[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+};
+
+/*!
+ * @brief A fixed-capacity unsigned integer of 32-bit limbs, usable in constant expressions
+ * @details Only the operations the conversions need are provided, and none of them checks for overflow; every caller
+ * sizes Limbs for the largest value it can produce.
+ */
+template<std::size_t Limbs> struct big_integer
+{
+    unsigned int limbs[Limbs] = {};
+    std::size_t count = 0; //!< Limbs in use, with limbs[count - 1] nonzero unless the value is zero.
+
+    constexpr big_integer() noexcept = default;
+
+    constexpr explicit big_integer(unsigned long long value) noexcept
+    {
+        for (; value != 0; value >>= 32)
+        {
+            limbs[count++] = static_cast<unsigned int>(value);
+        }
+    }
+
+    constexpr void multiply(unsigned int factor) noexcept
+    {
+        unsigned long long carry = 0;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            carry += static_cast<unsigned long long>(limbs[i]) * factor;
+            limbs[i] = static_cast<unsigned int>(carry);
+            carry >>= 32;
+        }
+        if (carry != 0)
+        {
+            limbs[count++] = static_cast<unsigned int>(carry);
+        }
+    }
+
+    constexpr void add(unsigned int value) noexcept
+    {
+        unsigned long long carry = value;
+        for (std::size_t i = 0; i < count && carry != 0; i++)
+        {
+            carry += limbs[i];
+            limbs[i] = static_cast<unsigned int>(carry);
+            carry >>= 32;
+        }
+        if (carry != 0)
+        {
+            limbs[count++] = static_cast<unsigned int>(carry);
+        }
+    }
+
+    //! Multiplies by 5^exponent, thirteen powers at a time.
+    constexpr void multiply_pow5(unsigned int exponent) noexcept
+    {
+        for (; exponent >= 13; exponent -= 13)
+        {
+            multiply(1220703125u);
+        }
+        unsigned int factor = 1;
+        for (; exponent != 0; exponent--)
+        {
+            factor *= 5;
+        }
+        multiply(factor);
+    }
+
+    //! Divides in place and returns the remainder.
+    constexpr unsigned int divide(unsigned int divisor) noexcept
+    {
+        unsigned long long remainder = 0;
+        for (std::size_t i = count; i-- != 0;)
+        {
+            remainder = (remainder << 32) | limbs[i];
+            limbs[i] = static_cast<unsigned int>(remainder / divisor);
+            remainder %= divisor;
+        }
+        while (count != 0 && limbs[count - 1] == 0)
+        {
+            count--;
+        }
+        return static_cast<unsigned int>(remainder);
+    }
+
+    constexpr void shift_left(std::size_t bits) noexcept
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        std::size_t limb_shift = bits / 32;
+        unsigned int bit_shift = static_cast<unsigned int>(bits % 32);
+        if (bit_shift != 0 && (limbs[count - 1] >> (32 - bit_shift)) != 0)
+        {
+            limbs[count] = 0;
+            count++;
+        }
+        for (std::size_t i = count; i-- != 0;)
+        {
+            unsigned int high = limbs[i] << bit_shift;
+            if (bit_shift != 0 && i != 0)
+            {
+                high |= limbs[i - 1] >> (32 - bit_shift);
+            }
+            limbs[i + limb_shift] = high;
+        }
+        for (std::size_t i = 0; i < limb_shift; i++)
+        {
+            limbs[i] = 0;
+        }
+        count += limb_shift;
+    }
+
+    constexpr std::size_t bit_length() const noexcept
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+        return count * 32 - static_cast<std::size_t>(__builtin_clz(limbs[count - 1]));
+    }
+
+    //! The 64 bits of the value starting at bit offset.
+    constexpr unsigned long long bits_at(std::size_t offset) const noexcept
+    {
+        unsigned long long result = 0;
+        for (std::size_t bit = 0; bit < 64; bit += 32)
+        {
+            std::size_t limb = (offset + bit) / 32;
+            unsigned int shift = static_cast<unsigned int>((offset + bit) % 32);
+            unsigned long long part = limb < count ? limbs[limb] >> shift : 0;
+            if (shift != 0 && limb + 1 < count)
+            {
+                part |= static_cast<unsigned long long>(limbs[limb + 1]) << (32 - shift);
+            }
+            result |= (part & 0xFFFFFFFFull) << bit;
+        }
+        return result;
+    }
+
+    constexpr int compare(const big_integer &other) const noexcept
+    {
+        if (count != other.count)
+        {
+            return count < other.count ? -1 : 1;
+        }
+        for (std::size_t i = count; i-- != 0;)
+        {
+            if (limbs[i] != other.limbs[i])
+            {
+                return limbs[i] < other.limbs[i] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+};
+
+//! A 128-bit table entry.
+struct power_entry
+{
+    unsigned long long low;
+    unsigned long long high;
+};
+
+inline constexpr int ryu_inverse_count = 342;
+inline constexpr int ryu_positive_count = 326;
+inline constexpr int ryu_inverse_bits = 125;
+inline constexpr int ryu_positive_bits = 125;
+
+struct power_tables
+{
+    power_entry ryu_inverse[ryu_inverse_count];   //!< floor(2^(bit_length(5^q) + 124) / 5^q) + 1
+    power_entry ryu_positive[ryu_positive_count]; //!< The top 125 bits of 5^q
+    //! 5^q normalized to 128 bits for q in [-342, 308], truncated for q >= 0 and rounded up for q < 0.
+    power_entry lemire[float_format<double>::largest_power - float_format<double>::smallest_power + 1];
+};
+
+//! The width bits of value below bit offset + width, which are shifted up when offset is negative.
+template<std::size_t Limbs>
+constexpr power_entry table_bits(big_integer<Limbs> value, long offset, bool round_up) noexcept
+{
+    if (offset < 0)
+    {
+        value.shift_left(static_cast<std::size_t>(-offset));
+        offset = 0;
+    }
+    power_entry entry = {value.bits_at(static_cast<std::size_t>(offset)),
+                         value.bits_at(static_cast<std::size_t>(offset) + 64)};
+    if (round_up && ++entry.low == 0)
+    {
+        entry.high++;
+    }
+    return entry;
+}
+
+/*!
+ * @brief Computes every table from exact powers of five
+ * @details Positive powers are built by repeated multiplication. The inverse powers come from floor(2^960 / 5^q),
+ * built by repeated division, which is enough bits for 5^-342 and exact at every step since floor(floor(x / a) / b)
+ * equals floor(x / (a * b)).
+ */
+constexpr power_tables make_power_tables() noexcept
+{
+    constexpr long precision = 960;
+    constexpr int lemire_zero = -float_format<double>::smallest_power;
+    power_tables tables{};
+    big_integer<32> power(1);
+    for (int q = 0; q < ryu_positive_count; q++)
+    {
+        long length = static_cast<long>(power.bit_length());
+        tables.ryu_positive[q] = table_bits(power, length - ryu_positive_bits, false);
+        if (q <= float_format<double>::largest_power)
+        {
+            tables.lemire[lemire_zero + q] = table_bits(power, length - 128, false);
+        }
+        power.multiply(5);
+    }
+    big_integer<32> inverse(1);
+    inverse.shift_left(precision);
+    big_integer<32> power_of_q(1);
+    for (int q = 0; q < ryu_inverse_count; q++)
+    {
+        long length = static_cast<long>(power_of_q.bit_length());
+        tables.ryu_inverse[q] = table_bits(inverse, precision - (length - 1 + ryu_inverse_bits), true);
+        if (q != 0 && q <= lemire_zero)
+        {
+            tables.lemire[lemire_zero - q] = table_bits(inverse, precision - (length + 127), true);
+        }
+        inverse.divide(5);
+        power_of_q.multiply(5);
+    }
+    return tables;
+}
+
+inline constexpr power_tables powers = make_power_tables();
+
+//! The high half of a * b, with the low half stored in low.
+inline unsigned long long multiply_128(unsigned long long a, unsigned long long b, unsigned long long &low) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    __extension__ using uint128 = unsigned __int128;
+    uint128 product = static_cast<uint128>(a) * b;
+    low = static_cast<unsigned long long>(product);
+    return static_cast<unsigned long long>(product >> 64);
+#else
+    unsigned long long ha = a >> 32, hb = b >> 32, la = a & 0xFFFFFFFFull, lb = b & 0xFFFFFFFFull;
+    unsigned long long hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+    unsigned long long mid = (ll >> 32) + (hl & 0xFFFFFFFFull) + (lh & 0xFFFFFFFFull);
+    low = (mid << 32) | (ll & 0xFFFFFFFFull);
+    return hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+#endif
+}
+
+/*
+ * Ryu. The names follow the paper: the value is m2 * 2^e2, and vr, vp and vm are the scaled value and the scaled
+ * upper and lower bounds of the interval that rounds to it.
+ */
+//! ceil(log2(5^e)) for e in [1, 3528], and 1 for e = 0.
+constexpr int pow5_bits(int e) noexcept
+{
+    return static_cast<int>((static_cast<unsigned int>(e) * 1217359u) >> 19) + 1;
+}
+
+//! floor(log10(2^e)) for e in [0, 1650].
+constexpr unsigned int log10_pow2(int e) noexcept
+{
+    return (static_cast<unsigned int>(e) * 78913u) >> 18;
+}
+
+//! floor(log10(5^e)) for e in [0, 2620].
+constexpr unsigned int log10_pow5(int e) noexcept
+{
+    return (static_cast<unsigned int>(e) * 732923u) >> 20;
+}
+
+template<typename Unsigned> constexpr bool multiple_of_pow5(Unsigned value, unsigned int p) noexcept
+{
+    unsigned int count = 0;
+    for (; value % 5 == 0 && value != 0; value /= 5)
+    {
+        count++;
+    }
+    return count >= p;
+}
+
+template<typename Unsigned> constexpr bool multiple_of_pow2(Unsigned value, unsigned int p) noexcept
+{
+    return (value & ((Unsigned(1) << p) - 1)) == 0;
+}
+
+//! floor(m * multiplier / 2^j) for the 125-bit multiplier and j >= 64.
+inline unsigned long long multiply_shift_64(unsigned long long m, const power_entry &multiplier, int j) noexcept
+{
+    unsigned long long low_unused;
+    unsigned long long high0 = multiply_128(m, multiplier.low, low_unused);
+    unsigned long long low1;
+    unsigned long long high1 = multiply_128(m, multiplier.high, low1);
+    unsigned long long sum = high0 + low1;
+    if (sum < high0)
+    {
+        high1++;
+    }
+    unsigned int shift = static_cast<unsigned int>(j - 64);
+    return shift == 0 ? sum : (high1 << (64 - shift)) | (sum >> shift);
+}
+
+//! floor(m * multiplier / 2^shift) for the 61-bit multiplier and shift >= 32.
+inline unsigned int multiply_shift_32(unsigned int m, unsigned long long multiplier, int shift) noexcept
+{
+    unsigned long long low = static_cast<unsigned long long>(m) * (multiplier & 0xFFFFFFFFull);
+    unsigned long long high = static_cast<unsigned long long>(m) * (multiplier >> 32);
+    return static_cast<unsigned int>(((low >> 32) + high) >> (shift - 32));
+}
+
+struct decimal_value
+{
+    unsigned long long digits;
+    int exponent;
+};
+
+/*!
+ * @brief The shortest decimal that rounds to the double with the given exponent and mantissa fields
+ * @details Ryu's d2d(), for finite nonzero values.
+ */
+inline decimal_value shortest_decimal(unsigned long long ieee_mantissa, unsigned int ieee_exponent) noexcept
+{
+    constexpr int bias = float_format<double>::exponent_bias + float_format<double>::mantissa_bits + 2;
+    int e2 = (ieee_exponent == 0 ? 1 : static_cast<int>(ieee_exponent)) - bias;
+    unsigned long long m2 = ieee_exponent == 0 ? ieee_mantissa : (1ull << 52) | ieee_mantissa;
+    const bool accept_bounds = (m2 & 1) == 0;
+    const unsigned long long mv = 4 * m2;
+    const unsigned int mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1 ? 1 : 0;
+
+    unsigned long long vr, vp, vm;
+    int e10;
+    bool vm_trailing_zeros = false;
+    bool vr_trailing_zeros = false;
+    if (e2 >= 0)
+    {
+        const unsigned int q = log10_pow2(e2) - (e2 > 3 ? 1 : 0);
+        e10 = static_cast<int>(q);
+        const int k = ryu_inverse_bits + pow5_bits(static_cast<int>(q)) - 1;
+        const int i = -e2 + static_cast<int>(q) + k;
+        vr = multiply_shift_64(mv, powers.ryu_inverse[q], i);
+        vp = multiply_shift_64(mv + 2, powers.ryu_inverse[q], i);
+        vm = multiply_shift_64(mv - 1 - mm_shift, powers.ryu_inverse[q], i);
+        if (q <= 21)
+        {
+            // Only one of mv, mp and mm can be a multiple of 5, if any
+            if (mv % 5 == 0)
+            {
+                vr_trailing_zeros = multiple_of_pow5(mv, q);
+            }
+            else if (accept_bounds)
+            {
+                vm_trailing_zeros = multiple_of_pow5(mv - 1 - mm_shift, q);
+            }
+            else if (multiple_of_pow5(mv + 2, q))
+            {
+                vp--;
+            }
+        }
+    }
+    else
+    {
+        const unsigned int q = log10_pow5(-e2) - (-e2 > 1 ? 1 : 0);
+        e10 = static_cast<int>(q) + e2;
+        const int i = -e2 - static_cast<int>(q);
+        const int k = pow5_bits(i) - ryu_positive_bits;
+        const int j = static_cast<int>(q) - k;
+        vr = multiply_shift_64(mv, powers.ryu_positive[i], j);
+        vp = multiply_shift_64(mv + 2, powers.ryu_positive[i], j);
+        vm = multiply_shift_64(mv - 1 - mm_shift, powers.ryu_positive[i], j);
+        if (q <= 1)
+        {
+            // mv = 4 * m2 always has two trailing zero bits, mm has one exactly when mm_shift is 1
+            vr_trailing_zeros = true;
+            if (accept_bounds)
+            {
+                vm_trailing_zeros = mm_shift == 1;
+            }
+            else
+            {
+                --vp;
+            }
+        }
+        else if (q < 63)
+        {
+            // vr is mv * 5^i / 2^q, exact when 2^q divides mv
+            vr_trailing_zeros = multiple_of_pow2(mv, q);
+        }
+    }
+
+    int removed = 0;
+    unsigned long long output;
+    if (vm_trailing_zeros || vr_trailing_zeros)
+    {
+        // The rare general case, which tracks whether the removed digits were all zero
+        unsigned int last_removed = 0;
+        for (; vp / 10 > vm / 10; removed++)
+        {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = static_cast<unsigned int>(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+        }
+        if (vm_trailing_zeros)
+        {
+            for (; vm % 10 == 0; removed++)
+            {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = static_cast<unsigned int>(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+            }
+        }
+        if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0)
+        {
+            // Exactly halfway, so round to even
+            last_removed = 4;
+        }
+        bool round_up = (vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5;
+        output = vr + (round_up ? 1 : 0);
+    }
+    else
+    {
+        bool round_up = false;
+        if (vp / 100 > vm / 100)
+        {
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        for (; vp / 10 > vm / 10; removed++)
+        {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+        }
+        output = vr + (vr == vm || round_up ? 1 : 0);
+    }
+    return {output, e10 + removed};
+}
+
+/*!
+ * @brief The shortest decimal that rounds to the float with the given exponent and mantissa fields
+ * @details Ryu's f2d(), multiplying by the top 64 bits of the double tables.
+ */
+inline decimal_value shortest_decimal(unsigned int ieee_mantissa, unsigned int ieee_exponent) noexcept
+{
+    constexpr int bias = float_format<float>::exponent_bias + float_format<float>::mantissa_bits + 2;
+    constexpr int inverse_bits = ryu_inverse_bits - 64;
+    constexpr int positive_bits = ryu_positive_bits - 64;
+    int e2 = (ieee_exponent == 0 ? 1 : static_cast<int>(ieee_exponent)) - bias;
+    unsigned int m2 = ieee_exponent == 0 ? ieee_mantissa : (1u << 23) | ieee_mantissa;
+    const bool accept_bounds = (m2 & 1) == 0;
+    const unsigned int mv = 4 * m2;
+    const unsigned int mp = 4 * m2 + 2;
+    const unsigned int mm = 4 * m2 - 1 - (ieee_mantissa != 0 || ieee_exponent <= 1 ? 1 : 0);
+
+    unsigned int vr, vp, vm;
+    int e10;
+    bool vm_trailing_zeros = false;
+    bool vr_trailing_zeros = false;
+    unsigned int last_removed = 0;
+    if (e2 >= 0)
+    {
+        const unsigned int q = log10_pow2(e2);
+        e10 = static_cast<int>(q);
+        const int k = inverse_bits + pow5_bits(static_cast<int>(q)) - 1;
+        const int i = -e2 + static_cast<int>(q) + k;
+        // The table holds floor(2^x / 5^q) + 1 in 128 bits, so its top half needs the + 1 again
+        const unsigned long long multiplier = powers.ryu_inverse[q].high + 1;
+        vr = multiply_shift_32(mv, multiplier, i);
+        vp = multiply_shift_32(mp, multiplier, i);
+        vm = multiply_shift_32(mm, multiplier, i);
+        if (q != 0 && (vp - 1) / 10 <= vm / 10)
+        {
+            // The loop below removes no digit, but rounding still needs the last one
+            const int l = inverse_bits + pow5_bits(static_cast<int>(q - 1)) - 1;
+            const int shift = -e2 + static_cast<int>(q) - 1 + l;
+            last_removed = multiply_shift_32(mv, powers.ryu_inverse[q - 1].high + 1, shift) % 10;
+        }
+        if (q <= 9)
+        {
+            if (mv % 5 == 0)
+            {
+                vr_trailing_zeros = multiple_of_pow5(mv, q);
+            }
+            else if (accept_bounds)
+            {
+                vm_trailing_zeros = multiple_of_pow5(mm, q);
+            }
+            else if (multiple_of_pow5(mp, q))
+            {
+                vp--;
+            }
+        }
+    }
+    else
+    {
+        const unsigned int q = log10_pow5(-e2);
+        e10 = static_cast<int>(q) + e2;
+        const int i = -e2 - static_cast<int>(q);
+        const int k = pow5_bits(i) - positive_bits;
+        int j = static_cast<int>(q) - k;
+        vr = multiply_shift_32(mv, powers.ryu_positive[i].high, j);
+        vp = multiply_shift_32(mp, powers.ryu_positive[i].high, j);
+        vm = multiply_shift_32(mm, powers.ryu_positive[i].high, j);
+        if (q != 0 && (vp - 1) / 10 <= vm / 10)
+        {
+            j = static_cast<int>(q) - 1 - (pow5_bits(i + 1) - positive_bits);
+            last_removed = multiply_shift_32(mv, powers.ryu_positive[i + 1].high, j) % 10;
+        }
+        if (q <= 1)
+        {
+            vr_trailing_zeros = true;
+            if (accept_bounds)
+            {
+                vm_trailing_zeros = mm == mv - 2;
+            }
+            else
+            {
+                --vp;
+            }
+        }
+        else if (q < 31)
+        {
+            // last_removed already holds the digit at 10^(q - 1), so only the ones below it must be zero
+            vr_trailing_zeros = multiple_of_pow2(mv, q - 1);
+        }
+    }
+
+    int removed = 0;
+    if (vm_trailing_zeros || vr_trailing_zeros)
+    {
+        for (; vp / 10 > vm / 10; removed++)
+        {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+        }
+        if (vm_trailing_zeros)
+        {
+            for (; vm % 10 == 0; removed++)
+            {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = vr % 10;
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+            }
+        }
+        if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0)
+        {
+            last_removed = 4;
+        }
+        bool round_up = (vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5;
+        return {vr + (round_up ? 1u : 0u), e10 + removed};
+    }
+    for (; vp / 10 > vm / 10; removed++)
+    {
+        last_removed = vr % 10;
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+    }
+    return {vr + (vr == vm || last_removed >= 5 ? 1u : 0u), e10 + removed};
+}
+
+//! Room for the decimal digits of any finite double, 2^1024 having 309.
+using exact_integer = big_integer<34>;
+
+//! Splits value into base 10^9 chunks, least significant first, and returns how many there are.
+inline std::size_t decimal_chunks(exact_integer value, unsigned int *chunks) noexcept
+{
+    std::size_t count = 0;
+    do
+    {
+        chunks[count++] = value.divide(1000000000u);
+    } while (value.count != 0);
+    return count;
+}
+
+//! The decimal number of digits in chunks.
+inline std::size_t chunks_length(const unsigned int *chunks, std::size_t count) noexcept
+{
+    return decimal_length(chunks[count - 1]) + 9 * (count - 1);
+}
+
+inline void write_chunks(char *dst, const unsigned int *chunks, std::size_t count) noexcept
+{
+    std::size_t length = decimal_length(chunks[count - 1]);
+    write_decimal(dst, chunks[count - 1], length);
+    dst += length;
+    for (std::size_t i = count - 1; i-- != 0; dst += 9)
+    {
+        write_decimal(dst, chunks[i], 9);
+    }
+}
+
+//! Writes a scientific exponent: the letter e, a sign and at least two digits.
+inline char *write_exponent(char *out, int exponent) noexcept
+{
+    *out++ = 'e';
+    *out++ = exponent < 0 ? '-' : '+';
+    unsigned int magnitude = static_cast<unsigned int>(exponent < 0 ? -exponent : exponent);
+    std::size_t length = magnitude >= 100 ? 3 : 2;
+    write_decimal(out, magnitude, length);
+    return out + length;
+}
+
+/*!
+ * @brief Writes a finite value given as its shortest decimal and as the exact m2 * 2^e2
+ * @param plain Picks the shorter of fixed and scientific, preferring fixed, as the overload without a format does
+ * @details Fixed notation of a value whose decimal exponent is positive and whose binary exponent is too spells out
+ * the exact integer, as printf does, rather than padding the shortest digits with zeros.
+ */
+inline to_chars_result write_decimal_value(char *first, char *last, bool negative, decimal_value value,
+                                           unsigned long long m2, int e2, chars_format format, bool plain) noexcept
+{
+    char digits[20];
+    std::size_t count = decimal_length(value.digits);
+    write_decimal(digits, value.digits, count);
+    const int scientific_exponent = value.exponent + static_cast<int>(count) - 1;
+    const int magnitude = scientific_exponent < 0 ? -scientific_exponent : scientific_exponent;
+    const std::size_t scientific_length = count + (count > 1 ? 1 : 0) + (magnitude >= 100 ? 5 : 4);
+
+    unsigned int chunks[36];
+    std::size_t chunk_count = 0;
+    std::size_t fixed_length;
+    const bool exact = value.exponent > 0 && e2 > 0;
+    if (exact)
+    {
+        exact_integer integer(m2);
+        integer.shift_left(static_cast<std::size_t>(e2));
+        chunk_count = decimal_chunks(integer, chunks);
+        fixed_length = chunks_length(chunks, chunk_count);
+    }
+    else if (value.exponent >= 0)
+    {
+        fixed_length = count + static_cast<std::size_t>(value.exponent);
+    }
+    else
+    {
+        int point = static_cast<int>(count) + value.exponent;
+        fixed_length = point > 0 ? count + 1 : count + 2 + static_cast<std::size_t>(-point);
+    }
+
+    bool scientific;
+    if (plain)
+    {
+        scientific = scientific_length < fixed_length;
+    }
+    else if (format == chars_format::general)
+    {
+        scientific = scientific_exponent < -4 || scientific_exponent >= 6;
+    }
+    else
+    {
+        scientific = format == chars_format::scientific;
+    }
+
+    std::size_t length = (negative ? 1 : 0) + (scientific ? scientific_length : fixed_length);
+    if (static_cast<std::size_t>(last - first) < length)
+    {
+        return {last, errc::value_too_large};
+    }
+    char *out = first;
+    if (negative)
+    {
+        *out++ = '-';
+    }
+    if (scientific)
+    {
+        *out++ = digits[0];
+        if (count > 1)
+        {
+            *out++ = '.';
+            __builtin_memcpy(out, digits + 1, count - 1);
+            out += count - 1;
+        }
+        return {write_exponent(out, scientific_exponent), errc{}};
+    }
+    if (exact)
+    {
+        write_chunks(out, chunks, chunk_count);
+        return {out + fixed_length, errc{}};
+    }
+    if (value.exponent >= 0)
+    {
+        __builtin_memcpy(out, digits, count);
+        __builtin_memset(out + count, '0', static_cast<std::size_t>(value.exponent));
+        return {out + fixed_length, errc{}};
+    }
+    int point = static_cast<int>(count) + value.exponent;
+    if (point > 0)
+    {
+        __builtin_memcpy(out, digits, static_cast<std::size_t>(point));
+        out[point] = '.';
+        __builtin_memcpy(out + point + 1, digits + point, count - static_cast<std::size_t>(point));
+    }
+    else
+    {
+        out[0] = '0';
+        out[1] = '.';
+        __builtin_memset(out + 2, '0', static_cast<std::size_t>(-point));
+        __builtin_memcpy(out + 2 - point, digits, count);
+    }
+    return {out + fixed_length, errc{}};
+}
+
+template<typename T>
+to_chars_result float_to_chars(char *first, char *last, T value, chars_format format, bool plain) noexcept
+{
+    using traits = float_format<T>;
+    using bits_type = typename traits::bits_type;
+    bits_type bits;
+    __builtin_memcpy(&bits, &value, sizeof(bits));
+    constexpr unsigned int sign_shift = sizeof(bits_type) * 8 - 1;
+    const bool negative = (bits >> sign_shift) != 0;
+    const bits_type mantissa = bits & ((bits_type(1) << traits::mantissa_bits) - 1);
+    const unsigned int exponent =
+        static_cast<unsigned int>(bits >> traits::mantissa_bits) & static_cast<unsigned int>(traits::infinite_exponent);
+    std::size_t room = static_cast<std::size_t>(last - first);
+    if (exponent == static_cast<unsigned int>(traits::infinite_exponent))
+    {
+        const char *text = mantissa != 0 ? "-nan" : "-inf";
+        std::size_t length = negative ? 4 : 3;
+        if (room < length)
+        {
+            return {last, errc::value_too_large};
+        }
+        __builtin_memcpy(first, text + (negative ? 0 : 1), length);
+        return {first + length, errc{}};
+    }
+    decimal_value decimal = {0, 0};
+    if (mantissa != 0 || exponent != 0)
+    {
+        decimal = shortest_decimal(mantissa, exponent);
+    }
+    unsigned long long m2 = exponent == 0 ? mantissa : mantissa | (bits_type(1) << traits::mantissa_bits);
+    int e2 = (exponent == 0 ? 1 : static_cast<int>(exponent)) - traits::exponent_bias - traits::mantissa_bits;
+    return write_decimal_value(first, last, negative, decimal, m2, e2, format, plain);
+}
+
+/*
+ * Parsing floating-point values.
+ */
+//! The digits of a decimal number as found in the text, with leading zeros.
+struct decimal_text
+{
+    const char *integer;
+    std::size_t integer_count;
+    const char *fraction;
+    std::size_t fraction_count;
+    long long exponent; //!< The value is the digits, read as one integer, times 10^exponent.
+
+    constexpr std::size_t size() const noexcept
+    {
+        return integer_count + fraction_count;
+    }
+
+    constexpr unsigned int operator[](std::size_t index) const noexcept
+    {
+        char c = index < integer_count ? integer[index] : fraction[index - integer_count];
+        return static_cast<unsigned int>(c - '0');
+    }
+};
+
+//! Digits the 64-bit fast path holds, and digits the exact path reads before the rest only count as nonzero or not.
+inline constexpr std::size_t fast_digits = 19;
+inline constexpr std::size_t exact_digits = 768;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+inline bool is_eight_digits(unsigned long long chunk) noexcept
+{
+    return (((chunk & 0xF0F0F0F0F0F0F0F0ull) | (((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) ==
+            0x3333333333333333ull);
+}
+
+//! Value of eight ASCII digits read as a little-endian word, in three multiplications.
+inline unsigned long long parse_eight_digits(unsigned long long chunk) noexcept
+{
+    chunk -= 0x3030303030303030ull;
+    chunk = chunk * 10 + (chunk >> 8);
+    return (((chunk & 0x000000FF000000FFull) * 0x000F424000000064ull) +
+            (((chunk >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >>
+           32;
+}
+#endif
+
+//! Scans digits, accumulating them into value modulo 2^64, eight at a time where the target allows.
+inline const char *scan_digits(const char *p, const char *last, unsigned long long &value) noexcept
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    unsigned long long chunk;
+    for (; last - p >= 8; p += 8)
+    {
+        __builtin_memcpy(&chunk, p, 8);
+        if (!is_eight_digits(chunk))
+        {
+            break;
+        }
+        value = value * 100000000ull + parse_eight_digits(chunk);
+    }
+#endif
+    for (; p != last && *p >= '0' && *p <= '9'; ++p)
+    {
+        value = value * 10 + static_cast<unsigned long long>(*p - '0');
+    }
+    return p;
+}
+
+template<typename T> struct rounded_value
+{
+    typename float_format<T>::bits_type bits;
+    bool certain;
+};
+
+/*!
+ * @brief The binary value nearest to w * 10^q, with one 128-bit product against a normalized power of five
+ * @details The product is within two units of its last bit of the exact one. When its bits below the mantissa are
+ * that close to all zeros or all ones, the rounding cannot be decided from it and the result is marked uncertain;
+ * that covers exact halfway cases as well.
+ */
+template<typename T> rounded_value<T> eisel_lemire(long long q, unsigned long long w) noexcept
+{
+    using traits = float_format<T>;
+    using bits_type = typename traits::bits_type;
+    constexpr bits_type infinity = bits_type(traits::infinite_exponent) << traits::mantissa_bits;
+    if (w == 0 || q < traits::smallest_power)
+    {
+        return {0, true};
+    }
+    if (q > traits::largest_power)
+    {
+        return {infinity, true};
+    }
+    const unsigned int leading_zeros = static_cast<unsigned int>(__builtin_clzll(w));
+    w <<= leading_zeros;
+    const power_entry &power = powers.lemire[q - float_format<double>::smallest_power];
+    unsigned long long low;
+    unsigned long long high = multiply_128(w, power.high, low);
+    unsigned long long cross_low;
+    unsigned long long cross = multiply_128(w, power.low, cross_low);
+    low += cross;
+    if (low < cross)
+    {
+        high++;
+    }
+
+    const unsigned int upper_bit = static_cast<unsigned int>(high >> 63);
+    const unsigned int shift = upper_bit + 64 - traits::mantissa_bits - 3;
+    unsigned long long mantissa = high >> shift;
+    const unsigned long long below = high & ((1ull << shift) - 1);
+    bool certain = !(below == 0 && low < 2) && !(below == (1ull << shift) - 1 && low > ~0ull - 2);
+
+    // floor(q * log2(10)) + 63, exact for the whole table
+    int power2 = static_cast<int>(((152170 + 65536) * q) >> 16) + 63 + static_cast<int>(upper_bit) -
+                 static_cast<int>(leading_zeros) + traits::exponent_bias;
+    if (power2 <= 0)
+    {
+        if (-power2 + 1 >= 64)
+        {
+            return {0, certain};
+        }
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        return {static_cast<bits_type>(mantissa), certain};
+    }
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (2ull << traits::mantissa_bits))
+    {
+        mantissa = 1ull << traits::mantissa_bits;
+        power2++;
+    }
+    mantissa &= ~(1ull << traits::mantissa_bits);
+    if (power2 >= traits::infinite_exponent)
+    {
+        return {infinity, true};
+    }
+    return {static_cast<bits_type>(mantissa | (static_cast<unsigned long long>(power2) << traits::mantissa_bits)),
+            certain};
+}
+
+using parse_integer = big_integer<144>;
+
+/*!
+ * @brief Rounds the decimal exactly, starting from a candidate at or below the result
+ * @details Each step compares the decimal with the point halfway between the candidate and the next value, both
+ * scaled to integers, and moves up while the decimal lies above it. The candidate comes from eisel_lemire(), which is
+ * never more than one value off, so at most a few steps are taken.
+ */
+template<typename T>
+typename float_format<T>::bits_type exact_round(const decimal_text &text, std::size_t first_digit,
+                                                typename float_format<T>::bits_type candidate) noexcept
+{
+    using traits = float_format<T>;
+    using bits_type = typename traits::bits_type;
+    constexpr bits_type infinity = bits_type(traits::infinite_exponent) << traits::mantissa_bits;
+    const std::size_t significant = text.size() - first_digit;
+    const std::size_t used = significant < exact_digits ? significant : exact_digits;
+    parse_integer digits;
+    for (std::size_t i = 0; i < used;)
+    {
+        unsigned int chunk = 0;
+        unsigned int scale = 1;
+        for (; i < used && scale != 1000000000u; i++, scale *= 10)
+        {
+            chunk = chunk * 10 + text[first_digit + i];
+        }
+        digits.multiply(scale);
+        digits.add(chunk);
+    }
+    bool tail = false;
+    for (std::size_t i = first_digit + used; i < text.size() && !tail; i++)
+    {
+        tail = text[i] != 0;
+    }
+    const long long exponent = text.exponent + static_cast<long long>(significant - used);
+
+    for (; candidate < infinity; candidate++)
+    {
+        bits_type field = candidate >> traits::mantissa_bits;
+        unsigned long long m = candidate & ((bits_type(1) << traits::mantissa_bits) - 1);
+        if (field != 0)
+        {
+            m |= 1ull << traits::mantissa_bits;
+        }
+        // The halfway point above the candidate is (2m + 1) * 2^(e - 1)
+        long long halfway_exponent =
+            (field == 0 ? 1 : static_cast<long long>(field)) - traits::exponent_bias - traits::mantissa_bits - 1;
+        parse_integer scaled = digits;
+        parse_integer halfway(2 * m + 1);
+        if (exponent >= 0)
+        {
+            scaled.multiply_pow5(static_cast<unsigned int>(exponent));
+        }
+        else
+        {
+            halfway.multiply_pow5(static_cast<unsigned int>(-exponent));
+        }
+        if (exponent > halfway_exponent)
+        {
+            scaled.shift_left(static_cast<std::size_t>(exponent - halfway_exponent));
+        }
+        else
+        {
+            halfway.shift_left(static_cast<std::size_t>(halfway_exponent - exponent));
+        }
+        int order = scaled.compare(halfway);
+        if (order < 0)
+        {
+            return candidate;
+        }
+        if (order == 0 && !tail)
+        {
+            // Exactly halfway, so round to even
+            return (m & 1) != 0 ? candidate + 1 : candidate;
+        }
+    }
+    return candidate;
+}
+
+template<typename T>
+from_chars_result float_from_chars(const char *first, const char *last, T &value, chars_format format) noexcept
+{
+    using traits = float_format<T>;
+    using bits_type = typename traits::bits_type;
+    constexpr bits_type infinity = bits_type(traits::infinite_exponent) << traits::mantissa_bits;
+    constexpr unsigned int sign_shift = sizeof(bits_type) * 8 - 1;
+    const char *p = first;
+    const bool negative = p != last && *p == '-';
+    if (negative)
+    {
+        ++p;
+    }
+    const bits_type sign = negative ? bits_type(1) << sign_shift : 0;
+
+    auto matches = [&](const char *word, std::size_t length) {
+        if (static_cast<std::size_t>(last - p) < length)
+        {
+            return false;
+        }
+        for (std::size_t i = 0; i < length; i++)
+        {
+            if ((p[i] | 0x20) != word[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (matches("inf", 3))
+    {
+        p += matches("infinity", 8) ? 8 : 3;
+        bits_type bits = sign | infinity;
+        __builtin_memcpy(&value, &bits, sizeof(bits));
+        return {p, errc{}};
+    }
+    if (matches("nan", 3))
+    {
+        p += 3;
+        if (p != last && *p == '(')
+        {
+            const char *q = p + 1;
+            for (; q != last && (digit_value(*q) < 36 || *q == '_'); ++q)
+            {
+            }
+            if (q != last && *q == ')')
+            {
+                p = q + 1;
+            }
+        }
+        bits_type bits = sign | infinity | (bits_type(1) << (traits::mantissa_bits - 1));
+        __builtin_memcpy(&value, &bits, sizeof(bits));
+        return {p, errc{}};
+    }
+
+    decimal_text text = {p, 0, p, 0, 0};
+    unsigned long long w = 0;
+    p = scan_digits(p, last, w);
+    text.integer_count = static_cast<std::size_t>(p - text.integer);
+    if (p != last && *p == '.')
+    {
+        text.fraction = ++p;
+        p = scan_digits(p, last, w);
+        text.fraction_count = static_cast<std::size_t>(p - text.fraction);
+    }
+    if (text.size() == 0)
+    {
+        return {first, errc::invalid_argument};
+    }
+    long long explicit_exponent = 0;
+    bool has_exponent = false;
+    if (format != chars_format::fixed && p != last && (*p == 'e' || *p == 'E'))
+    {
+        const char *q = p + 1;
+        bool negative_exponent = q != last && *q == '-';
+        if (q != last && (*q == '-' || *q == '+'))
+        {
+            ++q;
+        }
+        if (q != last && *q >= '0' && *q <= '9')
+        {
+            has_exponent = true;
+            for (; q != last && *q >= '0' && *q <= '9'; ++q)
+            {
+                // Saturate far beyond any exponent that is not zero or infinity anyway
+                if (explicit_exponent < 0x10000000)
+                {
+                    explicit_exponent = explicit_exponent * 10 + (*q - '0');
+                }
+            }
+            p = q;
+            explicit_exponent = negative_exponent ? -explicit_exponent : explicit_exponent;
+        }
+    }
+    if (format == chars_format::scientific && !has_exponent)
+    {
+        return {first, errc::invalid_argument};
+    }
+    text.exponent = explicit_exponent - static_cast<long long>(text.fraction_count);
+
+    // w holds the digits when there are few enough; otherwise take the first significant ones
+    std::size_t first_digit = 0;
+    long long q = text.exponent;
+    bool truncated = false;
+    if (text.size() > fast_digits)
+    {
+        for (; first_digit < text.size() && text[first_digit] == 0; first_digit++)
+        {
+        }
+        std::size_t significant = text.size() - first_digit;
+        if (significant > fast_digits)
+        {
+            w = 0;
+            for (std::size_t i = 0; i < fast_digits; i++)
+            {
+                w = w * 10 + text[first_digit + i];
+            }
+            q += static_cast<long long>(significant - fast_digits);
+            for (std::size_t i = first_digit + fast_digits; i < text.size() && !truncated; i++)
+            {
+                truncated = text[i] != 0;
+            }
+        }
+    }
+
+    bits_type bits;
+    if (!truncated && w <= (1ull << (traits::mantissa_bits + 1)) && q >= -traits::max_exact_power &&
+        q <= traits::max_exact_power)
+    {
+        // Both the digits and the power of ten are exact, so one correctly rounded operation is enough
+        T result = static_cast<T>(w);
+        result = q < 0 ? result / traits::exact_powers[-q] : result * traits::exact_powers[q];
+        __builtin_memcpy(&bits, &result, sizeof(bits));
+    }
+    else
+    {
+        rounded_value<T> rounded = eisel_lemire<T>(q, w);
+        if (rounded.certain && truncated)
+        {
+            // The digits lie between w and w + 1 units, which may round differently
+            rounded_value<T> above = eisel_lemire<T>(q, w + 1);
+            rounded.certain = above.certain && above.bits == rounded.bits;
+        }
+        bits = rounded.bits;
+        if (!rounded.certain)
+        {
+            bits = exact_round<T>(text, first_digit, bits != 0 ? bits - 1 : 0);
+        }
+    }
+    if (bits == infinity || (bits == 0 && (w != 0 || truncated)))
+    {
+        return {p, errc::result_out_of_range};
+    }
+    bits |= sign;
+    __builtin_memcpy(&value, &bits, sizeof(bits));
+    return {p, errc{}};
+}
+} // namespace detail
+
+/*!
+ * @brief Writes value in base, lowercase letters standing for the digits above 9
+ * @return The end of the characters written, or last with errc::value_too_large when they do not fit
+ */
+template<detail::charconv_integer T>
+to_chars_result to_chars(char *first, char *last, T value, int base = 10) noexcept
+{
+    unsigned long long magnitude = static_cast<unsigned long long>(value);
+    if constexpr (detail::is_signed_integer<T>)
+    {
+        if (value < T(0))
+        {
+            if (first == last)
+            {
+                return {last, errc::value_too_large};
+            }
+            *first++ = '-';
+            magnitude = 0ull - magnitude;
+        }
+    }
+    return detail::unsigned_to_chars(first, last, magnitude, static_cast<unsigned int>(base));
+}
+
+to_chars_result to_chars(char *, char *, bool, int = 10) = delete;
+
+/*!
+ * @brief Writes value in the shortest form that from_chars() reads back as the same value
+ * @details Fixed notation is used unless scientific notation is shorter. Infinities and NaNs are written as inf and
+ * nan, with a minus sign when the sign bit is set.
+ */
+inline to_chars_result to_chars(char *first, char *last, double value) noexcept
+{
+    return detail::float_to_chars(first, last, value, chars_format::general, true);
+}
+
+inline to_chars_result to_chars(char *first, char *last, float value) noexcept
+{
+    return detail::float_to_chars(first, last, value, chars_format::general, true);
+}
+
+/*!
+ * @brief Writes the shortest digits that read back as value in the notation of format
+ * @details chars_format::general uses scientific notation when the decimal exponent is below -4 or from 6, like
+ * printf's %g.
+ */
+inline to_chars_result to_chars(char *first, char *last, double value, chars_format format) noexcept
+{
+    return detail::float_to_chars(first, last, value, format, false);
+}
+
+inline to_chars_result to_chars(char *first, char *last, float value, chars_format format) noexcept
+{
+    return detail::float_to_chars(first, last, value, format, false);
+}
+
+/*!
+ * @brief Parses an integer in base, with a leading minus sign only for signed types
+ * @details A 0x prefix or a plus sign is not accepted. On errc::result_out_of_range ptr is past every digit and value
+ * is unchanged, as it is on errc::invalid_argument, where ptr is first.
+ */
+template<detail::charconv_integer T>
+from_chars_result from_chars(const char *first, const char *last, T &value, int base = 10) noexcept
+{
+    constexpr unsigned int bits = sizeof(T) * 8;
+    constexpr unsigned long long max_value = ~0ull >> (64 - bits + (detail::is_signed_integer<T> ? 1 : 0));
+    const char *p = first;
+    bool negative = false;
+    if constexpr (detail::is_signed_integer<T>)
+    {
+        negative = p != last && *p == '-';
+        p += negative ? 1 : 0;
+    }
+    unsigned long long magnitude;
+    bool overflow;
+    const char *end = detail::unsigned_from_chars(p, last, magnitude, max_value + (negative ? 1 : 0),
+                                                  static_cast<unsigned int>(base), overflow);
+    if (end == p)
+    {
+        return {first, errc::invalid_argument};
+    }
+    if (overflow)
+    {
+        return {end, errc::result_out_of_range};
+    }
+    value = static_cast<T>(negative ? 0ull - magnitude : magnitude);
+    return {end, errc{}};
+}
+
+/*!
+ * @brief Parses a floating-point value, rounding to nearest with ties to even
+ * @details The text is an optional minus sign and then digits with an optional decimal point, followed by an
+ * exponent that chars_format::scientific requires and chars_format::fixed does not read; or inf, infinity, nan or
+ * nan(chars), in any case. Values too large or too small to be anything but infinity or zero report
+ * errc::result_out_of_range and leave value unchanged.
+ */
+inline from_chars_result from_chars(const char *first, const char *last, double &value,
+                                    chars_format format = chars_format::general) noexcept
+{
+    return detail::float_from_chars(first, last, value, format);
+}
+
+inline from_chars_result from_chars(const char *first, const char *last, float &value,
+                                    chars_format format = chars_format::general) noexcept
+{
+    return detail::float_from_chars(first, last, value, format);
+}
+} // namespace std
+#endif
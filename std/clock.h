@@ -0,0 +1,42 @@
+/*!
+ * @file clock.h
+ * @brief Monotonic time from the os:: layer
+ * @namespace std
+ * @details The library keeps no clock of its own; the program provides os::clock_ns() like the other os:: hooks. A
+ * raw cycle counter, read without the os, is there for timing short stretches of code next to it.
+ */
+#ifndef CLOCK_H
+#define CLOCK_H
+
+namespace os
+{
+    /*!
+     * @brief Returns nanoseconds on a monotonic clock from an arbitrary starting point.
+     */
+    unsigned long long clock_ns();
+} // namespace os
+
+namespace std
+{
+namespace detail
+{
+/*!
+ * @brief Reads the time stamp counter on x86 or the virtual counter on AArch64, 0 on other targets
+ * @details The count is not serialized with the surrounding instructions and is only meaningful as a difference of
+ * two reads on the same core.
+ */
+inline unsigned long long cycle_count() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    unsigned long long ticks;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return 0;
+#endif
+}
+} // namespace detail
+} // namespace std
+#endif
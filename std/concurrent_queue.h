@@ -0,0 +1,622 @@
+/*!
+ * @file concurrent_queue.h
+ * @brief Lock-free queues for passing values between threads
+ * @namespace std
+ * @details The bounded queues are rings of a power-of-two number of slots, allocated once through the allocator when
+ * the queue is made and never resized, so pushing and popping never allocate.
+ *
+ * - spsc_queue serves exactly one producer thread and one consumer thread. Each side owns its index and keeps a
+ *   cached copy of the other side's, on its own cache line, so in the steady state a push or pop touches no line the
+ *   other thread writes.
+ * - mpmc_queue is Dmitry Vyukov's bounded queue for any number of producers and consumers. Each slot carries a
+ *   sequence number that says whose turn it is, so a push or pop claims its slot with one compare-exchange and
+ *   publishes it with one release store.
+ * - work_stealing_deque is the Chase-Lev deque a work-stealing scheduler gives each worker: the owner pushes and
+ *   pops at one end without contention and idle threads steal from the other. Unlike the queues it grows.
+ *
+ * The try_ operations return false instead of waiting when the queue is full or empty. push_batch() and pop_batch()
+ * move up to a given number of values at once and return how many they moved; a batch publishes its values with a
+ * single store of the index (spsc) or claims its slots with a single compare-exchange (mpmc), which is what makes
+ * batches cheaper per value than one operation each.
+ */
+#ifndef CONCURRENT_QUEUE_H
+#define CONCURRENT_QUEUE_H
+#include <atomic.h>
+#include <memory.h>
+#include <stddef.h>
+#include <type_traits.h>
+#include <utility.h>
+
+namespace std
+{
+namespace detail
+{
+//! The smallest power of two at least count and at least minimum.
+constexpr std::size_t ring_capacity(std::size_t count, std::size_t minimum) noexcept
+{
+    std::size_t capacity = minimum;
+    while (capacity < count)
+    {
+        capacity *= 2;
+    }
+    return capacity;
+}
+} // namespace detail
+
+/*!
+ * @brief A bounded wait-free queue for one producer thread and one consumer thread
+ * @details Only the producer may push and only the consumer may pop. size_approx() and empty() can be called from
+ * either and are exact only when the other side is idle.
+ * @tparam T The element type
+ * @tparam Allocator Allocator the slots come from
+ */
+template<typename T, typename Allocator = std::allocator<T>> class spsc_queue
+{
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using allocator_type = Allocator;
+
+    /*!
+     * @brief Allocates the slots for at least capacity values, rounded up to a power of two
+     */
+    explicit spsc_queue(size_type capacity, const Allocator &alloc = Allocator())
+        : _mask(detail::ring_capacity(capacity, 1) - 1)
+        , _alloc(alloc)
+    {
+        _slots = allocator_traits<Allocator>::allocate(_alloc, _mask + 1);
+    }
+
+    spsc_queue(const spsc_queue &) = delete;
+    spsc_queue &operator=(const spsc_queue &) = delete;
+
+    //! Destroys the values still queued; neither side may be running.
+    ~spsc_queue()
+    {
+        size_type tail = _producer.tail.load(memory_order::relaxed);
+        for (size_type head = _consumer.head.load(memory_order::relaxed); head != tail; ++head)
+        {
+            std::destroy_at(_slots + (head & _mask));
+        }
+        allocator_traits<Allocator>::deallocate(_alloc, _slots, _mask + 1);
+    }
+
+    size_type capacity() const noexcept
+    {
+        return _mask + 1;
+    }
+
+    size_type size_approx() const noexcept
+    {
+        size_type head = _consumer.head.load(memory_order::acquire);
+        return _producer.tail.load(memory_order::acquire) - head;
+    }
+
+    bool empty() const noexcept
+    {
+        return size_approx() == 0;
+    }
+
+    /*!
+     * @brief Constructs a value at the back, from the producer thread
+     * @return false if the queue is full, in which case nothing is constructed
+     */
+    template<typename... Args> bool try_emplace(Args &&...args)
+    {
+        size_type tail = _producer.tail.load(memory_order::relaxed);
+        if (free_slots(tail) == 0)
+        {
+            return false;
+        }
+        std::construct_at(_slots + (tail & _mask), std::forward<Args>(args)...);
+        _producer.tail.store(tail + 1, memory_order::release);
+        return true;
+    }
+
+    bool try_push(const T &value)
+    {
+        return try_emplace(value);
+    }
+
+    bool try_push(T &&value)
+    {
+        return try_emplace(std::move(value));
+    }
+
+    /*!
+     * @brief Moves the front value into out, from the consumer thread
+     * @return false if the queue is empty, in which case out is untouched
+     */
+    bool try_pop(T &out)
+    {
+        size_type head = _consumer.head.load(memory_order::relaxed);
+        if (queued(head) == 0)
+        {
+            return false;
+        }
+        T *slot = _slots + (head & _mask);
+        out = std::move(*slot);
+        std::destroy_at(slot);
+        _consumer.head.store(head + 1, memory_order::release);
+        return true;
+    }
+
+    /*!
+     * @brief Copies up to count values from first to the back and publishes them at once
+     * @return The number of values pushed, less than count if the queue filled up
+     */
+    template<typename InputIt> size_type push_batch(InputIt first, size_type count)
+    {
+        size_type tail = _producer.tail.load(memory_order::relaxed);
+        size_type room = free_slots(tail, count);
+        size_type pushed = room < count ? room : count;
+        for (size_type i = 0; i < pushed; ++i, ++first)
+        {
+            std::construct_at(_slots + ((tail + i) & _mask), *first);
+        }
+        _producer.tail.store(tail + pushed, memory_order::release);
+        return pushed;
+    }
+
+    /*!
+     * @brief Moves up to max_count values from the front to out and frees their slots at once
+     * @return The number of values popped
+     */
+    template<typename OutputIt> size_type pop_batch(OutputIt out, size_type max_count)
+    {
+        size_type head = _consumer.head.load(memory_order::relaxed);
+        size_type available = queued(head, max_count);
+        size_type popped = available < max_count ? available : max_count;
+        for (size_type i = 0; i < popped; ++i, ++out)
+        {
+            T *slot = _slots + ((head + i) & _mask);
+            *out = std::move(*slot);
+            std::destroy_at(slot);
+        }
+        _consumer.head.store(head + popped, memory_order::release);
+        return popped;
+    }
+
+  private:
+    //! Written by the producer; the consumer only reads tail.
+    struct alignas(detail::cache_line_size) producer_side
+    {
+        atomic<size_type> tail{0};
+        size_type cached_head = 0; //!< The consumer's head when last read.
+    };
+
+    //! Written by the consumer; the producer only reads head.
+    struct alignas(detail::cache_line_size) consumer_side
+    {
+        atomic<size_type> head{0};
+        size_type cached_tail = 0; //!< The producer's tail when last read.
+    };
+
+    producer_side _producer;
+    consumer_side _consumer;
+    // Set once by the constructor, so both sides read these without the line bouncing
+    alignas(detail::cache_line_size) T *_slots = nullptr;
+    size_type _mask;
+    STD_NO_UNIQUE_ADDRESS Allocator _alloc{};
+
+    //! Free slots after tail, reading the consumer's head only if the cached one shows fewer than wanted.
+    size_type free_slots(size_type tail, size_type wanted = 1) noexcept
+    {
+        size_type room = capacity() - (tail - _producer.cached_head);
+        if (room < wanted)
+        {
+            _producer.cached_head = _consumer.head.load(memory_order::acquire);
+            room = capacity() - (tail - _producer.cached_head);
+        }
+        return room;
+    }
+
+    //! Values queued from head, reading the producer's tail only if the cached one shows fewer than wanted.
+    size_type queued(size_type head, size_type wanted = 1) noexcept
+    {
+        size_type available = _consumer.cached_tail - head;
+        if (available < wanted)
+        {
+            _consumer.cached_tail = _producer.tail.load(memory_order::acquire);
+            available = _consumer.cached_tail - head;
+        }
+        return available;
+    }
+};
+
+/*!
+ * @brief A bounded lock-free queue for any number of producer and consumer threads
+ * @details Values come out in the order their pushes claimed slots. A push into a full queue and a pop from an empty
+ * one fail rather than wait, and a thread stalled between claiming a slot and publishing it holds up the threads
+ * behind it on that slot only.
+ * @tparam T The element type
+ * @tparam Allocator Allocator the slots come from, rebound to the slot type
+ */
+template<typename T, typename Allocator = std::allocator<T>> class mpmc_queue
+{
+    struct cell
+    {
+        //! Equals the position of the push this slot waits for, or that position + 1 once the value is in.
+        atomic<std::size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T *value() noexcept
+        {
+            return reinterpret_cast<T *>(storage);
+        }
+    };
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using allocator_type = typename allocator_traits<Allocator>::template rebind_alloc<cell>;
+
+    /*!
+     * @brief Allocates the slots for at least capacity values, rounded up to a power of two and at least 2
+     */
+    explicit mpmc_queue(size_type capacity, const Allocator &alloc = Allocator())
+        : _mask(detail::ring_capacity(capacity, 2) - 1)
+        , _alloc(alloc)
+    {
+        _cells = allocator_traits<allocator_type>::allocate(_alloc, _mask + 1);
+        for (size_type i = 0; i <= _mask; ++i)
+        {
+            std::construct_at(&_cells[i].sequence, i);
+        }
+    }
+
+    mpmc_queue(const mpmc_queue &) = delete;
+    mpmc_queue &operator=(const mpmc_queue &) = delete;
+
+    //! Destroys the values still queued; no thread may be using the queue.
+    ~mpmc_queue()
+    {
+        size_type tail = _enqueue.position.load(memory_order::relaxed);
+        for (size_type head = _dequeue.position.load(memory_order::relaxed); head != tail; ++head)
+        {
+            std::destroy_at(_cells[head & _mask].value());
+        }
+        allocator_traits<allocator_type>::deallocate(_alloc, _cells, _mask + 1);
+    }
+
+    size_type capacity() const noexcept
+    {
+        return _mask + 1;
+    }
+
+    //! The number of claimed slots, which may include pushes and pops still in progress.
+    size_type size_approx() const noexcept
+    {
+        size_type head = _dequeue.position.load(memory_order::acquire);
+        size_type tail = _enqueue.position.load(memory_order::acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const noexcept
+    {
+        return size_approx() == 0;
+    }
+
+    /*!
+     * @brief Constructs a value at the back
+     * @return false if the queue is full, in which case nothing is constructed
+     */
+    template<typename... Args> bool try_emplace(Args &&...args)
+    {
+        size_type position = 0;
+        if (claim(_enqueue.position, 0, 1, position) == 0)
+        {
+            return false;
+        }
+        cell &slot = _cells[position & _mask];
+        std::construct_at(slot.value(), std::forward<Args>(args)...);
+        slot.sequence.store(position + 1, memory_order::release);
+        return true;
+    }
+
+    bool try_push(const T &value)
+    {
+        return try_emplace(value);
+    }
+
+    bool try_push(T &&value)
+    {
+        return try_emplace(std::move(value));
+    }
+
+    /*!
+     * @brief Moves the front value into out
+     * @return false if the queue is empty, in which case out is untouched
+     */
+    bool try_pop(T &out)
+    {
+        size_type position = 0;
+        if (claim(_dequeue.position, 1, 1, position) == 0)
+        {
+            return false;
+        }
+        release(position, out);
+        return true;
+    }
+
+    /*!
+     * @brief Copies up to count values from first into consecutive slots claimed together
+     * @return The number of values pushed, less than count if the queue filled up
+     */
+    template<typename InputIt> size_type push_batch(InputIt first, size_type count)
+    {
+        size_type position = 0;
+        size_type claimed = claim(_enqueue.position, 0, count, position);
+        for (size_type i = 0; i < claimed; ++i, ++first)
+        {
+            cell &slot = _cells[(position + i) & _mask];
+            std::construct_at(slot.value(), *first);
+            slot.sequence.store(position + i + 1, memory_order::release);
+        }
+        return claimed;
+    }
+
+    /*!
+     * @brief Moves up to max_count values from consecutive slots claimed together to out
+     * @return The number of values popped
+     */
+    template<typename OutputIt> size_type pop_batch(OutputIt out, size_type max_count)
+    {
+        size_type position = 0;
+        size_type claimed = claim(_dequeue.position, 1, max_count, position);
+        for (size_type i = 0; i < claimed; ++i, ++out)
+        {
+            release(position + i, *out);
+        }
+        return claimed;
+    }
+
+  private:
+    struct alignas(detail::cache_line_size) cursor
+    {
+        atomic<size_type> position{0};
+    };
+
+    cursor _enqueue; //!< Position of the next push.
+    cursor _dequeue; //!< Position of the next pop.
+    alignas(detail::cache_line_size) cell *_cells = nullptr;
+    size_type _mask;
+    STD_NO_UNIQUE_ADDRESS allocator_type _alloc{};
+
+    /*!
+     * @brief Claims up to count consecutive slots whose sequence is their position + lag
+     * @details Pushes wait for lag 0, a slot its last pop freed; pops for lag 1, a slot its push filled. The run of
+     * ready slots is measured first and then claimed with one compare-exchange, which fails and retries if another
+     * thread claimed any of them meanwhile.
+     * @return The number of slots claimed, starting at first; 0 if the first slot is not ready
+     */
+    size_type claim(atomic<size_type> &cursor_position, size_type lag, size_type count, size_type &first) noexcept
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+        size_type position = cursor_position.load(memory_order::relaxed);
+        for (;;)
+        {
+            size_type ready = 0;
+            std::ptrdiff_t difference = 0;
+            while (ready < count && ready <= _mask)
+            {
+                size_type sequence = _cells[(position + ready) & _mask].sequence.load(memory_order::acquire);
+                difference = static_cast<std::ptrdiff_t>(sequence - (position + ready + lag));
+                if (difference != 0)
+                {
+                    break;
+                }
+                ++ready;
+            }
+            if (ready == 0)
+            {
+                if (difference < 0)
+                {
+                    // The slot still holds the previous lap: the queue is full (push) or empty (pop)
+                    return 0;
+                }
+                // Another thread already took this position
+                position = cursor_position.load(memory_order::relaxed);
+                continue;
+            }
+            if (cursor_position.compare_exchange_weak(position, position + ready, memory_order::relaxed))
+            {
+                first = position;
+                return ready;
+            }
+        }
+    }
+
+    //! Moves the value at a claimed position to out and hands the slot to the push one lap later.
+    template<typename Out> void release(size_type position, Out &&out)
+    {
+        cell &slot = _cells[position & _mask];
+        out = std::move(*slot.value());
+        std::destroy_at(slot.value());
+        slot.sequence.store(position + _mask + 1, memory_order::release);
+    }
+};
+
+/*!
+ * @brief The Chase-Lev work-stealing deque: its owner pushes and pops at the bottom, any thread steals at the top
+ * @details The owner's push and pop touch only the bottom index in the common case; a compare-exchange on the top
+ * index settles the race for the last value and every steal. This is the C11 formulation of Le, Pop, Cohen and
+ * Zappa Nardelli. The ring doubles when full; earlier rings stay allocated until the deque is destroyed, since a
+ * thief may still be reading one.
+ * @tparam T A trivially copyable type for which atomic<T> is lock-free, typically a pointer
+ * @tparam Allocator Allocator the rings come from
+ */
+template<typename T, typename Allocator = std::allocator<T>> class work_stealing_deque
+{
+    static_assert(is_trivially_copyable_v<T> && atomic<T>::is_always_lock_free,
+                  "the deque holds values that are copied with one atomic access");
+
+    struct ring
+    {
+        std::size_t mask;
+        ring *previous;   //!< The smaller ring this one replaced.
+        atomic<T> *slots; //!< mask + 1 slots, allocated separately.
+
+        T get(std::ptrdiff_t index) const noexcept
+        {
+            return slots[static_cast<std::size_t>(index) & mask].load(memory_order::relaxed);
+        }
+
+        void put(std::ptrdiff_t index, T value) noexcept
+        {
+            slots[static_cast<std::size_t>(index) & mask].store(value, memory_order::relaxed);
+        }
+    };
+
+    using ring_allocator = typename allocator_traits<Allocator>::template rebind_alloc<ring>;
+    using slot_allocator = typename allocator_traits<Allocator>::template rebind_alloc<atomic<T>>;
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+
+    explicit work_stealing_deque(size_type capacity = 64, const Allocator &alloc = Allocator())
+        : _alloc(alloc)
+    {
+        _ring.store(make_ring(detail::ring_capacity(capacity, 2), nullptr), memory_order::relaxed);
+    }
+
+    work_stealing_deque(const work_stealing_deque &) = delete;
+    work_stealing_deque &operator=(const work_stealing_deque &) = delete;
+
+    ~work_stealing_deque()
+    {
+        ring *current = _ring.load(memory_order::relaxed);
+        while (current != nullptr)
+        {
+            ring *previous = current->previous;
+            free_ring(current);
+            current = previous;
+        }
+    }
+
+    //! Values in the deque, exact only while no thread is pushing, popping or stealing.
+    size_type size_approx() const noexcept
+    {
+        std::ptrdiff_t bottom = _bottom.load(memory_order::relaxed);
+        std::ptrdiff_t top = _top.load(memory_order::relaxed);
+        return bottom > top ? static_cast<size_type>(bottom - top) : 0;
+    }
+
+    bool empty() const noexcept
+    {
+        return size_approx() == 0;
+    }
+
+    /*!
+     * @brief Adds a value at the bottom, from the owner thread; grows the ring if it is full
+     */
+    void push(T value)
+    {
+        std::ptrdiff_t bottom = _bottom.load(memory_order::relaxed);
+        std::ptrdiff_t top = _top.load(memory_order::acquire);
+        ring *current = _ring.load(memory_order::relaxed);
+        if (bottom - top > static_cast<std::ptrdiff_t>(current->mask))
+        {
+            current = grow(current, top, bottom);
+        }
+        current->put(bottom, value);
+        // Release, so a thief that sees the new bottom also sees the value and what it points to
+        _bottom.store(bottom + 1, memory_order::release);
+    }
+
+    /*!
+     * @brief Takes the value pushed last, from the owner thread
+     * @return false if the deque is empty or a thief took its last value first
+     */
+    bool pop(T &out) noexcept
+    {
+        std::ptrdiff_t bottom = _bottom.load(memory_order::relaxed) - 1;
+        ring *current = _ring.load(memory_order::relaxed);
+        _bottom.store(bottom, memory_order::relaxed);
+        atomic_thread_fence(memory_order::seq_cst);
+        std::ptrdiff_t top = _top.load(memory_order::relaxed);
+        if (top > bottom)
+        {
+            _bottom.store(bottom + 1, memory_order::relaxed);
+            return false;
+        }
+        out = current->get(bottom);
+        if (top == bottom)
+        {
+            // The last value: whoever moves top past it owns it
+            bool won = _top.compare_exchange_strong(top, top + 1, memory_order::seq_cst, memory_order::relaxed);
+            _bottom.store(bottom + 1, memory_order::relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /*!
+     * @brief Takes the oldest value, from any thread
+     * @return false if the deque is empty or another thread took the value first; a caller that wants a value
+     * may try again
+     */
+    bool steal(T &out) noexcept
+    {
+        std::ptrdiff_t top = _top.load(memory_order::acquire);
+        atomic_thread_fence(memory_order::seq_cst);
+        std::ptrdiff_t bottom = _bottom.load(memory_order::acquire);
+        if (top >= bottom)
+        {
+            return false;
+        }
+        T value = _ring.load(memory_order::acquire)->get(top);
+        if (!_top.compare_exchange_strong(top, top + 1, memory_order::seq_cst, memory_order::relaxed))
+        {
+            return false;
+        }
+        out = value;
+        return true;
+    }
+
+  private:
+    alignas(detail::cache_line_size) atomic<std::ptrdiff_t> _top{0}; //!< Next value to steal; only grows.
+    alignas(detail::cache_line_size) atomic<std::ptrdiff_t> _bottom{0}; //!< Next slot to push to.
+    atomic<ring *> _ring{nullptr};
+    STD_NO_UNIQUE_ADDRESS Allocator _alloc{};
+
+    ring *make_ring(size_type capacity, ring *previous)
+    {
+        ring_allocator ring_alloc(_alloc);
+        slot_allocator slot_alloc(_alloc);
+        ring *created = allocator_traits<ring_allocator>::allocate(ring_alloc, 1);
+        created->mask = capacity - 1;
+        created->previous = previous;
+        created->slots = allocator_traits<slot_allocator>::allocate(slot_alloc, capacity);
+        for (size_type i = 0; i < capacity; ++i)
+        {
+            std::construct_at(created->slots + i);
+        }
+        return created;
+    }
+
+    void free_ring(ring *released) noexcept
+    {
+        ring_allocator ring_alloc(_alloc);
+        slot_allocator slot_alloc(_alloc);
+        allocator_traits<slot_allocator>::deallocate(slot_alloc, released->slots, released->mask + 1);
+        allocator_traits<ring_allocator>::deallocate(ring_alloc, released, 1);
+    }
+
+    ring *grow(ring *current, std::ptrdiff_t top, std::ptrdiff_t bottom)
+    {
+        ring *larger = make_ring((current->mask + 1) * 2, current);
+        for (std::ptrdiff_t i = top; i < bottom; ++i)
+        {
+            larger->put(i, current->get(i));
+        }
+        _ring.store(larger, memory_order::release);
+        return larger;
+    }
+};
+} // namespace std
+#endif
@@ -0,0 +1,201 @@
+/*!
+ * @file coroutine.h
+ * @brief The coroutine support types the compiler looks up in namespace std
+ * @namespace std
+ * @note This header is a part of the C++ standard library.
+ * Modeled after https://en.cppreference.com/w/cpp/coroutine. A coroutine's promise type is found through
+ * coroutine_traits and its frame is driven through coroutine_handle, which wraps the compiler's __builtin_coro_
+ * builtins; nothing here needs runtime support. See task.h for a coroutine type built on these.
+ */
+#ifndef COROUTINE_H
+#define COROUTINE_H
+#include <stddef.h>
+
+namespace std
+{
+namespace detail
+{
+template<typename R, typename = void> struct coroutine_promise
+{
+};
+
+template<typename R> struct coroutine_promise<R, decltype(void(sizeof(typename R::promise_type)))>
+{
+    using promise_type = typename R::promise_type;
+};
+} // namespace detail
+
+/*!
+ * @brief Names the promise type of a coroutine returning R, which is R::promise_type unless specialized
+ */
+template<typename R, typename... Args> struct coroutine_traits : detail::coroutine_promise<R>
+{
+};
+
+template<typename Promise = void> struct coroutine_handle;
+
+/*!
+ * @brief A handle to a suspended coroutine of any promise type
+ */
+template<> struct coroutine_handle<void>
+{
+    constexpr coroutine_handle() noexcept = default;
+
+    constexpr coroutine_handle(std::nullptr_t) noexcept
+    {
+    }
+
+    static constexpr coroutine_handle from_address(void *address) noexcept
+    {
+        coroutine_handle handle;
+        handle._frame = address;
+        return handle;
+    }
+
+    constexpr void *address() const noexcept
+    {
+        return _frame;
+    }
+
+    constexpr explicit operator bool() const noexcept
+    {
+        return _frame != nullptr;
+    }
+
+    //! Whether the coroutine is suspended at its final suspend point.
+    bool done() const noexcept
+    {
+        return __builtin_coro_done(_frame);
+    }
+
+    void resume() const
+    {
+        __builtin_coro_resume(_frame);
+    }
+
+    void operator()() const
+    {
+        resume();
+    }
+
+    //! Destroys the frame; the coroutine must be suspended.
+    void destroy() const
+    {
+        __builtin_coro_destroy(_frame);
+    }
+
+    friend constexpr bool operator==(coroutine_handle a, coroutine_handle b) noexcept
+    {
+        return a._frame == b._frame;
+    }
+
+  protected:
+    void *_frame = nullptr;
+};
+
+/*!
+ * @brief A handle to a suspended coroutine whose promise is a Promise
+ */
+template<typename Promise> struct coroutine_handle : coroutine_handle<void>
+{
+    constexpr coroutine_handle() noexcept = default;
+
+    constexpr coroutine_handle(std::nullptr_t) noexcept
+    {
+    }
+
+    static coroutine_handle from_promise(Promise &promise) noexcept
+    {
+        coroutine_handle handle;
+        handle._frame = __builtin_coro_promise(static_cast<void *>(&promise), __alignof(Promise), true);
+        return handle;
+    }
+
+    static constexpr coroutine_handle from_address(void *address) noexcept
+    {
+        coroutine_handle handle;
+        handle._frame = address;
+        return handle;
+    }
+
+    Promise &promise() const noexcept
+    {
+        return *static_cast<Promise *>(__builtin_coro_promise(_frame, __alignof(Promise), false));
+    }
+};
+
+/*!
+ * @brief The promise of the coroutine noop_coroutine() returns
+ */
+struct noop_coroutine_promise
+{
+};
+
+namespace detail
+{
+#if !defined(__clang__)
+inline void noop_resume(void *) noexcept
+{
+}
+
+//! A frame laid out like a GCC coroutine's, with resume and destroy entries that return at once.
+struct noop_frame
+{
+    void (*resume)(void *) noexcept = &noop_resume;
+    void (*destroy)(void *) noexcept = &noop_resume;
+    noop_coroutine_promise promise;
+};
+
+inline noop_frame noop_coroutine_frame;
+#endif
+} // namespace detail
+
+/*!
+ * @brief A coroutine that does nothing when resumed and is never done
+ * @details Returned from await_suspend() to suspend without resuming anything else.
+ */
+inline coroutine_handle<noop_coroutine_promise> noop_coroutine() noexcept
+{
+#if defined(__clang__)
+    return coroutine_handle<noop_coroutine_promise>::from_address(__builtin_coro_noop());
+#else
+    // GCC has no __builtin_coro_noop, so the frame is made by hand
+    return coroutine_handle<noop_coroutine_promise>::from_address(&detail::noop_coroutine_frame);
+#endif
+}
+
+//! An awaitable that always suspends.
+struct suspend_always
+{
+    constexpr bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    constexpr void await_suspend(coroutine_handle<>) const noexcept
+    {
+    }
+
+    constexpr void await_resume() const noexcept
+    {
+    }
+};
+
+//! An awaitable that never suspends.
+struct suspend_never
+{
+    constexpr bool await_ready() const noexcept
+    {
+        return true;
+    }
+
+    constexpr void await_suspend(coroutine_handle<>) const noexcept
+    {
+    }
+
+    constexpr void await_resume() const noexcept
+    {
+    }
+};
+} // namespace std
+#endif
@@ -5,44 +5,156 @@
 
 /*!
  * @brief Get the length of a C-style string.
+ * @details The string is scanned a vector (or word) at a time. Loads are aligned to the block size so they never
+ * cross into an unmapped page, even though the final block may read bytes past the terminator.
  * @param str The string to measure.
  * @return The length of the string.
  */
-inline std::size_t strlen(const char *str)
+STD_NO_SANITIZE_ADDRESS constexpr inline std::size_t strlen(const char *str)
 {
-    // Start at 0 and count up until the null terminator.
-    std::size_t len = 0;
-    while (str[len] != 0)
+    if (__builtin_is_constant_evaluated())
     {
-        ++len;
+        // Start at 0 and count up until the null terminator.
+        std::size_t len = 0;
+        while (str[len] != 0)
+        {
+            ++len;
+        }
+        return len;
     }
-    return len;
+
+    const unsigned char *start = reinterpret_cast<const unsigned char *>(str);
+#if defined(STD_SIMD_VECTOR)
+    using ops = std::detail::simd_ops;
+    const ops::type zero = ops::splat(0);
+    std::size_t misalign = reinterpret_cast<std::uintptr_t>(start) & (ops::width - 1);
+    const unsigned char *block = reinterpret_cast<const unsigned char *>(reinterpret_cast<std::uintptr_t>(start) -
+                                                                        misalign);
+
+    // Lanes before the start of the string are shifted out of the first mask
+    ops::mask_type mask = ops::eq_mask(ops::scan_load(block), zero) >> (misalign * ops::mask_bits_per_byte);
+    if (mask != 0)
+    {
+        return std::detail::count_trailing_zeros(mask) / ops::mask_bits_per_byte;
+    }
+    for (;;)
+    {
+        block += ops::width;
+        mask = ops::eq_mask(ops::scan_load(block), zero);
+        if (mask != 0)
+        {
+            return static_cast<std::size_t>(block - start) +
+                   std::detail::count_trailing_zeros(mask) / ops::mask_bits_per_byte;
+        }
+    }
+#else
+    const unsigned char *cur = start;
+    while ((reinterpret_cast<std::uintptr_t>(cur) & (sizeof(std::size_t) - 1)) != 0)
+    {
+        if (*cur == 0)
+        {
+            return static_cast<std::size_t>(cur - start);
+        }
+        ++cur;
+    }
+    while (!std::detail::word_has_zero_byte(*reinterpret_cast<const std::detail::unaligned_word *>(cur)))
+    {
+        cur += sizeof(std::size_t);
+    }
+    while (*cur != 0)
+    {
+        ++cur;
+    }
+    return static_cast<std::size_t>(cur - start);
+#endif
 }
 
 /*!
  * @brief Compare two C-style strings lexicographically.
+ * @details Both strings are walked once and the scan stops at the first differing byte or the terminator,
+ * whichever comes first. Blocks are only loaded when they do not cross a page boundary in either string.
  * @param str1 The first string to compare.
  * @param str2 The second string to compare.
  * @return An integer less than, equal to, or greater than zero if str1 is found, respectively, to be less than,
  * to match, or be greater than str2.
  */
-inline int strcmp(const char *str1, const char *str2)
+STD_NO_SANITIZE_ADDRESS constexpr inline int strcmp(const char *str1, const char *str2)
 {
-    // Get the lengths of both strings
-    auto len = strlen(str1);
-    auto len2 = strlen(str2);
-
-    // Compare lengths
-    if (len < len2)
+    if (!__builtin_is_constant_evaluated())
     {
-        return -1; // str1 is shorter than str2
+        const unsigned char *a = reinterpret_cast<const unsigned char *>(str1);
+        const unsigned char *b = reinterpret_cast<const unsigned char *>(str2);
+#if defined(STD_SIMD_VECTOR)
+        using ops = std::detail::simd_ops;
+        constexpr std::uintptr_t page_mask = 4095;
+        const ops::type zero = ops::splat(0);
+        for (;;)
+        {
+            if ((reinterpret_cast<std::uintptr_t>(a) & page_mask) <= page_mask + 1 - ops::width &&
+                (reinterpret_cast<std::uintptr_t>(b) & page_mask) <= page_mask + 1 - ops::width)
+            {
+                ops::type va = ops::scan_load(a);
+                // A lane stops the scan if the bytes differ or if it holds the terminator
+                ops::mask_type stop = (ops::eq_mask(va, ops::scan_load(b)) ^ ops::all_lanes) | ops::eq_mask(va, zero);
+                if (stop != 0)
+                {
+                    std::size_t lane = std::detail::count_trailing_zeros(stop) / ops::mask_bits_per_byte;
+                    return a[lane] < b[lane] ? -1 : (a[lane] > b[lane] ? 1 : 0);
+                }
+                a += ops::width;
+                b += ops::width;
+                continue;
+            }
+            // Close to a page boundary, step over it one byte at a time
+            if (*a != *b || *a == 0)
+            {
+                return *a < *b ? -1 : (*a > *b ? 1 : 0);
+            }
+            ++a;
+            ++b;
+        }
+#else
+        // Word compares are only possible when both strings share the same alignment
+        if (((reinterpret_cast<std::uintptr_t>(a) ^ reinterpret_cast<std::uintptr_t>(b)) &
+             (sizeof(std::size_t) - 1)) == 0)
+        {
+            while ((reinterpret_cast<std::uintptr_t>(a) & (sizeof(std::size_t) - 1)) != 0)
+            {
+                if (*a != *b || *a == 0)
+                {
+                    return *a < *b ? -1 : (*a > *b ? 1 : 0);
+                }
+                ++a;
+                ++b;
+            }
+            for (;;)
+            {
+                std::size_t wa = *reinterpret_cast<const std::detail::unaligned_word *>(a);
+                if (wa != *reinterpret_cast<const std::detail::unaligned_word *>(b) ||
+                    std::detail::word_has_zero_byte(wa))
+                {
+                    break;
+                }
+                a += sizeof(std::size_t);
+                b += sizeof(std::size_t);
+            }
+        }
+        while (*a == *b && *a != 0)
+        {
+            ++a;
+            ++b;
+        }
+        return *a < *b ? -1 : (*a > *b ? 1 : 0);
+#endif
     }
-    if (len > len2)
+
+    std::size_t i = 0;
+    while (str1[i] == str2[i] && str1[i] != 0)
     {
-        return 1; // str1 is longer than str2
+        ++i;
     }
-
-    // Compare strings lexicographically
-    return std::memcmp(str1, str2, len);
+    const unsigned char c1 = static_cast<unsigned char>(str1[i]);
+    const unsigned char c2 = static_cast<unsigned char>(str2[i]);
+    return c1 < c2 ? -1 : (c1 > c2 ? 1 : 0);
 }
-#endif
\ No newline at end of file
+#endif
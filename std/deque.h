@@ -0,0 +1,550 @@
+/**
+ * @file deque.h
+ * @brief A double-ended queue stored in fixed-size chunks.
+ * @note This header is a part of the C++ standard library.
+ * Modeled after https://en.cppreference.com/w/cpp/container/deque. Elements live in chunks of ChunkSize elements
+ * reached through a map of chunk pointers with free slots at both ends, so pushing or popping at either end is O(1)
+ * and never moves an element: references and pointers to elements stay valid until the element is removed.
+ * Iterators do not: any push may invalidate them, since making room in the map moves the chunk pointers within it
+ * even when the map itself is not reallocated.
+ *
+ * Chunks emptied by pops are freed once more than one spare chunk is left at that end, so a deque used as a FIFO
+ * keeps a bounded footprint and one pushed and popped across a chunk boundary does not allocate every time. Only
+ * the ends can be modified; there is no insert or erase in the middle. The chunks and iterator are the ones of
+ * segmented_vector.h, and for_each_chunk() walks the elements one contiguous run at a time.
+ */
+
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include <algorithm.h>
+#include <bounds_check.h>
+#include <initializer_list.h>
+#include <memory.h>
+#include <segmented_vector.h>
+#include <stddef.h>
+#include <stdexcept.h>
+#include <type_traits.h>
+
+namespace std
+{
+/**
+ * @brief A sequence with O(1) insertion and removal at both ends, keeping every element where it was constructed.
+ *
+ * @tparam T Type of elements stored in the deque. Must not be void.
+ * @tparam ChunkSize Number of elements in a chunk, a power of two.
+ * @tparam Allocator Allocator used for the chunks; the map uses it rebound to T *.
+ */
+template<typename T, size_t ChunkSize = detail::default_chunk_size<T>(), typename Allocator = std::allocator<T>>
+class deque final
+{
+    static_assert(!std::is_void<T>::value, "deque cannot be instantiated with void type");
+    static_assert(ChunkSize != 0 && (ChunkSize & (ChunkSize - 1)) == 0, "the chunk size must be a power of two");
+
+    using map_allocator = typename allocator_traits<Allocator>::template rebind_alloc<T *>;
+
+  public:
+    /// Element type.
+    using value_type = T;
+    /// Allocator type.
+    using allocator_type = Allocator;
+    /// Unsigned integral type.
+    using size_type = size_t;
+    /// Reference to an element.
+    using reference = T &;
+    /// Const reference to an element.
+    using const_reference = const T &;
+    /// Random access iterator.
+    using iterator = detail::segmented_iterator<T, T, ChunkSize>;
+    /// Constant random access iterator.
+    using const_iterator = detail::segmented_iterator<T, const T, ChunkSize>;
+
+    /// Number of elements in a chunk.
+    static constexpr size_type chunk_size = ChunkSize;
+
+    deque() = default;
+
+    /**
+     * @brief Constructs an empty deque whose chunks and map come from alloc.
+     */
+    explicit deque(const Allocator &alloc) noexcept
+        : _map_alloc(alloc)
+        , _alloc(alloc)
+    {
+    }
+
+    deque(std::initializer_list<T> list, const Allocator &alloc = Allocator())
+        : deque(alloc)
+    {
+        for (const T &value : list)
+        {
+            emplace_back(value);
+        }
+    }
+
+    /**
+     * @brief Copy constructor; the allocator is chosen by allocator_traits::select_on_container_copy_construction().
+     */
+    deque(const deque &other)
+        : deque(allocator_traits<Allocator>::select_on_container_copy_construction(other._alloc))
+    {
+        append_copy(other);
+    }
+
+    /**
+     * @brief Move constructor. Takes over the chunks, so references into other now refer into this deque.
+     */
+    deque(deque &&other) noexcept
+        : _map_alloc(other._map_alloc)
+        , _alloc(other._alloc)
+    {
+        take(other);
+    }
+
+    deque &operator=(const deque &other)
+    {
+        if (this != &other)
+        {
+            clear();
+            append_copy(other);
+        }
+        return *this;
+    }
+
+    deque &operator=(deque &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            _map_alloc = other._map_alloc;
+            _alloc = other._alloc;
+            take(other);
+        }
+        return *this;
+    }
+
+    ~deque()
+    {
+        release();
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return _alloc;
+    }
+
+    // Capacity functions
+
+    constexpr size_type size() const noexcept
+    {
+        return _size;
+    }
+
+    constexpr bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    constexpr size_type max_size() const noexcept
+    {
+        return size_type(-1);
+    }
+
+    /**
+     * @brief Returns the number of allocated chunks.
+     */
+    constexpr size_type chunk_count() const noexcept
+    {
+        return _chunk_count;
+    }
+
+    /**
+     * @brief Frees the spare chunks at both ends.
+     */
+    void shrink_to_fit() noexcept
+    {
+        if (_size == 0)
+        {
+            free_chunks();
+            return;
+        }
+        while (_start >= ChunkSize)
+        {
+            drop_front_chunk();
+        }
+        while (_chunk_count * ChunkSize - (_start + _size) >= ChunkSize)
+        {
+            drop_back_chunk();
+        }
+    }
+
+    // Element access
+
+    /**
+     * @brief Provides unchecked access to the element at specified position.
+     */
+    reference operator[](size_type pos) noexcept
+    {
+        return *slot(_start + pos);
+    }
+
+    const_reference operator[](size_type pos) const noexcept
+    {
+        return *slot(_start + pos);
+    }
+
+    /**
+     * @brief Provides access to the element at specified position with bounds checking.
+     *
+     * @throws std::out_of_range if pos is not within the range of the deque, unless STD_BOUNDS_CHECK says
+     * otherwise.
+     */
+    reference at(size_type pos) noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(pos < _size);
+        return (*this)[pos];
+    }
+
+    const_reference at(size_type pos) const noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(pos < _size);
+        return (*this)[pos];
+    }
+
+    /**
+     * @brief Returns a reference to the first element. On an empty deque this fails as STD_BOUNDS_CHECK says.
+     */
+    reference front() noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(_size != 0);
+        return (*this)[0];
+    }
+
+    const_reference front() const noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(_size != 0);
+        return (*this)[0];
+    }
+
+    /**
+     * @brief Returns a reference to the last element. On an empty deque this fails as STD_BOUNDS_CHECK says.
+     */
+    reference back() noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(_size != 0);
+        return (*this)[_size - 1];
+    }
+
+    const_reference back() const noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(_size != 0);
+        return (*this)[_size - 1];
+    }
+
+    // Iterators
+
+    iterator begin() noexcept
+    {
+        return iterator(chunks(), _start);
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(chunks(), _start);
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(chunks(), _start + _size);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(chunks(), _start + _size);
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    /**
+     * @brief Calls fn(T *data, size_type count) for each chunk's contiguous run of elements, front to back.
+     */
+    template<typename Fn> void for_each_chunk(Fn &&fn)
+    {
+        detail::for_each_segment<ChunkSize>(chunks(), _start, _size, fn);
+    }
+
+    /**
+     * @brief Calls fn(const T *data, size_type count) for each chunk's contiguous run of elements, front to back.
+     */
+    template<typename Fn> void for_each_chunk(Fn &&fn) const
+    {
+        detail::for_each_segment<ChunkSize>(const_cast<const T *const *>(chunks()), _start, _size, fn);
+    }
+
+    // Modifiers
+
+    /**
+     * @brief Constructs an element at the back, in a new chunk if the last one is full.
+     *
+     * @return Reference to the new element.
+     */
+    template<typename... Args> reference emplace_back(Args &&...args)
+    {
+        if (_start + _size == _chunk_count * ChunkSize)
+        {
+            add_back_chunk();
+        }
+        T *element = slot(_start + _size);
+        std::construct_at(element, std::forward<Args>(args)...);
+        ++_size;
+        return *element;
+    }
+
+    /**
+     * @brief Constructs an element at the front, in a new chunk if the first one is full.
+     *
+     * @return Reference to the new element.
+     */
+    template<typename... Args> reference emplace_front(Args &&...args)
+    {
+        if (_start == 0)
+        {
+            add_front_chunk();
+        }
+        T *element = slot(_start - 1);
+        std::construct_at(element, std::forward<Args>(args)...);
+        --_start;
+        ++_size;
+        return *element;
+    }
+
+    void push_back(const T &value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T &&value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    void push_front(const T &value)
+    {
+        emplace_front(value);
+    }
+
+    void push_front(T &&value)
+    {
+        emplace_front(std::move(value));
+    }
+
+    /**
+     * @brief Removes the last element.
+     */
+    void pop_back()
+    {
+        if (_size == 0)
+        {
+            return;
+        }
+        --_size;
+        std::destroy_at(slot(_start + _size));
+        if (_chunk_count * ChunkSize - (_start + _size) >= 2 * ChunkSize)
+        {
+            drop_back_chunk();
+        }
+    }
+
+    /**
+     * @brief Removes the first element.
+     */
+    void pop_front()
+    {
+        if (_size == 0)
+        {
+            return;
+        }
+        std::destroy_at(slot(_start));
+        ++_start;
+        --_size;
+        if (_start >= 2 * ChunkSize)
+        {
+            drop_front_chunk();
+        }
+    }
+
+    /**
+     * @brief Destroys all elements and frees all chunks but one. The map is kept.
+     */
+    void clear() noexcept
+    {
+        for_each_chunk([](T *data, size_type count) { std::destroy(data, data + count); });
+        _size = 0;
+        while (_chunk_count > 1)
+        {
+            drop_back_chunk();
+        }
+        _start = 0;
+    }
+
+    void swap(deque &other) noexcept
+    {
+        std::swap(_map, other._map);
+        std::swap(_map_capacity, other._map_capacity);
+        std::swap(_map_first, other._map_first);
+        std::swap(_chunk_count, other._chunk_count);
+        std::swap(_start, other._start);
+        std::swap(_size, other._size);
+        std::swap(_map_alloc, other._map_alloc);
+        std::swap(_alloc, other._alloc);
+    }
+
+  private:
+    T **_map = nullptr;                               ///< Chunk pointers, in use from _map_first for _chunk_count.
+    size_type _map_capacity = 0;                      ///< Number of slots in _map.
+    size_type _map_first = 0;                         ///< Slot of the first chunk.
+    size_type _chunk_count = 0;                       ///< Number of chunks in use, each holding ChunkSize elements.
+    size_type _start = 0;                             ///< Position of the front element, below 2 * ChunkSize.
+    size_type _size = 0;                              ///< The number of elements.
+    STD_NO_UNIQUE_ADDRESS map_allocator _map_alloc{}; ///< Allocates the map.
+    STD_NO_UNIQUE_ADDRESS Allocator _alloc{};         ///< Allocates the chunks.
+
+    T *const *chunks() const noexcept
+    {
+        return _map + _map_first;
+    }
+
+    //! Returns the element slot at position, counted from the start of the first chunk.
+    T *slot(size_type position) const noexcept
+    {
+        return _map[_map_first + position / ChunkSize] + position % ChunkSize;
+    }
+
+    void append_copy(const deque &other)
+    {
+        other.for_each_chunk([this](const T *data, size_type count) {
+            for (size_type i = 0; i < count; ++i)
+            {
+                emplace_back(data[i]);
+            }
+        });
+    }
+
+    void take(deque &other) noexcept
+    {
+        _map = other._map;
+        _map_capacity = other._map_capacity;
+        _map_first = other._map_first;
+        _chunk_count = other._chunk_count;
+        _start = other._start;
+        _size = other._size;
+        other._map = nullptr;
+        other._map_capacity = 0;
+        other._map_first = 0;
+        other._chunk_count = 0;
+        other._start = 0;
+        other._size = 0;
+    }
+
+    /**
+     * @brief Makes room in the map for one more chunk at the front or the back.
+     *
+     * Recentres the chunks in place while the map is at most half full, and moves them to the middle of a map twice
+     * as large otherwise. Only chunk pointers are copied.
+     */
+    void make_map_room(bool at_front)
+    {
+        size_type needed = _chunk_count + 1;
+        if (needed * 2 <= _map_capacity)
+        {
+            size_type first = (_map_capacity - needed) / 2 + (at_front ? 1 : 0);
+            std::memmove(_map + first, _map + _map_first, _chunk_count * sizeof(T *));
+            _map_first = first;
+            return;
+        }
+        size_type capacity = _map_capacity * 2 < 8 ? 8 : _map_capacity * 2;
+        T **map = allocator_traits<map_allocator>::allocate(_map_alloc, capacity);
+        size_type first = (capacity - needed) / 2 + (at_front ? 1 : 0);
+        if (_chunk_count != 0)
+        {
+            std::memcpy(map + first, _map + _map_first, _chunk_count * sizeof(T *));
+        }
+        if (_map != nullptr)
+        {
+            allocator_traits<map_allocator>::deallocate(_map_alloc, _map, _map_capacity);
+        }
+        _map = map;
+        _map_capacity = capacity;
+        _map_first = first;
+    }
+
+    void add_back_chunk()
+    {
+        if (_map_first + _chunk_count == _map_capacity)
+        {
+            make_map_room(false);
+        }
+        _map[_map_first + _chunk_count] = allocator_traits<Allocator>::allocate(_alloc, ChunkSize);
+        ++_chunk_count;
+    }
+
+    void add_front_chunk()
+    {
+        if (_map_first == 0)
+        {
+            make_map_room(true);
+        }
+        T *chunk = allocator_traits<Allocator>::allocate(_alloc, ChunkSize);
+        --_map_first;
+        _map[_map_first] = chunk;
+        ++_chunk_count;
+        _start += ChunkSize;
+    }
+
+    void drop_back_chunk() noexcept
+    {
+        --_chunk_count;
+        allocator_traits<Allocator>::deallocate(_alloc, _map[_map_first + _chunk_count], ChunkSize);
+    }
+
+    void drop_front_chunk() noexcept
+    {
+        allocator_traits<Allocator>::deallocate(_alloc, _map[_map_first], ChunkSize);
+        ++_map_first;
+        --_chunk_count;
+        _start -= ChunkSize;
+    }
+
+    void free_chunks() noexcept
+    {
+        while (_chunk_count != 0)
+        {
+            drop_back_chunk();
+        }
+        _start = 0;
+    }
+
+    void release() noexcept
+    {
+        for_each_chunk([](T *data, size_type count) { std::destroy(data, data + count); });
+        _size = 0;
+        free_chunks();
+        if (_map != nullptr)
+        {
+            allocator_traits<map_allocator>::deallocate(_map_alloc, _map, _map_capacity);
+            _map = nullptr;
+            _map_capacity = 0;
+            _map_first = 0;
+        }
+    }
+};
+} // namespace std
+#endif
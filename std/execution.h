@@ -0,0 +1,517 @@
+/*!
+ * @file execution.h
+ * @brief Execution policies and the parallel overloads of the algorithms
+ * @namespace std
+ * @note This header is a part of the C++ standard library.
+ * Modeled after https://en.cppreference.com/w/cpp/algorithm/execution_policy_tag_t. Passing execution::par or
+ * execution::par_unseq as the first argument of sort, fill, copy, transform, reduce or for_each splits the range into
+ * chunks that run on a pool of worker threads started on first use. Idle participants steal half of the chunks left
+ * to another one, so uneven work still spreads over the pool. seq and unseq run the sequential algorithm.
+ *
+ * The pool sits on the os:: hooks of thread.h. Without STD_HAS_OS_THREADS, a nested parallel call (the pool runs one
+ * job at a time) or a range too small to be worth splitting, the algorithm runs on the calling thread. As the
+ * standard requires, an exception leaving an element function under a parallel policy calls std::terminate().
+ * The overloads take random access iterators.
+ */
+#ifndef EXECUTION_H
+#define EXECUTION_H
+#include <algorithm.h>
+#include <iterator.h>
+#include <numeric.h>
+#include <stddef.h>
+#include <thread.h>
+#include <type_traits.h>
+#include <utility.h>
+
+namespace std
+{
+namespace execution
+{
+struct sequenced_policy
+{
+    explicit sequenced_policy() = default;
+};
+
+struct parallel_policy
+{
+    explicit parallel_policy() = default;
+};
+
+struct parallel_unsequenced_policy
+{
+    explicit parallel_unsequenced_policy() = default;
+};
+
+struct unsequenced_policy
+{
+    explicit unsequenced_policy() = default;
+};
+
+inline constexpr sequenced_policy seq{};
+inline constexpr parallel_policy par{};
+inline constexpr parallel_unsequenced_policy par_unseq{};
+inline constexpr unsequenced_policy unseq{};
+} // namespace execution
+
+template<typename T> struct is_execution_policy : false_type
+{
+};
+template<> struct is_execution_policy<execution::sequenced_policy> : true_type
+{
+};
+template<> struct is_execution_policy<execution::parallel_policy> : true_type
+{
+};
+template<> struct is_execution_policy<execution::parallel_unsequenced_policy> : true_type
+{
+};
+template<> struct is_execution_policy<execution::unsequenced_policy> : true_type
+{
+};
+
+template<typename T> inline constexpr bool is_execution_policy_v = is_execution_policy<T>::value;
+
+namespace detail
+{
+template<typename Policy> using policy_t = remove_cv_t<remove_reference_t<Policy>>;
+
+template<typename Policy>
+concept execution_policy = is_execution_policy_v<policy_t<Policy>>;
+
+template<typename Policy>
+inline constexpr bool is_parallel_policy_v = is_same_v<policy_t<Policy>, execution::parallel_policy> ||
+                                             is_same_v<policy_t<Policy>, execution::parallel_unsequenced_policy>;
+
+inline constexpr std::size_t parallel_min_chunk = 4096;       //!< Elements below which a chunk is not worth a thread.
+inline constexpr std::size_t parallel_sort_min_chunk = 16384; //!< The same for the runs of the parallel sort.
+inline constexpr std::size_t parallel_chunks_per_thread = 8;  //!< Chunks per participant, which gives stealing slack.
+
+using parallel_chunk_fn = void (*)(void *context, std::size_t chunk) noexcept;
+
+#if defined(STD_HAS_OS_THREADS)
+/*!
+ * @brief The worker threads behind the parallel algorithms
+ * @details One job runs at a time. A job is a chunk count and a function; the chunks are dealt out evenly to the
+ * caller and the workers, each of which takes its own from the front and, once out, steals the back half of what
+ * another participant has left. Idle workers sleep in os::thread_wait() on the job generation.
+ */
+class thread_pool
+{
+  public:
+    static constexpr std::size_t max_workers = 255;
+
+    static thread_pool &instance()
+    {
+        static thread_pool pool;
+        return pool;
+    }
+
+    /*!
+     * @brief Returns the number of threads that work on a job, the caller included
+     */
+    std::size_t participants() const noexcept
+    {
+        return _worker_count + 1;
+    }
+
+    /*!
+     * @brief Runs fn(context, chunk) for every chunk in [0, chunk_count) and returns once all have finished
+     * @return False, without running anything, if there are no workers or another job is running
+     */
+    bool run(parallel_chunk_fn fn, void *context, std::size_t chunk_count) noexcept
+    {
+        if (_worker_count == 0 || !_busy.try_lock())
+        {
+            return false;
+        }
+        _job_fn = fn;
+        _job_context = context;
+        std::size_t count = participants();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            _slots[i].next = chunk_count / count * i + min(i, chunk_count % count);
+            _slots[i].end = chunk_count / count * (i + 1) + min(i + 1, chunk_count % count);
+        }
+        __atomic_store_n(&_active, static_cast<unsigned int>(_worker_count), __ATOMIC_RELAXED);
+        __atomic_add_fetch(&_generation, 1u, __ATOMIC_RELEASE);
+        os::thread_wake_all(&_generation);
+
+        execute(0);
+        unsigned int active;
+        while ((active = __atomic_load_n(&_active, __ATOMIC_ACQUIRE)) != 0)
+        {
+            os::thread_wait(&_active, active);
+        }
+        _busy.unlock();
+        return true;
+    }
+
+    thread_pool(const thread_pool &) = delete;
+    thread_pool &operator=(const thread_pool &) = delete;
+
+  private:
+    /*!
+     * @brief The chunks [next, end) a participant has left, on its own cache line
+     */
+    struct alignas(64) range_slot
+    {
+        spin_lock lock;
+        std::size_t next = 0;
+        std::size_t end = 0;
+    };
+
+    struct worker
+    {
+        thread_pool *pool = nullptr;
+        std::size_t slot = 0;
+        void *thread = nullptr;
+    };
+
+    static constexpr unsigned int spin_before_wait = 1024; //!< Polls of the generation before a worker sleeps.
+
+    range_slot _slots[max_workers + 1];
+    worker _workers[max_workers];
+    std::size_t _worker_count = 0;
+    spin_lock _busy;
+    parallel_chunk_fn _job_fn = nullptr;
+    void *_job_context = nullptr;
+    unsigned int _generation = 0; //!< Bumped to publish a job; workers sleep on it.
+    unsigned int _active = 0;     //!< Workers still in the current job; the caller sleeps on it.
+    bool _stopping = false;
+
+    thread_pool() noexcept
+    {
+        unsigned int threads = os::thread_count();
+        std::size_t wanted = min<std::size_t>(threads > 1 ? threads - 1 : 0, max_workers);
+        for (std::size_t i = 0; i < wanted; ++i)
+        {
+            _workers[i].pool = this;
+            _workers[i].slot = i + 1;
+            _workers[i].thread = os::thread_spawn(&worker_main, &_workers[i]);
+            if (_workers[i].thread == nullptr)
+            {
+                break;
+            }
+            ++_worker_count;
+        }
+    }
+
+    ~thread_pool()
+    {
+        __atomic_store_n(&_stopping, true, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&_generation, 1u, __ATOMIC_RELEASE);
+        os::thread_wake_all(&_generation);
+        for (std::size_t i = 0; i < _worker_count; ++i)
+        {
+            os::thread_join(_workers[i].thread);
+        }
+    }
+
+    static void worker_main(void *argument)
+    {
+        worker *self = static_cast<worker *>(argument);
+        self->pool->work(self->slot);
+#if defined(STD_ENABLE_MEMORY_POOL)
+        std::memory_pool::flush_thread_cache();
+#endif
+    }
+
+    void work(std::size_t slot) noexcept
+    {
+        unsigned int seen = 0;
+        for (;;)
+        {
+            unsigned int generation;
+            unsigned int spins = 0;
+            while ((generation = __atomic_load_n(&_generation, __ATOMIC_ACQUIRE)) == seen)
+            {
+                if (spins < spin_before_wait)
+                {
+                    ++spins;
+                    cpu_relax();
+                }
+                else
+                {
+                    os::thread_wait(&_generation, seen);
+                }
+            }
+            seen = generation;
+            if (__atomic_load_n(&_stopping, __ATOMIC_RELAXED))
+            {
+                return;
+            }
+            execute(slot);
+            if (__atomic_sub_fetch(&_active, 1u, __ATOMIC_ACQ_REL) == 0)
+            {
+                os::thread_wake_all(&_active);
+            }
+        }
+    }
+
+    void execute(std::size_t slot) noexcept
+    {
+        std::size_t chunk;
+        while (take(slot, chunk) || steal(slot, chunk))
+        {
+            _job_fn(_job_context, chunk);
+        }
+    }
+
+    bool take(std::size_t slot, std::size_t &chunk) noexcept
+    {
+        range_slot &own = _slots[slot];
+        own.lock.lock();
+        bool found = own.next < own.end;
+        if (found)
+        {
+            chunk = own.next++;
+        }
+        own.lock.unlock();
+        return found;
+    }
+
+    bool steal(std::size_t slot, std::size_t &chunk) noexcept
+    {
+        std::size_t count = participants();
+        for (std::size_t i = 1; i < count; ++i)
+        {
+            range_slot &victim = _slots[(slot + i) % count];
+            victim.lock.lock();
+            std::size_t half = (victim.end - victim.next + 1) / 2;
+            std::size_t begin = victim.end - half;
+            victim.end = begin;
+            victim.lock.unlock();
+            if (half == 0)
+            {
+                continue;
+            }
+            // The stolen chunks become this participant's own; its slot is empty, so nobody else touches it
+            chunk = begin;
+            range_slot &own = _slots[slot];
+            own.lock.lock();
+            own.next = begin + 1;
+            own.end = begin + half;
+            own.lock.unlock();
+            return true;
+        }
+        return false;
+    }
+};
+#endif
+
+/*!
+ * @brief Returns the offset of chunk index when count elements are split into chunks as even as possible
+ */
+constexpr std::size_t chunk_begin(std::size_t count, std::size_t chunks, std::size_t index) noexcept
+{
+    return count / chunks * index + min(index, count % chunks);
+}
+
+/*!
+ * @brief Returns how many chunks to split count elements into under Policy, 1 to run sequentially
+ */
+template<typename Policy> std::size_t chunk_count(std::size_t count, std::size_t min_chunk) noexcept
+{
+#if defined(STD_HAS_OS_THREADS)
+    if constexpr (is_parallel_policy_v<Policy>)
+    {
+        std::size_t chunks = count / min_chunk;
+        if (chunks > 1)
+        {
+            return min(chunks, thread_pool::instance().participants() * parallel_chunks_per_thread);
+        }
+    }
+#else
+    (void)count;
+    (void)min_chunk;
+#endif
+    return 1;
+}
+
+template<typename Body> void run_chunk(void *body, std::size_t chunk) noexcept
+{
+    (*static_cast<Body *>(body))(chunk);
+}
+
+/*!
+ * @brief Calls body(chunk) for every chunk in [0, chunks), on the pool when it is free and on this thread otherwise
+ */
+template<typename Body> void run_chunks(std::size_t chunks, Body &body)
+{
+#if defined(STD_HAS_OS_THREADS)
+    if (chunks > 1 && thread_pool::instance().run(&run_chunk<Body>, &body, chunks))
+    {
+        return;
+    }
+#endif
+    for (std::size_t i = 0; i < chunks; ++i)
+    {
+        run_chunk<Body>(&body, i);
+    }
+}
+
+/*!
+ * @brief Splits [0, count) into chunks and calls body(begin, end) for each of them
+ */
+template<typename Policy, typename Body> void parallel_for(std::size_t count, std::size_t min_chunk, Body body)
+{
+    std::size_t chunks = chunk_count<Policy>(count, min_chunk);
+    if (chunks <= 1)
+    {
+        body(std::size_t(0), count);
+        return;
+    }
+    auto chunk_body = [&](std::size_t chunk) {
+        body(chunk_begin(count, chunks, chunk), chunk_begin(count, chunks, chunk + 1));
+    };
+    run_chunks(chunks, chunk_body);
+}
+} // namespace detail
+
+/*!
+ * @brief Assigns value to every element of [first, last)
+ */
+template<detail::execution_policy Policy, typename RandomIt, typename T>
+void fill(Policy &&, RandomIt first, RandomIt last, const T &value)
+{
+    detail::parallel_for<detail::policy_t<Policy>>(static_cast<std::size_t>(last - first), detail::parallel_min_chunk,
+                                                    [&](std::size_t begin, std::size_t end) {
+                                                        std::fill(first + begin, first + end, value);
+                                                    });
+}
+
+/*!
+ * @brief Copies [first, last) to the range starting at d_first, which must not overlap it
+ * @return The end of the written range
+ */
+template<detail::execution_policy Policy, typename RandomIt, typename OutputIt>
+OutputIt copy(Policy &&, RandomIt first, RandomIt last, OutputIt d_first)
+{
+    std::size_t count = static_cast<std::size_t>(last - first);
+    detail::parallel_for<detail::policy_t<Policy>>(count, detail::parallel_min_chunk,
+                                                    [&](std::size_t begin, std::size_t end) {
+                                                        std::copy(first + begin, first + end, d_first + begin);
+                                                    });
+    return d_first + count;
+}
+
+/*!
+ * @brief Writes op(x) for every x in [first, last) to the range starting at d_first
+ * @return The end of the written range
+ */
+template<detail::execution_policy Policy, typename RandomIt, typename OutputIt, typename UnaryOp>
+OutputIt transform(Policy &&, RandomIt first, RandomIt last, OutputIt d_first, UnaryOp op)
+{
+    std::size_t count = static_cast<std::size_t>(last - first);
+    detail::parallel_for<detail::policy_t<Policy>>(
+        count, detail::parallel_min_chunk, [&](std::size_t begin, std::size_t end) {
+            std::transform(first + begin, first + end, d_first + begin, op);
+        });
+    return d_first + count;
+}
+
+/*!
+ * @brief Calls f on every element of [first, last), in no particular order under a parallel policy
+ */
+template<detail::execution_policy Policy, typename RandomIt, typename UnaryFunc>
+void for_each(Policy &&, RandomIt first, RandomIt last, UnaryFunc f)
+{
+    detail::parallel_for<detail::policy_t<Policy>>(static_cast<std::size_t>(last - first), detail::parallel_min_chunk,
+                                                    [&](std::size_t begin, std::size_t end) {
+                                                        std::for_each(first + begin, first + end, f);
+                                                    });
+}
+
+/*!
+ * @brief Folds [first, last) into init with op, which must be associative and commutative
+ * @details Each chunk is folded on its own, starting from its first element, and the partial results are then
+ * folded into init in chunk order.
+ */
+template<detail::execution_policy Policy, typename RandomIt, typename T, typename BinaryOp>
+T reduce(Policy &&, RandomIt first, RandomIt last, T init, BinaryOp op)
+{
+    std::size_t count = static_cast<std::size_t>(last - first);
+    std::size_t chunks = detail::chunk_count<detail::policy_t<Policy>>(count, detail::parallel_min_chunk);
+    if (chunks <= 1)
+    {
+        return std::reduce(first, last, std::move(init), op);
+    }
+    detail::sort_buffer<T> partial(chunks);
+    auto chunk_body = [&](std::size_t chunk) {
+        RandomIt it = first + detail::chunk_begin(count, chunks, chunk);
+        RandomIt end = first + detail::chunk_begin(count, chunks, chunk + 1);
+        T value = *it;
+        for (++it; it != end; ++it)
+        {
+            value = op(std::move(value), *it);
+        }
+        ::new (static_cast<void *>(partial.data + chunk)) T(std::move(value));
+    };
+    detail::run_chunks(chunks, chunk_body);
+    for (std::size_t i = 0; i < chunks; ++i)
+    {
+        init = op(std::move(init), std::move(partial.data[i]));
+        partial.data[i].~T();
+    }
+    return init;
+}
+
+template<detail::execution_policy Policy, typename RandomIt, typename T>
+T reduce(Policy &&policy, RandomIt first, RandomIt last, T init)
+{
+    return std::reduce(std::forward<Policy>(policy), first, last, std::move(init),
+                       [](T a, const T &b) { return std::move(a) + b; });
+}
+
+template<detail::execution_policy Policy, typename RandomIt>
+typename std::iterator_traits<RandomIt>::value_type reduce(Policy &&policy, RandomIt first, RandomIt last)
+{
+    return std::reduce(std::forward<Policy>(policy), first, last,
+                       typename std::iterator_traits<RandomIt>::value_type{});
+}
+
+/*!
+ * @brief Sorts [first, last) with comp
+ * @details Under a parallel policy every chunk is sorted with std::sort() and neighbouring runs are merged pairwise,
+ * each round of merges in parallel, through a buffer the size of the range. The order of equal elements is not
+ * preserved.
+ */
+template<detail::execution_policy Policy, typename RandomIt, typename Compare>
+void sort(Policy &&, RandomIt first, RandomIt last, Compare comp)
+{
+    std::size_t count = static_cast<std::size_t>(last - first);
+    std::size_t chunks = detail::chunk_count<detail::policy_t<Policy>>(count, detail::parallel_sort_min_chunk);
+    if (chunks <= 1)
+    {
+        std::sort(first, last, comp);
+        return;
+    }
+    auto sort_body = [&](std::size_t chunk) {
+        std::sort(first + detail::chunk_begin(count, chunks, chunk),
+                  first + detail::chunk_begin(count, chunks, chunk + 1), comp);
+    };
+    detail::run_chunks(chunks, sort_body);
+
+    detail::sort_buffer<detail::iter_value_t<RandomIt>> buffer(count);
+    for (std::size_t width = 1; width < chunks; width *= 2)
+    {
+        // Merge k joins the runs of chunks [2kw, 2kw + w) and [2kw + w, 2kw + 2w)
+        std::size_t merges = (chunks + 2 * width - 1) / (2 * width);
+        auto merge_body = [&](std::size_t merge) {
+            std::size_t left = merge * 2 * width;
+            std::size_t middle = min(left + width, chunks);
+            std::size_t right = min(left + 2 * width, chunks);
+            std::size_t begin = detail::chunk_begin(count, chunks, left);
+            detail::merge_adjacent(first + begin, first + detail::chunk_begin(count, chunks, middle),
+                                   first + detail::chunk_begin(count, chunks, right), buffer.data + begin, comp);
+        };
+        detail::run_chunks(merges, merge_body);
+    }
+}
+
+template<detail::execution_policy Policy, typename RandomIt> void sort(Policy &&policy, RandomIt first, RandomIt last)
+{
+    std::sort(std::forward<Policy>(policy), first, last, std::less<>());
+}
+} // namespace std
+#endif
@@ -1,6 +1,43 @@
 #ifndef EXPECTED_H
 #define EXPECTED_H
-#include <is_type.h>
+#include <new.h>
+#include <stddef.h>
+#include <type_traits.h>
+namespace std
+{
+/*!
+ * @brief An error on its way into an Expected, for returning the error case without naming the value type
+ * @details An Expected<T, E> is constructible from unexpected<E>, so return std::unexpected(error); works in any
+ * function returning an Expected with that error type.
+ */
+template<typename E> class unexpected
+{
+  public:
+    constexpr explicit unexpected(const E &error)
+        : _error(error)
+    {
+    }
+
+    constexpr explicit unexpected(E &&error)
+        : _error(static_cast<E &&>(error))
+    {
+    }
+
+    constexpr E &error() & noexcept
+    {
+        return _error;
+    }
+
+    constexpr const E &error() const & noexcept
+    {
+        return _error;
+    }
+
+  private:
+    E _error;
+};
+} // namespace std
+
 namespace LunaVoxelEngine
 {
 namespace Utils
@@ -25,6 +62,12 @@ template<typename T, typename E> class Expected
     {
     }
 
+    constexpr Expected(::std::unexpected<E> e)
+        : err(static_cast<E &&>(e.error()))
+        , has_val(false)
+    {
+    }
+
     constexpr Expected()
         : has_val(true)
     {
@@ -34,7 +77,7 @@ template<typename T, typename E> class Expected
 
     ~Expected()
     {
-        if (!is_void_v<T> && has_val)
+        if (has_val)
         {
             val.~T();
         }
@@ -58,6 +101,19 @@ template<typename T, typename E> class Expected
         }
     }
 
+    Expected(Expected &&other)
+        : has_val(other.has_val)
+    {
+        if (has_val)
+        {
+            new (&val) T(static_cast<T &&>(other.val));
+        }
+        else
+        {
+            new (&err) E(static_cast<E &&>(other.err));
+        }
+    }
+
     Expected &operator=(const Expected &other)
     {
         if (this != &other)
@@ -82,6 +138,11 @@ template<typename T, typename E> class Expected
         return Expected(static_cast<E &&>(e), nullptr);
     }
 
+    static constexpr Expected<T, E> Unexpected(const E &e)
+    {
+        return Expected(E(e), nullptr);
+    }
+
     constexpr bool has_value() const noexcept
     {
         return has_val;
@@ -92,6 +153,11 @@ template<typename T, typename E> class Expected
         return !has_val;
     }
 
+    constexpr T &value() &
+    {
+        return val;
+    }
+
     constexpr const T &value() const &
     {
         return val;
@@ -124,7 +190,7 @@ template<typename T, typename E> class Expected
     }
 
   private:
-    constexpr Expected(E &&e, nullptr_t)
+    constexpr Expected(E &&e, std::nullptr_t)
         : err(static_cast<E &&>(e))
         , has_val(false)
     {
@@ -132,4 +198,12 @@ template<typename T, typename E> class Expected
 };
 } // namespace Utils
 } // namespace LunaVoxelEngine
+
+namespace std
+{
+/*!
+ * @brief A value of T or the error E that prevented it, for code that reports failures without throwing
+ */
+template<typename T, typename E> using Expected = LunaVoxelEngine::Utils::Expected<T, E>;
+} // namespace std
 #endif
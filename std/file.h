@@ -0,0 +1,326 @@
+/*!
+ * @file file.h
+ * @brief Reading files through the os:: file hooks, mapped whole or streamed in chunks
+ * @namespace std
+ * @details Like the allocation hooks in new.h, files come from functions the program provides. They are declared
+ * only when STD_HAS_OS_FILES is defined for the whole program, which the ENABLE_OS_FILES CMake option does.
+ *
+ * mapped_file shows a whole file as one view of its bytes. When the os can map it, the view points into the mapping
+ * and nothing is copied; otherwise the file is read once into a single block. utf8_reader is for inputs of any size:
+ * it reads a fixed-size chunk at a time and converts each one to UTF-16 as it arrives, so memory stays the same
+ * however long the file is.
+ */
+#ifndef FILE_H
+#define FILE_H
+#include <new.h>
+#include <stddef.h>
+#include <string_view.h>
+#include <utf.h>
+#include <utility.h>
+#include <vector.h>
+
+#if defined(STD_HAS_OS_FILES)
+namespace os
+{
+    /*!
+     * @brief Opens a file for reading
+     * @return A handle for the other file hooks, or nullptr if the file cannot be opened
+     */
+    void *file_open(const char *path);
+
+    /*!
+     * @brief Closes a file from file_open(); mappings made from it stay valid
+     */
+    void file_close(void *file);
+
+    /*!
+     * @brief Returns the size of an open file in bytes
+     */
+    unsigned long long file_size(void *file);
+
+    /*!
+     * @brief Reads the next bytes of the file into buffer
+     * @details May read fewer than size bytes before the end of the file; callers read again for the rest.
+     * @return The number of bytes read, 0 at the end of the file, or static_cast<std::size_t>(-1) on an error
+     */
+    std::size_t file_read(void *file, void *buffer, std::size_t size);
+
+    /*!
+     * @brief Maps the first size bytes of the file read-only into memory
+     * @return The address of the mapping, or nullptr if the file cannot be mapped, in which case it is read instead
+     */
+    const void *file_map(void *file, std::size_t size);
+
+    /*!
+     * @brief Releases a mapping from file_map()
+     */
+    void file_unmap(const void *address, std::size_t size);
+} // namespace os
+
+namespace std
+{
+/*!
+ * @brief The whole contents of a file as a read-only view of its bytes
+ * @details Opening maps the file where the os supports it, so the view is the os's own pages and nothing is copied
+ * or allocated. Otherwise the file is read into one allocated block. Either way the bytes stay valid until the
+ * mapped_file is closed or destroyed, and reflect the file as it was when opened.
+ */
+class mapped_file final
+{
+  public:
+    mapped_file() noexcept = default;
+
+    //! Opens path; is_open() tells whether that worked.
+    explicit mapped_file(const char *path)
+    {
+        open(path);
+    }
+
+    mapped_file(mapped_file &&other) noexcept
+        : _data(std::exchange(other._data, nullptr))
+        , _size(std::exchange(other._size, 0u))
+        , _mapped(std::exchange(other._mapped, false))
+    {
+    }
+
+    mapped_file &operator=(mapped_file &&other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            _data = std::exchange(other._data, nullptr);
+            _size = std::exchange(other._size, 0u);
+            _mapped = std::exchange(other._mapped, false);
+        }
+        return *this;
+    }
+
+    mapped_file(const mapped_file &) = delete;
+    mapped_file &operator=(const mapped_file &) = delete;
+
+    ~mapped_file()
+    {
+        close();
+    }
+
+    /*!
+     * @brief Opens path in place of any file open now
+     * @return true if the file was opened and, when it could not be mapped, read completely
+     */
+    bool open(const char *path)
+    {
+        close();
+        void *file = os::file_open(path);
+        if (file == nullptr)
+        {
+            return false;
+        }
+        unsigned long long size = os::file_size(file);
+        bool opened = size <= static_cast<std::size_t>(-1) && load(file, static_cast<std::size_t>(size));
+        os::file_close(file);
+        return opened;
+    }
+
+    void close() noexcept
+    {
+        if (_mapped)
+        {
+            os::file_unmap(_data, _size);
+        }
+        else if (_size != 0)
+        {
+            ::operator delete(const_cast<char *>(_data));
+        }
+        _data = nullptr;
+        _size = 0;
+        _mapped = false;
+    }
+
+    bool is_open() const noexcept
+    {
+        return _data != nullptr;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return is_open();
+    }
+
+    //! Whether the bytes are the os's mapping of the file rather than a copy of it.
+    bool is_mapped() const noexcept
+    {
+        return _mapped;
+    }
+
+    const char *data() const noexcept
+    {
+        return _data;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    u8string_view view() const noexcept
+    {
+        return u8string_view(_data, _size);
+    }
+
+  private:
+    const char *_data = nullptr; ///< The contents, nullptr while no file is open.
+    std::size_t _size = 0;       ///< Number of bytes at _data.
+    bool _mapped = false;        ///< Whether _data came from os::file_map() rather than operator new.
+
+    //! Where an empty file's view points, as there is nothing to map or allocate.
+    static constexpr char empty_contents[1] = {};
+
+    bool load(void *file, std::size_t size)
+    {
+        if (size == 0)
+        {
+            _data = empty_contents;
+            return true;
+        }
+        if (const void *mapping = os::file_map(file, size))
+        {
+            _data = static_cast<const char *>(mapping);
+            _size = size;
+            _mapped = true;
+            return true;
+        }
+        char *buffer = static_cast<char *>(::operator new(size));
+        std::size_t filled = 0;
+        while (filled < size)
+        {
+            std::size_t count = os::file_read(file, buffer + filled, size - filled);
+            if (count == 0 || count == static_cast<std::size_t>(-1))
+            {
+                ::operator delete(buffer);
+                return false;
+            }
+            filled += count;
+        }
+        _data = buffer;
+        _size = size;
+        return true;
+    }
+};
+
+/*!
+ * @brief Streams a UTF-8 file as UTF-16, converting one chunk at a time
+ * @details Each next() reads up to chunk_size bytes into a buffer allocated once, and converts them into a second
+ * buffer that units() then views. A code point cut in two by a chunk boundary is carried over by a utf8_decoder to
+ * the next chunk, so the chunk size is free to choose. Memory and work per chunk stay the same at any file length.
+ *
+ * Invalid UTF-8, a read error or a file ending partway through a code point stop the stream and set failed().
+ */
+class utf8_reader final
+{
+  public:
+    static constexpr std::size_t default_chunk_size = 64 * 1024; //!< Bytes read per chunk unless told otherwise.
+
+    /*!
+     * @brief Opens path for streaming; is_open() tells whether that worked
+     * @param path The file to read
+     * @param chunk_size Number of bytes to read at a time, at least 1
+     */
+    explicit utf8_reader(const char *path, std::size_t chunk_size = default_chunk_size)
+        : _file(os::file_open(path))
+    {
+        if (_file != nullptr)
+        {
+            _bytes.resize_for_overwrite(chunk_size != 0 ? chunk_size : 1);
+            _units.resize_for_overwrite(utf::utf8_decoder::max_units(_bytes.size()));
+        }
+    }
+
+    utf8_reader(utf8_reader &&other) noexcept
+        : _file(std::exchange(other._file, nullptr))
+        , _bytes(std::move(other._bytes))
+        , _units(std::move(other._units))
+        , _count(std::exchange(other._count, 0u))
+        , _decoder(other._decoder)
+        , _failed(other._failed)
+    {
+    }
+
+    utf8_reader(const utf8_reader &) = delete;
+    utf8_reader &operator=(const utf8_reader &) = delete;
+    utf8_reader &operator=(utf8_reader &&) = delete;
+
+    ~utf8_reader()
+    {
+        close();
+    }
+
+    bool is_open() const noexcept
+    {
+        return _file != nullptr;
+    }
+
+    /*!
+     * @brief Reads and converts the next chunk
+     * @details A chunk may convert to no units when it only starts a code point; next() still returns true then.
+     * @return true if units() holds the next chunk; false at the end of the file or once the stream has failed
+     */
+    bool next()
+    {
+        _count = 0;
+        if (_file == nullptr)
+        {
+            return false;
+        }
+        std::size_t read = os::file_read(_file, _bytes.data(), _bytes.size());
+        if (read == 0 || read == static_cast<std::size_t>(-1))
+        {
+            if (read != 0 || !_decoder.finish())
+            {
+                _failed = true;
+            }
+            close();
+            return false;
+        }
+        std::size_t converted = _decoder.convert(_bytes.data(), read, _units.data());
+        if (converted == utf::invalid)
+        {
+            _failed = true;
+            close();
+            return false;
+        }
+        _count = converted;
+        return true;
+    }
+
+    //! The units of the chunk the last next() converted.
+    string_view units() const noexcept
+    {
+        return string_view(_units.data(), _count);
+    }
+
+    //! Whether the stream stopped on invalid UTF-8, a truncated code point or a read error.
+    bool failed() const noexcept
+    {
+        return _failed;
+    }
+
+  private:
+    void *_file = nullptr;       ///< Handle from os::file_open(), nullptr once the end is reached.
+    std::vector<char> _bytes;    ///< The chunk read last.
+    std::vector<short> _units;   ///< The chunk converted last, _count units of it in use.
+    std::size_t _count = 0;      ///< Number of units in the last chunk.
+    utf::utf8_decoder _decoder;  ///< Carries a code point split between chunks.
+    bool _failed = false;        ///< Whether the stream stopped early.
+
+    void close() noexcept
+    {
+        if (_file != nullptr)
+        {
+            os::file_close(_file);
+            _file = nullptr;
+        }
+    }
+};
+} // namespace std
+#endif
+#endif
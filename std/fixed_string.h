@@ -0,0 +1,613 @@
+/*!
+ * @file fixed_string.h
+ * @brief Strings of UTF-16 units with a capacity fixed at compile time, which never allocate
+ * @namespace std
+ * @details fixed_string<N> is an immutable string of at most N units built in a constant expression: a UTF-8 literal
+ * is transcoded by the compiler, so a constexpr fixed_string costs no encoding detection, conversion or allocation at
+ * run time and its units live in read-only data. It is a structural type, so it can also be a template argument, and
+ * the _fs literal hands out a reference to such a template argument object:
+ *
+ * @code
+ * constexpr std::fixed_string name = "caf\xC3\xA9";           // four units, transcoded at compile time
+ * constexpr std::string_view keys[] = {"width"_fs, "height"_fs}; // views into .rodata
+ * @endcode
+ *
+ * inplace_string<N> is the mutable counterpart: a string of up to N units stored in the object, for code that may not
+ * use the heap. Growing it past N throws std::length_error, or traps without exceptions; try_append() and
+ * try_push_back() report the overflow instead.
+ *
+ * Both convert to string_view for free and search, compare and hash through it, so they find, equal and hash like a
+ * std::string with the same units and can look up the keys of a container keyed by std::string.
+ */
+#ifndef FIXED_STRING_H
+#define FIXED_STRING_H
+#include <bounds_check.h>
+#include <functional.h>
+#include <stddef.h>
+#include <stdexcept.h>
+#include <string.h>
+#include <string_view.h>
+#include <type_traits.h>
+#include <utf.h>
+
+namespace std
+{
+namespace detail
+{
+/*!
+ * @brief Appends UTF-8 to the units in dst, never writing past capacity
+ * @details Ill-formed UTF-8 is taken as Latin-1, like the string constructor takes it. Runs in constant expressions,
+ * and through the vector kernels of utf.h otherwise when the input surely fits.
+ * @return The new number of units, or npos if the text does not fit
+ */
+template<typename Byte>
+constexpr std::size_t append_utf8(const Byte *src, std::size_t len, short *dst, std::size_t written,
+                                  std::size_t capacity) noexcept
+{
+    std::size_t result = utf::invalid;
+    if (len <= capacity - written)
+    {
+        // Every byte makes at most one unit, so the text fits whatever it holds
+        if (__builtin_is_constant_evaluated())
+        {
+            result = utf::detail::decode_scalar(src, 0, len, dst, written);
+        }
+        else
+        {
+            std::size_t count = utf::utf8_to_utf16(reinterpret_cast<const char *>(src), len, dst + written);
+            result = count == utf::invalid ? count : written + count;
+        }
+    }
+    else
+    {
+        // Decode one code point at a time, checking the room before each one is stored
+        std::size_t end = written;
+        std::size_t i = 0;
+        while (i < len)
+        {
+            short units[2];
+            std::size_t count = 0;
+            unsigned char lead = static_cast<unsigned char>(src[i]);
+            std::size_t consumed = 1;
+            if (lead < 0x80)
+            {
+                units[count++] = static_cast<short>(lead);
+            }
+            else if ((consumed = utf::detail::decode_sequence(src, i, len, units, count)) == 0)
+            {
+                // Ill-formed, so the whole text is Latin-1 and needs len units
+                return string_view::npos;
+            }
+            if (capacity - end < count)
+            {
+                return string_view::npos;
+            }
+            for (std::size_t unit = 0; unit < count; ++unit)
+            {
+                dst[end++] = units[unit];
+            }
+            i += consumed;
+        }
+        return end;
+    }
+    if (result != utf::invalid)
+    {
+        return result;
+    }
+    for (std::size_t i = 0; i < len; ++i)
+    {
+        dst[written + i] = static_cast<short>(static_cast<unsigned char>(src[i]));
+    }
+    return written + len;
+}
+
+//! Length of a null-terminated array of bytes, stopping at its end if it has no terminator.
+template<std::size_t M> constexpr std::size_t bounded_length(const char (&bytes)[M]) noexcept
+{
+    std::size_t length = 0;
+    while (length < M && bytes[length] != '\0')
+    {
+        ++length;
+    }
+    return length;
+}
+
+/*!
+ * @brief The read-only interface fixed_string and inplace_string share, written in terms of their string_view
+ * @details Derived provides data() and size(); searching and comparing run the same code as string_view.
+ */
+template<typename Derived> class inline_string_interface
+{
+  public:
+    using value_type = short;
+    using data_type = short;
+    using size_type = std::size_t;
+    using const_iterator = const short *;
+    static constexpr size_type npos = string_view::npos;
+
+    constexpr string_view view() const noexcept
+    {
+        return string_view(self().data(), self().size());
+    }
+
+    constexpr operator string_view() const noexcept
+    {
+        return view();
+    }
+
+    constexpr const_iterator begin() const noexcept
+    {
+        return self().data();
+    }
+
+    constexpr const_iterator end() const noexcept
+    {
+        return self().data() + self().size();
+    }
+
+    constexpr const short *c_str() const noexcept
+    {
+        return self().data();
+    }
+
+    constexpr size_type length() const noexcept
+    {
+        return self().size();
+    }
+
+    constexpr bool empty() const noexcept
+    {
+        return self().size() == 0;
+    }
+
+    //! The view of at most count units starting at pos; throws std::out_of_range if pos > size().
+    constexpr string_view substr(size_type pos, size_type count = npos) const
+    {
+        return view().substr(pos, count);
+    }
+
+    constexpr int compare(string_view other) const noexcept
+    {
+        return view().compare(other);
+    }
+
+    constexpr bool starts_with(string_view prefix) const noexcept
+    {
+        return view().starts_with(prefix);
+    }
+
+    constexpr bool ends_with(string_view suffix) const noexcept
+    {
+        return view().ends_with(suffix);
+    }
+
+    bool contains(string_view needle) const noexcept
+    {
+        return view().contains(needle);
+    }
+
+    size_type find(string_view needle, size_type pos = 0) const noexcept
+    {
+        return view().find(needle, pos);
+    }
+
+    size_type find(short unit, size_type pos = 0) const noexcept
+    {
+        return view().find(unit, pos);
+    }
+
+    size_type rfind(string_view needle, size_type pos = npos) const noexcept
+    {
+        return view().rfind(needle, pos);
+    }
+
+    size_type find_first_of(string_view set, size_type pos = 0) const noexcept
+    {
+        return view().find_first_of(set, pos);
+    }
+
+    size_type find_last_of(string_view set, size_type pos = npos) const noexcept
+    {
+        return view().find_last_of(set, pos);
+    }
+
+  private:
+    constexpr const Derived &self() const noexcept
+    {
+        return static_cast<const Derived &>(*this);
+    }
+};
+} // namespace detail
+
+/*!
+ * @brief An immutable string of at most N UTF-16 units, built at compile time
+ * @details The members are public because a template argument of class type must have only public members; treat
+ * them as private. Units past the end are zero, so two fixed_strings with the same text are the same template
+ * argument and data() is always null-terminated.
+ * @tparam N Capacity in units. Deduced from a literal as its length in bytes, which is never less than its units.
+ */
+template<std::size_t N> struct fixed_string : detail::inline_string_interface<fixed_string<N>>
+{
+    using size_type = std::size_t;
+
+    short stored_units[N + 1] = {};
+    size_type stored_size = 0;
+
+    constexpr fixed_string() noexcept = default;
+
+    /*!
+     * @brief Transcodes a UTF-8 literal; ill-formed UTF-8 is taken as Latin-1, like the string constructor takes it
+     */
+    template<std::size_t M>
+        requires(M - 1 <= N)
+    constexpr fixed_string(const char (&literal)[M]) noexcept
+    {
+        stored_size = detail::append_utf8(literal, detail::bounded_length(literal), stored_units, 0, N);
+    }
+
+    /*!
+     * @brief Copies the units of a view
+     * @throws std::length_error if the view holds more than N units
+     */
+    constexpr explicit fixed_string(string_view units)
+    {
+        if (units.size() > N)
+        {
+            STD_THROW(std::length_error());
+        }
+        for (size_type i = 0; i < units.size(); ++i)
+        {
+            stored_units[i] = units[i];
+        }
+        stored_size = units.size();
+    }
+
+    static constexpr size_type capacity() noexcept
+    {
+        return N;
+    }
+
+    static constexpr size_type max_size() noexcept
+    {
+        return N;
+    }
+
+    constexpr const short *data() const noexcept
+    {
+        return stored_units;
+    }
+
+    constexpr size_type size() const noexcept
+    {
+        return stored_size;
+    }
+
+    constexpr short operator[](size_type index) const noexcept
+    {
+        return stored_units[index];
+    }
+
+    //! Fails as STD_BOUNDS_CHECK says if index is out of range, see bounds_check.h.
+    constexpr short at(size_type index) const noexcept(!detail::bounds_check_throws)
+    {
+        detail::check_bounds(index < stored_size);
+        return stored_units[index];
+    }
+
+    constexpr short front() const noexcept(!detail::bounds_check_throws)
+    {
+        detail::check_bounds(stored_size != 0);
+        return stored_units[0];
+    }
+
+    constexpr short back() const noexcept(!detail::bounds_check_throws)
+    {
+        detail::check_bounds(stored_size != 0);
+        return stored_units[stored_size - 1];
+    }
+};
+
+template<std::size_t M> fixed_string(const char (&)[M]) -> fixed_string<M - 1>;
+
+/*!
+ * @brief A mutable string of up to N UTF-16 units stored inline, for code that must not allocate
+ * @details Copying copies the units; nothing is ever allocated. Operations that would grow the string past N units
+ * throw std::length_error and leave it unchanged.
+ * @tparam N Capacity in units
+ */
+template<std::size_t N> class inplace_string : public detail::inline_string_interface<inplace_string<N>>
+{
+  public:
+    using size_type = std::size_t;
+    using iterator = short *;
+    using const_iterator = const short *;
+
+    constexpr inplace_string() noexcept = default;
+
+    //! Null-terminated UTF-8, converted like the string constructor converts it.
+    constexpr inplace_string(const char *str)
+    {
+        append(str);
+    }
+
+    constexpr inplace_string(u8string_view bytes)
+    {
+        append(bytes);
+    }
+
+    constexpr explicit inplace_string(string_view units)
+    {
+        append(units);
+    }
+
+    static constexpr size_type capacity() noexcept
+    {
+        return N;
+    }
+
+    static constexpr size_type max_size() noexcept
+    {
+        return N;
+    }
+
+    constexpr short *data() noexcept
+    {
+        return _units;
+    }
+
+    constexpr const short *data() const noexcept
+    {
+        return _units;
+    }
+
+    constexpr size_type size() const noexcept
+    {
+        return _size;
+    }
+
+    constexpr iterator begin() noexcept
+    {
+        return _units;
+    }
+
+    constexpr iterator end() noexcept
+    {
+        return _units + _size;
+    }
+
+    using detail::inline_string_interface<inplace_string<N>>::begin;
+    using detail::inline_string_interface<inplace_string<N>>::end;
+
+    constexpr short &operator[](size_type index) noexcept
+    {
+        return _units[index];
+    }
+
+    constexpr short operator[](size_type index) const noexcept
+    {
+        return _units[index];
+    }
+
+    //! Fails as STD_BOUNDS_CHECK says if index is out of range, see bounds_check.h.
+    constexpr short &at(size_type index) noexcept(!detail::bounds_check_throws)
+    {
+        detail::check_bounds(index < _size);
+        return _units[index];
+    }
+
+    constexpr short at(size_type index) const noexcept(!detail::bounds_check_throws)
+    {
+        detail::check_bounds(index < _size);
+        return _units[index];
+    }
+
+    constexpr short &front() noexcept(!detail::bounds_check_throws)
+    {
+        detail::check_bounds(_size != 0);
+        return _units[0];
+    }
+
+    constexpr short front() const noexcept(!detail::bounds_check_throws)
+    {
+        detail::check_bounds(_size != 0);
+        return _units[0];
+    }
+
+    constexpr short &back() noexcept(!detail::bounds_check_throws)
+    {
+        detail::check_bounds(_size != 0);
+        return _units[_size - 1];
+    }
+
+    constexpr short back() const noexcept(!detail::bounds_check_throws)
+    {
+        detail::check_bounds(_size != 0);
+        return _units[_size - 1];
+    }
+
+    //! Appends the units of a view, or returns false and changes nothing if they do not fit.
+    constexpr bool try_append(string_view units) noexcept
+    {
+        if (units.size() > N - _size)
+        {
+            return false;
+        }
+        for (size_type i = 0; i < units.size(); ++i)
+        {
+            _units[_size + i] = units[i];
+        }
+        set_size(_size + units.size());
+        return true;
+    }
+
+    //! Appends UTF-8 text, or returns false and changes nothing if its units do not fit.
+    constexpr bool try_append(u8string_view bytes) noexcept
+    {
+        // Decode into the spare units; on failure the terminator at _size is rewritten and nothing else is visible
+        size_type end = detail::append_utf8(bytes.data(), bytes.size(), _units, _size, N);
+        if (end == this->npos)
+        {
+            _units[_size] = 0;
+            return false;
+        }
+        set_size(end);
+        return true;
+    }
+
+    constexpr bool try_push_back(short unit) noexcept
+    {
+        if (_size == N)
+        {
+            return false;
+        }
+        _units[_size] = unit;
+        set_size(_size + 1);
+        return true;
+    }
+
+    /*!
+     * @throws std::length_error if the units do not fit
+     */
+    constexpr inplace_string &append(string_view units)
+    {
+        if (!try_append(units))
+        {
+            STD_THROW(std::length_error());
+        }
+        return *this;
+    }
+
+    constexpr inplace_string &append(u8string_view bytes)
+    {
+        if (!try_append(bytes))
+        {
+            STD_THROW(std::length_error());
+        }
+        return *this;
+    }
+
+    constexpr inplace_string &append(const char *str)
+    {
+        return append(u8string_view(str));
+    }
+
+    constexpr void push_back(short unit)
+    {
+        if (!try_push_back(unit))
+        {
+            STD_THROW(std::length_error());
+        }
+    }
+
+    constexpr inplace_string &operator+=(string_view units)
+    {
+        return append(units);
+    }
+
+    constexpr inplace_string &operator+=(const char *str)
+    {
+        return append(str);
+    }
+
+    constexpr inplace_string &operator+=(short unit)
+    {
+        push_back(unit);
+        return *this;
+    }
+
+    //! Removes the last unit; does nothing on an empty string, like vector::pop_back().
+    constexpr void pop_back() noexcept
+    {
+        if (_size != 0)
+        {
+            set_size(_size - 1);
+        }
+    }
+
+    constexpr void clear() noexcept
+    {
+        set_size(0);
+    }
+
+    /*!
+     * @brief Truncates to count units or pads with copies of unit up to count
+     * @throws std::length_error if count > N
+     */
+    constexpr void resize(size_type count, short unit = 0)
+    {
+        if (count > N)
+        {
+            STD_THROW(std::length_error());
+        }
+        for (size_type i = _size; i < count; ++i)
+        {
+            _units[i] = unit;
+        }
+        set_size(count);
+    }
+
+  private:
+    short _units[N + 1] = {}; //!< The units and a terminator.
+    size_type _size = 0;      //!< Number of units in use.
+
+    constexpr void set_size(size_type size) noexcept
+    {
+        _size = size;
+        _units[size] = 0;
+    }
+};
+
+namespace detail
+{
+template<typename T> inline constexpr bool is_inline_string = false;
+template<std::size_t N> inline constexpr bool is_inline_string<fixed_string<N>> = true;
+template<std::size_t N> inline constexpr bool is_inline_string<inplace_string<N>> = true;
+
+/*
+ * An inline string on one side and anything that views as UTF-16 units on the other. Taking both sides by their own
+ * type makes these exact matches, ahead of the string and string_view operators that would need a conversion.
+ */
+template<typename A, typename B>
+concept inline_string_comparable = (is_inline_string<A> && is_convertible_v<const B &, string_view>) ||
+                                   (is_inline_string<B> && is_convertible_v<const A &, string_view>);
+} // namespace detail
+
+template<typename A, typename B>
+    requires detail::inline_string_comparable<A, B>
+constexpr bool operator==(const A &a, const B &b) noexcept
+{
+    return string_view(a) == string_view(b);
+}
+
+template<typename A, typename B>
+    requires detail::inline_string_comparable<A, B>
+constexpr bool operator<(const A &a, const B &b) noexcept
+{
+    return string_view(a).compare(string_view(b)) < 0;
+}
+
+/*!
+ * @brief Hashes a fixed_string like the string_view of its units, so it finds std::string keys and they find it
+ */
+template<std::size_t N> struct hash<fixed_string<N>> : hash<string_view>
+{
+    using is_transparent = void;
+};
+
+template<std::size_t N> struct hash<inplace_string<N>> : hash<string_view>
+{
+    using is_transparent = void;
+};
+
+inline namespace literals
+{
+/*!
+ * @brief The fixed_string of a UTF-8 literal, as a reference to a constant with static storage
+ */
+template<fixed_string Literal> constexpr const auto &operator""_fs() noexcept
+{
+    return Literal;
+}
+} // namespace literals
+} // namespace std
+#endif
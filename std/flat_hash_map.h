@@ -0,0 +1,447 @@
+/*!
+ * @file flat_hash_map.h
+ * @brief An open-addressing hash map with its elements stored inline
+ * @namespace std
+ * @details flat_hash_map follows the interface of std::unordered_map, but stores its elements in one contiguous
+ * array of slots and finds them with the SIMD control-byte probing described in hash_table.h. Lookups touch one or
+ * two cache lines instead of chasing a node per element.
+ *
+ * Unlike std::unordered_map, references and iterators are invalidated when the table grows or is rehashed, and
+ * there is no bucket interface beyond bucket_count(). The key type must be movable.
+ *
+ * The default key_equal is the transparent std::equal_to<>, so with a transparent hasher such as the one for
+ * std::string the lookup functions take any type the key compares equal to, e.g. a string_view, without building a
+ * temporary key.
+ */
+#ifndef FLAT_HASH_MAP_H
+#define FLAT_HASH_MAP_H
+#include <functional.h>
+#include <hash_table.h>
+#include <initializer_list.h>
+#include <memory.h>
+#include <stdexcept.h>
+#include <utility.h>
+
+namespace std
+{
+namespace detail
+{
+template<typename Key, typename T> struct map_policy
+{
+    using key_type = Key;
+    using value_type = pair<const Key, T>;
+
+    static const Key &key(const value_type &value) noexcept
+    {
+        return value.first;
+    }
+};
+} // namespace detail
+
+/*!
+ * @brief A hash map from Key to T in a Swiss table
+ * @tparam Key The key type
+ * @tparam T The mapped type
+ * @tparam Hash Hash function object for keys
+ * @tparam KeyEqual Equality for keys
+ * @tparam Allocator Allocator for the slot storage, rebound to the value type
+ */
+template<typename Key, typename T, typename Hash = hash<Key>, typename KeyEqual = equal_to<>,
+         typename Allocator = std::allocator<pair<const Key, T>>>
+class flat_hash_map final
+{
+    using table_type = detail::hash_table<detail::map_policy<Key, T>, Hash, KeyEqual, Allocator>;
+
+  public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = pair<const Key, T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = typename table_type::allocator_type;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using iterator = typename table_type::iterator;
+    using const_iterator = typename table_type::const_iterator;
+
+    flat_hash_map() noexcept = default;
+
+    /*!
+     * @brief Constructs an empty map with room for at least bucket_count slots
+     */
+    explicit flat_hash_map(size_type bucket_count, const Hash &hash = Hash(), const KeyEqual &equal = KeyEqual(),
+                           const allocator_type &alloc = allocator_type())
+        : _table(bucket_count, hash, equal, alloc)
+    {
+    }
+
+    explicit flat_hash_map(const allocator_type &alloc)
+        : _table(0, Hash(), KeyEqual(), alloc)
+    {
+    }
+
+    template<typename InputIt> flat_hash_map(InputIt first, InputIt last, size_type bucket_count = 0)
+        : _table(bucket_count)
+    {
+        insert(first, last);
+    }
+
+    flat_hash_map(std::initializer_list<value_type> init, size_type bucket_count = 0)
+        : _table(bucket_count)
+    {
+        insert(init);
+    }
+
+    flat_hash_map(const flat_hash_map &other) = default;
+    flat_hash_map(flat_hash_map &&other) noexcept = default;
+    flat_hash_map &operator=(const flat_hash_map &other) = default;
+    flat_hash_map &operator=(flat_hash_map &&other) = default;
+
+    flat_hash_map &operator=(std::initializer_list<value_type> init)
+    {
+        clear();
+        insert(init);
+        return *this;
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return _table.get_allocator();
+    }
+
+    hasher hash_function() const
+    {
+        return _table.hash_function();
+    }
+
+    key_equal key_eq() const
+    {
+        return _table.key_eq();
+    }
+
+    iterator begin() noexcept
+    {
+        return _table.begin();
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return _table.begin();
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return _table.begin();
+    }
+
+    iterator end() noexcept
+    {
+        return _table.end();
+    }
+
+    const_iterator end() const noexcept
+    {
+        return _table.end();
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return _table.end();
+    }
+
+    bool empty() const noexcept
+    {
+        return _table.empty();
+    }
+
+    size_type size() const noexcept
+    {
+        return _table.size();
+    }
+
+    size_type max_size() const noexcept
+    {
+        return _table.max_size();
+    }
+
+    size_type bucket_count() const noexcept
+    {
+        return _table.bucket_count();
+    }
+
+    float load_factor() const noexcept
+    {
+        return _table.load_factor();
+    }
+
+    float max_load_factor() const noexcept
+    {
+        return _table.max_load_factor();
+    }
+
+    void clear() noexcept
+    {
+        _table.clear();
+    }
+
+    /*!
+     * @brief Inserts value unless its key is already present
+     * @return The element with the key and whether value was inserted
+     */
+    pair<iterator, bool> insert(const value_type &value)
+    {
+        return _table.find_or_emplace(value.first, [&](value_type *slot) { std::construct_at(slot, value); });
+    }
+
+    pair<iterator, bool> insert(value_type &&value)
+    {
+        return _table.find_or_emplace(value.first,
+                                      [&](value_type *slot) { std::construct_at(slot, std::move(value)); });
+    }
+
+    template<typename InputIt> void insert(InputIt first, InputIt last)
+    {
+        for (; first != last; ++first)
+        {
+            emplace(*first);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> init)
+    {
+        insert(init.begin(), init.end());
+    }
+
+    /*!
+     * @brief Constructs a value from args and inserts it unless its key is already present
+     */
+    template<typename... Args> pair<iterator, bool> emplace(Args &&...args)
+    {
+        value_type value(std::forward<Args>(args)...);
+        return insert(std::move(value));
+    }
+
+    /*!
+     * @brief Inserts key with a mapped value built from args unless key is already present
+     * @details Unlike emplace(), nothing is constructed when the key exists.
+     */
+    template<typename... Args> pair<iterator, bool> try_emplace(const key_type &key, Args &&...args)
+    {
+        return _table.find_or_emplace(key, [&](value_type *slot) {
+            std::construct_at(slot, key, mapped_type(std::forward<Args>(args)...));
+        });
+    }
+
+    template<typename... Args> pair<iterator, bool> try_emplace(key_type &&key, Args &&...args)
+    {
+        return _table.find_or_emplace(key, [&](value_type *slot) {
+            std::construct_at(slot, std::move(key), mapped_type(std::forward<Args>(args)...));
+        });
+    }
+
+    /*!
+     * @brief Inserts key with value, or assigns value to the element that has key
+     */
+    template<typename M> pair<iterator, bool> insert_or_assign(const key_type &key, M &&value)
+    {
+        pair<iterator, bool> result = try_emplace(key, std::forward<M>(value));
+        if (!result.second)
+        {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    template<typename M> pair<iterator, bool> insert_or_assign(key_type &&key, M &&value)
+    {
+        pair<iterator, bool> result = try_emplace(std::move(key), std::forward<M>(value));
+        if (!result.second)
+        {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    /*!
+     * @brief Returns the value mapped to key, inserting a value-initialized one first if key is missing
+     */
+    mapped_type &operator[](const key_type &key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    mapped_type &operator[](key_type &&key)
+    {
+        return try_emplace(std::move(key)).first->second;
+    }
+
+    /*!
+     * @brief Returns the value mapped to key
+     * @throws std::out_of_range if key is missing
+     */
+    mapped_type &at(const key_type &key)
+    {
+        return at_impl(*this, key);
+    }
+
+    const mapped_type &at(const key_type &key) const
+    {
+        return at_impl(*this, key);
+    }
+
+    template<typename K>
+        requires table_type::is_transparent
+    mapped_type &at(const K &key)
+    {
+        return at_impl(*this, key);
+    }
+
+    template<typename K>
+        requires table_type::is_transparent
+    const mapped_type &at(const K &key) const
+    {
+        return at_impl(*this, key);
+    }
+
+    iterator find(const key_type &key) noexcept
+    {
+        return _table.find(key);
+    }
+
+    const_iterator find(const key_type &key) const noexcept
+    {
+        return _table.find(key);
+    }
+
+    template<typename K>
+        requires table_type::is_transparent
+    iterator find(const K &key) noexcept
+    {
+        return _table.find(key);
+    }
+
+    template<typename K>
+        requires table_type::is_transparent
+    const_iterator find(const K &key) const noexcept
+    {
+        return _table.find(key);
+    }
+
+    bool contains(const key_type &key) const noexcept
+    {
+        return _table.contains(key);
+    }
+
+    template<typename K>
+        requires table_type::is_transparent
+    bool contains(const K &key) const noexcept
+    {
+        return _table.contains(key);
+    }
+
+    size_type count(const key_type &key) const noexcept
+    {
+        return _table.contains(key) ? 1 : 0;
+    }
+
+    template<typename K>
+        requires table_type::is_transparent
+    size_type count(const K &key) const noexcept
+    {
+        return _table.contains(key) ? 1 : 0;
+    }
+
+    /*!
+     * @brief Removes the element at pos
+     * @return Iterator to the element after pos
+     */
+    iterator erase(const_iterator pos)
+    {
+        return _table.erase(pos);
+    }
+
+    iterator erase(iterator pos)
+    {
+        return _table.erase(pos);
+    }
+
+    /*!
+     * @brief Removes the element with key, if there is one
+     * @return The number of elements removed, 0 or 1
+     */
+    size_type erase(const key_type &key)
+    {
+        return _table.erase_key(key);
+    }
+
+    template<typename K>
+        requires(table_type::is_transparent && !is_same_v<remove_cv_t<K>, iterator> &&
+                 !is_same_v<remove_cv_t<K>, const_iterator>)
+    size_type erase(const K &key)
+    {
+        return _table.erase_key(key);
+    }
+
+    /*!
+     * @brief Makes room for count elements without growing again
+     */
+    void reserve(size_type count)
+    {
+        _table.reserve(count);
+    }
+
+    /*!
+     * @brief Rebuilds the table with at least count slots, dropping all tombstones; rehash(0) shrinks to fit
+     */
+    void rehash(size_type count)
+    {
+        _table.rehash(count);
+    }
+
+    void swap(flat_hash_map &other) noexcept
+    {
+        _table.swap(other._table);
+    }
+
+    friend void swap(flat_hash_map &a, flat_hash_map &b) noexcept
+    {
+        a.swap(b);
+    }
+
+    /*!
+     * @brief Maps compare equal when they have the same keys mapped to equal values, in any order
+     */
+    friend bool operator==(const flat_hash_map &a, const flat_hash_map &b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        for (const value_type &value : a)
+        {
+            const_iterator other = b.find(value.first);
+            if (other == b.end() || !(other->second == value.second))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+  private:
+    table_type _table;
+
+    template<typename Self, typename K> static auto &at_impl(Self &self, const K &key)
+    {
+        auto it = self._table.find(key);
+        if (it == self._table.end())
+        {
+            STD_THROW(std::out_of_range());
+        }
+        return it->second;
+    }
+};
+} // namespace std
+#endif
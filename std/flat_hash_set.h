@@ -0,0 +1,303 @@
+/*!
+ * @file flat_hash_set.h
+ * @brief An open-addressing hash set with its elements stored inline
+ * @namespace std
+ * @details flat_hash_set follows the interface of std::unordered_set on the Swiss table in hash_table.h; see
+ * flat_hash_map.h for how it differs from the node-based containers. Elements are immutable through iterators.
+ */
+#ifndef FLAT_HASH_SET_H
+#define FLAT_HASH_SET_H
+#include <functional.h>
+#include <hash_table.h>
+#include <initializer_list.h>
+#include <memory.h>
+#include <utility.h>
+
+namespace std
+{
+namespace detail
+{
+template<typename Key> struct set_policy
+{
+    using key_type = Key;
+    using value_type = Key;
+
+    static const Key &key(const value_type &value) noexcept
+    {
+        return value;
+    }
+};
+} // namespace detail
+
+/*!
+ * @brief A hash set of Key in a Swiss table
+ * @tparam Key The element type
+ * @tparam Hash Hash function object for elements
+ * @tparam KeyEqual Equality for elements
+ * @tparam Allocator Allocator for the slot storage
+ */
+template<typename Key, typename Hash = hash<Key>, typename KeyEqual = equal_to<>,
+         typename Allocator = std::allocator<Key>>
+class flat_hash_set final
+{
+    using table_type = detail::hash_table<detail::set_policy<Key>, Hash, KeyEqual, Allocator>;
+
+  public:
+    using key_type = Key;
+    using value_type = Key;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = typename table_type::allocator_type;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using iterator = typename table_type::const_iterator;
+    using const_iterator = typename table_type::const_iterator;
+
+    flat_hash_set() noexcept = default;
+
+    /*!
+     * @brief Constructs an empty set with room for at least bucket_count slots
+     */
+    explicit flat_hash_set(size_type bucket_count, const Hash &hash = Hash(), const KeyEqual &equal = KeyEqual(),
+                           const allocator_type &alloc = allocator_type())
+        : _table(bucket_count, hash, equal, alloc)
+    {
+    }
+
+    explicit flat_hash_set(const allocator_type &alloc)
+        : _table(0, Hash(), KeyEqual(), alloc)
+    {
+    }
+
+    template<typename InputIt> flat_hash_set(InputIt first, InputIt last, size_type bucket_count = 0)
+        : _table(bucket_count)
+    {
+        insert(first, last);
+    }
+
+    flat_hash_set(std::initializer_list<value_type> init, size_type bucket_count = 0)
+        : _table(bucket_count)
+    {
+        insert(init);
+    }
+
+    flat_hash_set(const flat_hash_set &other) = default;
+    flat_hash_set(flat_hash_set &&other) noexcept = default;
+    flat_hash_set &operator=(const flat_hash_set &other) = default;
+    flat_hash_set &operator=(flat_hash_set &&other) = default;
+
+    flat_hash_set &operator=(std::initializer_list<value_type> init)
+    {
+        clear();
+        insert(init);
+        return *this;
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return _table.get_allocator();
+    }
+
+    hasher hash_function() const
+    {
+        return _table.hash_function();
+    }
+
+    key_equal key_eq() const
+    {
+        return _table.key_eq();
+    }
+
+    iterator begin() const noexcept
+    {
+        return _table.begin();
+    }
+
+    iterator cbegin() const noexcept
+    {
+        return _table.begin();
+    }
+
+    iterator end() const noexcept
+    {
+        return _table.end();
+    }
+
+    iterator cend() const noexcept
+    {
+        return _table.end();
+    }
+
+    bool empty() const noexcept
+    {
+        return _table.empty();
+    }
+
+    size_type size() const noexcept
+    {
+        return _table.size();
+    }
+
+    size_type max_size() const noexcept
+    {
+        return _table.max_size();
+    }
+
+    size_type bucket_count() const noexcept
+    {
+        return _table.bucket_count();
+    }
+
+    float load_factor() const noexcept
+    {
+        return _table.load_factor();
+    }
+
+    float max_load_factor() const noexcept
+    {
+        return _table.max_load_factor();
+    }
+
+    void clear() noexcept
+    {
+        _table.clear();
+    }
+
+    /*!
+     * @brief Inserts value unless it is already present
+     * @return The element equal to value and whether value was inserted
+     */
+    pair<iterator, bool> insert(const value_type &value)
+    {
+        return _table.find_or_emplace(value, [&](value_type *slot) { std::construct_at(slot, value); });
+    }
+
+    pair<iterator, bool> insert(value_type &&value)
+    {
+        return _table.find_or_emplace(value, [&](value_type *slot) { std::construct_at(slot, std::move(value)); });
+    }
+
+    template<typename InputIt> void insert(InputIt first, InputIt last)
+    {
+        for (; first != last; ++first)
+        {
+            insert(*first);
+        }
+    }
+
+    void insert(std::initializer_list<value_type> init)
+    {
+        insert(init.begin(), init.end());
+    }
+
+    template<typename... Args> pair<iterator, bool> emplace(Args &&...args)
+    {
+        value_type value(std::forward<Args>(args)...);
+        return insert(std::move(value));
+    }
+
+    iterator find(const key_type &key) const noexcept
+    {
+        return _table.find(key);
+    }
+
+    template<typename K>
+        requires table_type::is_transparent
+    iterator find(const K &key) const noexcept
+    {
+        return _table.find(key);
+    }
+
+    bool contains(const key_type &key) const noexcept
+    {
+        return _table.contains(key);
+    }
+
+    template<typename K>
+        requires table_type::is_transparent
+    bool contains(const K &key) const noexcept
+    {
+        return _table.contains(key);
+    }
+
+    size_type count(const key_type &key) const noexcept
+    {
+        return _table.contains(key) ? 1 : 0;
+    }
+
+    template<typename K>
+        requires table_type::is_transparent
+    size_type count(const K &key) const noexcept
+    {
+        return _table.contains(key) ? 1 : 0;
+    }
+
+    /*!
+     * @brief Removes the element at pos
+     * @return Iterator to the element after pos
+     */
+    iterator erase(iterator pos)
+    {
+        return _table.erase(pos);
+    }
+
+    /*!
+     * @brief Removes the element equal to key, if there is one
+     * @return The number of elements removed, 0 or 1
+     */
+    size_type erase(const key_type &key)
+    {
+        return _table.erase_key(key);
+    }
+
+    template<typename K>
+        requires(table_type::is_transparent && !is_same_v<remove_cv_t<K>, iterator>)
+    size_type erase(const K &key)
+    {
+        return _table.erase_key(key);
+    }
+
+    void reserve(size_type count)
+    {
+        _table.reserve(count);
+    }
+
+    void rehash(size_type count)
+    {
+        _table.rehash(count);
+    }
+
+    void swap(flat_hash_set &other) noexcept
+    {
+        _table.swap(other._table);
+    }
+
+    friend void swap(flat_hash_set &a, flat_hash_set &b) noexcept
+    {
+        a.swap(b);
+    }
+
+    //! Sets compare equal when they hold the same elements, in any order.
+    friend bool operator==(const flat_hash_set &a, const flat_hash_set &b)
+    {
+        if (a.size() != b.size())
+        {
+            return false;
+        }
+        for (const value_type &value : a)
+        {
+            if (!b.contains(value))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+  private:
+    table_type _table;
+};
+} // namespace std
+#endif
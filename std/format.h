@@ -0,0 +1,607 @@
+/*!
+ * @file format.h
+ * @brief Formatting text and numbers into a buffer that is handed on in large batches
+ * @namespace std
+ * @details format_to() writes into a format_sink: a caller's buffer and a flush function that receives the buffered
+ * bytes whenever the buffer fills and once more when the sink is flushed or destroyed. A log line formatted into a
+ * buffered_sink on the stack therefore costs no allocation and one call of the flush function, which can be a single
+ * write. Without a flush function a sink keeps what fits and counts the rest, which is how format_to_n() works.
+ *
+ * The replacement fields are a subset of std::format's: {} or {index}, optionally followed by a colon and
+ * [[fill]align][0][width][type]. align is <, > or ^; type is d, x, X, b, o or c for integers, e, f or g for
+ * floating-point values, s for text and booleans and p for pointers. Numbers are written with to_chars(), so
+ * floating-point values get their shortest round-tripping digits, and text is written as UTF-8, strings and string
+ * views being converted from UTF-16 on the way. A malformed format string or a missing argument throws
+ * invalid_argument.
+ */
+#ifndef FORMAT_H
+#define FORMAT_H
+#include <charconv.h>
+#include <stddef.h>
+#include <stdexcept.h>
+#include <string_builder.h>
+#include <string_view.h>
+#include <type_traits.h>
+#include <utf.h>
+
+namespace std
+{
+/*!
+ * @brief A character buffer drained by a flush function
+ * @details Writes that fit are copied into the buffer. One that does not fit flushes the buffer first, and one
+ * larger than the whole buffer is then passed to the flush function directly rather than split.
+ */
+class format_sink
+{
+  public:
+    //! Receives size bytes at data; context is the pointer the sink was given.
+    using flush_function = void (*)(void *context, const char *data, std::size_t size);
+
+    /*!
+     * @param buffer capacity bytes the sink collects output in
+     * @param flush_to Where full buffers go; without one, output beyond capacity is dropped but still counted
+     */
+    format_sink(char *buffer, std::size_t capacity, flush_function flush_to = nullptr, void *context = nullptr) noexcept
+        : _buffer(buffer)
+        , _capacity(capacity)
+        , _flush(flush_to)
+        , _context(context)
+    {
+    }
+
+    format_sink(const format_sink &) = delete;
+    format_sink &operator=(const format_sink &) = delete;
+
+    ~format_sink()
+    {
+        flush();
+    }
+
+    void write(const char *data, std::size_t size) noexcept
+    {
+        _count += size;
+        if (size <= _capacity - _size)
+        {
+            __builtin_memcpy(_buffer + _size, data, size);
+            _size += size;
+            return;
+        }
+        overflow(data, size);
+    }
+
+    void put(char c) noexcept
+    {
+        write(&c, 1);
+    }
+
+    //! Writes count copies of c.
+    void fill(char c, std::size_t count) noexcept
+    {
+        char run[32];
+        __builtin_memset(run, c, sizeof(run));
+        for (; count > sizeof(run); count -= sizeof(run))
+        {
+            write(run, sizeof(run));
+        }
+        write(run, count);
+    }
+
+    //! Hands everything buffered to the flush function, if there is one.
+    void flush() noexcept
+    {
+        if (_flush != nullptr && _size != 0)
+        {
+            _flush(_context, _buffer, _size);
+            _size = 0;
+        }
+    }
+
+    //! The buffered bytes not yet flushed.
+    const char *data() const noexcept
+    {
+        return _buffer;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    //! Every byte written so far, flushed, buffered or dropped.
+    std::size_t count() const noexcept
+    {
+        return _count;
+    }
+
+  private:
+    void overflow(const char *data, std::size_t size) noexcept
+    {
+        if (_flush == nullptr)
+        {
+            std::size_t room = _capacity - _size;
+            __builtin_memcpy(_buffer + _size, data, room);
+            _size = _capacity;
+            return;
+        }
+        flush();
+        if (size >= _capacity)
+        {
+            _flush(_context, data, size);
+            return;
+        }
+        __builtin_memcpy(_buffer, data, size);
+        _size = size;
+    }
+
+    char *_buffer;
+    std::size_t _capacity;
+    std::size_t _size = 0;
+    std::size_t _count = 0;
+    flush_function _flush;
+    void *_context;
+};
+
+/*!
+ * @brief A format_sink with its buffer inline, meant to live on the stack
+ */
+template<std::size_t Capacity = 4096> class buffered_sink : public format_sink
+{
+  public:
+    explicit buffered_sink(flush_function flush_to, void *context = nullptr) noexcept
+        : format_sink(_storage, Capacity, flush_to, context)
+    {
+    }
+
+    ~buffered_sink()
+    {
+        flush();
+    }
+
+  private:
+    char _storage[Capacity];
+};
+
+template<typename OutputIt> struct format_to_n_result
+{
+    OutputIt out;
+    std::size_t size; //!< The length of the whole output, including what did not fit.
+};
+
+namespace detail
+{
+enum class format_kind : unsigned char
+{
+    none,
+    signed_integer,
+    unsigned_integer,
+    single,
+    floating,
+    boolean,
+    character,
+    unit,
+    utf8,
+    units,
+    pointer
+};
+
+/*!
+ * @brief One argument of format_to(), with its type erased so that a single loop formats every call
+ */
+struct format_arg
+{
+    format_kind kind;
+    std::size_t size = 0; //!< Bytes of utf8 text or units of units text.
+    union {
+        long long signed_integer;
+        unsigned long long unsigned_integer;
+        float single;
+        double floating;
+        bool boolean;
+        char character;
+        short unit;
+        const char *bytes;
+        const short *units;
+        const void *pointer;
+    };
+
+    constexpr format_arg() noexcept
+        : kind(format_kind::none)
+        , pointer(nullptr)
+    {
+    }
+
+    template<formattable_integer T>
+    constexpr format_arg(T value) noexcept
+        : kind(is_signed_integer<T> ? format_kind::signed_integer : format_kind::unsigned_integer)
+    {
+        if constexpr (is_signed_integer<T>)
+        {
+            signed_integer = value;
+        }
+        else
+        {
+            unsigned_integer = value;
+        }
+    }
+
+    constexpr format_arg(float value) noexcept
+        : kind(format_kind::single)
+        , single(value)
+    {
+    }
+
+    constexpr format_arg(double value) noexcept
+        : kind(format_kind::floating)
+        , floating(value)
+    {
+    }
+
+    constexpr format_arg(bool value) noexcept
+        : kind(format_kind::boolean)
+        , boolean(value)
+    {
+    }
+
+    constexpr format_arg(char value) noexcept
+        : kind(format_kind::character)
+        , character(value)
+    {
+    }
+
+    //! A single UTF-16 unit, as string_builder takes one.
+    constexpr format_arg(short value) noexcept
+        : kind(format_kind::unit)
+        , unit(value)
+    {
+    }
+
+    constexpr format_arg(const char *text) noexcept
+        : format_arg(u8string_view(text))
+    {
+    }
+
+    constexpr format_arg(u8string_view text) noexcept
+        : kind(format_kind::utf8)
+        , size(text.size())
+        , bytes(text.data())
+    {
+    }
+
+    constexpr format_arg(string_view text) noexcept
+        : kind(format_kind::units)
+        , size(text.size())
+        , units(text.data())
+    {
+    }
+
+    constexpr format_arg(const void *address) noexcept
+        : kind(format_kind::pointer)
+        , pointer(address)
+    {
+    }
+};
+
+struct format_spec
+{
+    char fill = ' ';
+    char align = 0; //!< <, > or ^, or 0 for the type's default.
+    bool zero = false;
+    std::size_t width = 0;
+    char type = 0;
+};
+
+//! Room for any number the formatter writes, the longest being a double in fixed notation.
+inline constexpr std::size_t format_number_size = 352;
+
+[[noreturn]] inline void format_error()
+{
+    STD_THROW(std::invalid_argument());
+}
+
+//! Writes fill to make up the width before and after size columns of content that write() then puts in between.
+template<typename Write>
+void write_padded(format_sink &sink, const format_spec &spec, std::size_t size, char default_align, Write write)
+{
+    std::size_t padding = spec.width > size ? spec.width - size : 0;
+    char align = spec.align != 0 ? spec.align : default_align;
+    std::size_t before = align == '>' ? padding : align == '^' ? padding / 2 : 0;
+    sink.fill(spec.fill, before);
+    write();
+    sink.fill(spec.fill, padding - before);
+}
+
+//! Writes the characters of a number, zero-padded after its sign when the spec asks for it.
+inline void write_number(format_sink &sink, const format_spec &spec, const char *text, std::size_t size)
+{
+    if (spec.zero && spec.align == 0)
+    {
+        std::size_t sign = size != 0 && (text[0] == '-' || text[0] == '+') ? 1 : 0;
+        sink.write(text, sign);
+        if (spec.width > size)
+        {
+            sink.fill('0', spec.width - size);
+        }
+        sink.write(text + sign, size - sign);
+        return;
+    }
+    write_padded(sink, spec, size, '>', [&] { sink.write(text, size); });
+}
+
+inline void write_utf8(format_sink &sink, const format_spec &spec, const char *text, std::size_t size)
+{
+    std::size_t columns = 0;
+    for (std::size_t i = 0; i < size; i++)
+    {
+        columns += utf::detail::is_continuation(static_cast<unsigned char>(text[i])) ? 0u : 1u;
+    }
+    write_padded(sink, spec, columns, '<', [&] { sink.write(text, size); });
+}
+
+//! Converts the units to UTF-8 through a stack buffer, a run at a time.
+inline void write_units(format_sink &sink, const format_spec &spec, const short *units, std::size_t count)
+{
+    std::size_t columns = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        columns += utf::detail::is_low_surrogate(static_cast<unsigned short>(units[i])) ? 0u : 1u;
+    }
+    write_padded(sink, spec, columns, '<', [&] {
+        char bytes[256];
+        while (count != 0)
+        {
+            std::size_t run = count < sizeof(bytes) / 3 ? count : sizeof(bytes) / 3;
+            if (run < count && utf::detail::is_high_surrogate(static_cast<unsigned short>(units[run - 1])))
+            {
+                run--;
+            }
+            sink.write(bytes, utf::utf16_to_utf8(units, run, bytes, sizeof(bytes)));
+            units += run;
+            count -= run;
+        }
+    });
+}
+
+inline void write_integer(format_sink &sink, const format_spec &spec, unsigned long long magnitude, bool negative)
+{
+    int base = 10;
+    switch (spec.type)
+    {
+    case 0:
+    case 'd':
+        break;
+    case 'x':
+    case 'X':
+        base = 16;
+        break;
+    case 'b':
+        base = 2;
+        break;
+    case 'o':
+        base = 8;
+        break;
+    case 'c': {
+        char c = static_cast<char>(magnitude);
+        write_padded(sink, spec, 1, '<', [&] { sink.put(c); });
+        return;
+    }
+    default:
+        format_error();
+    }
+    char text[format_number_size];
+    char *out = text;
+    if (negative)
+    {
+        *out++ = '-';
+    }
+    out = to_chars(out, text + sizeof(text), magnitude, base).ptr;
+    if (spec.type == 'X')
+    {
+        for (char *c = text; c != out; ++c)
+        {
+            *c = *c >= 'a' && *c <= 'f' ? static_cast<char>(*c - 'a' + 'A') : *c;
+        }
+    }
+    write_number(sink, spec, text, static_cast<std::size_t>(out - text));
+}
+
+template<typename T> void write_floating(format_sink &sink, const format_spec &spec, T value)
+{
+    char text[format_number_size];
+    to_chars_result result;
+    switch (spec.type)
+    {
+    case 0:
+        result = to_chars(text, text + sizeof(text), value);
+        break;
+    case 'e':
+        result = to_chars(text, text + sizeof(text), value, chars_format::scientific);
+        break;
+    case 'f':
+        result = to_chars(text, text + sizeof(text), value, chars_format::fixed);
+        break;
+    case 'g':
+        result = to_chars(text, text + sizeof(text), value, chars_format::general);
+        break;
+    default:
+        format_error();
+    }
+    write_number(sink, spec, text, static_cast<std::size_t>(result.ptr - text));
+}
+
+inline void format_value(format_sink &sink, const format_spec &spec, const format_arg &arg)
+{
+    switch (arg.kind)
+    {
+    case format_kind::signed_integer:
+    {
+        unsigned long long magnitude = static_cast<unsigned long long>(arg.signed_integer);
+        write_integer(sink, spec, arg.signed_integer < 0 ? 0ull - magnitude : magnitude, arg.signed_integer < 0);
+        return;
+    }
+    case format_kind::unsigned_integer:
+        write_integer(sink, spec, arg.unsigned_integer, false);
+        return;
+    case format_kind::single:
+        write_floating(sink, spec, arg.single);
+        return;
+    case format_kind::floating:
+        write_floating(sink, spec, arg.floating);
+        return;
+    case format_kind::boolean:
+        if (spec.type != 0 && spec.type != 's')
+        {
+            write_integer(sink, spec, arg.boolean ? 1ull : 0ull, false);
+            return;
+        }
+        write_utf8(sink, spec, arg.boolean ? "true" : "false", arg.boolean ? 4 : 5);
+        return;
+    case format_kind::character:
+        if (spec.type != 0 && spec.type != 'c')
+        {
+            write_integer(sink, spec, static_cast<unsigned char>(arg.character), false);
+            return;
+        }
+        write_utf8(sink, spec, &arg.character, 1);
+        return;
+    case format_kind::unit:
+        write_units(sink, spec, &arg.unit, 1);
+        return;
+    case format_kind::utf8:
+        write_utf8(sink, spec, arg.bytes, arg.size);
+        return;
+    case format_kind::units:
+        write_units(sink, spec, arg.units, arg.size);
+        return;
+    case format_kind::pointer: {
+        char text[2 + 2 * sizeof(void *)] = {'0', 'x'};
+        char *end = to_chars(text + 2, text + sizeof(text), reinterpret_cast<std::size_t>(arg.pointer), 16).ptr;
+        write_number(sink, spec, text, static_cast<std::size_t>(end - text));
+        return;
+    }
+    case format_kind::none:
+        break;
+    }
+    format_error();
+}
+
+/*!
+ * @brief Parses text up to the closing brace of a replacement field
+ * @return The position after the brace
+ */
+inline const char *parse_format_spec(const char *p, const char *end, format_spec &spec)
+{
+    auto is_align = [](char c) { return c == '<' || c == '>' || c == '^'; };
+    if (end - p >= 2 && is_align(p[1]) && p[0] != '}')
+    {
+        spec.fill = p[0];
+        spec.align = p[1];
+        p += 2;
+    }
+    else if (p != end && is_align(*p))
+    {
+        spec.align = *p++;
+    }
+    if (p != end && *p == '0')
+    {
+        spec.zero = true;
+        ++p;
+    }
+    for (; p != end && *p >= '0' && *p <= '9'; ++p)
+    {
+        spec.width = spec.width * 10 + static_cast<std::size_t>(*p - '0');
+    }
+    if (p != end && *p != '}')
+    {
+        spec.type = *p++;
+    }
+    if (p == end || *p != '}')
+    {
+        format_error();
+    }
+    return p + 1;
+}
+
+/*!
+ * @brief Formats into sink with the arguments already erased, the part of format_to() that is not a template
+ */
+inline void vformat_to(format_sink &sink, u8string_view format, const format_arg *args, std::size_t count)
+{
+    const char *p = format.data();
+    const char *end = p + format.size();
+    std::size_t next = 0;
+    while (p != end)
+    {
+        const char *brace = p;
+        for (; brace != end && *brace != '{' && *brace != '}'; ++brace)
+        {
+        }
+        sink.write(p, static_cast<std::size_t>(brace - p));
+        if (brace == end)
+        {
+            return;
+        }
+        p = brace + 1;
+        if (*brace == '}' || (p != end && *p == '{'))
+        {
+            // {{ and }} stand for one brace; a lone } is an error
+            if (p == end || *p != *brace)
+            {
+                format_error();
+            }
+            sink.put(*p++);
+            continue;
+        }
+        std::size_t index = next++;
+        if (p != end && *p >= '0' && *p <= '9')
+        {
+            for (index = 0; p != end && *p >= '0' && *p <= '9'; ++p)
+            {
+                index = index * 10 + static_cast<std::size_t>(*p - '0');
+            }
+        }
+        format_spec spec;
+        if (p != end && *p == ':')
+        {
+            p = parse_format_spec(p + 1, end, spec);
+        }
+        else if (p != end && *p == '}')
+        {
+            ++p;
+        }
+        else
+        {
+            format_error();
+        }
+        if (index >= count)
+        {
+            format_error();
+        }
+        format_value(sink, spec, args[index]);
+    }
+}
+} // namespace detail
+
+/*!
+ * @brief Writes format to sink with each replacement field replaced by the formatted argument it names
+ * @details The arguments are erased into an array on the stack and formatted by one non-template loop, so each
+ * call site costs little more than the array.
+ */
+template<typename... Args> void format_to(format_sink &sink, u8string_view format, const Args &...args)
+{
+    const detail::format_arg erased[] = {detail::format_arg(args)..., detail::format_arg()};
+    detail::vformat_to(sink, format, erased, sizeof...(Args));
+}
+
+/*!
+ * @brief Formats into the n bytes at out, dropping what does not fit
+ * @return The end of the bytes written and the length the whole output would have had
+ */
+template<typename... Args>
+format_to_n_result<char *> format_to_n(char *out, std::size_t n, u8string_view format, const Args &...args)
+{
+    format_sink sink(out, n);
+    format_to(sink, format, args...);
+    return {out + sink.size(), sink.count()};
+}
+} // namespace std
+#endif
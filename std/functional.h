@@ -0,0 +1,272 @@
+/*!
+ * @file functional.h
+ * @brief Comparison and hash function objects
+ * @namespace std
+ * @note This header is a part of the C++ standard library.
+ */
+#ifndef FUNCTIONAL_H
+#define FUNCTIONAL_H
+#include <stddef.h>
+#include <type_traits.h>
+#include <utility.h>
+
+// Long inputs are hashed with the CRC32C instruction where the target has it; STD_NO_SIMD turns that off too.
+#if !defined(STD_NO_SIMD) && ((defined(__SSE4_2__) && defined(__x86_64__)) || defined(__ARM_FEATURE_CRC32))
+#    define STD_HASH_CRC32 1
+#    if defined(__SSE4_2__)
+#        include <nmmintrin.h>
+#    else
+#        include <arm_acle.h>
+#    endif
+#endif
+
+namespace std
+{
+/*!
+ * @brief Function object for a < b
+ * @details std::less<> compares any two types that support operator<. The algorithms recognise both forms, together
+ * with greater, as plain comparisons of arithmetic keys and switch to their branchless kernels for them.
+ * @tparam T The type of the values to compare, or void for a transparent comparison
+ */
+template<typename T = void> struct less
+{
+    constexpr bool operator()(const T &a, const T &b) const
+    {
+        return a < b;
+    }
+};
+
+template<> struct less<void>
+{
+    using is_transparent = void;
+
+    template<typename T, typename U> constexpr bool operator()(T &&a, U &&b) const
+    {
+        return std::forward<T>(a) < std::forward<U>(b);
+    }
+};
+
+/*!
+ * @brief Function object for a > b
+ * @tparam T The type of the values to compare, or void for a transparent comparison
+ */
+template<typename T = void> struct greater
+{
+    constexpr bool operator()(const T &a, const T &b) const
+    {
+        return a > b;
+    }
+};
+
+template<> struct greater<void>
+{
+    using is_transparent = void;
+
+    template<typename T, typename U> constexpr bool operator()(T &&a, U &&b) const
+    {
+        return std::forward<T>(a) > std::forward<U>(b);
+    }
+};
+/*!
+ * @brief Function object for a == b
+ * @details std::equal_to<> is transparent, which lets the hash containers look a string up by a string_view.
+ * @tparam T The type of the values to compare, or void for a transparent comparison
+ */
+template<typename T = void> struct equal_to
+{
+    constexpr bool operator()(const T &a, const T &b) const
+    {
+        return a == b;
+    }
+};
+
+template<> struct equal_to<void>
+{
+    using is_transparent = void;
+
+    template<typename T, typename U> constexpr bool operator()(T &&a, U &&b) const
+    {
+        return std::forward<T>(a) == std::forward<U>(b);
+    }
+};
+
+namespace detail
+{
+inline constexpr unsigned long long hash_secret[3] = {0x2D358DCCAA6C78A5ull, 0x8BB84B93962EACC9ull,
+                                                      0x4B33A62ED433D4A3ull};
+
+//! Inputs at least this long take the CRC32 path where the target has the instruction.
+inline constexpr std::size_t hash_crc_threshold = 256;
+
+/*!
+ * @brief Multiplies a by b, leaving the low half of the 128-bit product in a and the high half in b
+ */
+inline void hash_mum(unsigned long long &a, unsigned long long &b) noexcept
+{
+#if defined(__SIZEOF_INT128__)
+    __extension__ using uint128 = unsigned __int128;
+    uint128 product = static_cast<uint128>(a) * b;
+    a = static_cast<unsigned long long>(product);
+    b = static_cast<unsigned long long>(product >> 64);
+#else
+    unsigned long long ha = a >> 32, hb = b >> 32, la = a & 0xFFFFFFFFull, lb = b & 0xFFFFFFFFull;
+    unsigned long long hh = ha * hb, hl = ha * lb, lh = la * hb, ll = la * lb;
+    unsigned long long mid = (ll >> 32) + (hl & 0xFFFFFFFFull) + (lh & 0xFFFFFFFFull);
+    a = (mid << 32) | (ll & 0xFFFFFFFFull);
+    b = hh + (hl >> 32) + (lh >> 32) + (mid >> 32);
+#endif
+}
+
+//! Folds the 128-bit product of a and b to 64 bits.
+inline unsigned long long hash_mix(unsigned long long a, unsigned long long b) noexcept
+{
+    hash_mum(a, b);
+    return a ^ b;
+}
+
+inline unsigned long long hash_read64(const unsigned char *p) noexcept
+{
+    unsigned long long value;
+    __builtin_memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline unsigned long long hash_read32(const unsigned char *p) noexcept
+{
+    unsigned int value;
+    __builtin_memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+#if defined(STD_HASH_CRC32)
+inline unsigned long long hash_crc32(unsigned long long crc, unsigned long long word) noexcept
+{
+#    if defined(__SSE4_2__)
+    return _mm_crc32_u64(crc, word);
+#    else
+    return __crc32cd(static_cast<unsigned int>(crc), word);
+#    endif
+}
+
+/*!
+ * @brief Runs four independent CRC32C lanes over the 32-byte blocks of a long input
+ * @details The CRC instruction has a latency of three cycles and a throughput of one, so four lanes keep it busy.
+ * CRC is linear, so the lanes only condense the input: their 128 bits go through the multiply mix like any other
+ * input words.
+ * @return The number of bytes consumed
+ */
+inline std::size_t hash_crc_blocks(const unsigned char *p, std::size_t size, unsigned long long &seed) noexcept
+{
+    unsigned long long c0 = seed, c1 = seed ^ hash_secret[0], c2 = seed ^ hash_secret[1], c3 = seed ^ hash_secret[2];
+    std::size_t done = 0;
+    for (; size - done >= 32; done += 32)
+    {
+        c0 = hash_crc32(c0, hash_read64(p + done));
+        c1 = hash_crc32(c1, hash_read64(p + done + 8));
+        c2 = hash_crc32(c2, hash_read64(p + done + 16));
+        c3 = hash_crc32(c3, hash_read64(p + done + 24));
+    }
+    seed = hash_mix((c0 | (c1 << 32)) ^ hash_secret[0], (c2 | (c3 << 32)) ^ seed);
+    return done;
+}
+#endif
+
+/*!
+ * @brief Hashes size bytes
+ * @details A rapidhash-style hash: up to 16 bytes are read as two overlapping words, longer inputs are consumed 48
+ * bytes at a time by three independent multiply lanes, and every round folds a 128-bit product. Inputs of at least
+ * hash_crc_threshold bytes use hardware CRC32C lanes instead when the target has them (SSE4.2 or ARMv8 CRC).
+ *
+ * The result depends on the target's byte order and instruction set, so it is only stable within one build.
+ */
+inline std::size_t hash_bytes(const void *data, std::size_t size, unsigned long long seed = 0) noexcept
+{
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    seed ^= hash_mix(seed ^ hash_secret[0], hash_secret[1]) ^ size;
+    unsigned long long a = 0, b = 0;
+    if (size <= 16)
+    {
+        if (size >= 4)
+        {
+            // Two pairs of possibly overlapping 4-byte reads cover every length from 4 to 16
+            const unsigned char *last = p + size - 4;
+            std::size_t delta = (size & 24) >> (size >> 3);
+            a = (hash_read32(p) << 32) | hash_read32(last);
+            b = (hash_read32(p + delta) << 32) | hash_read32(last - delta);
+        }
+        else if (size > 0)
+        {
+            a = (static_cast<unsigned long long>(p[0]) << 56) | (static_cast<unsigned long long>(p[size >> 1]) << 32) |
+                p[size - 1];
+        }
+    }
+    else
+    {
+        std::size_t left = size;
+#if defined(STD_HASH_CRC32)
+        if (left >= hash_crc_threshold)
+        {
+            std::size_t done = hash_crc_blocks(p, left, seed);
+            p += done;
+            left -= done;
+        }
+#endif
+        if (left > 48)
+        {
+            unsigned long long lane1 = seed, lane2 = seed;
+            do
+            {
+                seed = hash_mix(hash_read64(p) ^ hash_secret[0], hash_read64(p + 8) ^ seed);
+                lane1 = hash_mix(hash_read64(p + 16) ^ hash_secret[1], hash_read64(p + 24) ^ lane1);
+                lane2 = hash_mix(hash_read64(p + 32) ^ hash_secret[2], hash_read64(p + 40) ^ lane2);
+                p += 48;
+                left -= 48;
+            } while (left > 48);
+            seed ^= lane1 ^ lane2;
+        }
+        if (left > 16)
+        {
+            seed = hash_mix(hash_read64(p) ^ hash_secret[2], hash_read64(p + 8) ^ seed ^ hash_secret[1]);
+            if (left > 32)
+            {
+                seed = hash_mix(hash_read64(p + 16) ^ hash_secret[2], hash_read64(p + 24) ^ seed);
+            }
+        }
+        // The last 16 bytes of the input, which may reach back into bytes already hashed
+        a = hash_read64(p + left - 16);
+        b = hash_read64(p + left - 8);
+    }
+    a ^= hash_secret[1];
+    b ^= seed;
+    hash_mum(a, b);
+    return static_cast<std::size_t>(hash_mix(a ^ hash_secret[0] ^ size, b ^ hash_secret[1]));
+}
+} // namespace detail
+
+/*!
+ * @brief Function object that hashes a T, specialized for the types that can be hashed
+ * @details Integers and pointers hash to their value; the hash containers mix every hash that does not declare
+ * is_avalanching before using it, so such a hash only has to be distinct, not well distributed. The string types
+ * are specialized in string.h and string_view.h.
+ */
+template<typename T> struct hash;
+
+template<typename T>
+    requires is_integral_v<T>
+struct hash<T>
+{
+    constexpr std::size_t operator()(T value) const noexcept
+    {
+        return static_cast<std::size_t>(value);
+    }
+};
+
+template<typename T> struct hash<T *>
+{
+    std::size_t operator()(T *value) const noexcept
+    {
+        return reinterpret_cast<std::size_t>(value);
+    }
+};
+} // namespace std
+#endif
@@ -0,0 +1,114 @@
+/*!
+ * @file growth_policy.h
+ * @brief Policies that decide how far vector and string grow their storage
+ * @namespace std
+ * @details A container that runs out of room asks its growth policy for the new capacity. A policy is a type with two
+ * static functions, both counting in elements of element_size bytes:
+ *
+ * - grow(capacity, required, element_size) returns the capacity to grow to when an insertion needs room for required
+ *   elements and capacity are allocated; the result must be at least required.
+ * - round(required, element_size) returns the capacity reserve() allocates for a request of required elements, also
+ *   at least required. reserve_exact() skips it.
+ *
+ * Doubling keeps insertion amortized O(1) with the fewest reallocations; a factor of 1.5 lets a freed block be reused
+ * by a later growth step and peaks lower during the copy; page rounding sizes large blocks in whole pages, which is
+ * what in-place growth through os::operator_realloc and os::try_expand can extend; fixed increments bound the slack
+ * for buffers that grow by known amounts.
+ */
+#ifndef GROWTH_POLICY_H
+#define GROWTH_POLICY_H
+#include <stddef.h>
+
+namespace std
+{
+/*!
+ * @brief Grows the capacity by Numerator / Denominator, starting at Initial elements
+ */
+template<std::size_t Numerator, std::size_t Denominator, std::size_t Initial = 8> struct factor_growth
+{
+    static_assert(Numerator > Denominator && Denominator > 0, "the growth factor must be above 1");
+
+    static constexpr std::size_t grow(std::size_t capacity, std::size_t required, std::size_t) noexcept
+    {
+        if (capacity == 0)
+        {
+            return Initial < required ? required : Initial;
+        }
+        constexpr std::size_t extra = Numerator - Denominator;
+        std::size_t step = capacity <= static_cast<std::size_t>(-1) / extra ? capacity * extra / Denominator
+                                                                             : capacity / Denominator * extra;
+        // At least one more element, also for capacities below Denominator where the step rounds down to nothing
+        std::size_t next = capacity + (step == 0 ? 1 : step);
+        // Saturate rather than wrap for capacities near the top of the address space
+        if (next < capacity)
+        {
+            next = static_cast<std::size_t>(-1);
+        }
+        return next < required ? required : next;
+    }
+
+    static constexpr std::size_t round(std::size_t required, std::size_t) noexcept
+    {
+        return required;
+    }
+};
+
+using doubling_growth = factor_growth<2, 1>;
+using one_and_a_half_growth = factor_growth<3, 2>;
+
+/*!
+ * @brief Grows like Base, then rounds every block of at least one page up to whole pages
+ * @tparam PageSize The page size in bytes, a power of two
+ * @tparam Base The policy that picks the capacity before rounding
+ */
+template<std::size_t PageSize = 4096, typename Base = one_and_a_half_growth> struct page_growth
+{
+    static_assert((PageSize & (PageSize - 1)) == 0, "the page size must be a power of two");
+
+    static constexpr std::size_t to_pages(std::size_t count, std::size_t element_size) noexcept
+    {
+        std::size_t bytes = count * element_size;
+        if (element_size == 0 || bytes < PageSize || bytes / element_size != count)
+        {
+            return count;
+        }
+        return ((bytes + PageSize - 1) & ~(PageSize - 1)) / element_size;
+    }
+
+    static constexpr std::size_t grow(std::size_t capacity, std::size_t required, std::size_t element_size) noexcept
+    {
+        return to_pages(Base::grow(capacity, required, element_size), element_size);
+    }
+
+    static constexpr std::size_t round(std::size_t required, std::size_t element_size) noexcept
+    {
+        return to_pages(required, element_size);
+    }
+};
+
+/*!
+ * @brief Grows in steps of Increment elements, keeping the capacity a multiple of it
+ */
+template<std::size_t Increment> struct fixed_growth
+{
+    static_assert(Increment > 0, "the increment must not be zero");
+
+    static constexpr std::size_t grow(std::size_t capacity, std::size_t required, std::size_t) noexcept
+    {
+        std::size_t next = capacity + Increment;
+        next = next < required ? required : next;
+        return (next + Increment - 1) / Increment * Increment;
+    }
+
+    static constexpr std::size_t round(std::size_t required, std::size_t) noexcept
+    {
+        return (required + Increment - 1) / Increment * Increment;
+    }
+};
+
+/*!
+ * @brief The policy vector and string use unless told otherwise
+ */
+using default_growth = doubling_growth;
+} // namespace std
+#endif
@@ -0,0 +1,849 @@
+/*!
+ * @file hash_table.h
+ * @brief The open-addressing table behind flat_hash_map and flat_hash_set
+ * @namespace std
+ * @details A Swiss table, after Abseil's raw_hash_set. Elements live in one array of slots, next to an array of
+ * control bytes with one byte per slot: empty, deleted, or the low 7 bits of the hash (H2) of the element in it. The
+ * remaining hash bits (H1) pick the slot a probe starts at. A probe loads a group of control bytes at once and
+ * compares them all against H2 with one vector compare, so it touches an element only when the 7 bits already agree.
+ * Probes go from group to group in growing steps until a group has an empty byte.
+ *
+ * Groups are 16 bytes with SSE2 and 8 bytes, in a general-purpose register or a NEON register, otherwise. The first
+ * group's worth of control bytes is repeated after the last, so a group can be loaded at any slot without wrapping.
+ * The capacity is a power of two of at least one group and the table grows when 7/8 of it are in use.
+ *
+ * Erasing leaves the slot empty when no probe can have passed it, that is when an empty byte lies within one group
+ * width on either side; only otherwise does it leave a tombstone. When tombstones make up enough of the table that
+ * it has to grow, it is rebuilt at the same capacity instead, which drops them all.
+ *
+ * @note This header is an implementation detail of flat_hash_map.h and flat_hash_set.h.
+ */
+#ifndef HASH_TABLE_H
+#define HASH_TABLE_H
+#include <algorithm.h>
+#include <functional.h>
+#include <iterator.h>
+#include <memory.h>
+#include <stddef.h>
+#include <stdexcept.h>
+#include <type_traits.h>
+#include <utility.h>
+
+namespace std
+{
+namespace detail
+{
+using ctrl_t = signed char;
+inline constexpr ctrl_t ctrl_empty = -128;  //!< 0b10000000
+inline constexpr ctrl_t ctrl_deleted = -2;  //!< 0b11111110
+inline constexpr unsigned int ctrl_h2_bits = 7;
+
+/*!
+ * @brief The lanes of a group that matched, as a bit mask with lane_bits bits per lane
+ */
+template<unsigned int Width, unsigned int Shift> struct group_mask
+{
+    unsigned long long bits;
+
+    explicit operator bool() const noexcept
+    {
+        return bits != 0;
+    }
+
+    unsigned int lowest() const noexcept
+    {
+        return count_trailing_zeros(bits) >> Shift;
+    }
+
+    void clear_lowest() noexcept
+    {
+        bits &= bits - 1;
+    }
+
+    //! Lanes before the first match, Width if there is none.
+    unsigned int leading_lanes() const noexcept
+    {
+        return bits ? lowest() : Width;
+    }
+
+    //! Lanes after the last match, Width if there is none.
+    unsigned int trailing_lanes() const noexcept
+    {
+        if (!bits)
+        {
+            return Width;
+        }
+        unsigned int highest = 63u - static_cast<unsigned int>(__builtin_clzll(bits));
+        return Width - 1u - (highest >> Shift);
+    }
+};
+
+#if defined(STD_SIMD_SSE2)
+struct group
+{
+    static constexpr unsigned int width = 16;
+    using mask = group_mask<width, 0>;
+
+    __m128i ctrl;
+
+    explicit group(const ctrl_t *pos) noexcept
+        : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pos)))
+    {
+    }
+
+    mask match(ctrl_t h2) const noexcept
+    {
+        return {static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2))))};
+    }
+
+    mask match_empty() const noexcept
+    {
+        return match(ctrl_empty);
+    }
+
+    //! Empty and deleted are the only control bytes with the sign bit set.
+    mask match_empty_or_deleted() const noexcept
+    {
+        return {static_cast<unsigned int>(_mm_movemask_epi8(ctrl))};
+    }
+};
+#elif defined(STD_SIMD_NEON)
+struct group
+{
+    static constexpr unsigned int width = 8;
+    using mask = group_mask<width, 3>;
+    static constexpr unsigned long long msbs = 0x8080808080808080ull;
+
+    int8x8_t ctrl;
+
+    explicit group(const ctrl_t *pos) noexcept
+        : ctrl(vld1_s8(pos))
+    {
+    }
+
+    mask match(ctrl_t h2) const noexcept
+    {
+        uint8x8_t equal = vceq_s8(ctrl, vdup_n_s8(h2));
+        return {vget_lane_u64(vreinterpret_u64_u8(equal), 0) & msbs};
+    }
+
+    mask match_empty() const noexcept
+    {
+        return match(ctrl_empty);
+    }
+
+    mask match_empty_or_deleted() const noexcept
+    {
+        uint8x8_t negative = vcltz_s8(ctrl);
+        return {vget_lane_u64(vreinterpret_u64_u8(negative), 0) & msbs};
+    }
+};
+#else
+/*!
+ * @brief Eight control bytes in a word, matched with SWAR arithmetic
+ * @details match() may report a false positive in the lane above a true match, which only costs a key comparison.
+ */
+struct group
+{
+    static constexpr unsigned int width = 8;
+    using mask = group_mask<width, 3>;
+    static constexpr unsigned long long lsbs = 0x0101010101010101ull;
+    static constexpr unsigned long long msbs = 0x8080808080808080ull;
+
+    unsigned long long ctrl;
+
+    explicit group(const ctrl_t *pos) noexcept
+    {
+        __builtin_memcpy(&ctrl, pos, sizeof(ctrl));
+#    if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        ctrl = __builtin_bswap64(ctrl);
+#    endif
+    }
+
+    mask match(ctrl_t h2) const noexcept
+    {
+        unsigned long long x = ctrl ^ (lsbs * static_cast<unsigned char>(h2));
+        return {(x - lsbs) & ~x & msbs};
+    }
+
+    //! Empty is the only special byte whose bit 1 is clear.
+    mask match_empty() const noexcept
+    {
+        return {ctrl & ~(ctrl << 6) & msbs};
+    }
+
+    mask match_empty_or_deleted() const noexcept
+    {
+        return {ctrl & msbs};
+    }
+};
+#endif
+
+/*!
+ * @brief Spreads the bits of a user hash over the whole word, so H1 and H2 both depend on all of them
+ */
+inline std::size_t mix_hash(std::size_t hash) noexcept
+{
+    unsigned long long h = hash;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    return static_cast<std::size_t>(h);
+}
+
+template<typename T>
+concept transparent = requires { typename T::is_transparent; };
+
+//! Hashes that mark themselves avalanching already spread every input bit and are used as they are.
+template<typename T>
+concept avalanching = requires { typename T::is_avalanching; };
+
+/*!
+ * @brief Forward iterator over the full slots of a hash_table
+ * @tparam Element The value type, const-qualified for the const iterator
+ */
+template<typename Element> class hash_table_iterator
+{
+    template<typename, typename, typename, typename> friend class hash_table;
+    template<typename> friend class hash_table_iterator;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = remove_cv_t<Element>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Element *;
+    using reference = Element &;
+
+    hash_table_iterator() noexcept = default;
+
+    //! The const iterator converts from the mutable one.
+    template<typename Other>
+        requires(is_same_v<Element, const Other>)
+    hash_table_iterator(const hash_table_iterator<Other> &other) noexcept
+        : _ctrl(other._ctrl)
+        , _slot(other._slot)
+        , _end(other._end)
+    {
+    }
+
+    reference operator*() const noexcept
+    {
+        return *_slot;
+    }
+
+    pointer operator->() const noexcept
+    {
+        return _slot;
+    }
+
+    hash_table_iterator &operator++() noexcept
+    {
+        ++_ctrl;
+        ++_slot;
+        skip_free();
+        return *this;
+    }
+
+    hash_table_iterator operator++(int) noexcept
+    {
+        hash_table_iterator copy = *this;
+        ++*this;
+        return copy;
+    }
+
+    template<typename Other> bool operator==(const hash_table_iterator<Other> &other) const noexcept
+    {
+        return _ctrl == other._ctrl;
+    }
+
+  private:
+    const ctrl_t *_ctrl = nullptr;
+    Element *_slot = nullptr;
+    const ctrl_t *_end = nullptr;
+
+    hash_table_iterator(const ctrl_t *ctrl, Element *slot, const ctrl_t *end) noexcept
+        : _ctrl(ctrl)
+        , _slot(slot)
+        , _end(end)
+    {
+    }
+
+    void skip_free() noexcept
+    {
+        while (_ctrl != _end && *_ctrl < 0)
+        {
+            ++_ctrl;
+            ++_slot;
+        }
+    }
+};
+
+/*!
+ * @brief The Swiss table shared by flat_hash_map and flat_hash_set
+ * @tparam Policy Names key_type and value_type and extracts the key of a value with Policy::key()
+ * @tparam Hash Hash function object for keys
+ * @tparam KeyEqual Equality for keys
+ * @tparam Allocator Allocator rebound to value_type for the slot and control storage
+ */
+template<typename Policy, typename Hash, typename KeyEqual, typename Allocator> class hash_table
+{
+  public:
+    using key_type = typename Policy::key_type;
+    using value_type = typename Policy::value_type;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = typename allocator_traits<Allocator>::template rebind_alloc<value_type>;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+    using iterator = hash_table_iterator<value_type>;
+    using const_iterator = hash_table_iterator<const value_type>;
+
+    //! True when the hash and the equality both accept any type comparable with the key.
+    static constexpr bool is_transparent = transparent<Hash> && transparent<KeyEqual>;
+
+    hash_table() noexcept = default;
+
+    explicit hash_table(size_type bucket_count, const Hash &hash = Hash(), const KeyEqual &equal = KeyEqual(),
+                        const allocator_type &alloc = allocator_type())
+        : _hash(hash)
+        , _equal(equal)
+        , _alloc(alloc)
+    {
+        if (bucket_count > 0)
+        {
+            resize(normalize_capacity(bucket_count));
+        }
+    }
+
+    hash_table(const hash_table &other)
+        : hash_table(other, allocator_traits<allocator_type>::select_on_container_copy_construction(other._alloc))
+    {
+    }
+
+    hash_table(const hash_table &other, const allocator_type &alloc)
+        : _hash(other._hash)
+        , _equal(other._equal)
+        , _alloc(alloc)
+    {
+        reserve(other._size);
+        for (const value_type &value : other)
+        {
+            // Keys are known to be distinct, so each one only needs a free slot
+            size_type hash = hash_of(Policy::key(value));
+            size_type index = find_first_free(hash);
+            std::construct_at(_slots + index, value);
+            occupy(index, hash);
+        }
+    }
+
+    hash_table(hash_table &&other) noexcept
+        : _ctrl(other._ctrl)
+        , _slots(other._slots)
+        , _capacity(other._capacity)
+        , _size(other._size)
+        , _growth_left(other._growth_left)
+        , _hash(std::move(other._hash))
+        , _equal(std::move(other._equal))
+        , _alloc(std::move(other._alloc))
+    {
+        other.reset_empty();
+    }
+
+    ~hash_table()
+    {
+        destroy_all();
+        release();
+    }
+
+    hash_table &operator=(const hash_table &other)
+    {
+        if (this != &other)
+        {
+            hash_table copy(other, _alloc);
+            swap_storage(copy);
+            _hash = other._hash;
+            _equal = other._equal;
+        }
+        return *this;
+    }
+
+    /*!
+     * @brief Takes over the slots of other when the allocators compare equal, and otherwise moves its elements into
+     *        new storage from this allocator, which may throw; a stateless allocator rules that out.
+     */
+    hash_table &operator=(hash_table &&other) noexcept(std::is_empty_v<allocator_type>)
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+        clear();
+        release();
+        reset_empty();
+        _hash = std::move(other._hash);
+        _equal = std::move(other._equal);
+        if (_alloc == other._alloc)
+        {
+            swap_storage(other);
+            return *this;
+        }
+        reserve(other._size);
+        for (value_type &value : other)
+        {
+            size_type hash = hash_of(Policy::key(value));
+            size_type index = find_first_free(hash);
+            std::construct_at(_slots + index, std::move(value));
+            occupy(index, hash);
+        }
+        other.clear();
+        return *this;
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return _alloc;
+    }
+
+    hasher hash_function() const
+    {
+        return _hash;
+    }
+
+    key_equal key_eq() const
+    {
+        return _equal;
+    }
+
+    iterator begin() noexcept
+    {
+        iterator it(_ctrl, _slots, _ctrl + _capacity);
+        it.skip_free();
+        return it;
+    }
+
+    const_iterator begin() const noexcept
+    {
+        const_iterator it(_ctrl, _slots, _ctrl + _capacity);
+        it.skip_free();
+        return it;
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(_ctrl + _capacity, _slots + _capacity, _ctrl + _capacity);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(_ctrl + _capacity, _slots + _capacity, _ctrl + _capacity);
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    size_type size() const noexcept
+    {
+        return _size;
+    }
+
+    size_type max_size() const noexcept
+    {
+        return size_type(-1) / sizeof(value_type);
+    }
+
+    //! Number of slots; also the bucket count, each slot being a bucket of one.
+    size_type capacity() const noexcept
+    {
+        return _capacity;
+    }
+
+    size_type bucket_count() const noexcept
+    {
+        return _capacity;
+    }
+
+    float load_factor() const noexcept
+    {
+        return _capacity == 0 ? 0.0f : static_cast<float>(_size) / static_cast<float>(_capacity);
+    }
+
+    float max_load_factor() const noexcept
+    {
+        return 0.875f;
+    }
+
+    /*!
+     * @brief Destroys every element; the storage is kept for reuse
+     */
+    void clear() noexcept
+    {
+        destroy_all();
+        if (_capacity > 0)
+        {
+            std::memset(_ctrl, static_cast<unsigned char>(ctrl_empty), _capacity + group::width);
+        }
+        _size = 0;
+        _growth_left = max_load(_capacity);
+    }
+
+    /*!
+     * @brief Makes room for count elements without growing again
+     */
+    void reserve(size_type count)
+    {
+        if (count > _size + _growth_left)
+        {
+            resize(capacity_for(count));
+        }
+    }
+
+    /*!
+     * @brief Rebuilds the table with room for at least count slots and for the current elements, which also drops
+     * all tombstones; rehash(0) shrinks the table to fit
+     */
+    void rehash(size_type count)
+    {
+        if (count == 0 && _size == 0)
+        {
+            release();
+            reset_empty();
+            return;
+        }
+        size_type wanted = std::max(normalize_capacity(count), capacity_for(_size));
+        if (wanted != _capacity || _size + _growth_left != max_load(_capacity))
+        {
+            resize(wanted);
+        }
+    }
+
+    template<typename K> iterator find(const K &key) noexcept
+    {
+        size_type index = find_index(key);
+        return index == npos_index ? end() : iterator_at(index);
+    }
+
+    template<typename K> const_iterator find(const K &key) const noexcept
+    {
+        size_type index = find_index(key);
+        return index == npos_index ? end() : const_iterator(iterator_at(index));
+    }
+
+    template<typename K> bool contains(const K &key) const noexcept
+    {
+        return find_index(key) != npos_index;
+    }
+
+    /*!
+     * @brief Returns the slot holding key, or constructs a value in a free slot with make(slot) if there is none
+     * @return The slot and whether the value was constructed
+     */
+    template<typename K, typename Make> pair<iterator, bool> find_or_emplace(const K &key, Make &&make)
+    {
+        size_type hash = hash_of(key);
+        size_type index = find_index(key, hash);
+        if (index != npos_index)
+        {
+            return {iterator_at(index), false};
+        }
+        index = prepare_insert(hash);
+        make(_slots + index);
+        occupy(index, hash);
+        return {iterator_at(index), true};
+    }
+
+    template<typename K> size_type erase_key(const K &key)
+    {
+        size_type index = find_index(key);
+        if (index == npos_index)
+        {
+            return 0;
+        }
+        erase_at(index);
+        return 1;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        size_type index = static_cast<size_type>(pos._ctrl - _ctrl);
+        erase_at(index);
+        iterator next = iterator_at(index);
+        next.skip_free();
+        return next;
+    }
+
+    void swap(hash_table &other) noexcept
+    {
+        swap_storage(other);
+        std::swap(_hash, other._hash);
+        std::swap(_equal, other._equal);
+        std::swap(_alloc, other._alloc);
+    }
+
+  private:
+    static constexpr size_type npos_index = size_type(-1);
+
+    ctrl_t *_ctrl = nullptr;    //!< capacity + group::width control bytes, behind the slots in the same block.
+    value_type *_slots = nullptr;
+    size_type _capacity = 0;    //!< Zero or a power of two of at least group::width.
+    size_type _size = 0;
+    size_type _growth_left = 0; //!< Empty slots that may still be filled before the table grows.
+    STD_NO_UNIQUE_ADDRESS Hash _hash{};
+    STD_NO_UNIQUE_ADDRESS KeyEqual _equal{};
+    STD_NO_UNIQUE_ADDRESS allocator_type _alloc{};
+
+    static constexpr size_type max_load(size_type capacity) noexcept
+    {
+        return capacity - capacity / 8;
+    }
+
+    //! The smallest valid capacity of at least count slots.
+    static constexpr size_type normalize_capacity(size_type count) noexcept
+    {
+        size_type capacity = group::width;
+        while (capacity < count)
+        {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    //! The smallest valid capacity that holds count elements under the maximum load.
+    static constexpr size_type capacity_for(size_type count) noexcept
+    {
+        size_type capacity = group::width;
+        while (max_load(capacity) < count)
+        {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    //! Slots of value_type the block needs for capacity slots plus their control bytes.
+    static constexpr size_type block_units(size_type capacity) noexcept
+    {
+        return capacity + (capacity + group::width + sizeof(value_type) - 1) / sizeof(value_type);
+    }
+
+    template<typename K> size_type hash_of(const K &key) const noexcept
+    {
+        if constexpr (avalanching<Hash>)
+        {
+            return _hash(key);
+        }
+        else
+        {
+            return mix_hash(_hash(key));
+        }
+    }
+
+    static ctrl_t h2_of(size_type hash) noexcept
+    {
+        return static_cast<ctrl_t>(hash & ((1u << ctrl_h2_bits) - 1));
+    }
+
+    size_type h1_of(size_type hash) const noexcept
+    {
+        return (hash >> ctrl_h2_bits) & (_capacity - 1);
+    }
+
+    iterator iterator_at(size_type index) noexcept
+    {
+        return iterator(_ctrl + index, _slots + index, _ctrl + _capacity);
+    }
+
+    iterator iterator_at(size_type index) const noexcept
+    {
+        return const_cast<hash_table *>(this)->iterator_at(index);
+    }
+
+    template<typename K> size_type find_index(const K &key) const noexcept
+    {
+        return find_index(key, hash_of(key));
+    }
+
+    template<typename K> size_type find_index(const K &key, size_type hash) const noexcept
+    {
+        if (_capacity == 0)
+        {
+            return npos_index;
+        }
+        size_type mask = _capacity - 1;
+        size_type pos = h1_of(hash);
+        ctrl_t h2 = h2_of(hash);
+        for (size_type step = group::width;; step += group::width)
+        {
+            group g(_ctrl + pos);
+            for (typename group::mask match = g.match(h2); match; match.clear_lowest())
+            {
+                size_type index = (pos + match.lowest()) & mask;
+                if (_equal(Policy::key(_slots[index]), key))
+                {
+                    return index;
+                }
+            }
+            if (g.match_empty())
+            {
+                return npos_index;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    //! The first empty or deleted slot on the probe sequence of hash; the table must have one.
+    size_type find_first_free(size_type hash) const noexcept
+    {
+        size_type mask = _capacity - 1;
+        size_type pos = h1_of(hash);
+        for (size_type step = group::width;; step += group::width)
+        {
+            typename group::mask free = group(_ctrl + pos).match_empty_or_deleted();
+            if (free)
+            {
+                return (pos + free.lowest()) & mask;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    //! Finds the slot a new element with this hash goes to, growing the table first if needed.
+    size_type prepare_insert(size_type hash)
+    {
+        if (_capacity == 0)
+        {
+            resize(group::width);
+        }
+        size_type index = find_first_free(hash);
+        if (_growth_left == 0 && _ctrl[index] != ctrl_deleted)
+        {
+            // A table with many tombstones is rebuilt at its capacity, a full one grows
+            resize(_size * 32 <= _capacity * 25 ? _capacity : _capacity * 2);
+            index = find_first_free(hash);
+        }
+        return index;
+    }
+
+    void set_ctrl(size_type index, ctrl_t value) noexcept
+    {
+        _ctrl[index] = value;
+        if (index < group::width)
+        {
+            _ctrl[_capacity + index] = value;
+        }
+    }
+
+    //! Marks index, whose element has just been constructed, as full.
+    void occupy(size_type index, size_type hash) noexcept
+    {
+        if (_ctrl[index] == ctrl_empty)
+        {
+            --_growth_left;
+        }
+        set_ctrl(index, h2_of(hash));
+        ++_size;
+    }
+
+    void erase_at(size_type index) noexcept
+    {
+        std::destroy_at(_slots + index);
+        --_size;
+        // A probe only ever passed this slot if a whole group around it was full or deleted
+        size_type before = (index - group::width) & (_capacity - 1);
+        typename group::mask empty_after = group(_ctrl + index).match_empty();
+        typename group::mask empty_before = group(_ctrl + before).match_empty();
+        bool never_full = empty_after && empty_before &&
+                          empty_after.leading_lanes() + empty_before.trailing_lanes() < group::width;
+        set_ctrl(index, never_full ? ctrl_empty : ctrl_deleted);
+        if (never_full)
+        {
+            ++_growth_left;
+        }
+    }
+
+    /*!
+     * @brief Moves every element into a fresh block of new_capacity slots
+     */
+    void resize(size_type new_capacity)
+    {
+        ctrl_t *old_ctrl = _ctrl;
+        value_type *old_slots = _slots;
+        size_type old_capacity = _capacity;
+
+        value_type *block = allocator_traits<allocator_type>::allocate(_alloc, block_units(new_capacity));
+        _slots = block;
+        _ctrl = reinterpret_cast<ctrl_t *>(_slots + new_capacity);
+        _capacity = new_capacity;
+        std::memset(_ctrl, static_cast<unsigned char>(ctrl_empty), new_capacity + group::width);
+        for (size_type i = 0; i < old_capacity; ++i)
+        {
+            if (old_ctrl[i] >= 0)
+            {
+                size_type hash = hash_of(Policy::key(old_slots[i]));
+                size_type index = find_first_free(hash);
+                set_ctrl(index, h2_of(hash));
+                std::uninitialized_relocate(old_slots + i, old_slots + i + 1, _slots + index);
+            }
+        }
+        _growth_left = max_load(new_capacity) - _size;
+        if (old_capacity > 0)
+        {
+            allocator_traits<allocator_type>::deallocate(_alloc, old_slots, block_units(old_capacity));
+        }
+    }
+
+    void destroy_all() noexcept
+    {
+        if constexpr (!is_trivially_destructible_v<value_type>)
+        {
+            for (size_type i = 0; i < _capacity; ++i)
+            {
+                if (_ctrl[i] >= 0)
+                {
+                    std::destroy_at(_slots + i);
+                }
+            }
+        }
+    }
+
+    void release() noexcept
+    {
+        if (_capacity > 0)
+        {
+            allocator_traits<allocator_type>::deallocate(_alloc, _slots, block_units(_capacity));
+        }
+    }
+
+    void reset_empty() noexcept
+    {
+        _ctrl = nullptr;
+        _slots = nullptr;
+        _capacity = 0;
+        _size = 0;
+        _growth_left = 0;
+    }
+
+    void swap_storage(hash_table &other) noexcept
+    {
+        std::swap(_ctrl, other._ctrl);
+        std::swap(_slots, other._slots);
+        std::swap(_capacity, other._capacity);
+        std::swap(_size, other._size);
+        std::swap(_growth_left, other._growth_left);
+    }
+};
+} // namespace detail
+} // namespace std
+#endif
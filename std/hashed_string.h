@@ -0,0 +1,229 @@
+/*!
+ * @file hashed_string.h
+ * @brief Strings and string views that carry their hash
+ * @namespace std
+ * @details A hashed_string_view is a string_view plus the hash of its units, computed once when it is made. Keyed by
+ * basic_hashed_string, a hash container takes the cached hash instead of hashing the key again on every lookup and
+ * rehash, and two hashed strings with different hashes compare unequal without looking at their units.
+ *
+ * Lookups take a hashed_string_view, which can be made once and reused for many lookups, or a plain string_view,
+ * which is hashed on each call like a std::string key would be.
+ */
+#ifndef HASHED_STRING_H
+#define HASHED_STRING_H
+#include <functional.h>
+#include <memory.h>
+#include <stddef.h>
+#include <string.h>
+#include <string_view.h>
+#include <utility.h>
+
+namespace std
+{
+/*!
+ * @brief A view of UTF-16 units and their std::hash<string_view>
+ */
+class hashed_string_view
+{
+  public:
+    using size_type = std::size_t;
+
+    hashed_string_view() noexcept = default;
+
+    //! Hashes the units of view; explicit because it costs a pass over them.
+    explicit hashed_string_view(string_view view) noexcept
+        : _view(view)
+        , _hash(std::hash<string_view>()(view))
+    {
+    }
+
+    //! Takes a hash computed earlier, which must be std::hash<string_view>()(view).
+    constexpr hashed_string_view(string_view view, size_type precomputed_hash) noexcept
+        : _view(view)
+        , _hash(precomputed_hash)
+    {
+    }
+
+    constexpr string_view view() const noexcept
+    {
+        return _view;
+    }
+
+    constexpr const short *data() const noexcept
+    {
+        return _view.data();
+    }
+
+    constexpr size_type size() const noexcept
+    {
+        return _view.size();
+    }
+
+    constexpr bool empty() const noexcept
+    {
+        return _view.empty();
+    }
+
+    constexpr size_type hash() const noexcept
+    {
+        return _hash;
+    }
+
+    //! Different hashes prove the units differ; only equal hashes fall through to comparing them.
+    friend bool operator==(hashed_string_view a, hashed_string_view b) noexcept
+    {
+        return a._hash == b._hash && a._view == b._view;
+    }
+
+    friend bool operator==(hashed_string_view a, string_view b) noexcept
+    {
+        return a._view == b;
+    }
+
+  private:
+    string_view _view;
+    size_type _hash = std::hash<string_view>()(string_view());
+};
+
+/*!
+ * @brief An immutable string that stores its hash next to its units
+ * @tparam Allocator Allocator of the underlying basic_string
+ */
+template<typename Allocator = std::allocator<short>> class basic_hashed_string
+{
+  public:
+    using string_type = basic_string<Allocator>;
+    using size_type = std::size_t;
+
+    basic_hashed_string()
+        : _hash(std::hash<string_view>()(string_view()))
+    {
+    }
+
+    basic_hashed_string(const char *str)
+        : _string(str)
+        , _hash(std::hash<string_view>()(_string.view()))
+    {
+    }
+
+    explicit basic_hashed_string(string_view view, const Allocator &alloc = Allocator())
+        : _string(view, alloc)
+        , _hash(std::hash<string_view>()(view))
+    {
+    }
+
+    //! Copies the units and the hash of a hashed view without hashing again.
+    explicit basic_hashed_string(hashed_string_view view, const Allocator &alloc = Allocator())
+        : _string(view.view(), alloc)
+        , _hash(view.hash())
+    {
+    }
+
+    explicit basic_hashed_string(string_type &&str) noexcept
+        : _string(std::move(str))
+        , _hash(std::hash<string_view>()(_string.view()))
+    {
+    }
+
+    explicit basic_hashed_string(const string_type &str)
+        : _string(str)
+        , _hash(std::hash<string_view>()(_string.view()))
+    {
+    }
+
+    const string_type &str() const noexcept
+    {
+        return _string;
+    }
+
+    string_view view() const noexcept
+    {
+        return _string.view();
+    }
+
+    size_type size() const noexcept
+    {
+        return _string.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return _string.empty();
+    }
+
+    size_type hash() const noexcept
+    {
+        return _hash;
+    }
+
+    //! A hashed view of the string, sharing its cached hash.
+    operator hashed_string_view() const noexcept
+    {
+        return hashed_string_view(_string.view(), _hash);
+    }
+
+    /*!
+     * @brief Gives up the underlying string, leaving this one empty
+     */
+    string_type release() noexcept
+    {
+        string_type result = std::move(_string);
+        _hash = std::hash<string_view>()(string_view());
+        return result;
+    }
+
+  private:
+    string_type _string;
+    size_type _hash;
+};
+
+using hashed_string = basic_hashed_string<>;
+
+/*!
+ * @brief Returns the cached hash of a hashed string or view, and hashes a plain string_view
+ * @details Transparent, so containers keyed by a hashed string can be searched with either kind of view. A
+ * hashed_string_view hashes to the same value as its plain view, which keeps the two lookups consistent.
+ */
+template<> struct hash<hashed_string_view>
+{
+    using is_transparent = void;
+    using is_avalanching = void;
+
+    std::size_t operator()(hashed_string_view view) const noexcept
+    {
+        return view.hash();
+    }
+
+    std::size_t operator()(string_view view) const noexcept
+    {
+        return std::hash<string_view>()(view);
+    }
+};
+
+template<typename Allocator> struct hash<basic_hashed_string<Allocator>> : hash<hashed_string_view>
+{
+    using hash<hashed_string_view>::operator();
+
+    std::size_t operator()(const basic_hashed_string<Allocator> &str) const noexcept
+    {
+        return str.hash();
+    }
+};
+
+template<typename Allocator>
+bool operator==(const basic_hashed_string<Allocator> &a, const basic_hashed_string<Allocator> &b) noexcept
+{
+    return hashed_string_view(a) == hashed_string_view(b);
+}
+
+template<typename Allocator> bool operator==(const basic_hashed_string<Allocator> &a, hashed_string_view b) noexcept
+{
+    return hashed_string_view(a) == b;
+}
+
+template<typename Allocator> bool operator==(const basic_hashed_string<Allocator> &a, string_view b) noexcept
+{
+    return a.view() == b;
+}
+} // namespace std
+#endif
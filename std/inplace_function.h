@@ -0,0 +1,493 @@
+/*!
+ * @file inplace_function.h
+ * @brief Type-erased callables that keep small callables inside the object
+ * @namespace std
+ * @details Two wrappers for a callable with the signature R(Args...), such as a comparator or a task body handed to
+ * a function that is not a template:
+ *
+ * - inplace_function<R(Args...), Capacity, Alignment> stores the callable in Capacity bytes inside itself and never
+ *   allocates; a callable that does not fit is a compile error. It is copyable and its operator() is const, as in
+ *   SG14's inplace_function.
+ * - move_only_function<R(Args...)> is the C++23 type of that name: callables of up to three pointers that can be
+ *   moved without throwing are stored inline, larger ones on the heap through operator new. It is move only, so it
+ *   takes lambdas capturing move-only state, and its operator() is not const.
+ *
+ * Each wrapper holds a pointer to a constant table of functions made at compile time for the stored type, so a call
+ * is one indirect call and no virtual functions or RTTI are involved. A callable that is trivially copyable and
+ * trivially destructible, such as a function pointer or a lambda capturing nothing or only pointers and integers,
+ * has no relocate, copy or destroy entries: moving and copying the wrapper copies its bytes and destroying it does
+ * nothing. An empty wrapper points at a table whose call entry stops the program, so calls never test for empty.
+ *
+ * Only function signatures are supported, not member pointers or const, ref or noexcept qualified signatures.
+ */
+#ifndef INPLACE_FUNCTION_H
+#define INPLACE_FUNCTION_H
+#include <memory.h>
+#include <new.h>
+#include <stddef.h>
+#include <stdexcept.h>
+#include <type_traits.h>
+#include <utility.h>
+
+namespace std
+{
+namespace detail
+{
+//! The default alignment of inplace_function storage, the strictest of the scalar types as max_align_t would be.
+inline constexpr std::size_t function_alignment = alignof(long double);
+} // namespace detail
+
+/*!
+ * @brief The default inplace_function has 32 bytes of storage, enough for a lambda capturing four pointers
+ */
+template<typename Signature, std::size_t Capacity = 32, std::size_t Alignment = detail::function_alignment>
+class inplace_function;
+template<typename Signature> class move_only_function;
+
+namespace detail
+{
+template<typename Signature> struct function_vtable;
+
+/*!
+ * @brief The operations of one stored callable type, shared by every wrapper holding that type
+ */
+template<typename R, typename... Args> struct function_vtable<R(Args...)>
+{
+    R (*invoke)(void *storage, Args &&...args);
+    void (*relocate)(void *to, void *from) noexcept; //!< Moves into to and destroys from; nullptr copies the bytes.
+    void (*copy)(void *to, const void *from);         //!< Copies into to; nullptr copies the bytes.
+    void (*destroy)(void *storage) noexcept;          //!< nullptr when there is nothing to destroy.
+};
+
+template<typename F> inline constexpr bool is_trivial_callable = is_trivially_copyable_v<F> &&
+                                                                  is_trivially_destructible_v<F>;
+
+template<typename F> inline constexpr bool is_nothrow_relocatable_callable = noexcept(F(std::declval<F &&>()));
+
+template<typename R, typename F, typename... Args> R invoke_callable(F &callable, Args &&...args)
+{
+    if constexpr (is_void_v<R>)
+    {
+        callable(std::forward<Args>(args)...);
+    }
+    else
+    {
+        return callable(std::forward<Args>(args)...);
+    }
+}
+
+/*!
+ * @brief The tables for callables of type F, stored inline or, for move_only_function, behind a heap pointer
+ */
+template<typename Signature, typename F> struct function_vtables;
+
+template<typename R, typename F, typename... Args> struct function_vtables<R(Args...), F>
+{
+    static R invoke_local(void *storage, Args &&...args)
+    {
+        return invoke_callable<R>(*static_cast<F *>(storage), std::forward<Args>(args)...);
+    }
+
+    static R invoke_heap(void *storage, Args &&...args)
+    {
+        return invoke_callable<R>(**static_cast<F **>(storage), std::forward<Args>(args)...);
+    }
+
+    static void relocate_local(void *to, void *from) noexcept
+    {
+        F *source = static_cast<F *>(from);
+        std::construct_at(static_cast<F *>(to), std::move(*source));
+        std::destroy_at(source);
+    }
+
+    static void copy_local(void *to, const void *from)
+    {
+        std::construct_at(static_cast<F *>(to), *static_cast<const F *>(from));
+    }
+
+    static void destroy_local(void *storage) noexcept
+    {
+        std::destroy_at(static_cast<F *>(storage));
+    }
+
+    static void destroy_heap(void *storage) noexcept
+    {
+        delete *static_cast<F **>(storage);
+    }
+
+    static constexpr bool trivial = is_trivial_callable<F>;
+
+    //! For a callable kept inline by a wrapper that is copied.
+    static constexpr function_vtable<R(Args...)> copyable{&invoke_local, trivial ? nullptr : &relocate_local,
+                                                         trivial ? nullptr : &copy_local,
+                                                         trivial ? nullptr : &destroy_local};
+
+    //! For a callable kept inline by a move-only wrapper.
+    static constexpr function_vtable<R(Args...)> movable{&invoke_local, trivial ? nullptr : &relocate_local, nullptr,
+                                                        trivial ? nullptr : &destroy_local};
+
+    //! For a callable on the heap; the wrapper holds the pointer, which moves by copying its bytes.
+    static constexpr function_vtable<R(Args...)> heap{&invoke_heap, nullptr, nullptr, &destroy_heap};
+};
+
+template<typename R, typename... Args> R invoke_empty_function(void *, Args &&...)
+{
+    fatal_error("call of an empty function wrapper");
+}
+
+template<typename Signature> struct empty_function_vtable;
+
+template<typename R, typename... Args> struct empty_function_vtable<R(Args...)>
+{
+    static constexpr function_vtable<R(Args...)> value{&invoke_empty_function<R, Args...>, nullptr, nullptr, nullptr};
+};
+
+//! The type a wrapper stores for a callable passed as F: the callable itself, or a pointer for a function.
+template<typename F> struct stored_callable
+{
+    using type = remove_cv_t<remove_reference_t<F>>;
+};
+
+template<typename R, typename... Args> struct stored_callable<R (&)(Args...)>
+{
+    using type = R (*)(Args...);
+};
+
+template<typename R, typename... Args> struct stored_callable<R(Args...)>
+{
+    using type = R (*)(Args...);
+};
+
+template<typename T> struct is_function_wrapper : false_type
+{
+};
+
+template<typename Signature, std::size_t Capacity, std::size_t Alignment>
+struct is_function_wrapper<inplace_function<Signature, Capacity, Alignment>> : true_type
+{
+};
+
+template<typename Signature> struct is_function_wrapper<move_only_function<Signature>> : true_type
+{
+};
+
+/*!
+ * @brief A callable a wrapper of signature R(Args...) can be made from: not a wrapper itself, and callable with
+ * Args... giving something convertible to R
+ */
+template<typename F, typename R, typename... Args>
+concept wrappable_callable = !is_function_wrapper<remove_cv_t<remove_reference_t<F>>>::value &&
+                             requires(remove_cv_t<remove_reference_t<F>> &callable, Args &&...args) {
+                                 static_cast<R>(callable(std::forward<Args>(args)...));
+                             };
+
+/*!
+ * @brief Whether callable is a null function or member pointer, which makes an empty wrapper as in std::function
+ */
+template<typename F> constexpr bool is_null_callable(const F &callable) noexcept
+{
+    if constexpr (is_pointer_v<F> || is_member_pointer<F>::value)
+    {
+        return callable == nullptr;
+    }
+    else
+    {
+        (void)callable;
+        return false;
+    }
+}
+} // namespace detail
+
+/*!
+ * @brief A copyable callable wrapper that stores its callable in Capacity bytes and never allocates
+ * @tparam Capacity Bytes reserved for the callable; larger callables do not compile
+ * @tparam Alignment Alignment of the storage; callables needing more do not compile
+ */
+template<typename R, typename... Args, std::size_t Capacity, std::size_t Alignment>
+class inplace_function<R(Args...), Capacity, Alignment>
+{
+    static_assert(Capacity >= sizeof(void *), "an inplace_function needs room for at least a pointer");
+    using vtable = detail::function_vtable<R(Args...)>;
+
+  public:
+    using result_type = R;
+
+    //! Bytes available to a stored callable.
+    static constexpr std::size_t capacity = Capacity;
+
+    inplace_function() noexcept = default;
+
+    inplace_function(std::nullptr_t) noexcept
+    {
+    }
+
+    /*!
+     * @brief Stores a copy of callable, or stays empty if it is a null pointer
+     */
+    template<typename F>
+        requires detail::wrappable_callable<F, R, Args...>
+    inplace_function(F &&callable)
+    {
+        using stored = typename detail::stored_callable<F>::type;
+        static_assert(sizeof(stored) <= Capacity, "the callable does not fit in this inplace_function's Capacity");
+        static_assert(Alignment % alignof(stored) == 0, "the callable needs more alignment than this inplace_function");
+        if (!detail::is_null_callable(callable))
+        {
+            std::construct_at(reinterpret_cast<stored *>(_storage), std::forward<F>(callable));
+            _vtable = &detail::function_vtables<R(Args...), stored>::copyable;
+        }
+    }
+
+    inplace_function(const inplace_function &other)
+        : _vtable(other._vtable)
+    {
+        if (_vtable->copy == nullptr)
+        {
+            __builtin_memcpy(_storage, other._storage, Capacity);
+        }
+        else
+        {
+            _vtable->copy(_storage, other._storage);
+        }
+    }
+
+    inplace_function(inplace_function &&other) noexcept
+    {
+        take(other);
+    }
+
+    ~inplace_function()
+    {
+        reset();
+    }
+
+    inplace_function &operator=(const inplace_function &other)
+    {
+        if (this != &other)
+        {
+            inplace_function copy(other);
+            reset();
+            take(copy);
+        }
+        return *this;
+    }
+
+    inplace_function &operator=(inplace_function &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    inplace_function &operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    template<typename F>
+        requires detail::wrappable_callable<F, R, Args...>
+    inplace_function &operator=(F &&callable)
+    {
+        inplace_function replacement(std::forward<F>(callable));
+        reset();
+        take(replacement);
+        return *this;
+    }
+
+    void swap(inplace_function &other) noexcept
+    {
+        inplace_function held(std::move(other));
+        other.take(*this);
+        take(held);
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return _vtable != &detail::empty_function_vtable<R(Args...)>::value;
+    }
+
+    friend bool operator==(const inplace_function &function, std::nullptr_t) noexcept
+    {
+        return !function;
+    }
+
+    //! Calls the stored callable. Calling an empty inplace_function stops the program.
+    R operator()(Args... args) const
+    {
+        return _vtable->invoke(const_cast<unsigned char *>(_storage), std::forward<Args>(args)...);
+    }
+
+  private:
+    const vtable *_vtable = &detail::empty_function_vtable<R(Args...)>::value;
+    alignas(Alignment) unsigned char _storage[Capacity];
+
+    void reset() noexcept
+    {
+        if (_vtable->destroy != nullptr)
+        {
+            _vtable->destroy(_storage);
+        }
+        _vtable = &detail::empty_function_vtable<R(Args...)>::value;
+    }
+
+    //! Moves the callable of other, which is left empty, into this empty wrapper.
+    void take(inplace_function &other) noexcept
+    {
+        if (other._vtable->relocate == nullptr)
+        {
+            __builtin_memcpy(_storage, other._storage, Capacity);
+        }
+        else
+        {
+            other._vtable->relocate(_storage, other._storage);
+        }
+        _vtable = other._vtable;
+        other._vtable = &detail::empty_function_vtable<R(Args...)>::value;
+    }
+};
+
+/*!
+ * @brief A move-only callable wrapper that stores small callables inline and others on the heap
+ */
+template<typename R, typename... Args> class move_only_function<R(Args...)>
+{
+    using vtable = detail::function_vtable<R(Args...)>;
+
+  public:
+    using result_type = R;
+
+    //! Bytes available to a callable stored inline.
+    static constexpr std::size_t inline_capacity = 3 * sizeof(void *);
+
+    move_only_function() noexcept = default;
+
+    move_only_function(std::nullptr_t) noexcept
+    {
+    }
+
+    /*!
+     * @brief Stores callable inline if it fits and moves without throwing, on the heap otherwise
+     * @details A null pointer leaves the wrapper empty.
+     */
+    template<typename F>
+        requires detail::wrappable_callable<F, R, Args...>
+    move_only_function(F &&callable)
+    {
+        using stored = typename detail::stored_callable<F>::type;
+        if (detail::is_null_callable(callable))
+        {
+            return;
+        }
+        if constexpr (stores_inline<stored>)
+        {
+            std::construct_at(reinterpret_cast<stored *>(_storage), std::forward<F>(callable));
+            _vtable = &detail::function_vtables<R(Args...), stored>::movable;
+        }
+        else
+        {
+            stored *heap = new stored(std::forward<F>(callable));
+            __builtin_memcpy(_storage, &heap, sizeof(heap));
+            _vtable = &detail::function_vtables<R(Args...), stored>::heap;
+        }
+    }
+
+    move_only_function(move_only_function &&other) noexcept
+    {
+        take(other);
+    }
+
+    move_only_function(const move_only_function &) = delete;
+    move_only_function &operator=(const move_only_function &) = delete;
+
+    ~move_only_function()
+    {
+        reset();
+    }
+
+    move_only_function &operator=(move_only_function &&other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            take(other);
+        }
+        return *this;
+    }
+
+    move_only_function &operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    template<typename F>
+        requires detail::wrappable_callable<F, R, Args...>
+    move_only_function &operator=(F &&callable)
+    {
+        move_only_function replacement(std::forward<F>(callable));
+        reset();
+        take(replacement);
+        return *this;
+    }
+
+    void swap(move_only_function &other) noexcept
+    {
+        move_only_function held(std::move(other));
+        other.take(*this);
+        take(held);
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return _vtable != &detail::empty_function_vtable<R(Args...)>::value;
+    }
+
+    friend bool operator==(const move_only_function &function, std::nullptr_t) noexcept
+    {
+        return !function;
+    }
+
+    //! Calls the stored callable. Calling an empty move_only_function stops the program.
+    R operator()(Args... args)
+    {
+        return _vtable->invoke(_storage, std::forward<Args>(args)...);
+    }
+
+    //! Whether a callable of type F is kept inside the wrapper rather than on the heap.
+    template<typename F>
+    static constexpr bool stores_inline = sizeof(F) <= inline_capacity && alignof(F) <= alignof(void *) &&
+                                          detail::is_nothrow_relocatable_callable<F>;
+
+  private:
+    const vtable *_vtable = &detail::empty_function_vtable<R(Args...)>::value;
+    alignas(void *) unsigned char _storage[inline_capacity];
+
+    void reset() noexcept
+    {
+        if (_vtable->destroy != nullptr)
+        {
+            _vtable->destroy(_storage);
+        }
+        _vtable = &detail::empty_function_vtable<R(Args...)>::value;
+    }
+
+    void take(move_only_function &other) noexcept
+    {
+        if (other._vtable->relocate == nullptr)
+        {
+            __builtin_memcpy(_storage, other._storage, inline_capacity);
+        }
+        else
+        {
+            other._vtable->relocate(_storage, other._storage);
+        }
+        _vtable = other._vtable;
+        other._vtable = &detail::empty_function_vtable<R(Args...)>::value;
+    }
+};
+} // namespace std
+#endif
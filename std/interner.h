@@ -0,0 +1,294 @@
+/*!
+ * @file interner.h
+ * @brief A table that keeps one copy of each distinct string and hands out atoms for them
+ * @namespace std
+ * @details An atom is one pointer to the interned copy, so two atoms from the same interner are equal exactly when
+ * their strings are, and comparing them compares pointers. The copy stores its hash and length next to its units:
+ * hashing an atom reads the stored hash and view() points at the copy without copying it again. Atoms stay valid for
+ * as long as the interner that made them.
+ *
+ * The copies live in a monotonic arena and never move. The lookup table is an open-addressing array of atomic
+ * pointers to them, so any number of threads can intern at once. A string that is already there is found without
+ * taking a lock or writing to shared memory. Only a new string takes the interner's lock, to copy it into the arena
+ * and publish it. When the table grows, readers still probing the old array see every string published before the
+ * switch, and retry under the lock before concluding a string is missing. Old arrays stay in the arena until the
+ * interner is destroyed; together they are smaller than the current one.
+ */
+#ifndef INTERNER_H
+#define INTERNER_H
+#include <atomic.h>
+#include <cstring.h>
+#include <functional.h>
+#include <hashed_string.h>
+#include <memory_resource.h>
+#include <new.h>
+#include <stddef.h>
+#include <string_view.h>
+#include <thread.h>
+
+namespace std
+{
+namespace detail
+{
+/*!
+ * @brief The interned copy of a string: its hash and length, directly followed by its units
+ */
+struct atom_entry
+{
+    std::size_t hash;
+    std::size_t size;
+
+    const short *units() const noexcept
+    {
+        return reinterpret_cast<const short *>(this + 1);
+    }
+
+    bool equals(hashed_string_view text) const noexcept
+    {
+        return hash == text.hash() && size == text.size() &&
+               std::memcmp(units(), text.data(), size * sizeof(short)) == 0;
+    }
+};
+} // namespace detail
+
+/*!
+ * @brief A handle to a string interned by an interner
+ * @details The default atom is the empty string, which every interner returns for it without storing anything.
+ * Atoms from different interners must not be compared.
+ */
+class atom
+{
+  public:
+    using size_type = std::size_t;
+
+    constexpr atom() noexcept = default;
+
+    //! The interned units; valid while the interner is.
+    string_view view() const noexcept
+    {
+        return _entry != nullptr ? string_view(_entry->units(), _entry->size) : string_view();
+    }
+
+    //! std::hash<string_view> of the units, computed once when the string was interned.
+    size_type hash() const noexcept
+    {
+        return _entry != nullptr ? _entry->hash : std::hash<string_view>()(string_view());
+    }
+
+    hashed_string_view hashed() const noexcept
+    {
+        return hashed_string_view(view(), hash());
+    }
+
+    size_type size() const noexcept
+    {
+        return _entry != nullptr ? _entry->size : 0;
+    }
+
+    constexpr bool empty() const noexcept
+    {
+        return _entry == nullptr;
+    }
+
+    friend constexpr bool operator==(atom a, atom b) noexcept
+    {
+        return a._entry == b._entry;
+    }
+
+  private:
+    friend class interner;
+
+    const detail::atom_entry *_entry = nullptr; ///< The interned copy, nullptr for the empty string.
+
+    constexpr explicit atom(const detail::atom_entry *entry) noexcept
+        : _entry(entry)
+    {
+    }
+};
+
+template<> struct hash<atom>
+{
+    std::size_t operator()(atom value) const noexcept
+    {
+        return value.hash();
+    }
+};
+
+/*!
+ * @brief Stores each distinct string once and returns the same atom every time it is interned
+ * @details Safe to use from any number of threads at once. Neither copyable nor movable, as atoms point into it.
+ */
+class interner final
+{
+  public:
+    using size_type = std::size_t;
+
+    /*!
+     * @brief Creates an empty interner
+     * @param upstream Where the arena takes its chunks from
+     */
+    explicit interner(pmr::memory_resource *upstream = pmr::get_default_resource()) noexcept
+        : _arena(upstream)
+    {
+    }
+
+    interner(const interner &) = delete;
+    interner &operator=(const interner &) = delete;
+
+    //! Returns the atom for text, copying text into the arena the first time it is seen.
+    atom intern(string_view text)
+    {
+        return intern(hashed_string_view(text));
+    }
+
+    //! Like intern(string_view), with the hash computed earlier.
+    atom intern(hashed_string_view text)
+    {
+        if (text.empty())
+        {
+            return atom();
+        }
+        if (const detail::atom_entry *entry = lookup(_table.load(memory_order::acquire), text))
+        {
+            return atom(entry);
+        }
+        // Released on the way out even when the arena throws
+        struct locked
+        {
+            detail::spin_lock &lock;
+
+            ~locked()
+            {
+                lock.unlock();
+            }
+        };
+        _lock.lock();
+        locked guard{_lock};
+        return atom(insert(text));
+    }
+
+    //! Returns the atom for text if it has been interned, and the empty atom otherwise.
+    atom find(string_view text) const noexcept
+    {
+        return find(hashed_string_view(text));
+    }
+
+    atom find(hashed_string_view text) const noexcept
+    {
+        if (text.empty())
+        {
+            return atom();
+        }
+        return atom(lookup(_table.load(memory_order::acquire), text));
+    }
+
+    //! Number of distinct non-empty strings interned.
+    size_type size() const noexcept
+    {
+        return _count.load(memory_order::relaxed);
+    }
+
+  private:
+    //! One open-addressing array; its mask + 1 slots follow it in the same block.
+    struct table
+    {
+        size_type mask;
+
+        atomic<const detail::atom_entry *> *slots() noexcept
+        {
+            return reinterpret_cast<atomic<const detail::atom_entry *> *>(this + 1);
+        }
+    };
+
+    static constexpr size_type initial_slots = 64;
+
+    atomic<table *> _table{nullptr};          ///< The current array, nullptr until the first string.
+    atomic<size_type> _count{0};              ///< Number of strings in the table.
+    pmr::monotonic_buffer_resource _arena;    ///< Holds the copies and every array, written under _lock.
+    detail::spin_lock _lock;                  ///< Serializes insertions.
+
+    /*!
+     * @brief Probes slots from hash & mask until text or an empty slot is found
+     * @details Slots are acquired, so a pointer read from one points at a fully written entry.
+     */
+    static const detail::atom_entry *lookup(table *current, hashed_string_view text) noexcept
+    {
+        if (current == nullptr)
+        {
+            return nullptr;
+        }
+        atomic<const detail::atom_entry *> *slots = current->slots();
+        for (size_type index = text.hash() & current->mask;; index = (index + 1) & current->mask)
+        {
+            const detail::atom_entry *entry = slots[index].load(memory_order::acquire);
+            if (entry == nullptr || entry->equals(text))
+            {
+                return entry;
+            }
+        }
+    }
+
+    //! Looks text up again under the lock, since another thread may have added it, and adds it if it is missing.
+    const detail::atom_entry *insert(hashed_string_view text)
+    {
+        table *current = _table.load(memory_order::relaxed);
+        if (const detail::atom_entry *entry = lookup(current, text))
+        {
+            return entry;
+        }
+        size_type count = _count.load(memory_order::relaxed);
+        // Kept at most half full, so probes stay short
+        if (current == nullptr || (count + 1) * 2 > current->mask + 1)
+        {
+            current = grow(current);
+        }
+        void *block = _arena.allocate(sizeof(detail::atom_entry) + text.size() * sizeof(short),
+                                      alignof(detail::atom_entry));
+        detail::atom_entry *entry = ::new (block) detail::atom_entry{text.hash(), text.size()};
+        std::memcpy(reinterpret_cast<short *>(entry + 1), text.data(), text.size() * sizeof(short));
+        place(current, entry, memory_order::release);
+        _count.store(count + 1, memory_order::relaxed);
+        return entry;
+    }
+
+    //! Stores entry in the first empty slot of its probe sequence.
+    static void place(table *current, const detail::atom_entry *entry, memory_order order) noexcept
+    {
+        atomic<const detail::atom_entry *> *slots = current->slots();
+        size_type index = entry->hash & current->mask;
+        while (slots[index].load(memory_order::relaxed) != nullptr)
+        {
+            index = (index + 1) & current->mask;
+        }
+        slots[index].store(entry, order);
+    }
+
+    //! Builds an array twice the size holding every entry of old, then publishes it.
+    table *grow(table *old)
+    {
+        size_type slot_count = old != nullptr ? (old->mask + 1) * 2 : initial_slots;
+        void *block = _arena.allocate(sizeof(table) + slot_count * sizeof(atomic<const detail::atom_entry *>),
+                                      alignof(table));
+        table *replacement = ::new (block) table{slot_count - 1};
+        atomic<const detail::atom_entry *> *slots = replacement->slots();
+        for (size_type i = 0; i < slot_count; i++)
+        {
+            ::new (static_cast<void *>(slots + i)) atomic<const detail::atom_entry *>(nullptr);
+        }
+        if (old != nullptr)
+        {
+            atomic<const detail::atom_entry *> *old_slots = old->slots();
+            for (size_type i = 0; i <= old->mask; i++)
+            {
+                if (const detail::atom_entry *entry = old_slots[i].load(memory_order::relaxed))
+                {
+                    place(replacement, entry, memory_order::relaxed);
+                }
+            }
+        }
+        _table.store(replacement, memory_order::release);
+        return replacement;
+    }
+};
+} // namespace std
+#endif
@@ -0,0 +1,383 @@
+/*!
+ * @file memory.h
+ * @brief The default allocator and helpers for constructing, destroying and relocating objects in uninitialized
+ * storage
+ * @namespace std
+ * @note This header is a part of the C++ standard library.
+ */
+#ifndef MEMORY_H
+#define MEMORY_H
+#include <algorithm.h>
+#include <new.h>
+#include <stddef.h>
+#include <stdexcept.h>
+#include <type_traits.h>
+#include <utility.h>
+
+/*
+ * Empty allocators are stored with [[no_unique_address]] so that they add nothing to the size of a container.
+ */
+#if defined(_MSC_VER) && !defined(__clang__)
+#    define STD_NO_UNIQUE_ADDRESS [[msvc::no_unique_address]]
+#else
+#    define STD_NO_UNIQUE_ADDRESS [[no_unique_address]]
+#endif
+
+namespace std
+{
+/*!
+ * @brief The default allocator used by the containers
+ * @details Storage comes from the global operator new[] and therefore from os::operator_new_array(), the same hook the
+ *          containers used before they became allocator aware. Over-aligned types go through the aligned operator
+ *          new instead. The allocator is stateless, so every instance compares equal.
+ * @tparam T The type of the objects to allocate storage for
+ */
+template<typename T> class allocator
+{
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    template<typename U> struct rebind
+    {
+        using other = allocator<U>;
+    };
+
+    constexpr allocator() noexcept = default;
+    constexpr allocator(const allocator &) noexcept = default;
+    template<typename U> constexpr allocator(const allocator<U> &) noexcept
+    {
+    }
+    constexpr allocator &operator=(const allocator &) noexcept = default;
+
+    //! The largest count whose size in bytes fits in a size_type.
+    constexpr size_type max_size() const noexcept
+    {
+        return static_cast<size_type>(-1) / sizeof(T);
+    }
+
+    /*!
+     * @brief Allocates uninitialized storage for count objects
+     * @param count Number of objects
+     * @return Pointer to the storage
+     * @throws std::length_error if count > max_size(), where the size in bytes would wrap
+     */
+    [[nodiscard]] T *allocate(size_type count)
+    {
+        if (count > max_size())
+        {
+            STD_THROW(std::length_error());
+        }
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t(alignof(T))));
+        }
+        else
+        {
+            return static_cast<T *>(::operator new[](count * sizeof(T)));
+        }
+    }
+
+    /*!
+     * @brief Releases storage obtained from allocate()
+     * @param ptr Pointer returned by allocate()
+     * @param count The count passed to allocate()
+     */
+    void deallocate(T *ptr, size_type count) noexcept
+    {
+        (void)count;
+        if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            ::operator delete(static_cast<void *>(ptr), std::align_val_t(alignof(T)));
+        }
+        else
+        {
+            ::operator delete[](static_cast<void *>(ptr));
+        }
+    }
+
+#if defined(STD_HAS_OS_REALLOC) && !defined(STD_ENABLE_MEMORY_POOL) && !defined(STD_ENABLE_ALLOC_STATS)
+    /*!
+     * @brief Resizes storage from allocate() to new_count objects without moving it
+     * @details Only available when the program provides the os::try_expand() hook and operator new is not routed
+     *          through the memory pool or the allocation stats layer.
+     * @return true if the storage now holds new_count objects at the same address
+     */
+    bool try_expand(T *ptr, size_type old_count, size_type new_count) noexcept
+        requires(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+        (void)old_count;
+        if (new_count > max_size())
+        {
+            return false;
+        }
+        return os::try_expand(static_cast<void *>(ptr), new_count * sizeof(T));
+    }
+
+    /*!
+     * @brief Resizes storage from allocate() to new_count objects, moving its bytes if needed
+     * @details The objects are moved bytewise, so this is only for trivially relocatable types.
+     * @return The resized storage, or nullptr if it could not be resized, in which case ptr is left untouched
+     */
+    T *reallocate(T *ptr, size_type old_count, size_type new_count) noexcept
+        requires(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+        (void)old_count;
+        if (new_count > max_size())
+        {
+            return nullptr;
+        }
+        return static_cast<T *>(os::operator_realloc(static_cast<void *>(ptr), new_count * sizeof(T)));
+    }
+#endif
+
+    template<typename U> constexpr bool operator==(const allocator<U> &) const noexcept
+    {
+        return true;
+    }
+};
+
+/*!
+ * @brief Uniform access to the optional parts of an allocator
+ * @details Containers only call allocate() and deallocate() through this class, so an allocator needs nothing more
+ *          than value_type, allocate(), deallocate() and a rebind member. Allocators that can resize a block may add
+ *          try_expand() and reallocate(), which containers use to grow without copying.
+ * @tparam Alloc The allocator type
+ */
+template<typename Alloc> struct allocator_traits
+{
+    using allocator_type = Alloc;
+    using value_type = typename Alloc::value_type;
+    using size_type = std::size_t;
+
+    template<typename U> using rebind_alloc = typename Alloc::template rebind<U>::other;
+
+    [[nodiscard]] static value_type *allocate(Alloc &alloc, size_type count)
+    {
+        return alloc.allocate(count);
+    }
+
+    static void deallocate(Alloc &alloc, value_type *ptr, size_type count) noexcept
+    {
+        alloc.deallocate(ptr, count);
+    }
+
+    /*!
+     * @brief Resizes storage from allocate() without moving it, if the allocator can
+     * @details Uses Alloc::try_expand() if present; allocators without it never expand.
+     * @return true if ptr now holds new_count objects
+     */
+    static bool try_expand(Alloc &alloc, value_type *ptr, size_type old_count, size_type new_count) noexcept
+    {
+        if constexpr (requires { alloc.try_expand(ptr, old_count, new_count); })
+        {
+            return alloc.try_expand(ptr, old_count, new_count);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    //! True when reallocate() can succeed, i.e. Alloc has a reallocate() member.
+    static constexpr bool can_reallocate = requires(Alloc &alloc, value_type *ptr, size_type count) {
+        alloc.reallocate(ptr, count, count);
+    };
+
+    /*!
+     * @brief Resizes storage from allocate(), moving its bytes if needed, for trivially relocatable objects
+     * @details Uses Alloc::reallocate() if present.
+     * @return The resized storage, or nullptr if the allocator cannot resize it, in which case ptr is untouched
+     */
+    static value_type *reallocate(Alloc &alloc, value_type *ptr, size_type old_count, size_type new_count) noexcept
+    {
+        if constexpr (can_reallocate)
+        {
+            return alloc.reallocate(ptr, old_count, new_count);
+        }
+        else
+        {
+            (void)alloc;
+            (void)ptr;
+            (void)old_count;
+            (void)new_count;
+            return nullptr;
+        }
+    }
+
+    /*!
+     * @brief The allocator a copy of a container should use
+     * @details Uses Alloc::select_on_container_copy_construction() if present, a copy of alloc otherwise.
+     */
+    static Alloc select_on_container_copy_construction(const Alloc &alloc)
+    {
+        if constexpr (requires { alloc.select_on_container_copy_construction(); })
+        {
+            return alloc.select_on_container_copy_construction();
+        }
+        else
+        {
+            return alloc;
+        }
+    }
+};
+
+/*!
+ * @brief Constructs an object in uninitialized storage
+ * @tparam T The type of the object to construct
+ * @param p Pointer to storage suitable for a T
+ * @param args Arguments forwarded to the constructor of T
+ * @return Pointer to the constructed object
+ */
+template<typename T, typename... Args> constexpr T *construct_at(T *p, Args &&...args)
+{
+    return ::new (static_cast<void *>(p)) T(std::forward<Args>(args)...);
+}
+
+/*!
+ * @brief Destroys the object pointed to by p without releasing its storage
+ * @tparam T The type of the object
+ * @param p Pointer to the object to destroy
+ */
+template<typename T> constexpr void destroy_at(T *p) noexcept
+{
+    p->~T();
+}
+
+/*!
+ * @brief Destroys every object in the range [first, last)
+ * @tparam T The type of the objects
+ * @param first Beginning of the range
+ * @param last End of the range
+ * @note This is a no-op for trivially destructible types
+ */
+template<typename T> constexpr void destroy(T *first, T *last) noexcept
+{
+    if constexpr (!std::is_trivially_destructible_v<T>)
+    {
+        for (; first != last; ++first)
+        {
+            first->~T();
+        }
+    }
+}
+
+/*!
+ * @brief Copy-constructs count copies of value into uninitialized storage
+ * @tparam T The type of the objects
+ * @param first Beginning of the uninitialized storage
+ * @param count Number of objects to construct
+ * @param value The value to copy
+ * @return Pointer past the last constructed object
+ */
+template<typename T> T *uninitialized_fill_n(T *first, std::size_t count, const T &value)
+{
+    for (; count > 0; --count, ++first)
+    {
+        ::new (static_cast<void *>(first)) T(value);
+    }
+    return first;
+}
+
+/*!
+ * @brief Copy-constructs the range [first, last) into uninitialized storage
+ * @details Copying from a pointer range of trivially copyable objects is a single memcpy.
+ * @tparam InputIt The source iterator type
+ * @tparam T The type of the objects
+ * @param first Beginning of the source range
+ * @param last End of the source range
+ * @param d_first Beginning of the uninitialized storage
+ * @return Pointer past the last constructed object
+ */
+template<typename InputIt, typename T> T *uninitialized_copy(InputIt first, InputIt last, T *d_first)
+{
+    if constexpr ((std::is_same_v<InputIt, T *> || std::is_same_v<InputIt, const T *>) &&
+                  std::is_trivially_copyable_v<T>)
+    {
+        // A contiguous range of trivially copyable objects is copied as one block
+        std::size_t count = static_cast<std::size_t>(last - first);
+        if (count > 0)
+        {
+            std::memcpy(static_cast<void *>(d_first), static_cast<const void *>(first), count * sizeof(T));
+        }
+        return d_first + count;
+    }
+    else
+    {
+        for (; first != last; ++first, ++d_first)
+        {
+            ::new (static_cast<void *>(d_first)) T(*first);
+        }
+        return d_first;
+    }
+}
+
+/*!
+ * @brief Relocates the objects in [first, last) to uninitialized storage starting at d_first
+ * @details Relocation leaves the source storage uninitialized. Trivially relocatable types are moved with a single
+ *          memmove, every other type is move-constructed into place and the source destroyed, front to back. The
+ *          ranges may overlap as long as d_first is not after first.
+ * @tparam T The type of the objects
+ * @param first Beginning of the range to relocate
+ * @param last End of the range to relocate
+ * @param d_first Beginning of the destination storage
+ * @return Pointer past the last relocated object
+ */
+template<typename T> T *uninitialized_relocate(T *first, T *last, T *d_first) noexcept
+{
+    if constexpr (std::is_trivially_relocatable_v<T>)
+    {
+        std::size_t count = static_cast<std::size_t>(last - first);
+        if (count > 0)
+        {
+            std::memmove(static_cast<void *>(d_first), static_cast<const void *>(first), count * sizeof(T));
+        }
+        return d_first + count;
+    }
+    else
+    {
+        for (; first != last; ++first, ++d_first)
+        {
+            ::new (static_cast<void *>(d_first)) T(std::move(*first));
+            first->~T();
+        }
+        return d_first;
+    }
+}
+
+/*!
+ * @brief Relocates the objects in [first, last) to uninitialized storage ending at d_last
+ * @details The backward counterpart of uninitialized_relocate(), for overlapping ranges where the destination is
+ *          after the source.
+ * @tparam T The type of the objects
+ * @param first Beginning of the range to relocate
+ * @param last End of the range to relocate
+ * @param d_last End of the destination storage
+ * @return Pointer to the first relocated object
+ */
+template<typename T> T *uninitialized_relocate_backward(T *first, T *last, T *d_last) noexcept
+{
+    if constexpr (std::is_trivially_relocatable_v<T>)
+    {
+        std::size_t count = static_cast<std::size_t>(last - first);
+        if (count > 0)
+        {
+            std::memmove(static_cast<void *>(d_last - count), static_cast<const void *>(first), count * sizeof(T));
+        }
+        return d_last - count;
+    }
+    else
+    {
+        while (last != first)
+        {
+            --last;
+            --d_last;
+            ::new (static_cast<void *>(d_last)) T(std::move(*last));
+            last->~T();
+        }
+        return d_last;
+    }
+}
+} // namespace std
+#endif
@@ -0,0 +1,478 @@
+/*!
+ * @file memory_pool.h
+ * @brief Size-class pooling layer between the global operator new/delete and the os:: hooks
+ * @details Enabled by defining STD_ENABLE_MEMORY_POOL for the whole program, which the ENABLE_MEMORY_POOL CMake
+ * option does. new.h then routes every global operator new and delete through this pool, so memory allocated with
+ * the pool must never be released by a translation unit built without it.
+ *
+ * Requests of up to max_small_size bytes are rounded to one of class_count size classes. Each class is carved out of
+ * span_size spans obtained from os::operator_new_aligned() and aligned to their size, so the class of any block is
+ * read from the header at the start of its span. Freed blocks go onto a per-thread cache and are handed back to a
+ * spin-locked central free list per class in batches, which makes the common allocate and free a pointer pop and
+ * push. Larger or over-aligned requests get a span header of their own and go straight to the os:: hooks. Spans of
+ * small blocks are kept for reuse and never returned to the os.
+ *
+ * @section threads Thread hook
+ * The pool does not assume any thread library. It asks os::thread_cache_slot(), which the program provides like the
+ * other os:: hooks, for a pointer-sized slot private to the calling thread. Defining STD_MEMORY_POOL_THREAD_LOCAL
+ * uses a C++ thread_local slot instead. A thread without a slot (the hook returns nullptr) allocates from the
+ * central lists directly. Threads should call std::memory_pool::flush_thread_cache() before they exit, otherwise the
+ * blocks cached by them stay unused.
+ *
+ * @note This header is included by new.h and is not meant to be included directly.
+ */
+#ifndef MEMORY_POOL_H
+#define MEMORY_POOL_H
+#if !defined(NEW_H)
+#    error "memory_pool.h is included through new.h"
+#endif
+#include <stddef.h>
+
+namespace os
+{
+#if !defined(STD_MEMORY_POOL_THREAD_LOCAL)
+    /*!
+     * @brief Returns a pointer-sized slot private to the calling thread, or nullptr if the thread has none.
+     * @details The slot must read nullptr the first time a thread asks for it. The pool keeps its per-thread cache
+     * there.
+     */
+    void **thread_cache_slot();
+#endif
+} // namespace os
+
+namespace std
+{
+namespace memory_pool
+{
+inline constexpr std::size_t span_size = 64 * 1024;  //!< Size and alignment of a span.
+inline constexpr std::size_t header_size = 64;       //!< Space reserved for the span header.
+inline constexpr std::size_t class_count = 32;       //!< Number of small size classes.
+inline constexpr std::size_t max_small_size = 8192;  //!< Largest request served from a size class.
+inline constexpr std::size_t max_small_alignment = header_size; //!< Largest alignment served from a size class.
+} // namespace memory_pool
+
+namespace detail
+{
+/*!
+ * @brief Header at the start of every span.
+ */
+struct pool_span
+{
+    unsigned int size_class; //!< Class of the blocks in the span, or pool_large_class.
+    void *base;              //!< For large blocks, the pointer returned by the os hook.
+    std::size_t size;        //!< For large blocks, the size requested.
+};
+
+static_assert(sizeof(pool_span) <= memory_pool::header_size);
+
+inline constexpr unsigned int pool_large_class = ~0u;
+
+struct pool_free_block
+{
+    pool_free_block *next;
+};
+
+/*!
+ * @brief A test-and-set lock, the central lists are only held for a handful of pointer operations.
+ */
+struct pool_spin_lock
+{
+    bool flag = false;
+
+    void lock() noexcept
+    {
+        while (__atomic_test_and_set(&flag, __ATOMIC_ACQUIRE))
+        {
+            while (__atomic_load_n(&flag, __ATOMIC_RELAXED))
+            {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#elif defined(__aarch64__)
+                __asm__ __volatile__("yield");
+#endif
+            }
+        }
+    }
+
+    void unlock() noexcept
+    {
+        __atomic_clear(&flag, __ATOMIC_RELEASE);
+    }
+};
+
+/*!
+ * @brief The shared free list of one size class, on its own cache line.
+ */
+struct alignas(64) pool_central_list
+{
+    pool_spin_lock lock;
+    pool_free_block *head = nullptr;
+};
+
+/*!
+ * @brief Free blocks cached by one thread, one list per size class.
+ */
+struct pool_thread_cache
+{
+    pool_free_block *head[memory_pool::class_count];
+    unsigned int count[memory_pool::class_count];
+};
+
+inline pool_central_list pool_central[memory_pool::class_count];
+
+/*!
+ * @brief Maps a request size to its size class.
+ * @details Classes are 16 bytes apart up to 128 bytes, then four per power of two up to max_small_size.
+ */
+constexpr inline std::size_t pool_class_index(std::size_t size) noexcept
+{
+    if (size <= 128)
+    {
+        return size == 0 ? 0 : (size + 15) / 16 - 1;
+    }
+    std::size_t shift = 0;
+    for (std::size_t rest = (size - 1) >> 1; rest != 0; rest >>= 1)
+    {
+        ++shift;
+    }
+    return 8 + (shift - 7) * 4 + ((size - 1) >> (shift - 2)) - 4;
+}
+
+/*!
+ * @brief Returns the block size of a size class.
+ */
+constexpr inline std::size_t pool_class_size(std::size_t index) noexcept
+{
+    if (index < 8)
+    {
+        return (index + 1) * 16;
+    }
+    std::size_t shift = 7 + (index - 8) / 4;
+    return (std::size_t(1) << shift) + (((index - 8) % 4 + 1) << (shift - 2));
+}
+
+static_assert(pool_class_index(memory_pool::max_small_size) == memory_pool::class_count - 1);
+static_assert(pool_class_size(memory_pool::class_count - 1) == memory_pool::max_small_size);
+
+/*!
+ * @brief Number of blocks of a class a thread keeps before it returns half of them to the central list.
+ */
+constexpr inline unsigned int pool_cache_limit(std::size_t index) noexcept
+{
+    std::size_t limit = (16 * 1024) / pool_class_size(index);
+    return static_cast<unsigned int>(limit < 4 ? 4 : (limit > 64 ? 64 : limit));
+}
+
+/*!
+ * @brief Finds the header of the span holding ptr.
+ * @details A pointer at the very start of a span only occurs for large blocks aligned to span_size or more, whose
+ * header is placed one span below.
+ */
+inline pool_span *pool_span_of(void *ptr) noexcept
+{
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(ptr);
+    std::uintptr_t offset = address & (memory_pool::span_size - 1);
+    return reinterpret_cast<pool_span *>(offset == 0 ? address - memory_pool::span_size : address - offset);
+}
+
+inline void **pool_thread_slot() noexcept
+{
+#if defined(STD_MEMORY_POOL_THREAD_LOCAL)
+    static thread_local void *slot = nullptr;
+    return &slot;
+#else
+    return os::thread_cache_slot();
+#endif
+}
+
+/*!
+ * @brief Returns the cache of the calling thread, creating it on first use, or nullptr if the thread has no slot.
+ */
+inline pool_thread_cache *pool_cache() noexcept
+{
+    void **slot = pool_thread_slot();
+    if (slot == nullptr)
+    {
+        return nullptr;
+    }
+    if (*slot == nullptr)
+    {
+        pool_thread_cache *cache = static_cast<pool_thread_cache *>(os::operator_new(sizeof(pool_thread_cache)));
+        if (cache == nullptr)
+        {
+            return nullptr;
+        }
+        for (std::size_t i = 0; i < memory_pool::class_count; ++i)
+        {
+            cache->head[i] = nullptr;
+            cache->count[i] = 0;
+        }
+        *slot = cache;
+    }
+    return static_cast<pool_thread_cache *>(*slot);
+}
+
+/*!
+ * @brief Splices the list [first, last] onto the central list of a class.
+ */
+inline void pool_give(std::size_t index, pool_free_block *first, pool_free_block *last) noexcept
+{
+    pool_central_list &central = pool_central[index];
+    central.lock.lock();
+    last->next = central.head;
+    central.head = first;
+    central.lock.unlock();
+}
+
+/*!
+ * @brief Carves a new span into blocks of a class and returns them as a list, nullptr if the os is out of memory.
+ */
+inline pool_free_block *pool_carve_span(std::size_t index) noexcept
+{
+    void *memory = os::operator_new_aligned(memory_pool::span_size, memory_pool::span_size);
+    if (memory == nullptr)
+    {
+        return nullptr;
+    }
+    pool_span *span = static_cast<pool_span *>(memory);
+    span->size_class = static_cast<unsigned int>(index);
+    span->base = memory;
+    span->size = memory_pool::span_size;
+
+    std::size_t block_size = pool_class_size(index);
+    unsigned char *first = static_cast<unsigned char *>(memory) + memory_pool::header_size;
+    std::size_t blocks = (memory_pool::span_size - memory_pool::header_size) / block_size;
+    for (std::size_t i = 0; i + 1 < blocks; ++i)
+    {
+        reinterpret_cast<pool_free_block *>(first + i * block_size)->next =
+            reinterpret_cast<pool_free_block *>(first + (i + 1) * block_size);
+    }
+    reinterpret_cast<pool_free_block *>(first + (blocks - 1) * block_size)->next = nullptr;
+    return reinterpret_cast<pool_free_block *>(first);
+}
+
+/*!
+ * @brief Takes up to wanted blocks of a class, carving a new span when the central list is empty.
+ * @param index The size class.
+ * @param wanted Maximum number of blocks to take, at least one.
+ * @param taken Receives the number of blocks in the returned list.
+ * @return A nullptr terminated list of blocks, nullptr if out of memory.
+ */
+inline pool_free_block *pool_take(std::size_t index, unsigned int wanted, unsigned int &taken) noexcept
+{
+    pool_central_list &central = pool_central[index];
+    central.lock.lock();
+    pool_free_block *first = central.head;
+    pool_free_block *last = nullptr;
+    taken = 0;
+    for (pool_free_block *block = first; block != nullptr && taken < wanted; block = block->next)
+    {
+        last = block;
+        ++taken;
+    }
+    if (last != nullptr)
+    {
+        central.head = last->next;
+        last->next = nullptr;
+    }
+    central.lock.unlock();
+    if (taken > 0)
+    {
+        return first;
+    }
+
+    first = pool_carve_span(index);
+    if (first == nullptr)
+    {
+        return nullptr;
+    }
+    last = first;
+    taken = 1;
+    while (taken < wanted && last->next != nullptr)
+    {
+        last = last->next;
+        ++taken;
+    }
+    if (last->next != nullptr)
+    {
+        pool_free_block *rest = last->next;
+        pool_free_block *rest_last = rest;
+        while (rest_last->next != nullptr)
+        {
+            rest_last = rest_last->next;
+        }
+        last->next = nullptr;
+        pool_give(index, rest, rest_last);
+    }
+    return first;
+}
+
+/*!
+ * @brief Refills the cache of a class, or takes a single block when the thread has no cache.
+ */
+inline void *pool_allocate_slow(pool_thread_cache *cache, std::size_t index) noexcept
+{
+    unsigned int taken = 0;
+    if (cache == nullptr)
+    {
+        return pool_take(index, 1, taken);
+    }
+    pool_free_block *list = pool_take(index, pool_cache_limit(index) / 2, taken);
+    if (list == nullptr)
+    {
+        return nullptr;
+    }
+    cache->head[index] = list->next;
+    cache->count[index] = taken - 1;
+    return list;
+}
+
+/*!
+ * @brief Allocates a block with its own span header directly from the os.
+ */
+inline void *pool_allocate_large(std::size_t size, std::size_t alignment) noexcept
+{
+    std::size_t offset = alignment > memory_pool::header_size ? alignment : memory_pool::header_size;
+    std::size_t base_alignment = alignment > memory_pool::span_size ? alignment : memory_pool::span_size;
+    void *base = os::operator_new_aligned(size + offset, base_alignment);
+    if (base == nullptr)
+    {
+        return nullptr;
+    }
+    void *user = static_cast<unsigned char *>(base) + offset;
+    pool_span *span = pool_span_of(user);
+    span->size_class = pool_large_class;
+    span->base = base;
+    span->size = size;
+    return user;
+}
+
+inline void *pool_allocate_class(std::size_t index) noexcept
+{
+    pool_thread_cache *cache = pool_cache();
+    if (cache != nullptr && cache->head[index] != nullptr)
+    {
+        pool_free_block *block = cache->head[index];
+        cache->head[index] = block->next;
+        --cache->count[index];
+        return block;
+    }
+    return pool_allocate_slow(cache, index);
+}
+} // namespace detail
+
+namespace memory_pool
+{
+/*!
+ * @brief Allocates size bytes aligned to __STDCPP_DEFAULT_NEW_ALIGNMENT__.
+ * @return The block, or nullptr if the os hooks are out of memory.
+ */
+inline void *allocate(std::size_t size) noexcept
+{
+    if (size > max_small_size)
+    {
+        return detail::pool_allocate_large(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+    }
+    return detail::pool_allocate_class(detail::pool_class_index(size));
+}
+
+/*!
+ * @brief Allocates size bytes aligned to alignment, which must be a power of two.
+ * @details Alignments up to max_small_alignment are served from the first size class whose block size is a multiple
+ * of the alignment, since every block of such a class is aligned to it.
+ * @return The block, or nullptr if the os hooks are out of memory.
+ */
+inline void *allocate(std::size_t size, std::size_t alignment) noexcept
+{
+    if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    {
+        return allocate(size);
+    }
+    if (size <= max_small_size && alignment <= max_small_alignment)
+    {
+        for (std::size_t index = detail::pool_class_index(size); index < class_count; ++index)
+        {
+            if (detail::pool_class_size(index) % alignment == 0)
+            {
+                return detail::pool_allocate_class(index);
+            }
+        }
+    }
+    return detail::pool_allocate_large(size, alignment);
+}
+
+/*!
+ * @brief Releases a block obtained from allocate(). Does nothing for nullptr.
+ */
+inline void deallocate(void *ptr) noexcept
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    detail::pool_span *span = detail::pool_span_of(ptr);
+    if (span->size_class == detail::pool_large_class)
+    {
+        os::operator_delete(span->base);
+        return;
+    }
+
+    std::size_t index = span->size_class;
+    detail::pool_free_block *block = static_cast<detail::pool_free_block *>(ptr);
+    detail::pool_thread_cache *cache = detail::pool_cache();
+    if (cache == nullptr)
+    {
+        detail::pool_give(index, block, block);
+        return;
+    }
+    block->next = cache->head[index];
+    cache->head[index] = block;
+    unsigned int limit = detail::pool_cache_limit(index);
+    if (++cache->count[index] > limit)
+    {
+        // The block just freed is the warmest, keep it and hand the next half of the list back
+        detail::pool_free_block *first = block->next;
+        detail::pool_free_block *last = first;
+        for (unsigned int i = 1; i < limit / 2; ++i)
+        {
+            last = last->next;
+        }
+        block->next = last->next;
+        cache->count[index] -= limit / 2;
+        detail::pool_give(index, first, last);
+    }
+}
+
+/*!
+ * @brief Returns every block cached by the calling thread to the central lists and releases the cache.
+ * @details Call this before a thread exits. The thread may keep allocating afterwards, a new cache is created on
+ * demand.
+ */
+inline void flush_thread_cache() noexcept
+{
+    void **slot = detail::pool_thread_slot();
+    if (slot == nullptr || *slot == nullptr)
+    {
+        return;
+    }
+    detail::pool_thread_cache *cache = static_cast<detail::pool_thread_cache *>(*slot);
+    for (std::size_t index = 0; index < class_count; ++index)
+    {
+        detail::pool_free_block *first = cache->head[index];
+        if (first == nullptr)
+        {
+            continue;
+        }
+        detail::pool_free_block *last = first;
+        while (last->next != nullptr)
+        {
+            last = last->next;
+        }
+        detail::pool_give(index, first, last);
+    }
+    *slot = nullptr;
+    os::operator_delete(cache);
+}
+} // namespace memory_pool
+} // namespace std
+#endif
@@ -0,0 +1,326 @@
+/*!
+ * @file memory_resource.h
+ * @brief Polymorphic memory resources and the allocator that wraps them
+ * @namespace std::pmr
+ * @note This header is a part of the C++ standard library.
+ * Modeled after https://en.cppreference.com/w/cpp/header/memory_resource. Containers that use
+ * polymorphic_allocator can be pointed at an arena or a NUMA-local heap at run time without changing their type.
+ */
+#ifndef MEMORY_RESOURCE_H
+#define MEMORY_RESOURCE_H
+#include <memory.h>
+#include <new.h>
+#include <stddef.h>
+
+namespace std
+{
+namespace pmr
+{
+/*!
+ * @brief Alignment used when a caller does not ask for one
+ */
+inline constexpr std::size_t default_resource_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+/*!
+ * @brief Abstract interface to a source of memory
+ * @details Derived classes implement do_allocate(), do_deallocate() and do_is_equal(). Two resources compare equal
+ *          when memory allocated from one can be released through the other.
+ */
+class memory_resource
+{
+  public:
+    constexpr memory_resource() noexcept = default;
+    constexpr memory_resource(const memory_resource &) noexcept = default;
+    virtual ~memory_resource() = default;
+    memory_resource &operator=(const memory_resource &) noexcept = default;
+
+    /*!
+     * @brief Allocates at least bytes bytes aligned to alignment
+     * @param bytes Size of the allocation
+     * @param alignment Required alignment, a power of two
+     * @return Pointer to the storage
+     */
+    [[nodiscard]] void *allocate(std::size_t bytes, std::size_t alignment = default_resource_alignment)
+    {
+        return do_allocate(bytes, alignment);
+    }
+
+    /*!
+     * @brief Releases storage obtained from allocate() with the same bytes and alignment
+     */
+    void deallocate(void *ptr, std::size_t bytes, std::size_t alignment = default_resource_alignment)
+    {
+        do_deallocate(ptr, bytes, alignment);
+    }
+
+    /*!
+     * @brief Checks whether memory allocated from this resource can be released through other
+     */
+    bool is_equal(const memory_resource &other) const noexcept
+    {
+        return do_is_equal(other);
+    }
+
+  private:
+    virtual void *do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+    virtual void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) = 0;
+    virtual bool do_is_equal(const memory_resource &other) const noexcept = 0;
+};
+
+inline bool operator==(const memory_resource &lhs, const memory_resource &rhs) noexcept
+{
+    return &lhs == &rhs || lhs.is_equal(rhs);
+}
+
+namespace detail
+{
+/*!
+ * @brief The resource behind new_delete_resource(), the global operator new and therefore the os:: hooks
+ */
+class new_delete_memory_resource final : public memory_resource
+{
+  public:
+    constexpr new_delete_memory_resource() noexcept = default;
+
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            return ::operator new(bytes, std::align_val_t(alignment));
+        }
+        return ::operator new[](bytes);
+    }
+
+    void do_deallocate(void *ptr, std::size_t, std::size_t alignment) override
+    {
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        {
+            ::operator delete(ptr, std::align_val_t(alignment));
+            return;
+        }
+        ::operator delete[](ptr);
+    }
+
+    bool do_is_equal(const memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+inline constinit new_delete_memory_resource new_delete_instance;
+inline memory_resource *default_resource = &new_delete_instance;
+} // namespace detail
+
+/*!
+ * @brief Returns the resource that allocates with the global operator new
+ */
+inline memory_resource *new_delete_resource() noexcept
+{
+    return &detail::new_delete_instance;
+}
+
+/*!
+ * @brief Returns the resource used by default-constructed polymorphic allocators
+ */
+inline memory_resource *get_default_resource() noexcept
+{
+    return __atomic_load_n(&detail::default_resource, __ATOMIC_ACQUIRE);
+}
+
+/*!
+ * @brief Replaces the default resource
+ * @param resource The new default, or nullptr to restore new_delete_resource()
+ * @return The previous default resource
+ */
+inline memory_resource *set_default_resource(memory_resource *resource) noexcept
+{
+    if (resource == nullptr)
+    {
+        resource = new_delete_resource();
+    }
+    return __atomic_exchange_n(&detail::default_resource, resource, __ATOMIC_ACQ_REL);
+}
+
+/*!
+ * @brief An arena that hands out memory by bumping a pointer and releases it all at once
+ * @details Deallocation is a no-op; memory is only returned by release() or the destructor. When the current chunk
+ *          is exhausted a new one, at least twice as large as the previous, is taken from the upstream resource.
+ *          An initial buffer supplied by the caller is used first and never returned upstream.
+ * @note Not thread safe.
+ */
+class monotonic_buffer_resource final : public memory_resource
+{
+  public:
+    monotonic_buffer_resource() noexcept
+        : monotonic_buffer_resource(get_default_resource())
+    {
+    }
+
+    explicit monotonic_buffer_resource(memory_resource *upstream) noexcept
+        : _upstream{upstream}
+    {
+    }
+
+    explicit monotonic_buffer_resource(std::size_t initial_size,
+                                       memory_resource *upstream = get_default_resource()) noexcept
+        : _upstream{upstream}
+        , _next_chunk_size{initial_size < min_chunk_size ? min_chunk_size : initial_size}
+    {
+    }
+
+    monotonic_buffer_resource(void *buffer, std::size_t buffer_size,
+                              memory_resource *upstream = get_default_resource()) noexcept
+        : _upstream{upstream}
+        , _initial_buffer{static_cast<unsigned char *>(buffer)}
+        , _initial_size{buffer_size}
+        , _current{static_cast<unsigned char *>(buffer)}
+        , _remaining{buffer_size}
+        , _next_chunk_size{buffer_size < min_chunk_size ? min_chunk_size : buffer_size * 2}
+    {
+    }
+
+    monotonic_buffer_resource(const monotonic_buffer_resource &) = delete;
+    monotonic_buffer_resource &operator=(const monotonic_buffer_resource &) = delete;
+
+    ~monotonic_buffer_resource() override
+    {
+        release();
+    }
+
+    /*!
+     * @brief Returns every chunk to the upstream resource and rewinds to the initial buffer
+     */
+    void release() noexcept
+    {
+        while (_chunks != nullptr)
+        {
+            chunk_header *next = _chunks->next;
+            _upstream->deallocate(_chunks, _chunks->size, alignof(chunk_header));
+            _chunks = next;
+        }
+        _current = _initial_buffer;
+        _remaining = _initial_size;
+    }
+
+    memory_resource *upstream_resource() const noexcept
+    {
+        return _upstream;
+    }
+
+  private:
+    struct chunk_header
+    {
+        chunk_header *next;
+        std::size_t size;
+    };
+
+    static constexpr std::size_t min_chunk_size = 1024;
+
+    memory_resource *_upstream;                ///< Where new chunks come from.
+    chunk_header *_chunks = nullptr;           ///< Chunks taken from upstream, newest first.
+    unsigned char *_initial_buffer = nullptr;  ///< Caller supplied buffer, reused after release().
+    std::size_t _initial_size = 0;             ///< Size of the caller supplied buffer.
+    unsigned char *_current = nullptr;         ///< Next free byte in the current chunk.
+    std::size_t _remaining = 0;                ///< Free bytes left in the current chunk.
+    std::size_t _next_chunk_size = min_chunk_size;
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        std::size_t padding = (alignment - (reinterpret_cast<std::uintptr_t>(_current) & (alignment - 1))) &
+                              (alignment - 1);
+        if (_current == nullptr || padding + bytes > _remaining)
+        {
+            std::size_t needed = sizeof(chunk_header) + alignment + bytes;
+            std::size_t size = _next_chunk_size < needed ? needed : _next_chunk_size;
+            chunk_header *chunk = static_cast<chunk_header *>(_upstream->allocate(size, alignof(chunk_header)));
+            chunk->next = _chunks;
+            chunk->size = size;
+            _chunks = chunk;
+            _current = reinterpret_cast<unsigned char *>(chunk + 1);
+            _remaining = size - sizeof(chunk_header);
+            _next_chunk_size = size * 2;
+            padding = (alignment - (reinterpret_cast<std::uintptr_t>(_current) & (alignment - 1))) & (alignment - 1);
+        }
+        void *result = _current + padding;
+        _current += padding + bytes;
+        _remaining -= padding + bytes;
+        return result;
+    }
+
+    void do_deallocate(void *, std::size_t, std::size_t) override
+    {
+    }
+
+    bool do_is_equal(const memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+/*!
+ * @brief An allocator that forwards to a memory_resource chosen at run time
+ * @details Copies of a container do not inherit the resource; they use the default resource instead, as
+ *          select_on_container_copy_construction() specifies.
+ * @tparam T The type of the objects to allocate storage for
+ */
+template<typename T> class polymorphic_allocator
+{
+  public:
+    using value_type = T;
+
+    template<typename U> struct rebind
+    {
+        using other = polymorphic_allocator<U>;
+    };
+
+    polymorphic_allocator() noexcept
+        : _resource{get_default_resource()}
+    {
+    }
+
+    polymorphic_allocator(memory_resource *resource) noexcept
+        : _resource{resource}
+    {
+    }
+
+    polymorphic_allocator(const polymorphic_allocator &) noexcept = default;
+
+    template<typename U> polymorphic_allocator(const polymorphic_allocator<U> &other) noexcept
+        : _resource{other.resource()}
+    {
+    }
+
+    polymorphic_allocator &operator=(const polymorphic_allocator &) noexcept = default;
+
+    [[nodiscard]] T *allocate(std::size_t count)
+    {
+        return static_cast<T *>(_resource->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *ptr, std::size_t count) noexcept
+    {
+        _resource->deallocate(ptr, count * sizeof(T), alignof(T));
+    }
+
+    memory_resource *resource() const noexcept
+    {
+        return _resource;
+    }
+
+    polymorphic_allocator select_on_container_copy_construction() const noexcept
+    {
+        return polymorphic_allocator();
+    }
+
+    template<typename U> bool operator==(const polymorphic_allocator<U> &other) const noexcept
+    {
+        return *_resource == *other.resource();
+    }
+
+  private:
+    memory_resource *_resource;
+};
+} // namespace pmr
+} // namespace std
+#endif
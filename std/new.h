@@ -8,8 +8,169 @@ namespace os
     void *operator_new_aligned(std::size_t size, std::size_t alignment);
     void operator_delete(void *ptr);
     void operator_delete_array(void *ptr);
+
+#if defined(STD_HAS_OS_REALLOC)
+    /*!
+     * @brief Resizes a block from operator_new() or operator_new_array() to size bytes, like realloc
+     * @details The contents up to the smaller of the two sizes are kept, moving them if the block cannot be resized
+     * where it is; large blocks may be remapped rather than copied. The result is freed by the same operator_delete
+     * or operator_delete_array as the original block.
+     * @return The resized block, or nullptr if it could not be resized, in which case ptr is left untouched
+     */
+    void *operator_realloc(void *ptr, std::size_t size);
+
+    /*!
+     * @brief Resizes a block from operator_new() or operator_new_array() to size bytes without moving it
+     * @return true if the block now holds at least size bytes at the same address
+     */
+    bool try_expand(void *ptr, std::size_t size);
+#endif
+}
+#if defined(STD_ENABLE_MEMORY_POOL)
+#    include <memory_pool.h>
+#endif
+#if defined(STD_ENABLE_ALLOC_STATS)
+#    include <alloc_stats.h>
+#else
+//! Attributes the allocations of the enclosing scope to a tag; see alloc_stats.h. Does nothing unless enabled.
+#    define STD_ALLOC_TAG(name) static_cast<void>(0)
+
+namespace std
+{
+namespace detail
+{
+//! Containers report their growth here; only alloc_stats.h does anything with it.
+inline void alloc_note_growth(std::size_t, std::size_t, std::size_t, bool) noexcept
+{
 }
+} // namespace detail
+} // namespace std
+#endif
+
 // Global operator overloads
+#if defined(STD_ENABLE_ALLOC_STATS)
+inline void *operator new(std::size_t size)
+{
+    return std::detail::alloc_tracked_allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, std::detail::alloc_form::single);
+}
+
+inline void *operator new[](std::size_t size)
+{
+    return std::detail::alloc_tracked_allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, std::detail::alloc_form::array);
+}
+
+inline void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    return std::detail::alloc_tracked_allocate(size, static_cast<std::size_t>(alignment),
+                                               std::detail::alloc_form::aligned);
+}
+
+inline void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return std::detail::alloc_tracked_allocate(size, static_cast<std::size_t>(alignment),
+                                               std::detail::alloc_form::aligned);
+}
+
+inline void operator delete(void *ptr) noexcept
+{
+    std::detail::alloc_tracked_deallocate(ptr, std::detail::alloc_form::single);
+}
+
+inline void operator delete[](void *ptr) noexcept
+{
+    std::detail::alloc_tracked_deallocate(ptr, std::detail::alloc_form::array);
+}
+
+inline void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::detail::alloc_tracked_deallocate(ptr, std::detail::alloc_form::single);
+}
+
+inline void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::detail::alloc_tracked_deallocate(ptr, std::detail::alloc_form::array);
+}
+
+inline void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    std::detail::alloc_tracked_deallocate(ptr, std::detail::alloc_form::aligned);
+}
+
+inline void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    std::detail::alloc_tracked_deallocate(ptr, std::detail::alloc_form::aligned);
+}
+
+inline void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::detail::alloc_tracked_deallocate(ptr, std::detail::alloc_form::aligned);
+}
+
+inline void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::detail::alloc_tracked_deallocate(ptr, std::detail::alloc_form::aligned);
+}
+#elif defined(STD_ENABLE_MEMORY_POOL)
+inline void *operator new(std::size_t size)
+{
+    return std::memory_pool::allocate(size);
+}
+
+inline void *operator new[](std::size_t size)
+{
+    return std::memory_pool::allocate(size);
+}
+
+inline void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    return std::memory_pool::allocate(size, static_cast<std::size_t>(alignment));
+}
+
+inline void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return std::memory_pool::allocate(size, static_cast<std::size_t>(alignment));
+}
+
+inline void operator delete(void *ptr) noexcept
+{
+    std::memory_pool::deallocate(ptr);
+}
+
+inline void operator delete[](void *ptr) noexcept
+{
+    std::memory_pool::deallocate(ptr);
+}
+
+inline void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::memory_pool::deallocate(ptr);
+}
+
+inline void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::memory_pool::deallocate(ptr);
+}
+
+inline void operator delete(void *ptr, std::align_val_t) noexcept
+{
+    std::memory_pool::deallocate(ptr);
+}
+
+inline void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+    std::memory_pool::deallocate(ptr);
+}
+
+inline void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::memory_pool::deallocate(ptr);
+}
+
+inline void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    std::memory_pool::deallocate(ptr);
+}
+#else
 inline void *operator new(std::size_t size)
 {
     return os::operator_new(size);
@@ -27,10 +188,7 @@ inline void *operator new(std::size_t size, std::align_val_t alignment)
 
 inline void *operator new[](std::size_t size, std::align_val_t alignment)
 {
-    std::size_t align = static_cast<std::size_t>(alignment);
-    void *ptr = os::operator_new_aligned(size + sizeof(std::size_t), align);
-    *static_cast<std::size_t *>(ptr) = size;
-    return static_cast<char *>(ptr) + sizeof(std::size_t);
+    return os::operator_new_aligned(size, static_cast<std::size_t>(alignment));
 }
 
 inline void operator delete(void *ptr) noexcept
@@ -60,8 +218,19 @@ inline void operator delete(void *ptr, std::align_val_t) noexcept
 
 inline void operator delete[](void *ptr, std::align_val_t) noexcept
 {
-    os::operator_delete_array(ptr);
+    os::operator_delete(ptr);
+}
+
+inline void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    os::operator_delete(ptr);
+}
+
+inline void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept
+{
+    os::operator_delete(ptr);
 }
+#endif
 
 // Placement new operators
 inline void *operator new(std::size_t, void *ptr) noexcept
@@ -0,0 +1,58 @@
+/*!
+ * @file numeric.h
+ * @brief Numeric operations over ranges
+ * @namespace std
+ * @note This header is a part of the C++ standard library.
+ */
+#ifndef NUMERIC_H
+#define NUMERIC_H
+#include <iterator.h>
+#include <utility.h>
+
+namespace std
+{
+/*!
+ * @brief Folds [first, last) into init from left to right with op, which defaults to +
+ * @return The folded value
+ */
+template<typename InputIt, typename T, typename BinaryOp>
+constexpr T accumulate(InputIt first, InputIt last, T init, BinaryOp op)
+{
+    for (; first != last; ++first)
+    {
+        init = op(std::move(init), *first);
+    }
+    return init;
+}
+
+template<typename InputIt, typename T> constexpr T accumulate(InputIt first, InputIt last, T init)
+{
+    for (; first != last; ++first)
+    {
+        init = std::move(init) + *first;
+    }
+    return init;
+}
+
+/*!
+ * @brief Like accumulate(), but op must be associative and commutative, so the elements may be combined in any order
+ * @details The parallel overloads in execution.h rely on that; this sequential form folds from left to right.
+ */
+template<typename InputIt, typename T, typename BinaryOp>
+constexpr T reduce(InputIt first, InputIt last, T init, BinaryOp op)
+{
+    return accumulate(first, last, std::move(init), op);
+}
+
+template<typename InputIt, typename T> constexpr T reduce(InputIt first, InputIt last, T init)
+{
+    return accumulate(first, last, std::move(init));
+}
+
+template<typename InputIt>
+constexpr typename std::iterator_traits<InputIt>::value_type reduce(InputIt first, InputIt last)
+{
+    return accumulate(first, last, typename std::iterator_traits<InputIt>::value_type{});
+}
+} // namespace std
+#endif
@@ -0,0 +1,464 @@
+/*!
+ * @file search.h
+ * @brief Substring and character-set search over UTF-16 units and bytes
+ * @namespace std
+ * @details The kernels behind basic_string_view::find() and friends, picked by needle length:
+ * - one unit: a vector scan for that unit.
+ * - short needles: the vector first/last unit filter. Every position where both the first and the last unit of the
+ *   needle match is verified with memcmp, which rejects almost every false start after two compares.
+ * - long needles: Boyer-Moore-Horspool, whose skip table lets the search jump up to the needle length at a time.
+ * find_first_of() and find_last_of() test membership against a 256-bit bitmap instead of looping over the set.
+ * basic_searcher keeps the precomputed state so one needle can be applied to many haystacks.
+ */
+#ifndef SEARCH_H
+#define SEARCH_H
+#include <algorithm.h>
+#include <stddef.h>
+#include <trace.h>
+
+namespace std
+{
+template<typename T> class basic_string_view;
+
+namespace detail
+{
+inline constexpr std::size_t search_npos = static_cast<std::size_t>(-1);
+
+//! Needles longer than this use Horspool, shorter ones the first/last unit filter.
+inline constexpr std::size_t horspool_threshold = 32;
+
+/*!
+ * @brief Index into the 256-entry skip table and bitmap. UTF-16 units share entries by their low byte, which only
+ * makes skips shorter and bitmap hits a filter, never wrong.
+ */
+template<typename T> constexpr inline unsigned int search_key(T unit) noexcept
+{
+    return static_cast<unsigned int>(unit) & 0xFFu;
+}
+
+template<typename T> inline bool search_equal(const T *a, const T *b, std::size_t count) noexcept
+{
+    return count == 0 || memcmp(a, b, count * sizeof(T)) == 0;
+}
+
+#if defined(STD_SIMD_VECTOR)
+/*!
+ * @brief simd_ops seen as lanes of T
+ */
+template<typename T> struct search_lanes
+{
+    using type = simd_ops::type;
+    using mask_type = simd_ops::mask_type;
+    static constexpr std::size_t count = simd_ops::width / sizeof(T);
+    static constexpr unsigned int bits_per_unit = simd_ops::mask_bits_per_byte * sizeof(T);
+
+    static inline type load(const T *p) noexcept
+    {
+        return simd_ops::load(reinterpret_cast<const unsigned char *>(p));
+    }
+
+    static inline type splat(T unit) noexcept
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            return simd_ops::splat(static_cast<unsigned char>(unit));
+        }
+        else
+        {
+            return simd_ops::splat16(static_cast<unsigned short>(unit));
+        }
+    }
+
+    static inline mask_type eq_mask(type a, type b) noexcept
+    {
+        if constexpr (sizeof(T) == 1)
+        {
+            return simd_ops::eq_mask(a, b);
+        }
+        else
+        {
+            return simd_ops::eq_mask16(a, b);
+        }
+    }
+
+    //! Index of the lowest lane in a non-zero mask
+    static inline std::size_t first_lane(mask_type mask) noexcept
+    {
+        return count_trailing_zeros(mask) / bits_per_unit;
+    }
+
+    //! Clears the bits of the lowest lane in a non-zero mask
+    static inline mask_type clear_first_lane(mask_type mask) noexcept
+    {
+        constexpr mask_type lane_bits = static_cast<mask_type>((1ull << bits_per_unit) - 1);
+        return mask & ~(lane_bits << (first_lane(mask) * bits_per_unit));
+    }
+};
+#endif
+
+/*!
+ * @brief Finds the first unit equal to unit in [pos, size)
+ */
+template<typename T> inline std::size_t search_unit(const T *data, std::size_t size, T unit, std::size_t pos) noexcept
+{
+    std::size_t i = pos;
+#if defined(STD_SIMD_VECTOR)
+    using lanes = search_lanes<T>;
+    const typename lanes::type wanted = lanes::splat(unit);
+    for (; i + lanes::count <= size; i += lanes::count)
+    {
+        typename lanes::mask_type mask = lanes::eq_mask(lanes::load(data + i), wanted);
+        if (mask != 0)
+        {
+            return i + lanes::first_lane(mask);
+        }
+    }
+#endif
+    for (; i < size; ++i)
+    {
+        if (data[i] == unit)
+        {
+            return i;
+        }
+    }
+    return search_npos;
+}
+
+/*!
+ * @brief Finds needle, at least two units long, with the first/last unit filter
+ */
+template<typename T>
+inline std::size_t search_filtered(const T *data, std::size_t size, const T *needle, std::size_t needle_size,
+                                   std::size_t pos) noexcept
+{
+    const std::size_t last = needle_size - 1;
+    const std::size_t end = size - needle_size; // the last position a match can start at
+    std::size_t i = pos;
+#if defined(STD_SIMD_VECTOR)
+    using lanes = search_lanes<T>;
+    const typename lanes::type first_units = lanes::splat(needle[0]);
+    const typename lanes::type last_units = lanes::splat(needle[last]);
+    for (; i + lanes::count <= end + 1; i += lanes::count)
+    {
+        typename lanes::mask_type mask = lanes::eq_mask(lanes::load(data + i), first_units) &
+                                         lanes::eq_mask(lanes::load(data + i + last), last_units);
+        while (mask != 0)
+        {
+            std::size_t candidate = i + lanes::first_lane(mask);
+            if (search_equal(data + candidate + 1, needle + 1, last - 1))
+            {
+                return candidate;
+            }
+            mask = lanes::clear_first_lane(mask);
+        }
+    }
+#endif
+    for (; i <= end; ++i)
+    {
+        if (data[i] == needle[0] && data[i + last] == needle[last] && search_equal(data + i + 1, needle + 1, last - 1))
+        {
+            return i;
+        }
+    }
+    return search_npos;
+}
+
+/*!
+ * @brief Fills the Horspool skip table for a forward search
+ */
+template<typename T> inline void horspool_forward_table(const T *needle, std::size_t needle_size,
+                                                        std::size_t (&shift)[256]) noexcept
+{
+    for (std::size_t &entry : shift)
+    {
+        entry = needle_size;
+    }
+    // Later occurrences overwrite earlier ones with the smaller shift
+    for (std::size_t j = 0; j + 1 < needle_size; ++j)
+    {
+        shift[search_key(needle[j])] = needle_size - 1 - j;
+    }
+}
+
+template<typename T>
+inline std::size_t search_horspool(const T *data, std::size_t size, const T *needle, std::size_t needle_size,
+                                   std::size_t pos, const std::size_t (&shift)[256]) noexcept
+{
+    const std::size_t last = needle_size - 1;
+    const T last_unit = needle[last];
+    std::size_t i = pos;
+    while (i + needle_size <= size)
+    {
+        T tail = data[i + last];
+        if (tail == last_unit && search_equal(data + i, needle, last))
+        {
+            return i;
+        }
+        i += shift[search_key(tail)];
+    }
+    return search_npos;
+}
+
+/*!
+ * @brief Fills the Horspool skip table for a backward search, keyed on the first unit of the window
+ */
+template<typename T> inline void horspool_backward_table(const T *needle, std::size_t needle_size,
+                                                         std::size_t (&shift)[256]) noexcept
+{
+    for (std::size_t &entry : shift)
+    {
+        entry = needle_size;
+    }
+    for (std::size_t j = needle_size - 1; j > 0; --j)
+    {
+        shift[search_key(needle[j])] = j;
+    }
+}
+
+template<typename T>
+inline std::size_t search_horspool_backward(const T *data, const T *needle, std::size_t needle_size,
+                                            std::size_t start, const std::size_t (&shift)[256]) noexcept
+{
+    const T first_unit = needle[0];
+    std::size_t i = start;
+    for (;;)
+    {
+        T head = data[i];
+        if (head == first_unit && search_equal(data + i + 1, needle + 1, needle_size - 1))
+        {
+            return i;
+        }
+        std::size_t step = shift[search_key(head)];
+        if (i < step)
+        {
+            return search_npos;
+        }
+        i -= step;
+    }
+}
+
+/*!
+ * @brief Finds the first occurrence of needle at or after pos
+ */
+template<typename T>
+inline std::size_t search_forward(const T *data, std::size_t size, const T *needle, std::size_t needle_size,
+                                  std::size_t pos) noexcept
+{
+    STD_TRACE_SCOPE_VALUE("find", size);
+    if (needle_size == 0)
+    {
+        return pos <= size ? pos : search_npos;
+    }
+    if (needle_size > size || pos > size - needle_size)
+    {
+        return search_npos;
+    }
+    if (needle_size == 1)
+    {
+        return search_unit(data, size, needle[0], pos);
+    }
+    if (needle_size <= horspool_threshold)
+    {
+        return search_filtered(data, size, needle, needle_size, pos);
+    }
+    std::size_t shift[256];
+    horspool_forward_table(needle, needle_size, shift);
+    return search_horspool(data, size, needle, needle_size, pos, shift);
+}
+
+/*!
+ * @brief Finds the last occurrence of needle that starts at or before pos
+ */
+template<typename T>
+inline std::size_t search_backward(const T *data, std::size_t size, const T *needle, std::size_t needle_size,
+                                   std::size_t pos) noexcept
+{
+    if (needle_size > size)
+    {
+        return search_npos;
+    }
+    std::size_t start = min(pos, size - needle_size);
+    if (needle_size == 0)
+    {
+        return start;
+    }
+    if (needle_size <= horspool_threshold)
+    {
+        const std::size_t last = needle_size - 1;
+        for (std::size_t i = start + 1; i-- > 0;)
+        {
+            if (data[i] == needle[0] && data[i + last] == needle[last] && search_equal(data + i, needle, last))
+            {
+                return i;
+            }
+        }
+        return search_npos;
+    }
+    std::size_t shift[256];
+    horspool_backward_table(needle, needle_size, shift);
+    return search_horspool_backward(data, needle, needle_size, start, shift);
+}
+
+/*!
+ * @brief A set of units with constant time membership
+ * @details Bytes are tested exactly against the bitmap. UTF-16 units are too, as long as every unit of the set is
+ * below 256; otherwise the bitmap filters by low byte and a hit is confirmed by scanning the set.
+ */
+template<typename T> class unit_set
+{
+  public:
+    unit_set(const T *units, std::size_t count) noexcept
+        : _units(units)
+        , _count(count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            unsigned int key = search_key(units[i]);
+            _bits[key / 64] |= 1ull << (key % 64);
+            _exact = _exact && unit_value(units[i]) < 256;
+        }
+    }
+
+    bool contains(T unit) const noexcept
+    {
+        unsigned int key = search_key(unit);
+        if ((_bits[key / 64] & (1ull << (key % 64))) == 0)
+        {
+            return false;
+        }
+        if (_exact)
+        {
+            return unit_value(unit) < 256;
+        }
+        for (std::size_t i = 0; i < _count; ++i)
+        {
+            if (_units[i] == unit)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+  private:
+    static constexpr unsigned int unit_value(T unit) noexcept
+    {
+        return sizeof(T) == 1 ? static_cast<unsigned char>(unit) : static_cast<unsigned short>(unit);
+    }
+
+    const T *_units;
+    std::size_t _count;
+    unsigned long long _bits[4] = {};
+    bool _exact = true;
+};
+
+template<typename T>
+inline std::size_t search_first_of(const T *data, std::size_t size, const T *set, std::size_t set_size,
+                                   std::size_t pos) noexcept
+{
+    if (set_size == 1)
+    {
+        return search_unit(data, size, set[0], pos);
+    }
+    unit_set<T> members(set, set_size);
+    for (std::size_t i = pos; i < size; ++i)
+    {
+        if (members.contains(data[i]))
+        {
+            return i;
+        }
+    }
+    return search_npos;
+}
+
+template<typename T>
+inline std::size_t search_last_of(const T *data, std::size_t size, const T *set, std::size_t set_size,
+                                  std::size_t pos) noexcept
+{
+    if (size == 0 || set_size == 0)
+    {
+        return search_npos;
+    }
+    unit_set<T> members(set, set_size);
+    for (std::size_t i = min(pos, size - 1) + 1; i-- > 0;)
+    {
+        if (members.contains(data[i]))
+        {
+            return i;
+        }
+    }
+    return search_npos;
+}
+} // namespace detail
+
+/*!
+ * @brief A needle prepared once and searched for in any number of haystacks
+ * @details The needle is not copied and must outlive the searcher. Long needles keep their Horspool skip table, so
+ * each search starts scanning straight away.
+ * @tparam T The code unit type, short for UTF-16 and char for UTF-8
+ */
+template<typename T> class basic_searcher
+{
+  public:
+    using size_type = std::size_t;
+    static constexpr size_type npos = detail::search_npos;
+
+    basic_searcher(const T *needle, size_type needle_size) noexcept
+        : _needle(needle)
+        , _size(needle_size)
+    {
+        if (_size > detail::horspool_threshold)
+        {
+            detail::horspool_forward_table(_needle, _size, _shift);
+        }
+    }
+
+    basic_searcher(basic_string_view<T> needle) noexcept
+        : basic_searcher(needle.data(), needle.size())
+    {
+    }
+
+    /*!
+     * @brief Finds the first occurrence of the needle in haystack at or after pos
+     * @return The index of the match or npos
+     */
+    size_type find(basic_string_view<T> haystack, size_type pos = 0) const noexcept
+    {
+        const T *data = haystack.data();
+        size_type size = haystack.size();
+        if (_size <= detail::horspool_threshold)
+        {
+            return detail::search_forward(data, size, _needle, _size, pos);
+        }
+        if (_size > size || pos > size - _size)
+        {
+            return npos;
+        }
+        return detail::search_horspool(data, size, _needle, _size, pos, _shift);
+    }
+
+    size_type size() const noexcept
+    {
+        return _size;
+    }
+
+  private:
+    const T *_needle;
+    size_type _size;
+    size_type _shift[256] = {};
+};
+
+/*!
+ * @brief A searcher for UTF-16 needles in std::string and std::string_view
+ */
+using searcher = basic_searcher<short>;
+
+/*!
+ * @brief A searcher for UTF-8 needles in raw bytes
+ */
+using u8searcher = basic_searcher<char>;
+} // namespace std
+
+// basic_searcher takes its arguments as views; string_view.h includes this header for its own kernels
+#include <string_view.h>
+#endif
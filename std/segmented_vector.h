@@ -0,0 +1,626 @@
+/**
+ * @file segmented_vector.h
+ * @brief A vector stored in fixed-size chunks, which never moves its elements.
+ * @note This header is a part of the C++ standard library.
+ * segmented_vector<T> keeps its elements in chunks of ChunkSize elements each, found through an index of chunk
+ * pointers. Appending allocates a new chunk when the last one is full and never copies or relocates an element, so
+ * push_back costs the same at ten million elements as at ten, and references, pointers and iterators to elements
+ * stay valid until the element is removed: iterators find the index through the container, so they outlive the
+ * index growing. Only the index, one pointer per chunk, grows like a vector. Moving or swapping the container
+ * invalidates its iterators.
+ *
+ * Elements are contiguous within a chunk only. for_each_chunk() hands the elements to a callback one contiguous
+ * run at a time, which is how loops that want plain pointers, such as ones the compiler should vectorize, walk the
+ * container; the random access iterators work with the algorithms in algorithm.h.
+ *
+ * deque.h builds a double-ended queue from the same chunks and iterator.
+ */
+
+#ifndef SEGMENTED_VECTOR_H
+#define SEGMENTED_VECTOR_H
+
+#include <bounds_check.h>
+#include <iterator.h>
+#include <memory.h>
+#include <stddef.h>
+#include <stdexcept.h>
+#include <type_traits.h>
+#include <vector.h>
+
+namespace std
+{
+namespace detail
+{
+/**
+ * @brief The default number of elements in a chunk: a power of two filling about 4 KiB, and at least 16.
+ */
+template<typename T> constexpr std::size_t default_chunk_size() noexcept
+{
+    std::size_t count = 16;
+    while (count * 2 * sizeof(T) <= 4096)
+    {
+        count *= 2;
+    }
+    return count;
+}
+
+/**
+ * @brief Calls fn(data, count) for each contiguous run of the count elements from position onwards.
+ *
+ * @param chunks The chunk pointers, the element at position p being chunks[p / ChunkSize][p % ChunkSize].
+ */
+template<std::size_t ChunkSize, typename T, typename Fn>
+void for_each_segment(T *const *chunks, std::size_t position, std::size_t count, Fn &&fn)
+{
+    while (count != 0)
+    {
+        std::size_t offset = position % ChunkSize;
+        std::size_t run = ChunkSize - offset < count ? ChunkSize - offset : count;
+        fn(chunks[position / ChunkSize] + offset, run);
+        position += run;
+        count -= run;
+    }
+}
+
+/**
+ * @brief Random access iterator over elements stored in chunks of ChunkSize.
+ *
+ * Holds the chunk index and a position in it; the chunk of an element is found with a shift and its place in the
+ * chunk with a mask.
+ *
+ * @tparam T The element type.
+ * @tparam Value T, or const T for the constant iterator.
+ * @tparam Index What the iterator points to to find the chunks: T * for an array of chunk pointers, which is only
+ * valid while that array does not move, or a container of them with data(), followed on every access so the
+ * iterator survives the container reallocating it.
+ */
+template<typename T, typename Value, std::size_t ChunkSize, typename Index = T *> class segmented_iterator
+{
+  public:
+    using difference_type = std::ptrdiff_t;
+    using value_type = T;
+    using pointer = Value *;
+    using reference = Value &;
+    using iterator_category = random_access_iterator_tag;
+
+    constexpr segmented_iterator() noexcept = default;
+
+    constexpr segmented_iterator(const Index *index, std::size_t position) noexcept
+        : _index(index)
+        , _position(position)
+    {
+    }
+
+    constexpr segmented_iterator(const segmented_iterator &) noexcept = default;
+    constexpr segmented_iterator &operator=(const segmented_iterator &) noexcept = default;
+
+    //! An iterator converts to a constant iterator.
+    constexpr segmented_iterator(const segmented_iterator<T, T, ChunkSize, Index> &other) noexcept
+        requires(!is_same_v<Value, T>)
+        : _index(other.index())
+        , _position(other.position())
+    {
+    }
+
+    reference operator*() const noexcept
+    {
+        return chunk(_position / ChunkSize)[_position % ChunkSize];
+    }
+
+    pointer operator->() const noexcept
+    {
+        return &**this;
+    }
+
+    reference operator[](difference_type n) const noexcept
+    {
+        return *(*this + n);
+    }
+
+    segmented_iterator &operator++() noexcept
+    {
+        ++_position;
+        return *this;
+    }
+
+    segmented_iterator operator++(int) noexcept
+    {
+        segmented_iterator old = *this;
+        ++_position;
+        return old;
+    }
+
+    segmented_iterator &operator--() noexcept
+    {
+        --_position;
+        return *this;
+    }
+
+    segmented_iterator operator--(int) noexcept
+    {
+        segmented_iterator old = *this;
+        --_position;
+        return old;
+    }
+
+    segmented_iterator &operator+=(difference_type n) noexcept
+    {
+        _position += static_cast<std::size_t>(n);
+        return *this;
+    }
+
+    segmented_iterator &operator-=(difference_type n) noexcept
+    {
+        _position -= static_cast<std::size_t>(n);
+        return *this;
+    }
+
+    friend segmented_iterator operator+(segmented_iterator it, difference_type n) noexcept
+    {
+        return it += n;
+    }
+
+    friend segmented_iterator operator+(difference_type n, segmented_iterator it) noexcept
+    {
+        return it += n;
+    }
+
+    friend segmented_iterator operator-(segmented_iterator it, difference_type n) noexcept
+    {
+        return it -= n;
+    }
+
+    friend difference_type operator-(const segmented_iterator &a, const segmented_iterator &b) noexcept
+    {
+        return static_cast<difference_type>(a._position - b._position);
+    }
+
+    friend bool operator==(const segmented_iterator &a, const segmented_iterator &b) noexcept
+    {
+        return a._position == b._position;
+    }
+
+    friend bool operator<(const segmented_iterator &a, const segmented_iterator &b) noexcept
+    {
+        return a._position < b._position;
+    }
+
+    friend bool operator>(const segmented_iterator &a, const segmented_iterator &b) noexcept
+    {
+        return b < a;
+    }
+
+    friend bool operator<=(const segmented_iterator &a, const segmented_iterator &b) noexcept
+    {
+        return !(b < a);
+    }
+
+    friend bool operator>=(const segmented_iterator &a, const segmented_iterator &b) noexcept
+    {
+        return !(a < b);
+    }
+
+    constexpr const Index *index() const noexcept
+    {
+        return _index;
+    }
+
+    constexpr std::size_t position() const noexcept
+    {
+        return _position;
+    }
+
+  private:
+    const Index *_index = nullptr;
+    std::size_t _position = 0;
+
+    T *chunk(std::size_t number) const noexcept
+    {
+        if constexpr (is_pointer_v<Index>)
+        {
+            return _index[number];
+        }
+        else
+        {
+            return _index->data()[number];
+        }
+    }
+};
+} // namespace detail
+
+/**
+ * @brief A sequence that grows at the end one chunk at a time, keeping every element where it was constructed.
+ *
+ * @tparam T Type of elements stored in the vector. Must not be void.
+ * @tparam ChunkSize Number of elements in a chunk, a power of two.
+ * @tparam Allocator Allocator used for the chunks; the chunk index uses it rebound to T *.
+ */
+template<typename T, size_t ChunkSize = detail::default_chunk_size<T>(), typename Allocator = std::allocator<T>>
+class segmented_vector final
+{
+    static_assert(!std::is_void<T>::value, "segmented_vector cannot be instantiated with void type");
+    static_assert(ChunkSize != 0 && (ChunkSize & (ChunkSize - 1)) == 0, "the chunk size must be a power of two");
+
+    using index_allocator = typename allocator_traits<Allocator>::template rebind_alloc<T *>;
+
+  public:
+    /// Element type.
+    using value_type = T;
+    /// Allocator type.
+    using allocator_type = Allocator;
+    /// Unsigned integral type.
+    using size_type = size_t;
+    /// Reference to an element.
+    using reference = T &;
+    /// Const reference to an element.
+    using const_reference = const T &;
+    /// Random access iterator.
+    using iterator = detail::segmented_iterator<T, T, ChunkSize, vector<T *, index_allocator>>;
+    /// Constant random access iterator.
+    using const_iterator = detail::segmented_iterator<T, const T, ChunkSize, vector<T *, index_allocator>>;
+
+    /// Number of elements in a chunk.
+    static constexpr size_type chunk_size = ChunkSize;
+
+    segmented_vector() = default;
+
+    /**
+     * @brief Constructs an empty vector whose chunks and index come from alloc.
+     */
+    explicit segmented_vector(const Allocator &alloc)
+        : _chunks(index_allocator(alloc))
+        , _alloc(alloc)
+    {
+    }
+
+    /**
+     * @brief Constructs a vector with count copies of value.
+     */
+    explicit segmented_vector(size_type count, const T &value = T(), const Allocator &alloc = Allocator())
+        : segmented_vector(alloc)
+    {
+        resize(count, value);
+    }
+
+    segmented_vector(std::initializer_list<T> list, const Allocator &alloc = Allocator())
+        : segmented_vector(alloc)
+    {
+        reserve(list.size());
+        for (const T &value : list)
+        {
+            emplace_back(value);
+        }
+    }
+
+    /**
+     * @brief Copy constructor; the allocator is chosen by allocator_traits::select_on_container_copy_construction().
+     */
+    segmented_vector(const segmented_vector &other)
+        : segmented_vector(allocator_traits<Allocator>::select_on_container_copy_construction(other._alloc))
+    {
+        reserve(other._size);
+        other.for_each_chunk([this](const T *data, size_type count) {
+            for (size_type i = 0; i < count; ++i)
+            {
+                emplace_back(data[i]);
+            }
+        });
+    }
+
+    /**
+     * @brief Move constructor. Takes over the chunks, so references into other now refer into this vector.
+     */
+    segmented_vector(segmented_vector &&other) noexcept
+        : _chunks(std::move(other._chunks))
+        , _size(other._size)
+        , _alloc(other._alloc)
+    {
+        other._size = 0;
+    }
+
+    segmented_vector &operator=(const segmented_vector &other)
+    {
+        if (this != &other)
+        {
+            clear();
+            reserve(other._size);
+            other.for_each_chunk([this](const T *data, size_type count) {
+                for (size_type i = 0; i < count; ++i)
+                {
+                    emplace_back(data[i]);
+                }
+            });
+        }
+        return *this;
+    }
+
+    segmented_vector &operator=(segmented_vector &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            _chunks = std::move(other._chunks);
+            _size = other._size;
+            _alloc = other._alloc;
+            other._size = 0;
+        }
+        return *this;
+    }
+
+    ~segmented_vector()
+    {
+        release();
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return _alloc;
+    }
+
+    // Capacity functions
+
+    constexpr size_type size() const noexcept
+    {
+        return _size;
+    }
+
+    constexpr bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    constexpr size_type max_size() const noexcept
+    {
+        return size_type(-1);
+    }
+
+    /**
+     * @brief Returns the number of elements the allocated chunks have room for.
+     */
+    size_type capacity() const noexcept
+    {
+        return _chunks.size() * ChunkSize;
+    }
+
+    /**
+     * @brief Returns the number of allocated chunks.
+     */
+    size_type chunk_count() const noexcept
+    {
+        return _chunks.size();
+    }
+
+    /**
+     * @brief Allocates chunks until new_cap elements fit. Existing elements stay where they are.
+     */
+    void reserve(size_type new_cap)
+    {
+        size_type chunks = (new_cap + ChunkSize - 1) / ChunkSize;
+        _chunks.reserve(chunks);
+        while (_chunks.size() < chunks)
+        {
+            _chunks.push_back(allocator_traits<Allocator>::allocate(_alloc, ChunkSize));
+        }
+    }
+
+    /**
+     * @brief Frees the chunks past the one holding the last element.
+     */
+    void shrink_to_fit()
+    {
+        size_type used = (_size + ChunkSize - 1) / ChunkSize;
+        while (_chunks.size() > used)
+        {
+            allocator_traits<Allocator>::deallocate(_alloc, _chunks.back(), ChunkSize);
+            _chunks.pop_back();
+        }
+        _chunks.shrink_to_fit();
+    }
+
+    // Element access
+
+    /**
+     * @brief Provides unchecked access to the element at specified position.
+     */
+    reference operator[](size_type pos) noexcept
+    {
+        return _chunks[pos / ChunkSize][pos % ChunkSize];
+    }
+
+    const_reference operator[](size_type pos) const noexcept
+    {
+        return _chunks[pos / ChunkSize][pos % ChunkSize];
+    }
+
+    /**
+     * @brief Provides access to the element at specified position with bounds checking.
+     *
+     * @throws std::out_of_range if pos is not within the range of the vector, unless STD_BOUNDS_CHECK says
+     * otherwise.
+     */
+    reference at(size_type pos) noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(pos < _size);
+        return (*this)[pos];
+    }
+
+    const_reference at(size_type pos) const noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(pos < _size);
+        return (*this)[pos];
+    }
+
+    /**
+     * @brief Returns a reference to the first element. On an empty vector this fails as STD_BOUNDS_CHECK says.
+     */
+    reference front() noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(_size != 0);
+        return (*this)[0];
+    }
+
+    const_reference front() const noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(_size != 0);
+        return (*this)[0];
+    }
+
+    /**
+     * @brief Returns a reference to the last element. On an empty vector this fails as STD_BOUNDS_CHECK says.
+     */
+    reference back() noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(_size != 0);
+        return (*this)[_size - 1];
+    }
+
+    const_reference back() const noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(_size != 0);
+        return (*this)[_size - 1];
+    }
+
+    // Iterators
+
+    iterator begin() noexcept
+    {
+        return iterator(&_chunks, 0);
+    }
+
+    const_iterator begin() const noexcept
+    {
+        return const_iterator(&_chunks, 0);
+    }
+
+    iterator end() noexcept
+    {
+        return iterator(&_chunks, _size);
+    }
+
+    const_iterator end() const noexcept
+    {
+        return const_iterator(&_chunks, _size);
+    }
+
+    const_iterator cbegin() const noexcept
+    {
+        return begin();
+    }
+
+    const_iterator cend() const noexcept
+    {
+        return end();
+    }
+
+    /**
+     * @brief Calls fn(T *data, size_type count) for each chunk's contiguous run of elements, in order.
+     */
+    template<typename Fn> void for_each_chunk(Fn &&fn)
+    {
+        detail::for_each_segment<ChunkSize>(_chunks.data(), 0, _size, fn);
+    }
+
+    /**
+     * @brief Calls fn(const T *data, size_type count) for each chunk's contiguous run of elements, in order.
+     */
+    template<typename Fn> void for_each_chunk(Fn &&fn) const
+    {
+        detail::for_each_segment<ChunkSize>(const_cast<const T *const *>(_chunks.data()), 0, _size, fn);
+    }
+
+    // Modifiers
+
+    /**
+     * @brief Constructs an element at the end, in a new chunk if the last one is full.
+     *
+     * No element is moved, so references to them, and to the arguments, remain valid.
+     *
+     * @return Reference to the new element.
+     */
+    template<typename... Args> reference emplace_back(Args &&...args)
+    {
+        if (_size == _chunks.size() * ChunkSize)
+        {
+            _chunks.push_back(allocator_traits<Allocator>::allocate(_alloc, ChunkSize));
+        }
+        T *slot = _chunks[_size / ChunkSize] + _size % ChunkSize;
+        std::construct_at(slot, std::forward<Args>(args)...);
+        ++_size;
+        return *slot;
+    }
+
+    void push_back(const T &value)
+    {
+        emplace_back(value);
+    }
+
+    void push_back(T &&value)
+    {
+        emplace_back(std::move(value));
+    }
+
+    /**
+     * @brief Removes the last element. Its chunk is kept for the next append.
+     */
+    void pop_back()
+    {
+        if (_size > 0)
+        {
+            --_size;
+            std::destroy_at(&(*this)[_size]);
+        }
+    }
+
+    /**
+     * @brief Resizes the vector to contain count elements, appending copies of value if it grows.
+     */
+    void resize(size_type count, const T &value = T())
+    {
+        if (count > _size)
+        {
+            reserve(count);
+            while (_size < count)
+            {
+                emplace_back(value);
+            }
+            return;
+        }
+        while (_size > count)
+        {
+            pop_back();
+        }
+    }
+
+    /**
+     * @brief Destroys all elements. The chunks are kept; shrink_to_fit() frees them.
+     */
+    void clear() noexcept
+    {
+        for_each_chunk([](T *data, size_type count) { std::destroy(data, data + count); });
+        _size = 0;
+    }
+
+    void swap(segmented_vector &other) noexcept
+    {
+        _chunks.swap(other._chunks);
+        std::swap(_size, other._size);
+        std::swap(_alloc, other._alloc);
+    }
+
+  private:
+    vector<T *, index_allocator> _chunks;     ///< The chunk index, each chunk holding ChunkSize elements.
+    size_type _size = 0;                      ///< The number of elements, filling the chunks from the first.
+    STD_NO_UNIQUE_ADDRESS Allocator _alloc{}; ///< Allocates the chunks.
+
+    void release() noexcept
+    {
+        clear();
+        for (T *chunk : _chunks)
+        {
+            allocator_traits<Allocator>::deallocate(_alloc, chunk, ChunkSize);
+        }
+        _chunks.clear();
+    }
+};
+} // namespace std
+#endif
@@ -0,0 +1,417 @@
+/**
+ * @file small_vector.h
+ * @brief A vector that keeps its first elements inside the object.
+ * @note This header is a part of the C++ standard library.
+ * small_vector<T, N> stores up to N elements in a buffer inside the object and only moves them to the heap when it
+ * grows past that, so short sequences never allocate. It is built on the same detail::vector_base as std::vector,
+ * see vector.h, so it has the same member functions and grows, relocates, inserts and erases with the same code,
+ * including the allocator and growth policy parameters.
+ *
+ * Everything except the inline buffer lives in small_vector_base<T>, which does not depend on N. Functions that take
+ * a small_vector_base<T> & work with a small_vector of any inline capacity and are only instantiated once per T,
+ * in the spirit of llvm::SmallVectorImpl.
+ */
+
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include <growth_policy.h>
+#include <initializer_list.h>
+#include <memory.h>
+#include <stddef.h>
+#include <type_traits.h>
+#include <vector.h>
+
+namespace std
+{
+
+/**
+ * @brief The part of small_vector<T, N> that does not depend on N.
+ *
+ * Objects of this type only exist as the base of a small_vector, which places its inline buffer right behind it;
+ * the base finds the buffer from its own address. Heap storage comes from the allocator.
+ *
+ * @tparam T Type of elements stored in the vector. Must not be void.
+ * @tparam Allocator Allocator used for the heap storage.
+ * @tparam Growth Policy for the capacity to grow to, see growth_policy.h.
+ */
+template<typename T, typename Allocator = std::allocator<T>, typename Growth = std::default_growth>
+class small_vector_base : public detail::vector_base<T, Allocator, Growth, small_vector_base<T, Allocator, Growth>>
+{
+    using base = detail::vector_base<T, Allocator, Growth, small_vector_base<T, Allocator, Growth>>;
+    friend base;
+
+  public:
+    using typename base::size_type;
+
+    small_vector_base(const small_vector_base &) = delete;
+
+    /**
+     * @brief Copy assignment operator.
+     *
+     * Replaces the contents with a copy of the contents of another vector, which may have a different inline
+     * capacity. This vector keeps its allocator.
+     *
+     * @param other The vector to copy from.
+     * @return Reference to this vector.
+     */
+    small_vector_base &operator=(const small_vector_base &other)
+    {
+        if (this != &other)
+        {
+            this->assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Move assignment operator.
+     *
+     * Takes over the heap storage of other when both allocators compare equal, and otherwise relocates its elements,
+     * which allocates when they do not fit this vector's storage. The other vector is left empty, using its inline
+     * buffer.
+     *
+     * @param other The vector to move from.
+     * @return Reference to this vector.
+     */
+    small_vector_base &operator=(small_vector_base &&other)
+    {
+        if (this != &other)
+        {
+            std::destroy(_data, _data + _size);
+            _size = 0;
+            if (!other.is_small() && _alloc == other._alloc)
+            {
+                this->release_block();
+                _data = other._data;
+                _size = other._size;
+                _capacity = other._capacity;
+                other.reset_storage();
+                other._size = 0;
+                return *this;
+            }
+            if (other._size > _capacity)
+            {
+                this->reallocate(other._size);
+            }
+            std::uninitialized_relocate(other._data, other._data + other._size, _data);
+            _size = other._size;
+            other._size = 0;
+            other.clear();
+        }
+        return *this;
+    }
+
+    small_vector_base &operator=(std::initializer_list<T> list)
+    {
+        this->assign(list);
+        return *this;
+    }
+
+    /**
+     * @brief Returns the number of elements the inline buffer holds.
+     */
+    constexpr size_type inline_capacity() const noexcept
+    {
+        return _inline_capacity;
+    }
+
+    /**
+     * @brief Checks whether the elements are stored in the inline buffer.
+     */
+    bool is_small() const noexcept
+    {
+        return _data == inline_data();
+    }
+
+    /**
+     * @brief Shrinks the capacity to fit the current size.
+     *
+     * Heap storage is released; the elements move back into the inline buffer when they fit, otherwise into a heap
+     * block of exactly size() elements.
+     */
+    void shrink_to_fit()
+    {
+        if (is_small() || _capacity == _size)
+        {
+            return;
+        }
+        if (_size <= _inline_capacity)
+        {
+            T *heap = _data;
+            size_type heap_capacity = _capacity;
+            reset_storage();
+            std::uninitialized_relocate(heap, heap + _size, _data);
+            this->deallocate(heap, heap_capacity);
+            return;
+        }
+        this->reallocate(_size);
+    }
+
+    /**
+     * @brief Swaps the contents and the allocators with another vector.
+     *
+     * Two heap vectors exchange their storage, and a heap block passes to the inline side when only one has one.
+     * Two inline vectors grow to hold each other's elements, which are then swapped element by element.
+     */
+    void swap(small_vector_base &other)
+    {
+        if (this == &other)
+        {
+            return;
+        }
+        // Exchanged first, so that every block below is allocated by the vector that ends up owning it
+        std::swap(_alloc, other._alloc);
+        if (!is_small() && !other.is_small())
+        {
+            std::swap(_data, other._data);
+            std::swap(_size, other._size);
+            std::swap(_capacity, other._capacity);
+            return;
+        }
+        if (!other.is_small())
+        {
+            take_heap(other);
+            return;
+        }
+        if (!is_small())
+        {
+            other.take_heap(*this);
+            return;
+        }
+        this->ensure_capacity(other._size);
+        other.ensure_capacity(_size);
+        size_type common = min(_size, other._size);
+        for (size_type i = 0; i < common; ++i)
+        {
+            std::swap(_data[i], other._data[i]);
+        }
+        if (_size > common)
+        {
+            std::uninitialized_relocate(_data + common, _data + _size, other._data + common);
+        }
+        else
+        {
+            std::uninitialized_relocate(other._data + common, other._data + other._size, _data + common);
+        }
+        std::swap(_size, other._size);
+    }
+
+  protected:
+    /**
+     * @brief Starts out empty on the inline buffer of inline_capacity elements that follows this object.
+     */
+    small_vector_base(size_type inline_capacity, const Allocator &alloc) noexcept
+        : base(alloc)
+        , _inline_capacity{inline_capacity}
+    {
+        reset_storage();
+    }
+
+    /**
+     * @brief Destroys the elements and releases heap storage.
+     *
+     * Not virtual and protected: a small_vector is never destroyed through its base.
+     */
+    ~small_vector_base()
+    {
+        std::destroy(_data, _data + _size);
+        this->release_block();
+    }
+
+  private:
+    using base::_alloc;
+    using base::_capacity;
+    using base::_data;
+    using base::_size;
+
+    size_type _inline_capacity; ///< Number of elements the inline buffer has room for.
+
+    /**
+     * @brief Returns the inline buffer, which small_vector places at the first suitably aligned offset behind the
+     * base.
+     */
+    T *inline_data() const noexcept
+    {
+        constexpr size_type offset = (sizeof(small_vector_base) + alignof(T) - 1) / alignof(T) * alignof(T);
+        return reinterpret_cast<T *>(const_cast<unsigned char *>(reinterpret_cast<const unsigned char *>(this)) +
+                                     offset);
+    }
+
+    //! Whether the elements are in a heap block from the allocator rather than the inline buffer.
+    bool has_block() const noexcept
+    {
+        return !is_small();
+    }
+
+    void reset_storage() noexcept
+    {
+        _data = inline_data();
+        _capacity = _inline_capacity;
+    }
+
+    /**
+     * @brief The swap of this inline vector with the heap vector heap: this takes the heap block, and heap takes the
+     * elements, back on its inline buffer when they fit.
+     */
+    void take_heap(small_vector_base &heap)
+    {
+        T *block = heap._data;
+        size_type block_size = heap._size;
+        size_type block_capacity = heap._capacity;
+        if (_size <= heap._inline_capacity)
+        {
+            heap.reset_storage();
+        }
+        else
+        {
+            heap._data = heap.allocate(_size);
+            heap._capacity = _size;
+        }
+        std::uninitialized_relocate(_data, _data + _size, heap._data);
+        heap._size = _size;
+        _data = block;
+        _size = block_size;
+        _capacity = block_capacity;
+    }
+};
+
+/**
+ * @brief A vector with room for N elements inside the object.
+ *
+ * Converts to small_vector_base<T, Allocator, Growth> &, which is how functions should take it when they do not
+ * care about N.
+ *
+ * @tparam T Type of elements stored in the vector. Must not be void.
+ * @tparam N Number of elements stored inline, at least 1.
+ * @tparam Allocator Allocator used for the heap storage.
+ * @tparam Growth Policy for the capacity to grow to, see growth_policy.h.
+ */
+template<typename T, size_t N, typename Allocator = std::allocator<T>, typename Growth = std::default_growth>
+class small_vector final : public small_vector_base<T, Allocator, Growth>
+{
+    static_assert(N > 0, "small_vector needs room for at least one inline element");
+    using base = small_vector_base<T, Allocator, Growth>;
+
+  public:
+    using typename base::size_type;
+
+    /**
+     * @brief Constructs an empty vector on the inline buffer.
+     */
+    small_vector() noexcept
+        : base(N, Allocator())
+    {
+    }
+
+    /**
+     * @brief Constructs an empty vector on the inline buffer that allocates from alloc once it outgrows it.
+     */
+    explicit small_vector(const Allocator &alloc) noexcept
+        : base(N, alloc)
+    {
+    }
+
+    /**
+     * @brief Constructs a vector with count copies of value.
+     */
+    explicit small_vector(size_type count, const T &value = T(), const Allocator &alloc = Allocator())
+        : base(N, alloc)
+    {
+        this->assign(count, value);
+    }
+
+    small_vector(std::initializer_list<T> list, const Allocator &alloc = Allocator())
+        : base(N, alloc)
+    {
+        this->assign(list);
+    }
+
+    small_vector(const small_vector &other)
+        : small_vector(static_cast<const base &>(other))
+    {
+    }
+
+    /**
+     * @brief Copies a small_vector of any inline capacity. The allocator is chosen by
+     * allocator_traits::select_on_container_copy_construction().
+     */
+    explicit small_vector(const base &other)
+        : base(N, std::allocator_traits<Allocator>::select_on_container_copy_construction(other.get_allocator()))
+    {
+        this->assign(other.begin(), other.end());
+    }
+
+    /**
+     * @brief Takes over the heap storage of other, or relocates its elements into the inline buffer, where an
+     * inline vector of the same N always fits; so this never allocates.
+     */
+    small_vector(small_vector &&other) noexcept
+        : base(N, other.get_allocator())
+    {
+        base::operator=(std::move(other));
+    }
+
+    /**
+     * @brief Moves from a small_vector of any inline capacity, taking over its heap storage if it has any.
+     *
+     * Inline elements that do not fit in N are moved to the heap, so unlike the move constructor this may allocate.
+     */
+    explicit small_vector(base &&other)
+        : base(N, other.get_allocator())
+    {
+        base::operator=(std::move(other));
+    }
+
+    ~small_vector() = default;
+
+    small_vector &operator=(const small_vector &other)
+    {
+        base::operator=(other);
+        return *this;
+    }
+
+    /**
+     * @brief Moves from a small_vector of the same inline capacity.
+     *
+     * Only allocates when the allocators differ and other's heap elements do not fit, which a stateless allocator
+     * rules out.
+     */
+    small_vector &operator=(small_vector &&other) noexcept(std::is_empty_v<Allocator>)
+    {
+        base::operator=(std::move(other));
+        return *this;
+    }
+
+    /**
+     * @brief Copies a small_vector of any inline capacity.
+     */
+    small_vector &operator=(const base &other)
+    {
+        base::operator=(other);
+        return *this;
+    }
+
+    /**
+     * @brief Moves from a small_vector of any inline capacity, taking over its heap storage if it has any.
+     *
+     * May allocate, see small_vector(base &&).
+     */
+    small_vector &operator=(base &&other)
+    {
+        base::operator=(std::move(other));
+        return *this;
+    }
+
+    small_vector &operator=(std::initializer_list<T> list)
+    {
+        base::operator=(list);
+        return *this;
+    }
+
+  private:
+    /// The inline buffer, found by the base from its address.
+    [[maybe_unused]] alignas(T) unsigned char _storage[N * sizeof(T)];
+};
+} // namespace std
+#endif
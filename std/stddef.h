@@ -69,6 +69,11 @@ namespace std
      * This type is used to represent the result of the division of two integers.
      */
     typedef unsigned long int uintmax_t;
+
+    /*!
+     * @brief Type of the null pointer literal nullptr.
+     */
+    typedef decltype(nullptr) nullptr_t;
 } // namespace std
 
 /*!
@@ -87,5 +92,6 @@ using intptr_t = std::intptr_t;
 using uintptr_t = std::uintptr_t;
 using intmax_t = std::intmax_t;
 using uintmax_t = std::uintmax_t;
+using nullptr_t = std::nullptr_t;
 
 #endif // STDDEF_H
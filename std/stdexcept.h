@@ -1,5 +1,18 @@
 #ifndef STDEXCEPT_H
 #define STDEXCEPT_H
+
+/*!
+ * @brief Defined when the library reports errors by throwing.
+ * @details On unless the compiler has exceptions turned off (-fno-exceptions) or STD_NO_EXCEPTIONS is defined, in
+ * which case every STD_THROW traps instead, so nothing in the library needs unwinding tables.
+ */
+#if defined(__cpp_exceptions) && !defined(STD_NO_EXCEPTIONS)
+#    define STD_HAS_EXCEPTIONS 1
+#    define STD_THROW(...) throw __VA_ARGS__
+#else
+#    define STD_THROW(...) ::std::detail::fatal_error((__VA_ARGS__).what())
+#endif
+
 namespace std
 {
     class [[nodiscard]] exception
@@ -135,5 +148,19 @@ namespace std
             return "invalid argument";
         }
     };
+
+    namespace detail
+    {
+        /*!
+         * @brief Where STD_THROW goes when exceptions are off: stops the program at the failing call.
+         * @param what The message of the exception that would have been thrown, left for a debugger to read.
+         */
+        [[noreturn]] inline void fatal_error(const char *what) noexcept
+        {
+            const char *volatile message = what;
+            (void)message;
+            __builtin_trap();
+        }
+    }
 }
-#endif
\ No newline at end of file
+#endif
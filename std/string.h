@@ -58,19 +58,37 @@
 #ifndef string_H
 #define string_H
 #include <algorithm.h>
+#include <bounds_check.h>
 #include <cstring.h>
+#include <expected.h>
+#include <growth_policy.h>
+#include <memory.h>
+#include <memory_resource.h>
 #include <new.h>
 #include <iterator.h>
 #include <stdexcept.h>
+#include <string_view.h>
+#include <trace.h>
+#include <utf.h>
+#include <type_traits.h>
 namespace std
 {
 /*!
  * @brief A temporary string class for UTF-8 conversion results. this is a move only class that is not ment to have a
  * size_type lifetime
+ * @details The buffer is either copied with new[] or adopted from the allocator of the string that produced it, in
+ * which case a release function hands it back to that allocator.
  */
 class [[nodiscard]] throw_away_string final
 {
   public:
+    /*!
+     * @brief Returns an adopted buffer to the allocator it came from.
+     */
+    using release_function = void (*)(char *buffer, std::size_t capacity, void *context) noexcept;
+
+    throw_away_string() = default;
+
     /*!
      * @brief Constructor for the throw_away_string class.
      * @param str The input string to be converted to UTF-8.
@@ -78,18 +96,36 @@ class [[nodiscard]] throw_away_string final
     explicit throw_away_string(const char *str)
     {
         len = strlen(str);
-        ptr = new char[len + 1];
+        _capacity = len + 1;
+        ptr = new char[_capacity];
         memset(static_cast<void *>(const_cast<char *>(ptr)), '\0', len + 1);
         memcpy(static_cast<void *>(const_cast<char *>(ptr)), reinterpret_cast<const void *>(str), len);
     }
+
+    /*!
+     * @brief Takes ownership of a null-terminated buffer without copying it.
+     * @param buffer The buffer, buffer[length] must be 0.
+     * @param length Length of the string in bytes, excluding the terminator.
+     * @param capacity Size of the buffer as it was allocated.
+     * @param release Called with buffer, capacity and context when the string is destroyed.
+     * @param context Passed through to release.
+     */
+    throw_away_string(char *buffer, std::size_t length, std::size_t capacity, release_function release,
+                      void *context) noexcept
+        : ptr(buffer)
+        , len(length)
+        , _capacity(capacity)
+        , _release(release)
+        , _context(context)
+    {
+    }
+
     /*!
      * @brief Destructor for the throw_away_string class.
      */
-    throw_away_string()
+    ~throw_away_string()
     {
-        if (ptr != nullptr)
-            delete[] ptr;
-        ptr = nullptr;
+        reset();
     }
     /*!
      * @brief Copy constructor for the throw_away_string class. is deleted to prevent copying.
@@ -103,9 +139,12 @@ class [[nodiscard]] throw_away_string final
      * @brief Move constructor for the throw_away_string class. this the only way to handle the string
      */
     throw_away_string(throw_away_string &&other) noexcept
+        : ptr(other.ptr)
+        , len(other.len)
+        , _capacity(other._capacity)
+        , _release(other._release)
+        , _context(other._context)
     {
-        ptr = other.ptr;
-        len = other.len;
         other.ptr = nullptr;
         other.len = 0;
     }
@@ -114,10 +153,17 @@ class [[nodiscard]] throw_away_string final
      */
     throw_away_string &operator=(throw_away_string &&other) noexcept
     {
-        ptr = other.ptr;
-        len = other.len;
-        other.ptr = nullptr;
-        other.len = 0;
+        if (this != &other)
+        {
+            reset();
+            ptr = other.ptr;
+            len = other.len;
+            _capacity = other._capacity;
+            _release = other._release;
+            _context = other._context;
+            other.ptr = nullptr;
+            other.len = 0;
+        }
         return *this;
     }
     /*!
@@ -138,14 +184,54 @@ class [[nodiscard]] throw_away_string final
         return len;
     }
 
+    /*!
+     * @brief Returns a view of the UTF-8 bytes, not including the terminator.
+     */
+    u8string_view view() const noexcept
+    {
+        return u8string_view(ptr, len);
+    }
+
   private:
-    const char *ptr = nullptr; //!< Pointer to the underlying character array.
-    std::size_t len = 0;       //!< Length of the string.
+    const char *ptr = nullptr;          //!< Pointer to the underlying character array.
+    std::size_t len = 0;                //!< Length of the string.
+    std::size_t _capacity = 0;          //!< Allocated size of the character array.
+    release_function _release = nullptr; //!< Frees an adopted array, nullptr for arrays from new[].
+    void *_context = nullptr;           //!< Passed to _release.
+
+    void reset() noexcept
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+        if (_release != nullptr)
+        {
+            _release(const_cast<char *>(ptr), _capacity, _context);
+        }
+        else
+        {
+            delete[] ptr;
+        }
+        ptr = nullptr;
+    }
 };
 
-class [[nodiscard]] string final
+/*!
+ * @brief The UTF-16 string, parameterised on the allocator that provides its storage.
+ * @details Everything the string allocates, including the buffer returned by throw_away(), comes from Allocator.
+ * The default std::allocator forwards to the global operator new[] and so to the os:: hooks; being stateless it adds
+ * nothing to the size of the string. Use std::string for the default and std::pmr::string for a memory_resource.
+ * Heap buffers grow as the Growth policy decides, see growth_policy.h, and are resized in place or without a copy
+ * when the allocator can do that.
+ * @tparam Allocator Allocator of data_type (short).
+ * @tparam Growth Policy for the capacity to grow to.
+ */
+template<typename Allocator = std::allocator<short>, typename Growth = std::default_growth>
+class [[nodiscard]] basic_string final
 {
   public:
+    using allocator_type = Allocator;
     using data_type = short;
     using size_type = std::size_t;
     using ssize_type = std::ssize_t;
@@ -156,143 +242,201 @@ class [[nodiscard]] string final
     using reverse_iterator = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
     static constexpr size_type npos = static_cast<size_type>(-1);
+    //! Code units stored inside the object before the string moves to the heap; 11 on 64-bit targets.
+    static constexpr size_type inline_capacity = (sizeof(data_type *) + 2 * sizeof(size_type)) / sizeof(data_type) - 1;
 
-    string(const_type str, ssize_type len_in = -1)
+    basic_string(const_type str, ssize_type len_in = -1, const Allocator &alloc = Allocator())
+        : _alloc(alloc)
     {
+        size_type count = 0;
         if (len_in == -1)
         {
-            while (str[len] != 0)
+            while (str[count] != 0)
             {
-                ++len;
+                ++count;
             }
         }
         else
         {
-            len = static_cast<size_type>(len_in);
+            count = static_cast<size_type>(len_in);
         }
-        ensure_capacity(len);
-        memcpy(ptr, str, len * sizeof(data_type));
+        assign_units(str, count);
     }
 
-    string()
-        : len(0)
+    basic_string()
+        : basic_string(Allocator())
     {
-        ensure_capacity(1);
-        ptr[0] = 0;
     }
 
-    string(const char *str, ssize_type len_in = -1)
+    /*!
+     * @brief Constructs an empty string. Empty and short strings live in the object itself and never allocate.
+     */
+    explicit basic_string(const Allocator &alloc) noexcept
+        : _alloc(alloc)
     {
-        Encoding encoding = detect_encoding(str, len_in);
-        convert_to_utf16(str, len_in, encoding);
     }
 
-    string(const string &other)
-        : len(other.len)
-        , _str_capacity(other._str_capacity)
+    basic_string(const char *str, ssize_type len_in = -1, const Allocator &alloc = Allocator())
+        : _alloc(alloc)
     {
-        if (len > 0)
-        {
-            ptr = new data_type[_str_capacity];
-            memcpy(ptr, other.ptr, len * sizeof(data_type));
-        }
+        append_encoded(str, len_in);
     }
 
-    string(string &&other) noexcept
-        : ptr(other.ptr)
-        , len(other.len)
-        , _str_capacity(other._str_capacity)
+    /*!
+     * @brief Copies the units of a view, which may point into another string.
+     */
+    explicit basic_string(string_view view, const Allocator &alloc = Allocator())
+        : _alloc(alloc)
     {
-        other.ptr = nullptr;
-        other.len = 0;
-        other._str_capacity = 0;
+        assign_units(view.data(), view.size());
+    }
+
+    basic_string(const basic_string &other)
+        : basic_string(other, std::allocator_traits<Allocator>::select_on_container_copy_construction(other._alloc))
+    {
+    }
+
+    basic_string(const basic_string &other, const Allocator &alloc)
+        : _alloc(alloc)
+    {
+        assign_units(other.buffer(), other.size());
+    }
+
+    basic_string(basic_string &&other) noexcept
+        : _rep(other._rep)
+        , _alloc(std::move(other._alloc))
+    {
+        other._rep = representation{};
     }
 
-    ~string()
+    ~basic_string()
     {
-        delete[] ptr;
+        release_heap();
     }
 
-    string &operator=(const string &other)
+    basic_string &operator=(const basic_string &other)
     {
         if (this != &other)
         {
-            delete[] ptr;
-            len = other.len;
-            _str_capacity = other._str_capacity;
-            ptr = new data_type[_str_capacity];
-            memcpy(ptr, other.ptr, len * sizeof(data_type));
+            assign_units(other.buffer(), other.size());
         }
         return *this;
     }
 
-    string &operator=(string &&other) noexcept
+    /*!
+     * @brief Takes over the buffer of other if both allocators compare equal, copies it otherwise.
+     */
+    basic_string &operator=(basic_string &&other) noexcept
     {
         if (this != &other)
         {
-            delete[] ptr;
-            ptr = other.ptr;
-            len = other.len;
-            _str_capacity = other._str_capacity;
-            other.ptr = nullptr;
-            other.len = 0;
-            other._str_capacity = 0;
+            if (other.is_heap() && !(_alloc == other._alloc))
+            {
+                return *this = static_cast<const basic_string &>(other);
+            }
+            release_heap();
+            _rep = other._rep;
+            other._rep = representation{};
         }
         return *this;
     }
 
-    string &operator=(const_type str)
+    basic_string &operator=(const_type str)
     {
-        len = strlen(reinterpret_cast<const char *>(str));
-        ensure_capacity(len);
-        memcpy(ptr, str, len * sizeof(data_type));
+        size_type count = 0;
+        while (str[count] != 0)
+        {
+            ++count;
+        }
+        assign_units(str, count);
         return *this;
     }
 
-    string operator+(const char *str) const
+    /*!
+     * @brief Concatenations allocate the result once at its final size; on an rvalue string they append in place,
+     * so a chain like a + b + c reuses the first temporary. For many pieces use string_builder or concat().
+     */
+    basic_string operator+(const char *str) const &
     {
-        string result = *this;
-        result.append(str);
+        size_type bytes = strlen(str);
+        basic_string result(_alloc);
+        result.reserve(size() + bytes);
+        result.append(view());
+        result.append(str, bytes);
         return result;
     }
 
-    string operator+(const_type str) const
+    basic_string operator+(const_type str) const &
     {
-        string result = *this;
-        result.append(str);
-        return result;
+        return *this + string_view(str);
     }
 
-    string operator+(const string &str) const
+    basic_string operator+(string_view str) const &
     {
-        string result = *this;
+        basic_string result(_alloc);
+        result.reserve(size() + str.size());
+        result.append(view());
         result.append(str);
         return result;
     }
 
+    basic_string operator+(const basic_string &str) const &
+    {
+        return *this + str.view();
+    }
+
+    basic_string operator+(const char *str) &&
+    {
+        append(str);
+        return std::move(*this);
+    }
+
+    basic_string operator+(const_type str) &&
+    {
+        append(string_view(str));
+        return std::move(*this);
+    }
+
+    basic_string operator+(string_view str) &&
+    {
+        append(str);
+        return std::move(*this);
+    }
+
+    basic_string operator+(const basic_string &str) &&
+    {
+        append(str.view());
+        return std::move(*this);
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+        return _alloc;
+    }
+
     iterator begin() noexcept
     {
-        return ptr;
+        return buffer();
     }
     const_iterator begin() const noexcept
     {
-        return ptr;
+        return buffer();
     }
     const_iterator cbegin() const noexcept
     {
-        return ptr;
+        return buffer();
     }
     iterator end() noexcept
     {
-        return ptr + len;
+        return buffer() + size();
     }
     const_iterator end() const noexcept
     {
-        return ptr + len;
+        return buffer() + size();
     }
     const_iterator cend() const noexcept
     {
-        return ptr + len;
+        return buffer() + size();
     }
 
     reverse_iterator rbegin() noexcept
@@ -322,27 +466,48 @@ class [[nodiscard]] string final
 
     size_type size() const noexcept
     {
-        return len;
+        return is_heap() ? _rep.heap.len : _rep.small.tag;
     }
 
     size_type length() const noexcept
     {
-        return len;
+        return size();
     }
 
     constexpr bool empty() const noexcept
     {
-        return len == 0;
+        return size() == 0;
     }
 
+    /*!
+     * @brief Number of code units that fit without allocating, at least inline_capacity.
+     */
     size_type capacity() const noexcept
     {
-        return _str_capacity;
+        return is_heap() ? (_rep.heap.cap & ~heap_flag) : inline_capacity;
+    }
+
+    /*!
+     * @brief Makes room for new_capacity units if the string has less, rounded up only as the growth policy asks
+     * (not at all for the default policy).
+     */
+    void reserve(size_type new_capacity)
+    {
+        if (new_capacity > capacity())
+        {
+            reallocate(Growth::round(new_capacity, sizeof(data_type)));
+        }
     }
 
-    void reserve(size_type new__str_capacity)
+    /*!
+     * @brief Makes room for exactly new_capacity units if the string has less, whatever the growth policy.
+     */
+    void reserve_exact(size_type new_capacity)
     {
-        ensure_capacity(new__str_capacity);
+        if (new_capacity > capacity())
+        {
+            reallocate(new_capacity);
+        }
     }
 
     constexpr size_type max_size() const noexcept
@@ -350,693 +515,697 @@ class [[nodiscard]] string final
         return static_cast<size_type>(-1) / sizeof(data_type);
     }
 
-    data_type at(size_type index) const
+    /*!
+     * @brief Returns the unit at index, failing as STD_BOUNDS_CHECK says if it is out of range (by default with
+     * std::out_of_range). See bounds_check.h.
+     */
+    data_type at(size_type index) const noexcept(!std::detail::bounds_check_throws)
     {
-        if (index >= len)
+        std::detail::check_bounds(index < size());
+        return buffer()[index];
+    }
+
+    data_type &at(size_type index) noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(index < size());
+        return buffer()[index];
+    }
+
+    /*!
+     * @brief Returns a pointer to the unit at index, or the std::out_of_range that at() would throw.
+     */
+    std::Expected<data_type *, std::out_of_range> try_at(size_type index) noexcept
+    {
+        if (index >= size())
         {
-            throw std::out_of_range();
+            return std::Expected<data_type *, std::out_of_range>::Unexpected(std::out_of_range());
         }
-        return ptr[index];
+        return buffer() + index;
     }
 
-    data_type &at(size_type index)
+    std::Expected<const_type, std::out_of_range> try_at(size_type index) const noexcept
     {
-        if (index >= len)
+        if (index >= size())
         {
-            throw std::out_of_range();
+            return std::Expected<const_type, std::out_of_range>::Unexpected(std::out_of_range());
         }
-        return ptr[index];
+        return buffer() + index;
     }
 
-    data_type operator[](size_type index) const
+    //! Checked like at(); under STD_BOUNDS_NONE both are unchecked.
+    data_type operator[](size_type index) const noexcept(!std::detail::bounds_check_throws)
     {
         return at(index);
     }
 
-    data_type &operator[](size_type index)
+    data_type &operator[](size_type index) noexcept(!std::detail::bounds_check_throws)
     {
         return at(index);
     }
 
     data_type *data()
     {
-        return ptr;
+        return buffer();
+    }
+
+    /*!
+     * @brief Returns a view of the units, valid until the string is next modified.
+     */
+    string_view view() const noexcept
+    {
+        return string_view(buffer(), size());
+    }
+
+    operator string_view() const noexcept
+    {
+        return view();
     }
 
     const_type data() const
     {
-        return ptr;
+        return buffer();
     }
 
-    data_type front() const
+    //! The first unit; on an empty string this fails as STD_BOUNDS_CHECK says.
+    data_type front() const noexcept(!std::detail::bounds_check_throws)
     {
-        return ptr[0];
+        std::detail::check_bounds(!empty());
+        return buffer()[0];
     }
 
-    data_type back() const
+    //! The last unit; on an empty string this fails as STD_BOUNDS_CHECK says.
+    data_type back() const noexcept(!std::detail::bounds_check_throws)
     {
-        return ptr[len - 1];
+        std::detail::check_bounds(!empty());
+        return buffer()[size() - 1];
     }
 
     data_type *raw_data()
     {
-        return ptr;
+        return buffer();
     }
     const_type raw_data() const
     {
-        return ptr;
+        return buffer();
     }
 
     void push_back(data_type ch)
     {
-        ensure_capacity(len + 1);
-        ptr[len++] = ch;
+        size_type count = size();
+        ensure_capacity(count + 1);
+        buffer()[count] = ch;
+        set_length(count + 1);
     }
 
     void pop_back()
     {
-        if (len > 0)
+        size_type count = size();
+        if (count > 0)
         {
-            --len;
+            set_length(count - 1);
         }
     }
 
+    /*!
+     * @brief Releases unused heap capacity, moving the string back inline if it fits.
+     */
     void shrink_to_fit()
     {
-        _str_capacity = len;
-        data_type *new_ptr = new data_type[_str_capacity];
-        memcpy(new_ptr, ptr, len * sizeof(data_type));
-        delete[] ptr;
-        ptr = new_ptr;
+        if (!is_heap())
+        {
+            return;
+        }
+        data_type *old_block = _rep.heap.ptr;
+        size_type old_capacity = capacity();
+        size_type count = size();
+        if (count <= inline_capacity)
+        {
+            _rep = representation{};
+            memcpy(_rep.small.buf, old_block, count * sizeof(data_type));
+            _rep.small.tag = static_cast<udata_type>(count);
+        }
+        else
+        {
+            data_type *block = allocate(count);
+            memcpy(block, old_block, count * sizeof(data_type));
+            set_heap(block, count, count);
+        }
+        deallocate(old_block, old_capacity);
     }
 
     void resize(size_type new_size)
     {
         ensure_capacity(new_size);
-        len = new_size;
+        set_length(new_size);
     }
 
-    string &append(const char *str)
+    basic_string &append(const char *str)
     {
-        auto encoding = detect_encoding(str, -1);
-        convert_to_utf16(str, -1, encoding);
+        append_encoded(str, -1);
         return *this;
     }
 
-    string &operator+=(const char *str)
+    /*!
+     * @brief Converts count bytes of str like the constructor does and appends them; str need not be terminated.
+     */
+    basic_string &append(const char *str, size_type count)
+    {
+        append_encoded(str, static_cast<ssize_type>(count));
+        return *this;
+    }
+
+    basic_string &operator+=(const char *str)
     {
         return append(str);
     }
 
-    string &append(const string &other)
+    basic_string &append(string_view other)
     {
-        ensure_capacity(len + other.len);
-        memcpy(ptr + len, other.ptr, other.len * sizeof(data_type));
-        len += other.len;
+        const_type units = buffer();
+        if (other.data() >= units && other.data() < units + capacity())
+        {
+            // The view points into this string and growing would move it
+            basic_string copy(other, _alloc);
+            return append(copy.view());
+        }
+        size_type count = size();
+        ensure_capacity(count + other.size());
+        memcpy(buffer() + count, other.data(), other.size() * sizeof(data_type));
+        set_length(count + other.size());
         return *this;
     }
 
-    string &operator+=(const string &other)
+    basic_string &operator+=(string_view other)
     {
         return append(other);
     }
 
-    string &append(data_type ch)
+    basic_string &append(data_type ch)
     {
-        ensure_capacity(len + 1);
-        ptr[len++] = ch;
+        push_back(ch);
         return *this;
     }
 
-    string &operator+=(data_type ch)
+    basic_string &operator+=(data_type ch)
     {
         return append(ch);
     }
 
-    string substr(size_type start, size_type end) const
+    basic_string substr(size_type start, size_type end) const
     {
-        string substr;
-        substr.reserve(end - start);
-        for (size_type i = start; i < end; ++i)
-        {
-            substr.push_back(ptr[i]);
-        }
-        return substr;
+        return basic_string(buffer() + start, static_cast<ssize_type>(end - start), _alloc);
     }
 
-    string &insert(size_type pos, const string &str)
+    /*!
+     * @brief Like substr() but returns a view of the units in [start, end) instead of a copy.
+     * @throws std::out_of_range if the range is not inside the string.
+     */
+    string_view substr_view(size_type start, size_type end) const
     {
-        if (pos > len)
-        {
-            throw std::out_of_range();
-        }
-        size_type new_len = len + str.len;
-        ensure_capacity(new_len);
-
-        // Move existing characters
-        for (size_type i = len; i > pos; --i)
+        if (start > end || end > size())
         {
-            ptr[i + str.len - 1] = ptr[i - 1];
+            STD_THROW(std::out_of_range());
         }
+        return string_view(buffer() + start, end - start);
+    }
 
-        // Copy new string
-        for (size_type i = 0; i < str.len; ++i)
+    basic_string &insert(size_type pos, const basic_string &str)
+    {
+        if (&str == this)
         {
-            ptr[pos + i] = str.ptr[i];
+            basic_string copy(str);
+            return insert(pos, copy);
         }
-
-        len = new_len;
-        return *this;
+        return insert(pos, str.buffer(), str.size());
     }
 
-    string &insert(size_type pos, const_type s, size_type n)
+    basic_string &insert(size_type pos, const_type s, size_type n)
     {
-        if (pos > len)
+        size_type count = size();
+        if (pos > count)
         {
-            throw std::out_of_range();
+            STD_THROW(std::out_of_range());
         }
-        ensure_capacity(len + n);
+        ensure_capacity(count + n);
+        data_type *units = buffer();
 
         // Move existing characters
-        for (size_type i = len; i > pos; --i)
-        {
-            ptr[i + n - 1] = ptr[i - 1];
-        }
+        memmove(units + pos + n, units + pos, (count - pos) * sizeof(data_type));
 
         // Copy new characters
-        for (size_type i = 0; i < n; ++i)
-        {
-            ptr[pos + i] = s[i];
-        }
+        memcpy(units + pos, s, n * sizeof(data_type));
 
-        len += n;
+        set_length(count + n);
         return *this;
     }
 
-    string &insert(size_type pos, size_type n, data_type c)
+    basic_string &insert(size_type pos, size_type n, data_type c)
     {
-        if (pos > len)
+        size_type count = size();
+        if (pos > count)
         {
-            throw std::out_of_range();
+            STD_THROW(std::out_of_range());
         }
-        ensure_capacity(len + n);
+        ensure_capacity(count + n);
+        data_type *units = buffer();
 
         // Move existing characters
-        for (size_type i = len; i > pos; --i)
-        {
-            ptr[i + n - 1] = ptr[i - 1];
-        }
+        memmove(units + pos + n, units + pos, (count - pos) * sizeof(data_type));
 
         // Fill with character
         for (size_type i = 0; i < n; ++i)
         {
-            ptr[pos + i] = c;
+            units[pos + i] = c;
         }
 
-        len += n;
+        set_length(count + n);
         return *this;
     }
 
-    string &erase(size_type pos, size_type n)
+    basic_string &erase(size_type pos, size_type n)
     {
-        if (pos > len)
+        size_type count = size();
+        if (pos > count)
         {
-            throw std::out_of_range();
+            STD_THROW(std::out_of_range());
         }
 
-        if (n == npos || pos + n > len)
+        if (n == npos || pos + n > count)
         {
-            n = len - pos;
+            n = count - pos;
         }
 
-        for (size_type i = pos; i + n < len; ++i)
-        {
-            ptr[i] = ptr[i + n];
-        }
+        data_type *units = buffer();
+        memmove(units + pos, units + pos + n, (count - pos - n) * sizeof(data_type));
 
-        len -= n;
+        set_length(count - n);
         return *this;
     }
 
-    constexpr size_type find(const string &str, size_type pos) const noexcept
+    /*!
+     * @brief Finds the first occurrence of str at or after pos.
+     * @return The index of the match or npos.
+     */
+    size_type find(string_view str, size_type pos = 0) const noexcept
     {
-        if (pos >= len)
-            return npos;
-        if (str.empty())
-            return pos;
+        return view().find(str, pos);
+    }
 
-        for (size_type i = pos; i <= len - str.len; ++i)
-        {
-            bool found = true;
-            for (size_type j = 0; j < str.len; ++j)
-            {
-                if (ptr[i + j] != str.ptr[j])
-                {
-                    found = false;
-                    break;
-                }
-            }
-            if (found)
-                return i;
-        }
-        return npos;
+    size_type find(u8string_view str, size_type pos = 0) const
+    {
+        return with_units(str, [&](string_view units) { return find(units, pos); });
+    }
+
+    /*!
+     * @brief Finds the last occurrence of str that starts at or before pos.
+     * @return The index of the match or npos.
+     */
+    size_type rfind(string_view str, size_type pos = npos) const noexcept
+    {
+        return view().rfind(str, pos);
     }
 
-    constexpr size_type rfind(const string &str, size_type pos) const noexcept
+    size_type rfind(u8string_view str, size_type pos = npos) const
     {
-        if (str.empty())
-            return min(pos, len);
-        if (len < str.len)
-            return npos;
+        return with_units(str, [&](string_view units) { return rfind(units, pos); });
+    }
 
-        pos = min(pos, len - str.len);
+    size_type find_first_of(string_view set, size_type pos = 0) const noexcept
+    {
+        return view().find_first_of(set, pos);
+    }
 
-        for (size_type i = pos + 1; i-- > 0;)
-        {
-            bool found = true;
-            for (size_type j = 0; j < str.len; ++j)
-            {
-                if (ptr[i + j] != str.ptr[j])
-                {
-                    found = false;
-                    break;
-                }
-            }
-            if (found)
-                return i;
-        }
-        return npos;
+    size_type find_first_of(u8string_view set, size_type pos = 0) const
+    {
+        return with_units(set, [&](string_view units) { return find_first_of(units, pos); });
     }
 
-    constexpr size_type find_first_of(const string &str, size_type pos) const noexcept
+    size_type find_last_of(string_view set, size_type pos = npos) const noexcept
     {
-        for (size_type i = pos; i < len; ++i)
-        {
-            for (size_type j = 0; j < str.len; ++j)
-            {
-                if (ptr[i] == str.ptr[j])
-                {
-                    return i;
-                }
-            }
-        }
-        return npos;
+        return view().find_last_of(set, pos);
     }
 
-    constexpr size_type find_last_of(const string &str, size_type pos) const noexcept
+    size_type find_last_of(u8string_view set, size_type pos = npos) const
     {
-        if (empty())
-            return npos;
-        pos = min(pos, len - 1);
+        return with_units(set, [&](string_view units) { return find_last_of(units, pos); });
+    }
 
-        for (size_type i = pos + 1; i-- > 0;)
-        {
-            for (size_type j = 0; j < str.len; ++j)
-            {
-                if (ptr[i] == str.ptr[j])
-                {
-                    return i;
-                }
-            }
-        }
-        return npos;
+    /*!
+     * @brief Compares the units lexicographically.
+     * @return Negative, zero or positive as this string orders before, equal to or after other.
+     */
+    int compare(string_view other) const noexcept
+    {
+        return view().compare(other);
     }
 
-    constexpr bool operator<(const string &rhs) const noexcept
+    int compare(u8string_view other) const
     {
-        size_type min_len = min(len, rhs.len);
+        return with_units(other, [&](string_view units) { return compare(units); });
+    }
+
+    constexpr bool operator<(const basic_string &rhs) const noexcept
+    {
+        size_type count = size();
+        size_type rhs_count = rhs.size();
+        size_type min_len = min(count, rhs_count);
+        const_type units = buffer();
+        const_type rhs_units = rhs.buffer();
         for (size_type i = 0; i < min_len; ++i)
         {
-            if (ptr[i] < rhs.ptr[i])
+            if (units[i] < rhs_units[i])
                 return true;
-            if (ptr[i] > rhs.ptr[i])
+            if (units[i] > rhs_units[i])
                 return false;
         }
-        return len < rhs.len;
+        return count < rhs_count;
     }
 
-    constexpr bool operator<=(const string &rhs) const noexcept
+    constexpr bool operator<=(const basic_string &rhs) const noexcept
     {
         return !(rhs < *this);
     }
 
-    constexpr bool operator>(const string &rhs) const noexcept
+    constexpr bool operator>(const basic_string &rhs) const noexcept
     {
         return rhs < *this;
     }
 
-    constexpr bool operator>=(const string &rhs) const noexcept
+    constexpr bool operator>=(const basic_string &rhs) const noexcept
     {
         return !(*this < rhs);
     }
 
-    constexpr bool operator==(const string &other) const
+    constexpr bool operator==(const basic_string &other) const
     {
-        if (len != other.len)
+        if (size() != other.size())
         {
             return false;
         }
-        return memcmp(ptr, other.ptr, len * sizeof(data_type)) == 0;
+        return memcmp(buffer(), other.buffer(), size() * sizeof(data_type)) == 0;
     }
 
-    constexpr bool operator!=(const string &other) const
+    constexpr bool operator!=(const basic_string &other) const
     {
         return !(*this == other);
     }
 
-    const throw_away_string throw_away() const
+    bool operator==(string_view other) const noexcept
     {
-        if (!ptr)
-            return throw_away_string("\0");
-        char *utf8_result = new char[len + 1];
-        memset(utf8_result, '\0', len + 1);
+        return view() == other;
+    }
 
-        size_type i = 0;
-        ssize_type j = 0;
+    /*!
+     * @brief Converts the string to UTF-8 in a buffer of exactly the right size.
+     * @details The length is measured first, so the conversion writes straight into the buffer that the result
+     * adopts: one allocation, no copy. Unpaired surrogates are dropped.
+     */
+    const throw_away_string throw_away() const
+    {
+        using char_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<char>;
+        static_assert(sizeof(char_allocator) <= sizeof(void *) && std::is_trivially_copyable_v<char_allocator>,
+                      "throw_away() stores the allocator in a pointer-sized context");
+        size_type count = size();
+        const_type units = buffer();
+        size_type utf8_count = utf::utf8_length(units, count);
+        size_type utf8_capacity = utf8_count + 1;
+        char_allocator char_alloc(_alloc);
+        char *utf8_result = std::allocator_traits<char_allocator>::allocate(char_alloc, utf8_capacity);
+        utf::utf16_to_utf8(units, count, utf8_result, utf8_count);
+        utf8_result[utf8_count] = '\0';
 
-        while (i < len)
-        {
-            udata_type code_unit = static_cast<udata_type>(ptr[i++]);
+        void *context = nullptr;
+        memcpy(&context, &char_alloc, sizeof(char_alloc));
+        return throw_away_string(utf8_result, utf8_count, utf8_capacity, &release_utf8<char_allocator>, context);
+    }
 
-            if (code_unit < 0x80)
-            {
-                // 1-byte UTF-8
-                utf8_result[j++] = static_cast<char>(code_unit);
-            }
-            else if (code_unit < 0x800)
-            {
-                // 2-byte UTF-8
-                utf8_result[j++] = static_cast<char>(0xC0 | (code_unit >> 6));
-                utf8_result[j++] = static_cast<char>(0x80 | (code_unit & 0x3F));
-            }
-            else if (code_unit >= 0xD800 && code_unit <= 0xDBFF)
-            {
-                // Surrogate pair: high surrogate
-                udata_type high_surrogate = code_unit;
-                udata_type low_surrogate = static_cast<udata_type>(ptr[i]);
-
-                if (low_surrogate >= 0xDC00 && low_surrogate <= 0xDFFF)
-                {
-                    // Valid surrogate pair
-                    i++; // Consume the low surrogate
-                    unsigned int code_point =
-                        static_cast<unsigned int>(0x10000) +
-                        ((static_cast<unsigned int>(high_surrogate) - static_cast<unsigned int>(0xD800))
-                         << static_cast<unsigned int>(10)) +
-                        (static_cast<unsigned int>(low_surrogate) - static_cast<unsigned int>(0xDC00));
-
-                    // Encode the code point as 4-byte UTF-8
-                    utf8_result[j++] = static_cast<char>(0xF0 | (code_point >> 18));
-                    utf8_result[j++] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
-                    utf8_result[j++] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
-                    utf8_result[j++] = static_cast<char>(0x80 | (code_point & 0x3F));
-                }
-                else
-                {
-                    // Invalid surrogate pair; skip the invalid sequence
-                    continue;
-                }
-            }
-            else if (code_unit >= 0xDC00 && code_unit <= 0xDFFF)
-            {
-                // Unpaired low surrogate; skip it
-                continue;
-            }
-            else
-            {
-                // 3-byte UTF-8
-                utf8_result[j++] = static_cast<char>(0xE0 | (code_unit >> 12));
-                utf8_result[j++] = static_cast<char>(0x80 | ((code_unit >> 6) & 0x3F));
-                utf8_result[j++] = static_cast<char>(0x80 | (code_unit & 0x3F));
-            }
-        }
-        throw_away_string ret(utf8_result);
-        delete[] utf8_result;
-        return ret;
+    /*!
+     * @brief Number of bytes the string takes as UTF-8, not counting a terminator.
+     */
+    size_type utf8_size() const noexcept
+    {
+        return utf::utf8_length(buffer(), size());
     }
 
-    bool start_with(const string &other) const
+    /*!
+     * @brief Converts the string to UTF-8 into a caller-owned buffer, without allocating.
+     * @details Output that does not fit is cut at a code point boundary. The result is null-terminated whenever
+     * dst_capacity is not zero, so a buffer of utf8_size() + 1 bytes always holds the whole string.
+     * @param dst The destination buffer.
+     * @param dst_capacity Size of dst in bytes, including room for the terminator.
+     * @return The number of bytes written, not counting the terminator.
+     */
+    size_type encode_utf8_into(char *dst, size_type dst_capacity) const noexcept
     {
-        if (len < other.len)
+        if (dst_capacity == 0)
         {
-            return false;
+            return 0;
         }
-        return memcmp(ptr, other.ptr, other.len * sizeof(data_type)) == 0;
+        size_type written = utf::utf16_to_utf8(buffer(), size(), dst, dst_capacity - 1);
+        dst[written] = '\0';
+        return written;
     }
 
-    bool end_with(const string &other) const
+    bool start_with(string_view other) const noexcept
     {
-        if (len < other.len)
-        {
-            return false;
-        }
-        return memcmp(ptr + len - other.len, other.ptr, other.len * sizeof(data_type)) == 0;
+        return view().starts_with(other);
+    }
+
+    bool start_with(u8string_view other) const
+    {
+        return with_units(other, [&](string_view units) { return start_with(units); });
+    }
+
+    bool end_with(string_view other) const noexcept
+    {
+        return view().ends_with(other);
     }
 
+    bool end_with(u8string_view other) const
+    {
+        return with_units(other, [&](string_view units) { return end_with(units); });
+    }
+
+    /*!
+     * @brief Empties the string and releases any heap buffer.
+     */
     void clear()
     {
-        delete[] ptr;
-        ptr = nullptr;
-        len = 0;
-        _str_capacity = 0;
+        release_heap();
+        _rep = representation{};
     }
 
     void resize(size_type n, data_type ch)
     {
-        if (n > len)
+        size_type count = size();
+        if (n > count)
         {
-            reserve(n);
-            while (len < n)
-            {
-                push_back(ch);
-            }
+            insert(count, n - count, ch);
             return;
         }
         resize(n);
     }
 
-    friend string operator+(const char *lhs, const string &rhs)
+    friend basic_string operator+(const char *lhs, const basic_string &rhs)
     {
-        return string(lhs) + rhs;
+        size_type bytes = strlen(lhs);
+        basic_string result(rhs._alloc);
+        result.reserve(bytes + rhs.size());
+        result.append(lhs, bytes);
+        result.append(rhs.view());
+        return result;
     }
 
-    friend string operator+(const_type lhs, const string &rhs)
+    friend basic_string operator+(const_type lhs, const basic_string &rhs)
     {
-        return string(lhs) + rhs;
+        string_view units(lhs);
+        basic_string result(rhs._alloc);
+        result.reserve(units.size() + rhs.size());
+        result.append(units);
+        result.append(rhs.view());
+        return result;
     }
 
   private:
-    data_type *ptr = nullptr;
-    size_type len = 0;
-    size_type _str_capacity = 0;
+    /*
+     * The string is either on the heap or stored inline in the same bytes. The top bit of the inline tag overlaps
+     * the top bit of the heap capacity, which is set for heap strings; on big-endian targets both layouts are
+     * mirrored so the two bits still meet. The object holds no pointer into itself, so it stays trivially
+     * relocatable.
+     */
+    struct heap_rep
+    {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        size_type cap;
+        size_type len;
+        data_type *ptr;
+#else
+        data_type *ptr;
+        size_type len;
+        size_type cap;
+#endif
+    };
 
-    enum class Encoding
+    struct small_rep
     {
-        ASCII,
-        UTF8,
-        UTF16_LE,
-        UTF16_BE,
-        UTF32_LE,
-        UTF32_BE
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        udata_type tag;
+        data_type buf[inline_capacity];
+#else
+        data_type buf[inline_capacity];
+        udata_type tag;
+#endif
     };
 
-    ssize_type get_utf16_length(const char *str, Encoding encoding)
+    union representation
     {
-        if (!str)
-            return 0;
+        small_rep small;
+        heap_rep heap;
+    };
 
-        // Skip BOM
-        if (encoding == Encoding::UTF8 && static_cast<unsigned char>(str[0]) == 0xEF &&
-            static_cast<unsigned char>(str[1]) == 0xBB && static_cast<unsigned char>(str[2]) == 0xBF)
-        {
-            str += 3;
-        }
-        else if ((encoding == Encoding::UTF16_BE || encoding == Encoding::UTF16_LE) &&
-                 static_cast<unsigned char>(str[0]) == 0xFE && static_cast<unsigned char>(str[1]) == 0xFF)
-        {
-            str += 2;
-        }
-        else if ((encoding == Encoding::UTF32_BE || encoding == Encoding::UTF32_LE) &&
-                 ((static_cast<unsigned char>(str[0]) == 0x00 && static_cast<unsigned char>(str[1]) == 0x00 &&
-                   static_cast<unsigned char>(str[2]) == 0xFE && static_cast<unsigned char>(str[3]) == 0xFF) ||
-                  (static_cast<unsigned char>(str[0]) == 0xFF && static_cast<unsigned char>(str[1]) == 0xFE &&
-                   static_cast<unsigned char>(str[2]) == 0x00 && static_cast<unsigned char>(str[3]) == 0x00)))
-        {
-            str += 4;
-        }
+    static_assert(sizeof(small_rep) == sizeof(heap_rep), "the inline buffer must overlay the heap fields exactly");
 
-        ssize_type utf16_len = 0;
+    static constexpr size_type heap_flag = size_type(1) << (sizeof(size_type) * 8 - 1);
+    static constexpr udata_type small_heap_bit = 0x8000;
 
-        switch (encoding)
-        {
-        case Encoding::ASCII:
-            utf16_len = static_cast<ssize_type>(strlen(str));
-            break;
+    representation _rep = {};
+    STD_NO_UNIQUE_ADDRESS Allocator _alloc{};
 
-        case Encoding::UTF8: {
-            for (ssize_type i = 0; str[i];)
-            {
-                unsigned char byte = static_cast<unsigned char>(str[i]);
-                if (byte < 0x80)
-                {
-                    utf16_len++;
-                    i++;
-                }
-                else if ((byte & 0xE0) == 0xC0)
-                {
-                    utf16_len++;
-                    i += 2;
-                }
-                else if ((byte & 0xF0) == 0xE0)
-                {
-                    utf16_len++;
-                    i += 3;
-                }
-                else if ((byte & 0xF8) == 0xF0)
-                {
-                    utf16_len += 2; // Emoji or supplementary character (surrogate pair)
-                    i += 4;
-                }
-                else
-                {
-                    // Handle invalid byte sequences gracefully
-                    i++;
-                }
-            }
-            break;
-        }
-
-        case Encoding::UTF16_LE:
-        case Encoding::UTF16_BE: {
-            const udata_type *ptr_utf16 = reinterpret_cast<const udata_type *>(str);
-            while (*ptr_utf16)
-            {
-                if (*ptr_utf16 >= 0xD800 && *ptr_utf16 <= 0xDBFF)
-                {
-                    utf16_len += 2; // High surrogate followed by low surrogate
-                    ptr_utf16 += 2;
-                }
-                else
-                {
-                    utf16_len++;
-                    ptr_utf16++;
-                }
-            }
-            break;
-        }
+    bool is_heap() const noexcept
+    {
+        return (_rep.small.tag & small_heap_bit) != 0;
+    }
 
-        case Encoding::UTF32_LE:
-        case Encoding::UTF32_BE: {
-            const unsigned int *utf32_str = reinterpret_cast<const unsigned int *>(str);
-            while (*utf32_str)
-            {
-                utf16_len += (*utf32_str > 0xFFFF) ? 2 : 1; // Surrogate pairs for supplementary planes
-                utf32_str++;
-            }
-            break;
-        }
-        }
+    data_type *buffer() noexcept
+    {
+        return is_heap() ? _rep.heap.ptr : _rep.small.buf;
+    }
 
-        return utf16_len;
+    const_type buffer() const noexcept
+    {
+        return is_heap() ? _rep.heap.ptr : _rep.small.buf;
     }
 
-    Encoding detect_encoding(const char *str, ssize_type len_in)
+    void set_length(size_type count) noexcept
     {
-        // Determine actual length if not provided
-        if (len_in == -1)
+        if (is_heap())
         {
-            len_in = static_cast<ssize_type>(strlen(str));
+            _rep.heap.len = count;
         }
+        else
+        {
+            _rep.small.tag = static_cast<udata_type>(count);
+        }
+    }
 
-        if (len_in < 2)
-            return Encoding::ASCII;
-
-        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(str);
-
-        // UTF-8 BOM check
-        if (len_in >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
-            return Encoding::UTF8;
+    void set_heap(data_type *block, size_type count, size_type block_capacity) noexcept
+    {
+        _rep.heap.ptr = block;
+        _rep.heap.len = count;
+        _rep.heap.cap = block_capacity | heap_flag;
+    }
 
-        // UTF-16 BOM check
-        if (len_in >= 2)
+    /*!
+     * @brief Frees the heap buffer, if any. The representation is left for the caller to reset.
+     */
+    void release_heap() noexcept
+    {
+        if (is_heap())
         {
-            if (bytes[0] == 0xFE && bytes[1] == 0xFF)
-                return Encoding::UTF16_BE;
-            if (bytes[0] == 0xFF && bytes[1] == 0xFE)
-                return Encoding::UTF16_LE;
+            deallocate(_rep.heap.ptr, capacity());
         }
+    }
 
-        // UTF-32 BOM check
-        if (len_in >= 4)
+    /*!
+     * @brief Replaces the contents with count units from src, which may point into this string.
+     */
+    void assign_units(const_type src, size_type count)
+    {
+        if (count > capacity())
         {
-            if (bytes[0] == 0x00 && bytes[1] == 0x00 && bytes[2] == 0xFE && bytes[3] == 0xFF)
-                return Encoding::UTF32_BE;
-            if (bytes[0] == 0xFF && bytes[1] == 0xFE && bytes[2] == 0x00 && bytes[3] == 0x00)
-                return Encoding::UTF32_LE;
+            data_type *block = allocate(count);
+            memcpy(block, src, count * sizeof(data_type));
+            release_heap();
+            set_heap(block, count, count);
+            return;
         }
-
-        return detect_utf8_heuristic(str, len_in);
+        memmove(buffer(), src, count * sizeof(data_type));
+        set_length(count);
     }
 
-    Encoding detect_utf8_heuristic(const char *str, ssize_type len_in)
+    data_type *allocate(size_type count)
     {
-        size_type utf8_sequence_count = 0;
-        size_type expected_continuation_bytes = 0;
-
-        for (ssize_type i = 0; i < len_in; ++i)
-        {
-            unsigned char byte = static_cast<unsigned char>(str[i]);
+        return std::allocator_traits<Allocator>::allocate(_alloc, count);
+    }
 
-            if (expected_continuation_bytes == 0)
-            {
-                if (byte <= 0x7F)
-                    continue;
-
-                if ((byte & 0xE0) == 0xC0)
-                    expected_continuation_bytes = 1;
-                else if ((byte & 0xF0) == 0xE0)
-                    expected_continuation_bytes = 2;
-                else if ((byte & 0xF8) == 0xF0)
-                    expected_continuation_bytes = 3;
-                else
-                    return Encoding::ASCII;
-
-                utf8_sequence_count++;
-            }
-            else
-            {
-                if ((byte & 0xC0) != 0x80)
-                    return Encoding::ASCII;
-                expected_continuation_bytes--;
-            }
-        }
+    void deallocate(data_type *block, size_type count) noexcept
+    {
+        std::allocator_traits<Allocator>::deallocate(_alloc, block, count);
+    }
 
-        return (utf8_sequence_count > 0) ? Encoding::UTF8 : Encoding::ASCII;
+    /*!
+     * @brief Hands a throw_away() buffer back to the allocator stored bytewise in context.
+     */
+    template<typename CharAllocator>
+    static void release_utf8(char *block, std::size_t block_capacity, void *context) noexcept
+    {
+        CharAllocator char_alloc;
+        memcpy(&char_alloc, &context, sizeof(char_alloc));
+        std::allocator_traits<CharAllocator>::deallocate(char_alloc, block, block_capacity);
     }
 
-    void convert_to_utf16(const char *str, ssize_type len_in, Encoding encoding)
+    enum class Encoding
     {
-        size_type true_len = static_cast<size_type>(len_in);
-        if (len_in == -1)
-        {
-            true_len = strlen(str);
-        }
+        UTF8,
+        UTF16_LE,
+        UTF16_BE,
+        UTF32_LE,
+        UTF32_BE
+    };
 
-        ensure_capacity(true_len);
-        len = 0;
+    /*!
+     * @brief Picks the encoding from a byte order mark; input without one is taken to be UTF-8.
+     */
+    static Encoding detect_encoding(const char *str, size_type count) noexcept
+    {
+        const unsigned char *bytes = reinterpret_cast<const unsigned char *>(str);
+        // The UTF-32 LE mark starts with the UTF-16 LE one, so it is checked first
+        if (count >= 4 && bytes[0] == 0xFF && bytes[1] == 0xFE && bytes[2] == 0x00 && bytes[3] == 0x00)
+            return Encoding::UTF32_LE;
+        if (count >= 4 && bytes[0] == 0x00 && bytes[1] == 0x00 && bytes[2] == 0xFE && bytes[3] == 0xFF)
+            return Encoding::UTF32_BE;
+        if (count >= 2 && bytes[0] == 0xFE && bytes[1] == 0xFF)
+            return Encoding::UTF16_BE;
+        if (count >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE)
+            return Encoding::UTF16_LE;
+        return Encoding::UTF8;
+    }
 
-        switch (encoding)
+    /*!
+     * @brief Converts str to UTF-16 and appends it.
+     * @details UTF-8 is transcoded and validated in a single pass into a buffer sized once up front, as no UTF-8 byte
+     * yields more than one unit. Input that is not well-formed UTF-8 is widened byte by byte as Latin-1.
+     * @param str The bytes to convert.
+     * @param len_in Number of bytes, or -1 if str is null-terminated.
+     */
+    void append_encoded(const char *str, ssize_type len_in)
+    {
+        size_type true_len = len_in == -1 ? strlen(str) : static_cast<size_type>(len_in);
+        switch (detect_encoding(str, true_len))
         {
-        case Encoding::ASCII:
-            for (ssize_type i = 0; i < len_in; ++i)
+        case Encoding::UTF8: {
+            size_type start = size();
+            ensure_capacity(start + true_len);
+            data_type *units = buffer() + start;
+            size_type written = utf::utf8_to_utf16(str, true_len, units);
+            if (written == utf::invalid)
             {
-                ptr[len++] = static_cast<data_type>(str[i]);
+                utf::latin1_to_utf16(str, true_len, units);
+                written = true_len;
             }
+            set_length(start + written);
             break;
-
-        case Encoding::UTF8:
-            convert_utf8_to_utf16(str, true_len);
-            break;
+        }
 
         case Encoding::UTF16_LE:
             convert_utf16le_to_utf16(str, true_len);
@@ -1056,149 +1225,74 @@ class [[nodiscard]] string final
         }
     }
 
-    void convert_utf8_to_utf16(const char *str, size_type len_in)
-    {
-        size_type utf16_index = 0;
-        for (size_type i = 0; i < len_in;)
-        {
-            unsigned char first_byte = static_cast<unsigned char>(str[i]);
-
-            if (first_byte < 0x80)
-            {
-                ensure_capacity(utf16_index + 1);
-                ptr[utf16_index++] = first_byte;
-                i++;
-            }
-            else if ((first_byte & 0xE0) == 0xC0)
-            {
-                if (i + 1 >= len_in)
-                    throw std::runtime_error("Incomplete UTF-8 sequence");
-
-                unsigned char second_byte = static_cast<unsigned char>(str[i + 1]);
-                if ((second_byte & 0xC0) != 0x80)
-                    throw std::runtime_error("Invalid UTF-8 sequence");
-
-                unsigned int code_point = (static_cast<unsigned int>(first_byte) & 0x1F) << 6 |
-                                          (static_cast<unsigned int>(second_byte) & 0x3F);
-                ensure_capacity(utf16_index + 1);
-                ptr[utf16_index++] = static_cast<data_type>(code_point);
-                i += 2;
-            }
-
-            else if ((first_byte & 0xF0) == 0xE0)
-            {
-                if (i + 2 >= len_in)
-                    throw std::runtime_error("Incomplete UTF-8 sequence");
-
-                unsigned char second_byte = static_cast<unsigned char>(str[i + 1]);
-                unsigned char third_byte = static_cast<unsigned char>(str[i + 2]);
-
-                if ((second_byte & 0xC0) != 0x80 || (third_byte & 0xC0) != 0x80)
-                    throw std::runtime_error("Invalid UTF-8 sequence");
-
-                unsigned int code_point = ((static_cast<unsigned int>(first_byte) & 0x0F) << 12) |
-                                          ((static_cast<unsigned int>(second_byte) & 0x3F) << 6) |
-                                          (static_cast<unsigned int>(third_byte) & 0x3F);
-                ensure_capacity(utf16_index + 1);
-                ptr[utf16_index++] = static_cast<data_type>(code_point);
-                i += 3;
-            }
-
-            else if ((first_byte & 0xF8) == 0xF0)
-            {
-                if (i + 3 >= len_in)
-                    throw std::runtime_error("Incomplete UTF-8 sequence");
-
-                unsigned char second_byte = static_cast<unsigned char>(str[i + 1]);
-                unsigned char third_byte = static_cast<unsigned char>(str[i + 2]);
-                unsigned char fourth_byte = static_cast<unsigned char>(str[i + 3]);
-
-                if ((second_byte & 0xC0) != 0x80 || (third_byte & 0xC0) != 0x80 || (fourth_byte & 0xC0) != 0x80)
-                    throw std::runtime_error("Invalid UTF-8 sequence");
-
-                unsigned int code_point = ((static_cast<unsigned int>(first_byte) & 0x07) << 18) | ((static_cast<unsigned int>(second_byte) & 0x3F) << 12) |
-                                          ((static_cast<unsigned int>(third_byte) & 0x3F) << 6) | (static_cast<unsigned int>(fourth_byte) & 0x3F);
-
-                code_point -= 0x10000;
-                ensure_capacity(utf16_index + 2);
-                ptr[utf16_index++] = static_cast<data_type>(0xD800 | ((code_point >> 10) & 0x3FF));
-                ptr[utf16_index++] = static_cast<data_type>(0xDC00 | (code_point & 0x3FF));
-
-                i += 4;
-            }
-            else
-            {
-                throw std::runtime_error("Invalid UTF-8 start byte");
-            }
-        }
-
-        len = utf16_index;
-    }
-
     void convert_utf16le_to_utf16(const char *str, size_type len_in)
     {
-        ensure_capacity(len_in / 2);
-        len = 0;
+        size_type start = size();
+        ensure_capacity(start + len_in / 2);
+        data_type *units = buffer() + start;
+        size_type count = 0;
 
         for (size_type i = 0; i < len_in; i += 2)
         {
             udata_type code_unit = (static_cast<unsigned char>(str[i + 1]) << 8) | static_cast<unsigned char>(str[i]);
 
-            ensure_capacity(len + 1);
-            ptr[len++] = static_cast<data_type>(code_unit);
+            units[count++] = static_cast<data_type>(code_unit);
 
             if (code_unit >= 0xD800 && code_unit <= 0xDBFF)
             {
                 if (i + 2 >= len_in)
-                    throw std::runtime_error("Incomplete surrogate pair");
+                    STD_THROW(std::runtime_error("Incomplete surrogate pair"));
 
                 udata_type low_surrogate =
                     (static_cast<unsigned char>(str[i + 3]) << 8) | static_cast<unsigned char>(str[i + 2]);
 
                 if (low_surrogate < 0xDC00 || low_surrogate > 0xDFFF)
-                    throw std::runtime_error("Invalid low surrogate");
+                    STD_THROW(std::runtime_error("Invalid low surrogate"));
 
-                ensure_capacity(len + 1);
-                ptr[len++] = static_cast<data_type>(low_surrogate);
+                units[count++] = static_cast<data_type>(low_surrogate);
                 i += 2;
             }
         }
+        set_length(start + count);
     }
 
     void convert_utf16be_to_utf16(const char *str, size_type len_in)
     {
-        ensure_capacity(len_in / 2);
-        len = 0;
+        size_type start = size();
+        ensure_capacity(start + len_in / 2);
+        data_type *units = buffer() + start;
+        size_type count = 0;
 
         for (size_type i = 0; i < len_in; i += 2)
         {
             udata_type code_unit = (static_cast<unsigned char>(str[i]) << 8) | static_cast<unsigned char>(str[i + 1]);
 
-            ensure_capacity(len + 1);
-            ptr[len++] = static_cast<data_type>(code_unit);
+            units[count++] = static_cast<data_type>(code_unit);
 
             if (code_unit >= 0xD800 && code_unit <= 0xDBFF)
             {
                 if (i + 2 >= len_in)
-                    throw std::runtime_error("Incomplete surrogate pair");
+                    STD_THROW(std::runtime_error("Incomplete surrogate pair"));
 
                 udata_type low_surrogate =
                     (static_cast<unsigned char>(str[i + 2]) << 8) | static_cast<unsigned char>(str[i + 3]);
 
                 if (low_surrogate < 0xDC00 || low_surrogate > 0xDFFF)
-                    throw std::runtime_error("Invalid low surrogate");
+                    STD_THROW(std::runtime_error("Invalid low surrogate"));
 
-                ensure_capacity(len + 1);
-                ptr[len++] = static_cast<data_type>(low_surrogate);
+                units[count++] = static_cast<data_type>(low_surrogate);
                 i += 2;
             }
         }
+        set_length(start + count);
     }
 
     void convert_utf32le_to_utf16(const char *str, size_type len_in)
     {
-        ensure_capacity(len_in / 4 * 2);
-        len = 0;
+        size_type start = size();
+        ensure_capacity(start + len_in / 4 * 2);
+        data_type *units = buffer() + start;
+        size_type count = 0;
 
         for (size_type i = 0; i < len_in; i += 4)
         {
@@ -1208,26 +1302,27 @@ class [[nodiscard]] string final
 
             if (code_point <= 0xFFFF)
             {
-                ensure_capacity(len + 1);
-                ptr[len++] = static_cast<data_type>(code_point);
+                units[count++] = static_cast<data_type>(code_point);
                 continue;
             }
             else if (code_point <= 0x10FFFF)
             {
                 code_point -= 0x10000;
-                ensure_capacity(len + 2);
-                ptr[len++] = static_cast<data_type>(0xD800 | ((code_point >> 10) & 0x3FF));
-                ptr[len++] = static_cast<data_type>(0xDC00 | (code_point & 0x3FF));
+                units[count++] = static_cast<data_type>(0xD800 | ((code_point >> 10) & 0x3FF));
+                units[count++] = static_cast<data_type>(0xDC00 | (code_point & 0x3FF));
                 continue;
             }
-            throw std::runtime_error("Invalid Unicode code point");
+            STD_THROW(std::runtime_error("Invalid Unicode code point"));
         }
+        set_length(start + count);
     }
 
     void convert_utf32be_to_utf16(const char *str, size_type len_in)
     {
-        ensure_capacity(len_in / 4 * 2);
-        len = 0;
+        size_type start = size();
+        ensure_capacity(start + len_in / 4 * 2);
+        data_type *units = buffer() + start;
+        size_type count = 0;
 
         for (size_type i = 0; i < len_in; i += 4)
         {
@@ -1237,42 +1332,134 @@ class [[nodiscard]] string final
 
             if (code_point <= 0xFFFF)
             {
-                ensure_capacity(len + 1);
-                ptr[len++] = static_cast<data_type>(code_point);
+                units[count++] = static_cast<data_type>(code_point);
             }
             else if (code_point <= 0x10FFFF)
             {
                 code_point -= 0x10000;
-                ensure_capacity(len + 2);
-                ptr[len++] = static_cast<data_type>(0xD800 | ((code_point >> 10) & 0x3FF));
-                ptr[len++] = static_cast<data_type>(0xDC00 | (code_point & 0x3FF));
+                units[count++] = static_cast<data_type>(0xD800 | ((code_point >> 10) & 0x3FF));
+                units[count++] = static_cast<data_type>(0xDC00 | (code_point & 0x3FF));
             }
             else
             {
-                throw std::runtime_error("Invalid Unicode code point");
+                STD_THROW(std::runtime_error("Invalid Unicode code point"));
             }
         }
+        set_length(start + count);
     }
 
-    void ensure_capacity(size_type new__str_capacity)
+    //! ASCII needles up to this many bytes are widened on the stack rather than converted into a string.
+    static constexpr size_type stack_needle_units = 64;
+
+    /*!
+     * @brief Calls function with str as UTF-16 units.
+     * @details Short ASCII input, the common case for literals, is widened into a stack buffer; anything else goes
+     * through the full conversion into a temporary string.
+     */
+    template<typename Function> auto with_units(u8string_view str, Function &&function) const
     {
-        if (new__str_capacity > _str_capacity)
+        if (str.size() <= stack_needle_units)
         {
-            size_type new_cap = (_str_capacity == 0) ? 8 : _str_capacity * 2;
-            if (new_cap < new__str_capacity)
+            data_type units[stack_needle_units];
+            bool ascii = true;
+            for (size_type i = 0; i < str.size(); ++i)
             {
-                new_cap = new__str_capacity;
+                unsigned char byte = static_cast<unsigned char>(str[i]);
+                ascii = ascii && byte < 0x80;
+                units[i] = static_cast<data_type>(byte);
             }
-            data_type *new_ptr = new data_type[new_cap];
-            if (ptr != nullptr && len > 0)
+            if (ascii)
             {
-                memcpy(new_ptr, ptr, len * sizeof(data_type));
+                return function(string_view(units, str.size()));
+            }
+        }
+        basic_string converted(str.data(), static_cast<ssize_type>(str.size()), _alloc);
+        return function(converted.view());
+    }
+
+    /*!
+     * @brief Moves the string to a heap buffer of at least required units, grown as the growth policy decides.
+     */
+    void ensure_capacity(size_type required)
+    {
+        size_type current = capacity();
+        if (required <= current)
+        {
+            return;
+        }
+        reallocate(Growth::grow(current, required, sizeof(data_type)));
+    }
+
+    /*!
+     * @brief Moves the string to a heap buffer of exactly new_capacity units, which must hold size() of them.
+     * @details A heap buffer is first offered to the allocator to extend in place or to realloc, which is safe as the
+     * units are trivially relocatable.
+     */
+    void reallocate(size_type new_capacity)
+    {
+        STD_TRACE_SCOPE_VALUE("string reallocate", new_capacity * sizeof(data_type));
+        size_type count = size();
+        if (is_heap() && count > 0)
+        {
+            data_type *current = _rep.heap.ptr;
+            size_type current_capacity = capacity();
+            if (new_capacity > current_capacity &&
+                std::allocator_traits<Allocator>::try_expand(_alloc, current, current_capacity, new_capacity))
+            {
+                std::detail::alloc_note_growth(count * sizeof(data_type), current_capacity * sizeof(data_type),
+                                               new_capacity * sizeof(data_type), true);
+                set_heap(current, count, new_capacity);
+                return;
+            }
+            data_type *resized =
+                std::allocator_traits<Allocator>::reallocate(_alloc, current, current_capacity, new_capacity);
+            if (resized != nullptr)
+            {
+                std::detail::alloc_note_growth(count * sizeof(data_type), current_capacity * sizeof(data_type),
+                                               new_capacity * sizeof(data_type), false);
+                set_heap(resized, count, new_capacity);
+                return;
             }
-            delete[] ptr;
-            ptr = new_ptr;
-            _str_capacity = new_cap;
         }
+        std::detail::alloc_note_growth(count * sizeof(data_type), capacity() * sizeof(data_type),
+                                       new_capacity * sizeof(data_type), false);
+        data_type *block = allocate(new_capacity);
+        memcpy(block, buffer(), count * sizeof(data_type));
+        release_heap();
+        set_heap(block, count, new_capacity);
     }
 };
+
+/*!
+ * @brief The UTF-16 string using the default allocator.
+ */
+using string = basic_string<>;
+
+/*!
+ * @brief A string owns its heap buffer through a plain pointer and its inline buffer holds no address, so relocating
+ * it is a memcpy of the object as long as its allocator can be relocated the same way.
+ */
+template<typename Allocator, typename Growth>
+struct is_trivially_relocatable<basic_string<Allocator, Growth>>
+    : integral_constant<bool, is_trivially_relocatable_v<Allocator>>
+{
+};
+
+/*!
+ * @brief Hashes a string as the string_view of its units
+ * @details Transparent, so a hash container keyed by string finds a string_view without building a string from it.
+ */
+template<typename Allocator, typename Growth> struct hash<basic_string<Allocator, Growth>> : hash<string_view>
+{
+    using is_transparent = void;
+};
+
+namespace pmr
+{
+/*!
+ * @brief A string that allocates from a memory_resource.
+ */
+using string = std::basic_string<polymorphic_allocator<short>>;
+} // namespace pmr
 } // namespace std
 #endif
@@ -0,0 +1,326 @@
+/*!
+ * @file string_builder.h
+ * @brief Building a string from many pieces with a single allocation
+ * @namespace std
+ * @details Concatenating with operator+ allocates and copies once per step. A string_builder instead records the
+ * pieces, sums their lengths when build() is called, reserves the result once and copies every piece into it a
+ * single time. concat() does the same for a fixed list of pieces without recording them.
+ *
+ * Pieces can be UTF-8 text (const char * or u8string_view, converted like the string constructor converts them),
+ * strings and string views, single characters and integers, which are formatted in decimal. The length of UTF-8 text
+ * is counted as its byte count, an upper bound of its UTF-16 length that is exact for ASCII.
+ *
+ * The builder refers to text pieces without copying them, so they must outlive the call to build(). Temporary strings
+ * are rejected for that reason; concat() takes them, as all its pieces live until it returns.
+ */
+#ifndef STRING_BUILDER_H
+#define STRING_BUILDER_H
+#include <charconv.h>
+#include <memory.h>
+#include <small_vector.h>
+#include <stddef.h>
+#include <string.h>
+#include <string_view.h>
+#include <type_traits.h>
+
+namespace std
+{
+namespace detail
+{
+//! Longest decimal form of a 64-bit integer, including a minus sign.
+inline constexpr std::size_t max_decimal_length = 20;
+
+//! Integers other than the character types, which the builders append as characters.
+template<typename T>
+concept formattable_integer = is_integral_v<T> && !is_same_v<remove_cv_t<T>, bool> &&
+                              !is_same_v<remove_cv_t<T>, char> && !is_same_v<remove_cv_t<T>, short>;
+
+//! Number of characters format_integer() writes for value.
+template<formattable_integer T> std::size_t integer_length(T value) noexcept
+{
+    if (value < T(0))
+    {
+        return 1 + decimal_length(0ull - static_cast<unsigned long long>(value));
+    }
+    return decimal_length(static_cast<unsigned long long>(value));
+}
+
+/*!
+ * @brief Writes value in decimal to dst
+ * @return The number of characters written, at most max_decimal_length
+ */
+template<formattable_integer T> std::size_t format_integer(char *dst, T value) noexcept
+{
+    return static_cast<std::size_t>(to_chars(dst, dst + max_decimal_length, value).ptr - dst);
+}
+
+/*!
+ * @brief One recorded piece of a string_builder
+ */
+struct string_piece
+{
+    enum class kind : unsigned char
+    {
+        utf8,
+        units,
+        unit,
+        number
+    };
+
+    kind type;
+    std::size_t size; //!< Bytes for utf8 and number pieces, units otherwise.
+    union {
+        const char *bytes;
+        const short *units;
+        short unit;
+        char digits[max_decimal_length];
+    };
+};
+
+/*
+ * Length bounds and appenders for each kind of piece, shared by string_builder and concat().
+ */
+inline std::size_t piece_length(const char *str) noexcept
+{
+    return strlen(str);
+}
+
+inline std::size_t piece_length(u8string_view bytes) noexcept
+{
+    return bytes.size();
+}
+
+inline std::size_t piece_length(string_view units) noexcept
+{
+    return units.size();
+}
+
+template<typename Allocator, typename Growth>
+std::size_t piece_length(const basic_string<Allocator, Growth> &str) noexcept
+{
+    return str.size();
+}
+
+inline std::size_t piece_length(char) noexcept
+{
+    return 1;
+}
+
+inline std::size_t piece_length(short) noexcept
+{
+    return 1;
+}
+
+template<formattable_integer T> std::size_t piece_length(T value) noexcept
+{
+    return integer_length(value);
+}
+
+template<typename String> void append_piece(String &out, const char *str)
+{
+    out.append(str);
+}
+
+template<typename String> void append_piece(String &out, u8string_view bytes)
+{
+    out.append(bytes.data(), bytes.size());
+}
+
+template<typename String> void append_piece(String &out, string_view units)
+{
+    out.append(units);
+}
+
+template<typename String, typename Allocator, typename Growth>
+void append_piece(String &out, const basic_string<Allocator, Growth> &str)
+{
+    out.append(str.view());
+}
+
+template<typename String> void append_piece(String &out, char ch)
+{
+    out.append(&ch, 1);
+}
+
+template<typename String> void append_piece(String &out, short unit)
+{
+    out.push_back(unit);
+}
+
+template<typename String, formattable_integer T> void append_piece(String &out, T value)
+{
+    char digits[max_decimal_length];
+    out.append(digits, format_integer(digits, value));
+}
+} // namespace detail
+
+/*!
+ * @brief Collects pieces of text and joins them into a string with one allocation
+ * @tparam Allocator Allocator of the strings build() returns
+ */
+template<typename Allocator = std::allocator<short>> class basic_string_builder
+{
+  public:
+    using string_type = basic_string<Allocator>;
+    using size_type = std::size_t;
+
+    basic_string_builder() = default;
+
+    explicit basic_string_builder(const Allocator &alloc)
+        : _alloc(alloc)
+    {
+    }
+
+    //! Null-terminated UTF-8; its length is taken now.
+    basic_string_builder &append(const char *str)
+    {
+        return append(u8string_view(str));
+    }
+
+    basic_string_builder &append(u8string_view bytes)
+    {
+        detail::string_piece &piece = add(detail::string_piece::kind::utf8, bytes.size());
+        piece.bytes = bytes.data();
+        return *this;
+    }
+
+    basic_string_builder &append(string_view units)
+    {
+        detail::string_piece &piece = add(detail::string_piece::kind::units, units.size());
+        piece.units = units.data();
+        return *this;
+    }
+
+    template<typename StringAllocator, typename Growth>
+    basic_string_builder &append(const basic_string<StringAllocator, Growth> &str)
+    {
+        return append(str.view());
+    }
+
+    //! A temporary would be gone before build() reads it.
+    template<typename StringAllocator, typename Growth>
+    basic_string_builder &append(basic_string<StringAllocator, Growth> &&) = delete;
+
+    //! A character of UTF-8 text; bytes above 0x7F are taken as Latin-1, like invalid UTF-8 in the constructor.
+    basic_string_builder &append(char ch)
+    {
+        detail::string_piece &piece = add(detail::string_piece::kind::unit, 1);
+        piece.unit = static_cast<short>(static_cast<unsigned char>(ch));
+        return *this;
+    }
+
+    //! A UTF-16 code unit, the element type of std::string.
+    basic_string_builder &append(short unit)
+    {
+        detail::string_piece &piece = add(detail::string_piece::kind::unit, 1);
+        piece.unit = unit;
+        return *this;
+    }
+
+    //! An integer in decimal; it is formatted now, so it need not outlive the builder.
+    template<detail::formattable_integer T> basic_string_builder &append(T value)
+    {
+        detail::string_piece &piece = add(detail::string_piece::kind::number, 0);
+        piece.size = detail::format_integer(piece.digits, value);
+        _length += piece.size;
+        return *this;
+    }
+
+    template<typename Piece>
+    basic_string_builder &operator<<(Piece &&piece)
+        requires requires(basic_string_builder &builder) { builder.append(std::forward<Piece>(piece)); }
+    {
+        return append(std::forward<Piece>(piece));
+    }
+
+    /*!
+     * @brief Upper bound of the length of the built string, in UTF-16 units
+     */
+    size_type length_bound() const noexcept
+    {
+        return _length;
+    }
+
+    size_type piece_count() const noexcept
+    {
+        return _pieces.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return _pieces.empty();
+    }
+
+    void clear() noexcept
+    {
+        _pieces.clear();
+        _length = 0;
+    }
+
+    /*!
+     * @brief Joins the pieces into a string allocated once at length_bound() units
+     */
+    string_type build() const
+    {
+        string_type result(_alloc);
+        result.reserve(_length);
+        for (const detail::string_piece &piece : _pieces)
+        {
+            switch (piece.type)
+            {
+            case detail::string_piece::kind::utf8:
+                result.append(piece.bytes, piece.size);
+                break;
+            case detail::string_piece::kind::units:
+                result.append(string_view(piece.units, piece.size));
+                break;
+            case detail::string_piece::kind::unit:
+                result.push_back(piece.unit);
+                break;
+            case detail::string_piece::kind::number:
+                result.append(piece.digits, piece.size);
+                break;
+            }
+        }
+        return result;
+    }
+
+    operator string_type() const
+    {
+        return build();
+    }
+
+  private:
+    //! Pieces recorded inline before the list moves to the heap.
+    static constexpr size_type inline_pieces = 16;
+
+    small_vector<detail::string_piece, inline_pieces> _pieces;
+    size_type _length = 0;
+    STD_NO_UNIQUE_ADDRESS Allocator _alloc{};
+
+    detail::string_piece &add(detail::string_piece::kind type, size_type size)
+    {
+        _pieces.emplace_back();
+        detail::string_piece &piece = _pieces.back();
+        piece.type = type;
+        piece.size = size;
+        _length += size;
+        return piece;
+    }
+};
+
+using string_builder = basic_string_builder<>;
+
+/*!
+ * @brief Joins pieces into a string with one allocation
+ * @details Takes the same pieces as string_builder::append(), including temporary strings.
+ */
+template<typename... Pieces> string concat(const Pieces &...pieces)
+{
+    string result;
+    result.reserve((std::size_t(0) + ... + detail::piece_length(pieces)));
+    (detail::append_piece(result, pieces), ...);
+    return result;
+}
+} // namespace std
+#endif
@@ -0,0 +1,295 @@
+/*!
+ * @file string_view.h
+ * @brief Non-owning views over a string's UTF-16 units and over raw UTF-8 bytes
+ * @namespace std
+ * @note This header is a part of the C++ standard library.
+ * Modeled after https://en.cppreference.com/w/cpp/string/basic_string_view. A view is a pointer and a length; slicing,
+ * comparing and searching through one never allocates. std::string converts to a string_view implicitly, a
+ * throw_away_string through view().
+ */
+#ifndef STRING_VIEW_H
+#define STRING_VIEW_H
+#include <algorithm.h>
+#include <bounds_check.h>
+#include <functional.h>
+#include <iterator.h>
+#include <search.h>
+#include <stddef.h>
+#include <stdexcept.h>
+
+namespace std
+{
+/*!
+ * @brief A read-only view of count contiguous code units
+ * @details The view does not own its units, which must outlive it, and they need not be null-terminated.
+ * @tparam T The code unit type, short for UTF-16 and char for UTF-8
+ */
+template<typename T> class basic_string_view
+{
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using const_type = const T *;
+    using iterator = const T *;
+    using const_iterator = const T *;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    constexpr basic_string_view() noexcept = default;
+    constexpr basic_string_view(const basic_string_view &) noexcept = default;
+    constexpr basic_string_view &operator=(const basic_string_view &) noexcept = default;
+
+    /*!
+     * @brief Views a null-terminated sequence of units, not including the terminator
+     */
+    constexpr basic_string_view(const_type str) noexcept
+        : _data(str)
+    {
+        while (str[_size] != 0)
+        {
+            ++_size;
+        }
+    }
+
+    constexpr basic_string_view(const_type str, size_type count) noexcept
+        : _data(str)
+        , _size(count)
+    {
+    }
+
+    constexpr const_iterator begin() const noexcept
+    {
+        return _data;
+    }
+
+    constexpr const_iterator end() const noexcept
+    {
+        return _data + _size;
+    }
+
+    constexpr const_reverse_iterator rbegin() const noexcept
+    {
+        return const_reverse_iterator(end());
+    }
+
+    constexpr const_reverse_iterator rend() const noexcept
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    constexpr const_type data() const noexcept
+    {
+        return _data;
+    }
+
+    constexpr size_type size() const noexcept
+    {
+        return _size;
+    }
+
+    constexpr size_type length() const noexcept
+    {
+        return _size;
+    }
+
+    constexpr bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    constexpr T operator[](size_type index) const noexcept
+    {
+        return _data[index];
+    }
+
+    //! Fails as STD_BOUNDS_CHECK says if index is out of range, see bounds_check.h.
+    constexpr T at(size_type index) const noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(index < _size);
+        return _data[index];
+    }
+
+    constexpr T front() const noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(_size != 0);
+        return _data[0];
+    }
+
+    constexpr T back() const noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(_size != 0);
+        return _data[_size - 1];
+    }
+
+    constexpr void remove_prefix(size_type count) noexcept
+    {
+        _data += count;
+        _size -= count;
+    }
+
+    constexpr void remove_suffix(size_type count) noexcept
+    {
+        _size -= count;
+    }
+
+    /*!
+     * @brief Returns the view of at most count units starting at pos
+     * @throws std::out_of_range if pos > size()
+     */
+    constexpr basic_string_view substr(size_type pos, size_type count = npos) const
+    {
+        if (pos > _size)
+        {
+            STD_THROW(std::out_of_range());
+        }
+        return basic_string_view(_data + pos, min(count, _size - pos));
+    }
+
+    /*!
+     * @brief Compares the units lexicographically
+     * @return Negative, zero or positive as this view orders before, equal to or after other
+     */
+    constexpr int compare(basic_string_view other) const noexcept
+    {
+        size_type common = min(_size, other._size);
+        for (size_type i = 0; i < common; ++i)
+        {
+            if (_data[i] != other._data[i])
+            {
+                return _data[i] < other._data[i] ? -1 : 1;
+            }
+        }
+        return _size == other._size ? 0 : (_size < other._size ? -1 : 1);
+    }
+
+    constexpr bool starts_with(basic_string_view prefix) const noexcept
+    {
+        return _size >= prefix._size && equal_units(_data, prefix._data, prefix._size);
+    }
+
+    constexpr bool ends_with(basic_string_view suffix) const noexcept
+    {
+        return _size >= suffix._size && equal_units(_data + _size - suffix._size, suffix._data, suffix._size);
+    }
+
+    bool contains(basic_string_view needle) const noexcept
+    {
+        return find(needle) != npos;
+    }
+
+    /*!
+     * @brief Finds the first occurrence of needle at or after pos
+     * @details The algorithm is picked by needle length, see search.h.
+     * @return The index of the match or npos
+     */
+    size_type find(basic_string_view needle, size_type pos = 0) const noexcept
+    {
+        return detail::search_forward(_data, _size, needle._data, needle._size, pos);
+    }
+
+    size_type find(T unit, size_type pos = 0) const noexcept
+    {
+        return detail::search_unit(_data, _size, unit, pos);
+    }
+
+    /*!
+     * @brief Finds the last occurrence of needle that starts at or before pos
+     * @return The index of the match or npos
+     */
+    size_type rfind(basic_string_view needle, size_type pos = npos) const noexcept
+    {
+        return detail::search_backward(_data, _size, needle._data, needle._size, pos);
+    }
+
+    /*!
+     * @brief Finds the first unit at or after pos that is one of the units in set
+     */
+    size_type find_first_of(basic_string_view set, size_type pos = 0) const noexcept
+    {
+        return detail::search_first_of(_data, _size, set._data, set._size, pos);
+    }
+
+    /*!
+     * @brief Finds the last unit at or before pos that is one of the units in set
+     */
+    size_type find_last_of(basic_string_view set, size_type pos = npos) const noexcept
+    {
+        return detail::search_last_of(_data, _size, set._data, set._size, pos);
+    }
+
+    constexpr bool operator==(basic_string_view other) const noexcept
+    {
+        return _size == other._size && equal_units(_data, other._data, _size);
+    }
+
+    constexpr bool operator!=(basic_string_view other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+    constexpr bool operator<(basic_string_view other) const noexcept
+    {
+        return compare(other) < 0;
+    }
+
+    constexpr bool operator<=(basic_string_view other) const noexcept
+    {
+        return compare(other) <= 0;
+    }
+
+    constexpr bool operator>(basic_string_view other) const noexcept
+    {
+        return compare(other) > 0;
+    }
+
+    constexpr bool operator>=(basic_string_view other) const noexcept
+    {
+        return compare(other) >= 0;
+    }
+
+  private:
+    const_type _data = nullptr; //!< First viewed unit.
+    size_type _size = 0;        //!< Number of viewed units.
+
+    static constexpr bool equal_units(const_type a, const_type b, size_type count) noexcept
+    {
+        if (__builtin_is_constant_evaluated())
+        {
+            for (size_type i = 0; i < count; ++i)
+            {
+                if (a[i] != b[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+        return count == 0 || memcmp(a, b, count * sizeof(T)) == 0;
+    }
+};
+
+/*!
+ * @brief A view of the UTF-16 units of a std::string
+ */
+using string_view = basic_string_view<short>;
+
+/*!
+ * @brief A view of raw UTF-8 (or ASCII) bytes, such as a literal or a throw_away_string
+ */
+using u8string_view = basic_string_view<char>;
+
+/*!
+ * @brief Hashes the code units of a view; std::string hashes the same way, see string.h
+ * @details The result is already well mixed, which is_avalanching tells the hash containers.
+ */
+template<typename T> struct hash<basic_string_view<T>>
+{
+    using is_avalanching = void;
+
+    std::size_t operator()(basic_string_view<T> view) const noexcept
+    {
+        return detail::hash_bytes(view.data(), view.size() * sizeof(T));
+    }
+};
+} // namespace std
+#endif
@@ -0,0 +1,570 @@
+/*!
+ * @file task.h
+ * @brief Coroutine tasks and the work-stealing scheduler that runs them
+ * @namespace std
+ * @details A task<T, E> is a coroutine that finishes with an Expected<T, E>: co_return a T for success or
+ * std::unexpected(error) for failure, so errors reach the awaiting coroutine as values and need no exceptions. A
+ * task<void, E> returns Expected<monostate, E> and succeeds with co_return {};. Tasks are lazy: co_await starts one
+ * on the current thread and resumes the awaiting coroutine when it finishes, with no allocation beyond its frame.
+ *
+ * A task_scheduler runs tasks on worker threads started through the os:: hooks of thread.h. Each worker owns a
+ * Chase-Lev deque (see work_stealing_deque in concurrent_queue.h) that coroutines resumed on it are pushed to and
+ * popped from in LIFO order; idle workers steal the oldest entries of the others, and threads that are not workers
+ * submit through a bounded mpmc_queue. Three operations put work on it:
+ *
+ * - co_await scheduler.schedule() suspends the calling coroutine and resumes it on a worker.
+ * - scheduler.spawn(task) starts a task on the pool and returns it; co_await on it later for the result, which makes
+ *   fork-join parallelism a spawn() followed by a co_await.
+ * - scheduler.block_on(task) runs a task from ordinary code and waits for its result, running queued work on the
+ *   calling thread meanwhile. It is the way into the pool from main(), and the only one without STD_HAS_OS_THREADS,
+ *   where the scheduler has no workers and everything runs inside block_on().
+ *
+ * Coroutine frames come from the memory pool when STD_ENABLE_MEMORY_POOL is defined, so spawning a task costs a
+ * pointer pop from the thread cache rather than a trip to the os:: hooks.
+ *
+ * A task must not be destroyed while it runs: await every spawned task or block_on() it, and finish all of them
+ * before the scheduler is destroyed, which stops its workers without running what is still queued. An exception
+ * leaving a task stops the program, as for the parallel algorithms.
+ */
+#ifndef TASK_H
+#define TASK_H
+#include <atomic.h>
+#include <concurrent_queue.h>
+#include <coroutine.h>
+#include <expected.h>
+#include <new.h>
+#include <stddef.h>
+#include <stdexcept.h>
+#include <thread.h>
+#include <type_traits.h>
+#include <utility.h>
+
+namespace std
+{
+class task_scheduler;
+
+namespace detail
+{
+//! Allocates a coroutine frame, from the pool's size classes when it is on.
+inline void *allocate_frame(std::size_t size)
+{
+#if defined(STD_ENABLE_MEMORY_POOL) && !defined(STD_ENABLE_ALLOC_STATS)
+    return std::memory_pool::allocate(size);
+#else
+    // With the stats layer on the frame goes through it, and from there to the pool if that is on too
+    return ::operator new(size);
+#endif
+}
+
+inline void free_frame(void *frame, std::size_t size) noexcept
+{
+#if defined(STD_ENABLE_MEMORY_POOL) && !defined(STD_ENABLE_ALLOC_STATS)
+    (void)size;
+    std::memory_pool::deallocate(frame);
+#else
+    ::operator delete(frame, size);
+#endif
+}
+
+//! What a task's continuation is set to once it has finished; no coroutine frame has this address.
+inline char task_done_marker;
+
+template<typename T> struct task_value
+{
+    using type = T;
+};
+
+template<> struct task_value<void>
+{
+    using type = monostate;
+};
+} // namespace detail
+
+/*!
+ * @brief A lazily started coroutine that produces an Expected<T, E>
+ * @tparam T The value of a successful task, void for none
+ * @tparam E The error a failed task reports
+ */
+template<typename T, typename E> class [[nodiscard]] task
+{
+  public:
+    using value_type = T;
+    using error_type = E;
+    using result_type = Expected<typename detail::task_value<T>::type, E>;
+
+    class promise_type
+    {
+      public:
+        promise_type() noexcept = default;
+        promise_type(const promise_type &) = delete;
+        promise_type &operator=(const promise_type &) = delete;
+
+        ~promise_type()
+        {
+            if (_has_result)
+            {
+                result().~result_type();
+            }
+        }
+
+        task get_return_object() noexcept
+        {
+            return task(coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        auto final_suspend() const noexcept
+        {
+            return final_awaiter{};
+        }
+
+        //! Takes a T, std::unexpected(error) or, for task<void, E>, {}.
+        void return_value(result_type value)
+        {
+            std::construct_at(&result(), std::move(value));
+            _has_result = true;
+        }
+
+        void unhandled_exception() const noexcept
+        {
+            detail::fatal_error("an exception left a std::task");
+        }
+
+        static void *operator new(std::size_t size)
+        {
+            return detail::allocate_frame(size);
+        }
+
+        static void operator delete(void *frame, std::size_t size) noexcept
+        {
+            detail::free_frame(frame, size);
+        }
+
+      private:
+        friend class task;
+
+        //! The coroutine awaiting this one, nullptr if none is yet, or the done marker once this one finished.
+        atomic<void *> _continuation{nullptr};
+        bool _has_result = false;
+        alignas(result_type) unsigned char _storage[sizeof(result_type)];
+
+        result_type &result() noexcept
+        {
+            return *reinterpret_cast<result_type *>(_storage);
+        }
+    };
+
+    task(task &&other) noexcept
+        : _coroutine(other._coroutine)
+        , _started(other._started)
+    {
+        other._coroutine = nullptr;
+    }
+
+    task &operator=(task &&other) noexcept
+    {
+        if (this != &other)
+        {
+            release();
+            _coroutine = other._coroutine;
+            _started = other._started;
+            other._coroutine = nullptr;
+        }
+        return *this;
+    }
+
+    task(const task &) = delete;
+    task &operator=(const task &) = delete;
+
+    ~task()
+    {
+        release();
+    }
+
+    //! Whether the task has finished, so that co_await on it resumes at once.
+    bool ready() const noexcept
+    {
+        return _started && _coroutine.promise()._continuation.load(memory_order::acquire) == done_marker();
+    }
+
+    /*!
+     * @brief Starts the task if it has not started and resumes the awaiting coroutine with its result
+     * @details The result is moved out, so a task is awaited once.
+     */
+    auto operator co_await() & noexcept
+    {
+        return awaiter{this};
+    }
+
+    auto operator co_await() && noexcept
+    {
+        return awaiter{this};
+    }
+
+  private:
+    friend class task_scheduler;
+
+    coroutine_handle<promise_type> _coroutine;
+    bool _started = false;
+
+    explicit task(coroutine_handle<promise_type> coroutine) noexcept
+        : _coroutine(coroutine)
+    {
+    }
+
+    static void *done_marker() noexcept
+    {
+        return &detail::task_done_marker;
+    }
+
+    void release() noexcept
+    {
+        if (_coroutine)
+        {
+            _coroutine.destroy();
+            _coroutine = nullptr;
+        }
+    }
+
+    //! Marks the task started and returns the coroutine for the caller to resume or schedule.
+    coroutine_handle<> start() noexcept
+    {
+        _started = true;
+        return _coroutine;
+    }
+
+    result_type take_result()
+    {
+        return std::move(_coroutine.promise().result());
+    }
+
+    //! Resumes whoever awaits the finished task by symmetric transfer, or nothing if nobody does yet.
+    struct final_awaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        coroutine_handle<> await_suspend(coroutine_handle<promise_type> finished) const noexcept
+        {
+            void *waiting = finished.promise()._continuation.exchange(done_marker(), memory_order::acq_rel);
+            if (waiting == nullptr)
+            {
+                return noop_coroutine();
+            }
+            return coroutine_handle<>::from_address(waiting);
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    struct awaiter
+    {
+        task *awaited;
+
+        bool await_ready() const noexcept
+        {
+            return awaited->ready();
+        }
+
+        coroutine_handle<> await_suspend(coroutine_handle<> waiting) const noexcept
+        {
+            atomic<void *> &continuation = awaited->_coroutine.promise()._continuation;
+            if (!awaited->_started)
+            {
+                // Not running anywhere yet, so nothing races with setting the continuation
+                continuation.store(waiting.address(), memory_order::relaxed);
+                return awaited->start();
+            }
+            // Spawned: it may finish on another thread while the continuation is being set
+            void *expected = nullptr;
+            if (continuation.compare_exchange_strong(expected, waiting.address(), memory_order::acq_rel,
+                                                     memory_order::acquire))
+            {
+                return noop_coroutine();
+            }
+            return waiting;
+        }
+
+        result_type await_resume() const
+        {
+            return awaited->take_result();
+        }
+    };
+};
+
+/*!
+ * @brief A pool of worker threads that resume coroutines, balanced by work stealing
+ */
+class task_scheduler
+{
+  public:
+    using size_type = std::size_t;
+
+    //! Capacity of the queue that threads other than the workers submit through.
+    static constexpr size_type injection_capacity = 1024;
+
+    //! A worker for every hardware thread but the calling one, or none without STD_HAS_OS_THREADS.
+    task_scheduler()
+        : task_scheduler(default_worker_count())
+    {
+    }
+
+    /*!
+     * @brief Starts up to workers worker threads; without STD_HAS_OS_THREADS it starts none
+     */
+    explicit task_scheduler(size_type workers)
+        : _injected(injection_capacity)
+    {
+#if defined(STD_HAS_OS_THREADS)
+        if (workers == 0)
+        {
+            return;
+        }
+        // Sized before any thread starts, since the first workers steal while the rest are spawned
+        _workers = new worker[workers];
+        _worker_slots = workers;
+        for (size_type i = 0; i < workers; ++i)
+        {
+            _workers[i].owner = this;
+            _workers[i].next_victim = i + 1;
+            _workers[i].thread = os::thread_spawn(&worker_main, &_workers[i]);
+            if (_workers[i].thread == nullptr)
+            {
+                break;
+            }
+            ++_worker_count;
+        }
+#else
+        (void)workers;
+#endif
+    }
+
+    task_scheduler(const task_scheduler &) = delete;
+    task_scheduler &operator=(const task_scheduler &) = delete;
+
+    //! Stops and joins the workers; coroutines still queued are not resumed.
+    ~task_scheduler()
+    {
+#if defined(STD_HAS_OS_THREADS)
+        _stopping.store(true, memory_order::seq_cst);
+        atomic_ref<unsigned int>(_epoch).fetch_add(1, memory_order::seq_cst);
+        os::thread_wake_all(&_epoch);
+        for (size_type i = 0; i < _worker_count; ++i)
+        {
+            os::thread_join(_workers[i].thread);
+        }
+        delete[] _workers;
+#endif
+    }
+
+    size_type worker_count() const noexcept
+    {
+        return _worker_count;
+    }
+
+    /*!
+     * @brief Queues a suspended coroutine to be resumed by the pool
+     * @details A worker pushes onto its own deque; other threads go through the shared queue, and while it is full
+     * they run queued work themselves to make room.
+     */
+    void post(coroutine_handle<> coroutine)
+    {
+        worker *self = local_worker();
+        if (self != nullptr)
+        {
+            self->deque.push(coroutine.address());
+        }
+        else
+        {
+            while (!_injected.try_push(coroutine.address()))
+            {
+                if (!run_one())
+                {
+                    detail::cpu_relax();
+                }
+            }
+        }
+        wake();
+    }
+
+    /*!
+     * @brief Resumes one queued coroutine on the calling thread
+     * @return false if no work was found
+     */
+    bool run_one()
+    {
+        worker *self = local_worker();
+        void *frame = nullptr;
+        if ((self != nullptr && self->deque.pop(frame)) || _injected.try_pop(frame) || steal(self, frame))
+        {
+            coroutine_handle<>::from_address(frame).resume();
+            return true;
+        }
+        return false;
+    }
+
+    //! co_await schedule() moves the awaiting coroutine onto the pool.
+    auto schedule() noexcept
+    {
+        struct schedule_awaiter
+        {
+            task_scheduler *scheduler;
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            void await_suspend(coroutine_handle<> waiting) const
+            {
+                scheduler->post(waiting);
+            }
+
+            void await_resume() const noexcept
+            {
+            }
+        };
+        return schedule_awaiter{this};
+    }
+
+    /*!
+     * @brief Starts a task on the pool and gives it back, to be awaited for its result later
+     */
+    template<typename T, typename E> task<T, E> spawn(task<T, E> work)
+    {
+        if (!work._started)
+        {
+            post(work.start());
+        }
+        return work;
+    }
+
+    /*!
+     * @brief Runs a task on the pool and waits for its result, helping with queued work meanwhile
+     */
+    template<typename T, typename E> typename task<T, E>::result_type block_on(task<T, E> work)
+    {
+        task<T, E> running = spawn(std::move(work));
+        while (!running.ready())
+        {
+            if (!run_one())
+            {
+                detail::cpu_relax();
+            }
+        }
+        return running.take_result();
+    }
+
+  private:
+    struct worker
+    {
+        task_scheduler *owner = nullptr;
+        void *thread = nullptr;
+        size_type next_victim = 0; //!< Where the next steal attempt starts, rotated to spread the thieves.
+        work_stealing_deque<void *> deque;
+    };
+
+    //! Failed rounds of looking for work before a worker sleeps.
+    static constexpr unsigned int spin_before_wait = 256;
+
+    static inline thread_local worker *current_worker = nullptr;
+
+    worker *_workers = nullptr;
+    size_type _worker_slots = 0;
+    size_type _worker_count = 0; //!< Workers whose threads started, the first of the slots.
+    mpmc_queue<void *> _injected;
+    atomic<bool> _stopping{false};
+    atomic<unsigned int> _sleepers{0};
+    alignas(detail::cache_line_size) unsigned int _epoch = 0; //!< Bumped by every post; idle workers sleep on it.
+
+    static size_type default_worker_count() noexcept
+    {
+#if defined(STD_HAS_OS_THREADS)
+        unsigned int threads = os::thread_count();
+        return threads > 1 ? threads - 1 : 0;
+#else
+        return 0;
+#endif
+    }
+
+    worker *local_worker() const noexcept
+    {
+        return current_worker != nullptr && current_worker->owner == this ? current_worker : nullptr;
+    }
+
+    bool steal(worker *self, void *&frame) noexcept
+    {
+        size_type start = self != nullptr ? self->next_victim++ : 0;
+        for (size_type i = 0; i < _worker_slots; ++i)
+        {
+            worker &victim = _workers[(start + i) % _worker_slots];
+            if (&victim != self && victim.deque.steal(frame))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void wake() noexcept
+    {
+#if defined(STD_HAS_OS_THREADS)
+        atomic_ref<unsigned int>(_epoch).fetch_add(1, memory_order::seq_cst);
+        if (_sleepers.load(memory_order::seq_cst) != 0)
+        {
+            os::thread_wake_all(&_epoch);
+        }
+#endif
+    }
+
+#if defined(STD_HAS_OS_THREADS)
+    static void worker_main(void *argument)
+    {
+        worker *self = static_cast<worker *>(argument);
+        current_worker = self;
+        self->owner->work();
+        current_worker = nullptr;
+#    if defined(STD_ENABLE_MEMORY_POOL)
+        std::memory_pool::flush_thread_cache();
+#    endif
+    }
+
+    void work()
+    {
+        unsigned int idle = 0;
+        while (!_stopping.load(memory_order::relaxed))
+        {
+            if (run_one())
+            {
+                idle = 0;
+                continue;
+            }
+            if (++idle < spin_before_wait)
+            {
+                detail::cpu_relax();
+                continue;
+            }
+            // Announce the sleep before the last look, so a post either is seen here or sees the sleeper
+            _sleepers.fetch_add(1, memory_order::seq_cst);
+            unsigned int seen = atomic_ref<unsigned int>(_epoch).load(memory_order::seq_cst);
+            bool found = run_one();
+            if (!found && !_stopping.load(memory_order::seq_cst))
+            {
+                os::thread_wait(&_epoch, seen);
+            }
+            _sleepers.fetch_sub(1, memory_order::seq_cst);
+            idle = 0;
+        }
+    }
+#endif
+};
+} // namespace std
+#endif
@@ -0,0 +1,95 @@
+/*!
+ * @file thread.h
+ * @brief The os:: thread hooks the library runs its worker threads on
+ * @namespace os
+ * @details Like the allocation hooks in new.h, threads come from functions the program provides, so the library does
+ * not depend on any thread library. The hooks are only declared when STD_HAS_OS_THREADS is defined for the whole
+ * program, which the ENABLE_OS_THREADS CMake option does. Without them everything that would run on worker threads,
+ * such as the parallel algorithms in execution.h, runs on the calling thread instead.
+ *
+ * thread_wait() and thread_wake_all() are the futex-style primitive idle workers sleep on. A futex, WaitOnAddress or
+ * a mutex and condition variable shared by all addresses are all valid implementations.
+ */
+#ifndef THREAD_H
+#define THREAD_H
+#include <stddef.h>
+
+#if defined(STD_HAS_OS_THREADS)
+namespace os
+{
+    /*!
+     * @brief Starts a thread running entry(argument)
+     * @return A handle for thread_join(), or nullptr if no thread could be started
+     */
+    void *thread_spawn(void (*entry)(void *), void *argument);
+
+    /*!
+     * @brief Waits for a thread started by thread_spawn() to return and releases it
+     */
+    void thread_join(void *thread);
+
+    /*!
+     * @brief Returns the number of threads the hardware runs at once, at least 1
+     */
+    unsigned int thread_count();
+
+    /*!
+     * @brief Blocks the calling thread while *address equals expected
+     * @details May return early; callers re-check the value in a loop.
+     */
+    void thread_wait(unsigned int *address, unsigned int expected);
+
+    /*!
+     * @brief Wakes every thread blocked in thread_wait() on address
+     */
+    void thread_wake_all(unsigned int *address);
+} // namespace os
+#endif
+
+namespace std
+{
+namespace detail
+{
+/*!
+ * @brief Tells the core the caller is spinning, which frees resources for a sibling hyperthread
+ */
+inline void cpu_relax() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/*!
+ * @brief A test-and-set lock for critical sections of a few instructions
+ */
+struct spin_lock
+{
+    bool flag = false;
+
+    bool try_lock() noexcept
+    {
+        return !__atomic_test_and_set(&flag, __ATOMIC_ACQUIRE);
+    }
+
+    void lock() noexcept
+    {
+        while (__atomic_test_and_set(&flag, __ATOMIC_ACQUIRE))
+        {
+            while (__atomic_load_n(&flag, __ATOMIC_RELAXED))
+            {
+                cpu_relax();
+            }
+        }
+    }
+
+    void unlock() noexcept
+    {
+        __atomic_clear(&flag, __ATOMIC_RELEASE);
+    }
+};
+} // namespace detail
+} // namespace std
+#endif
@@ -0,0 +1,351 @@
+/*!
+ * @file trace.h
+ * @brief Timed events from the library's hot paths, kept per thread in ring buffers
+ * @namespace std::trace
+ * @details Enabled by defining STD_ENABLE_TRACE for the whole program, which the ENABLE_TRACE CMake option does.
+ * Otherwise STD_TRACE_SCOPE and STD_TRACE_SCOPE_VALUE expand to nothing, their arguments are not evaluated and this
+ * header declares nothing else, so the instrumented paths compile exactly as they would without it.
+ *
+ * A scope records one event when it ends: its name, its start and duration from os::clock_ns() and an optional
+ * value, such as the bytes a reallocation asked for. The library traces vector and string reallocation, UTF-8 and
+ * UTF-16 transcoding, sort and substring find; programs can add scopes of their own.
+ *
+ * Each thread writes to its own ring of ring_size events, set STD_TRACE_RING_SIZE to change it. A ring is allocated
+ * from os::operator_new() on the thread's first event and kept until the program ends, so the events of threads that
+ * have exited can still be read. Once a ring is full, each event overwrites the oldest. Writing takes no lock and no
+ * read-modify-write, only plain stores: every slot is a small seqlock, and readers skip the slots that are being
+ * overwritten while they read them.
+ *
+ * @section usage Reading the events
+ * std::trace::collect() copies the events held, std::trace::dump() writes them as text through a print function such
+ * as the test runner's print(), and std::trace::write_chrome_json() writes them as Trace Event JSON, which
+ * chrome://tracing and ui.perfetto.dev open. std::trace::reset() forgets the events recorded so far.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#if defined(STD_ENABLE_TRACE)
+#    include <charconv.h>
+#    include <clock.h>
+#    include <new.h>
+#    include <stddef.h>
+
+#    if !defined(STD_TRACE_RING_SIZE)
+#        define STD_TRACE_RING_SIZE 4096
+#    endif
+
+namespace std
+{
+namespace trace
+{
+inline constexpr std::size_t ring_size = STD_TRACE_RING_SIZE; //!< Events each thread keeps, a power of two.
+
+static_assert(ring_size != 0 && (ring_size & (ring_size - 1)) == 0, "STD_TRACE_RING_SIZE must be a power of two");
+
+/*!
+ * @brief Copy of one recorded event
+ */
+struct event
+{
+    const char *name;               //!< Name of the scope, a string literal.
+    unsigned long long start_ns;    //!< os::clock_ns() when the scope began.
+    unsigned long long duration_ns; //!< Time from the start of the scope to its end.
+    std::size_t value;              //!< The value given to the scope, 0 if none was.
+    unsigned int thread;            //!< Index of the writing thread, in the order threads first traced.
+};
+
+/*!
+ * @brief Where write_chrome_json() sends its output, the same shape as format_sink's flush function
+ */
+using write_function = void (*)(void *context, const char *data, std::size_t size);
+} // namespace trace
+
+namespace detail
+{
+/*!
+ * @brief One event in a ring
+ * @details sequence is the event's position in the ring plus one while the slot holds it, and 0 while it is being
+ * overwritten; a reader keeps what it copied only if sequence read the same before and after.
+ */
+struct trace_slot
+{
+    unsigned long long sequence;
+    const char *name;
+    unsigned long long start_ns;
+    unsigned long long duration_ns;
+    std::size_t value;
+};
+
+struct trace_ring
+{
+    trace_ring *next;           ///< The ring of the thread that first traced before this one.
+    unsigned int thread;        ///< Index of the owning thread.
+    unsigned long long written; ///< Events the owner has written.
+    unsigned long long first;   ///< Events before this position were dropped by reset().
+    trace_slot slots[trace::ring_size];
+};
+
+//! Every thread's ring, newest first. Rings are only ever added.
+inline trace_ring *trace_rings = nullptr;
+inline unsigned int trace_thread_count = 0;
+inline thread_local trace_ring *trace_current = nullptr;
+
+/*!
+ * @brief Allocates the calling thread's ring and links it into trace_rings, or returns nullptr if out of memory
+ */
+inline trace_ring *trace_new_ring() noexcept
+{
+    void *memory = os::operator_new(sizeof(trace_ring));
+    if (memory == nullptr)
+    {
+        return nullptr;
+    }
+    trace_ring *ring = ::new (memory) trace_ring{};
+    ring->thread = __atomic_fetch_add(&trace_thread_count, 1u, __ATOMIC_RELAXED);
+    ring->next = __atomic_load_n(&trace_rings, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&trace_rings, &ring->next, ring, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    {
+    }
+    return ring;
+}
+
+inline void trace_record(const char *name, unsigned long long start_ns, unsigned long long duration_ns,
+                         std::size_t value) noexcept
+{
+    trace_ring *ring = trace_current;
+    if (ring == nullptr)
+    {
+        ring = trace_current = trace_new_ring();
+        if (ring == nullptr)
+        {
+            return;
+        }
+    }
+    unsigned long long position = __atomic_load_n(&ring->written, __ATOMIC_RELAXED);
+    trace_slot &slot = ring->slots[position & (trace::ring_size - 1)];
+    __atomic_store_n(&slot.sequence, 0ull, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&slot.name, name, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.start_ns, start_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.duration_ns, duration_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.value, value, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot.sequence, position + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring->written, position + 1, __ATOMIC_RELEASE);
+}
+
+/*!
+ * @brief Calls visit(const trace::event &) for each event held, thread by thread and oldest first within a thread
+ */
+template<typename Visit> void trace_visit(Visit &&visit) noexcept
+{
+    for (trace_ring *ring = __atomic_load_n(&trace_rings, __ATOMIC_ACQUIRE); ring != nullptr; ring = ring->next)
+    {
+        unsigned long long written = __atomic_load_n(&ring->written, __ATOMIC_ACQUIRE);
+        unsigned long long position = written > trace::ring_size ? written - trace::ring_size : 0;
+        unsigned long long first = __atomic_load_n(&ring->first, __ATOMIC_RELAXED);
+        for (position = position < first ? first : position; position < written; ++position)
+        {
+            trace_slot &slot = ring->slots[position & (trace::ring_size - 1)];
+            if (__atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE) != position + 1)
+            {
+                continue;
+            }
+            trace::event copy{__atomic_load_n(&slot.name, __ATOMIC_RELAXED),
+                              __atomic_load_n(&slot.start_ns, __ATOMIC_RELAXED),
+                              __atomic_load_n(&slot.duration_ns, __ATOMIC_RELAXED),
+                              __atomic_load_n(&slot.value, __ATOMIC_RELAXED), ring->thread};
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&slot.sequence, __ATOMIC_RELAXED) == position + 1)
+            {
+                visit(copy);
+            }
+        }
+    }
+}
+
+/*!
+ * @brief Text collected in a fixed buffer and handed on in pieces, so nothing is allocated
+ * @details Each piece is also null-terminated, which lets a print function take it as it is.
+ */
+struct trace_output
+{
+    char text[512];
+    std::size_t size = 0;
+    trace::write_function write;
+    void *context;
+
+    void flush() noexcept
+    {
+        if (size != 0)
+        {
+            text[size] = '\0';
+            write(context, text, size);
+            size = 0;
+        }
+    }
+
+    trace_output &operator<<(const char *str) noexcept
+    {
+        for (; *str != '\0'; ++str)
+        {
+            if (size == sizeof(text) - 1)
+            {
+                flush();
+            }
+            text[size++] = *str;
+        }
+        return *this;
+    }
+
+    trace_output &operator<<(unsigned long long value) noexcept
+    {
+        char digits[24];
+        *to_chars(digits, digits + sizeof(digits) - 1, value).ptr = '\0';
+        return *this << digits;
+    }
+
+    //! Nanoseconds as microseconds with three decimals, the unit of the Trace Event format.
+    trace_output &microseconds(unsigned long long ns) noexcept
+    {
+        char digits[5] = {'.'};
+        write_decimal(digits + 1, ns % 1000, 3);
+        return *this << ns / 1000 << digits;
+    }
+
+    //! A JSON string, escaping the characters that would end it.
+    trace_output &quoted(const char *str) noexcept
+    {
+        *this << "\"";
+        for (; *str != '\0'; ++str)
+        {
+            char piece[3] = {'\\', *str, '\0'};
+            *this << (*str == '"' || *str == '\\' ? piece : piece + 1);
+        }
+        return *this << "\"";
+    }
+};
+} // namespace detail
+
+namespace trace
+{
+/*!
+ * @brief Copies up to capacity of the events held into out
+ * @return The number of events copied
+ */
+inline std::size_t collect(event *out, std::size_t capacity) noexcept
+{
+    std::size_t count = 0;
+    detail::trace_visit([&](const event &recorded) noexcept {
+        if (count < capacity)
+        {
+            out[count++] = recorded;
+        }
+    });
+    return count;
+}
+
+/*!
+ * @brief Drops every event recorded so far
+ * @details Events being recorded while reset() runs may or may not be kept.
+ */
+inline void reset() noexcept
+{
+    for (detail::trace_ring *ring = __atomic_load_n(&detail::trace_rings, __ATOMIC_ACQUIRE); ring != nullptr;
+         ring = ring->next)
+    {
+        __atomic_store_n(&ring->first, __atomic_load_n(&ring->written, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+    }
+}
+
+/*!
+ * @brief Writes the events as text, one line per call of print
+ * @details Nothing is allocated, so dump() may be called from anywhere, a crash handler included.
+ */
+inline void dump(void (*print)(const char *)) noexcept
+{
+    auto forward = [](void *context, const char *data, std::size_t) {
+        (*static_cast<void (**)(const char *)>(context))(data);
+    };
+    detail::trace_output line{{}, 0, forward, &print};
+    detail::trace_visit([&](const event &recorded) noexcept {
+        line << "trace: thread " << recorded.thread << " " << recorded.name << " " << recorded.duration_ns
+             << " ns at " << recorded.start_ns << " ns, value " << static_cast<unsigned long long>(recorded.value)
+             << "\n";
+        line.flush();
+    });
+}
+
+/*!
+ * @brief Writes the events as a Trace Event JSON object, in pieces passed to write
+ * @details Each event is a complete ("X") event of process 1 on the thread that recorded it, with the value as its
+ * only argument. Timestamps are os::clock_ns() in microseconds.
+ */
+inline void write_chrome_json(write_function write, void *context = nullptr) noexcept
+{
+    detail::trace_output out{{}, 0, write, context};
+    const char *separator = "\n";
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    detail::trace_visit([&](const event &recorded) noexcept {
+        out << separator << "{\"name\":";
+        out.quoted(recorded.name) << ",\"cat\":\"std\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                                  << static_cast<unsigned long long>(recorded.thread) << ",\"ts\":";
+        out.microseconds(recorded.start_ns) << ",\"dur\":";
+        out.microseconds(recorded.duration_ns) << ",\"args\":{\"value\":"
+                                               << static_cast<unsigned long long>(recorded.value) << "}}";
+        separator = ",\n";
+    });
+    out << "\n]}\n";
+    out.flush();
+}
+
+/*!
+ * @brief Records an event for the lifetime of the scope
+ * @details Use it through STD_TRACE_SCOPE or STD_TRACE_SCOPE_VALUE, which compile to nothing when tracing is off.
+ * Nothing is recorded while a constant expression is evaluated.
+ */
+class scope
+{
+  public:
+    constexpr explicit scope(const char *name, std::size_t value = 0) noexcept
+        : _name(name)
+        , _value(value)
+    {
+        if !consteval
+        {
+            _start = os::clock_ns();
+        }
+    }
+
+    scope(const scope &) = delete;
+    scope &operator=(const scope &) = delete;
+
+    constexpr ~scope()
+    {
+        if !consteval
+        {
+            detail::trace_record(_name, _start, os::clock_ns() - _start, _value);
+        }
+    }
+
+  private:
+    const char *_name;
+    std::size_t _value;
+    unsigned long long _start = 0;
+};
+} // namespace trace
+} // namespace std
+
+#    define STD_TRACE_JOIN2(a, b) a##b
+#    define STD_TRACE_JOIN(a, b) STD_TRACE_JOIN2(a, b)
+//! Records the enclosing scope as an event called name, a string literal.
+#    define STD_TRACE_SCOPE(name) ::std::trace::scope STD_TRACE_JOIN(std_trace_scope_, __LINE__)(name)
+//! Like STD_TRACE_SCOPE, with a value stored in the event, such as a size.
+#    define STD_TRACE_SCOPE_VALUE(name, value)                                                                       \
+        ::std::trace::scope STD_TRACE_JOIN(std_trace_scope_, __LINE__)(name, value)
+#else
+//! Records the enclosing scope as an event called name; see trace.h. Does nothing unless enabled.
+#    define STD_TRACE_SCOPE(name) static_cast<void>(0)
+//! Records the enclosing scope with a value; see trace.h. Does nothing unless enabled, value is not evaluated.
+#    define STD_TRACE_SCOPE_VALUE(name, value) static_cast<void>(0)
+#endif
+#endif
@@ -315,6 +315,32 @@ template<typename T> struct is_trivially_destructible
 
 template<typename T> inline constexpr bool is_trivially_destructible_v = is_trivially_destructible<T>::value;
 
+template<typename T> struct is_trivially_copyable : integral_constant<bool, __is_trivially_copyable(T)>
+{
+};
+
+template<typename T> inline constexpr bool is_trivially_copyable_v = is_trivially_copyable<T>::value;
+
+//! Whether T is a class with no non-static data members, such as a stateless allocator.
+template<typename T> struct is_empty : integral_constant<bool, __is_empty(T)>
+{
+};
+
+template<typename T> inline constexpr bool is_empty_v = is_empty<T>::value;
+
+/*!
+ * @brief Tells containers that a T can be moved to new storage by copying its bytes.
+ * @details Relocating means move-constructing into new storage and destroying the source. For a trivially
+ * relocatable type this is the same as a memcpy, so containers can move a whole block at once. Every trivially
+ * copyable type qualifies. Types that only own resources through pointers, and never point into themselves, opt in by
+ * specializing this trait to true_type.
+ */
+template<typename T> struct is_trivially_relocatable : integral_constant<bool, is_trivially_copyable<T>::value>
+{
+};
+
+template<typename T> inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
 template<typename t>
     struct is_nothrow_destructible : std::integral_constant < bool
     , requires(t object)
@@ -0,0 +1,612 @@
+/*!
+ * @file utf.h
+ * @brief Transcoding kernels between UTF-8 and the UTF-16 units used by std::string
+ * @namespace std::utf
+ * @details The kernels convert whole buffers at a time. Runs of ASCII, the common case for configuration files and
+ * source text, are widened or narrowed a vector register at a time; a block that contains anything else is handled
+ * sequence by sequence and the vector loop resumes after it. Validation happens in the same pass, so the input is
+ * read exactly once.
+ */
+#ifndef UTF_H
+#define UTF_H
+#include <algorithm.h>
+#include <stddef.h>
+#include <trace.h>
+
+namespace std
+{
+namespace utf
+{
+/*!
+ * @brief Returned by the converters when the input is not well-formed
+ */
+inline constexpr std::size_t invalid = static_cast<std::size_t>(-1);
+
+namespace detail
+{
+#if defined(STD_SIMD_AVX2)
+inline constexpr std::size_t ascii_block = 32;
+
+inline bool widen_ascii_block(const unsigned char *src, short *dst) noexcept
+{
+    __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+    if (_mm256_movemask_epi8(bytes) != 0)
+    {
+        return false;
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), _mm256_cvtepu8_epi16(_mm256_castsi256_si128(bytes)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + 16),
+                        _mm256_cvtepu8_epi16(_mm256_extracti128_si256(bytes, 1)));
+    return true;
+}
+#elif defined(STD_SIMD_SSE2)
+inline constexpr std::size_t ascii_block = 16;
+
+inline bool widen_ascii_block(const unsigned char *src, short *dst) noexcept
+{
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    if (_mm_movemask_epi8(bytes) != 0)
+    {
+        return false;
+    }
+    __m128i zero = _mm_setzero_si128();
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_unpacklo_epi8(bytes, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + 8), _mm_unpackhi_epi8(bytes, zero));
+    return true;
+}
+#elif defined(STD_SIMD_NEON)
+inline constexpr std::size_t ascii_block = 16;
+
+inline bool widen_ascii_block(const unsigned char *src, short *dst) noexcept
+{
+    uint8x16_t bytes = vld1q_u8(src);
+    // Folding the halves together keeps any top bit that is set in either of them
+    uint8x8_t folded = vorr_u8(vget_low_u8(bytes), vget_high_u8(bytes));
+    if ((vget_lane_u64(vreinterpret_u64_u8(folded), 0) & 0x8080808080808080ull) != 0)
+    {
+        return false;
+    }
+    unsigned short *units = reinterpret_cast<unsigned short *>(dst);
+    vst1q_u16(units, vmovl_u8(vget_low_u8(bytes)));
+    vst1q_u16(units + 8, vmovl_u8(vget_high_u8(bytes)));
+    return true;
+}
+#else
+inline constexpr std::size_t ascii_block = sizeof(std::size_t);
+
+inline bool widen_ascii_block(const unsigned char *src, short *dst) noexcept
+{
+    constexpr std::size_t highs = static_cast<std::size_t>(-1) / 0xFF * 0x80;
+    if ((*reinterpret_cast<const std::detail::unaligned_word *>(src) & highs) != 0)
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < ascii_block; ++i)
+    {
+        dst[i] = static_cast<short>(src[i]);
+    }
+    return true;
+}
+#endif
+
+#if defined(STD_SIMD_AVX2)
+inline constexpr std::size_t narrow_block = 32;
+
+inline bool ascii_units_block(const short *src) noexcept
+{
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 16));
+    __m256i above = _mm256_and_si256(_mm256_or_si256(low, high), _mm256_set1_epi16(static_cast<short>(0xFF80)));
+    return _mm256_testz_si256(above, above) != 0;
+}
+
+inline bool narrow_ascii_block(const short *src, unsigned char *dst) noexcept
+{
+    if (!ascii_units_block(src))
+    {
+        return false;
+    }
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + 16));
+    // packus works within 128-bit lanes, the permute puts the four quarters back in order
+    __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), packed);
+    return true;
+}
+#elif defined(STD_SIMD_SSE2)
+inline constexpr std::size_t narrow_block = 16;
+
+inline bool ascii_units_block(const short *src) noexcept
+{
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 8));
+    __m128i above = _mm_and_si128(_mm_or_si128(low, high), _mm_set1_epi16(static_cast<short>(0xFF80)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi16(above, _mm_setzero_si128())) == 0xFFFF;
+}
+
+inline bool narrow_ascii_block(const short *src, unsigned char *dst) noexcept
+{
+    if (!ascii_units_block(src))
+    {
+        return false;
+    }
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_packus_epi16(low, high));
+    return true;
+}
+#elif defined(STD_SIMD_NEON)
+inline constexpr std::size_t narrow_block = 16;
+
+inline bool ascii_units_block(const short *src) noexcept
+{
+    const unsigned short *units = reinterpret_cast<const unsigned short *>(src);
+    uint16x8_t both = vorrq_u16(vld1q_u16(units), vld1q_u16(units + 8));
+    uint16x4_t folded = vorr_u16(vget_low_u16(both), vget_high_u16(both));
+    return (vget_lane_u64(vreinterpret_u64_u16(folded), 0) & 0xFF80FF80FF80FF80ull) == 0;
+}
+
+inline bool narrow_ascii_block(const short *src, unsigned char *dst) noexcept
+{
+    if (!ascii_units_block(src))
+    {
+        return false;
+    }
+    const unsigned short *units = reinterpret_cast<const unsigned short *>(src);
+    uint16x8_t low = vld1q_u16(units);
+    uint16x8_t high = vld1q_u16(units + 8);
+    vst1q_u8(dst, vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+    return true;
+}
+#else
+inline constexpr std::size_t narrow_block = sizeof(std::size_t) / sizeof(short);
+
+inline bool ascii_units_block(const short *src) noexcept
+{
+    constexpr std::size_t above = static_cast<std::size_t>(-1) / 0xFFFF * 0xFF80;
+    return (*reinterpret_cast<const std::detail::unaligned_word *>(src) & above) == 0;
+}
+
+inline bool narrow_ascii_block(const short *src, unsigned char *dst) noexcept
+{
+    if (!ascii_units_block(src))
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < narrow_block; ++i)
+    {
+        dst[i] = static_cast<unsigned char>(src[i]);
+    }
+    return true;
+}
+#endif
+
+constexpr inline bool is_continuation(unsigned int byte) noexcept
+{
+    return (byte & 0xC0) == 0x80;
+}
+
+/*!
+ * @brief Decodes the sequence at src[i], which must start with a non-ASCII byte, and writes one or two units
+ * @details Rejects everything Unicode calls ill-formed: stray continuation bytes, overlong forms, encoded surrogates,
+ * code points past U+10FFFF and sequences cut off by the end of the input.
+ * @return The number of bytes consumed, or 0 if the sequence is ill-formed
+ */
+template<typename Byte>
+constexpr std::size_t decode_sequence(const Byte *src, std::size_t i, std::size_t len, short *dst,
+                                      std::size_t &written) noexcept
+{
+    // Byte is char or unsigned char, so the same decoder runs in constant expressions
+    auto byte = [src](std::size_t offset) noexcept {
+        return static_cast<unsigned int>(static_cast<unsigned char>(src[offset]));
+    };
+    unsigned int lead = byte(i);
+    if (lead < 0xC2)
+    {
+        return 0;
+    }
+    if (lead < 0xE0)
+    {
+        if (i + 1 >= len || !is_continuation(byte(i + 1)))
+        {
+            return 0;
+        }
+        dst[written++] = static_cast<short>(((lead & 0x1F) << 6) | (byte(i + 1) & 0x3F));
+        return 2;
+    }
+    if (lead < 0xF0)
+    {
+        if (i + 2 >= len || !is_continuation(byte(i + 1)) || !is_continuation(byte(i + 2)))
+        {
+            return 0;
+        }
+        unsigned int second = byte(i + 1);
+        // E0 must not be overlong, ED must not encode a surrogate
+        if ((lead == 0xE0 && second < 0xA0) || (lead == 0xED && second > 0x9F))
+        {
+            return 0;
+        }
+        dst[written++] = static_cast<short>(((lead & 0x0F) << 12) | ((second & 0x3F) << 6) | (byte(i + 2) & 0x3F));
+        return 3;
+    }
+    if (lead < 0xF5)
+    {
+        if (i + 3 >= len || !is_continuation(byte(i + 1)) || !is_continuation(byte(i + 2)) ||
+            !is_continuation(byte(i + 3)))
+        {
+            return 0;
+        }
+        unsigned int second = byte(i + 1);
+        // F0 must not be overlong, F4 must stay at or below U+10FFFF
+        if ((lead == 0xF0 && second < 0x90) || (lead == 0xF4 && second > 0x8F))
+        {
+            return 0;
+        }
+        unsigned int code_point =
+            ((lead & 0x07) << 18) | ((second & 0x3F) << 12) | ((byte(i + 2) & 0x3F) << 6) | (byte(i + 3) & 0x3F);
+        code_point -= 0x10000;
+        dst[written++] = static_cast<short>(0xD800 | (code_point >> 10));
+        dst[written++] = static_cast<short>(0xDC00 | (code_point & 0x3FF));
+        return 4;
+    }
+    return 0;
+}
+
+/*!
+ * @brief Decodes src[i, len) one code point at a time, without the vector kernels
+ * @details Usable in constant expressions. dst needs room for len - i more units.
+ * @return The total number of units in dst, or invalid if the input is not well-formed UTF-8
+ */
+template<typename Byte>
+constexpr std::size_t decode_scalar(const Byte *src, std::size_t i, std::size_t len, short *dst,
+                                    std::size_t written) noexcept
+{
+    while (i < len)
+    {
+        unsigned char lead = static_cast<unsigned char>(src[i]);
+        if (lead < 0x80)
+        {
+            dst[written++] = static_cast<short>(lead);
+            ++i;
+            continue;
+        }
+        std::size_t consumed = decode_sequence(src, i, len, dst, written);
+        if (consumed == 0)
+        {
+            return invalid;
+        }
+        i += consumed;
+    }
+    return written;
+}
+
+constexpr inline bool is_high_surrogate(unsigned int unit) noexcept
+{
+    return unit >= 0xD800 && unit <= 0xDBFF;
+}
+
+constexpr inline bool is_low_surrogate(unsigned int unit) noexcept
+{
+    return unit >= 0xDC00 && unit <= 0xDFFF;
+}
+
+/*!
+ * @brief Number of UTF-8 bytes for the units starting at src[i], and how many units that takes
+ * @details Unpaired surrogates encode to nothing, matching how the encoder skips them.
+ */
+constexpr inline std::size_t encoded_size(const short *src, std::size_t i, std::size_t count,
+                                          std::size_t &consumed) noexcept
+{
+    unsigned int unit = static_cast<unsigned short>(src[i]);
+    consumed = 1;
+    if (unit < 0x80)
+    {
+        return 1;
+    }
+    if (unit < 0x800)
+    {
+        return 2;
+    }
+    if (is_high_surrogate(unit))
+    {
+        if (i + 1 < count && is_low_surrogate(static_cast<unsigned short>(src[i + 1])))
+        {
+            consumed = 2;
+            return 4;
+        }
+        return 0;
+    }
+    return is_low_surrogate(unit) ? 0 : 3;
+}
+} // namespace detail
+
+/*!
+ * @brief Converts UTF-8 to UTF-16 and validates it in one pass
+ * @details Every UTF-8 byte produces at most one UTF-16 unit, so a destination of len units is always large enough
+ * and the caller can size it once before converting. On failure the contents of dst are unspecified.
+ * @param src The UTF-8 bytes, not necessarily null-terminated
+ * @param len Number of bytes in src
+ * @param dst Storage for at least len units
+ * @return The number of units written, or invalid if src is not well-formed UTF-8
+ */
+inline std::size_t utf8_to_utf16(const char *src, std::size_t len, short *dst) noexcept
+{
+    STD_TRACE_SCOPE_VALUE("utf8 to utf16", len);
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(src);
+    std::size_t i = 0;
+    std::size_t written = 0;
+    while (i + detail::ascii_block <= len)
+    {
+        if (detail::widen_ascii_block(bytes + i, dst + written))
+        {
+            i += detail::ascii_block;
+            written += detail::ascii_block;
+            continue;
+        }
+        // Decode up to the end of this block, then let the vector loop try again
+        std::size_t block_end = i + detail::ascii_block;
+        while (i < block_end)
+        {
+            if (bytes[i] < 0x80)
+            {
+                dst[written++] = static_cast<short>(bytes[i++]);
+                continue;
+            }
+            std::size_t consumed = detail::decode_sequence(bytes, i, len, dst, written);
+            if (consumed == 0)
+            {
+                return invalid;
+            }
+            i += consumed;
+        }
+    }
+    return detail::decode_scalar(bytes, i, len, dst, written);
+}
+
+/*!
+ * @brief Widens each byte to one unit, reading the input as Latin-1
+ * @param src The bytes to widen
+ * @param len Number of bytes in src
+ * @param dst Storage for at least len units
+ */
+inline void latin1_to_utf16(const char *src, std::size_t len, short *dst) noexcept
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(src);
+    for (std::size_t i = 0; i < len; ++i)
+    {
+        dst[i] = static_cast<short>(bytes[i]);
+    }
+}
+
+/*!
+ * @brief Exact number of bytes utf16_to_utf8() produces for the units, not counting a terminator
+ * @param src The UTF-16 units
+ * @param count Number of units in src
+ */
+inline std::size_t utf8_length(const short *src, std::size_t count) noexcept
+{
+    std::size_t length = 0;
+    std::size_t i = 0;
+    while (i < count)
+    {
+        if (i + detail::narrow_block <= count && detail::ascii_units_block(src + i))
+        {
+            i += detail::narrow_block;
+            length += detail::narrow_block;
+            continue;
+        }
+        std::size_t consumed = 0;
+        length += detail::encoded_size(src, i, count, consumed);
+        i += consumed;
+    }
+    return length;
+}
+
+/*!
+ * @brief Converts UTF-16 to UTF-8, stopping before the first code point that does not fit
+ * @details Unpaired surrogates are skipped. The output is never cut inside a sequence and is not null-terminated.
+ * @param src The UTF-16 units
+ * @param count Number of units in src
+ * @param dst Destination for the bytes
+ * @param capacity Number of bytes available at dst; utf8_length() bytes are always enough
+ * @return The number of bytes written
+ */
+inline std::size_t utf16_to_utf8(const short *src, std::size_t count, char *dst, std::size_t capacity) noexcept
+{
+    STD_TRACE_SCOPE_VALUE("utf16 to utf8", count);
+    unsigned char *bytes = reinterpret_cast<unsigned char *>(dst);
+    std::size_t i = 0;
+    std::size_t written = 0;
+    while (i < count)
+    {
+        if (i + detail::narrow_block <= count && written + detail::narrow_block <= capacity &&
+            detail::narrow_ascii_block(src + i, bytes + written))
+        {
+            i += detail::narrow_block;
+            written += detail::narrow_block;
+            continue;
+        }
+        std::size_t consumed = 0;
+        std::size_t size = detail::encoded_size(src, i, count, consumed);
+        if (written + size > capacity)
+        {
+            break;
+        }
+        unsigned int unit = static_cast<unsigned short>(src[i]);
+        switch (size)
+        {
+        case 1:
+            bytes[written] = static_cast<unsigned char>(unit);
+            break;
+        case 2:
+            bytes[written] = static_cast<unsigned char>(0xC0 | (unit >> 6));
+            bytes[written + 1] = static_cast<unsigned char>(0x80 | (unit & 0x3F));
+            break;
+        case 3:
+            bytes[written] = static_cast<unsigned char>(0xE0 | (unit >> 12));
+            bytes[written + 1] = static_cast<unsigned char>(0x80 | ((unit >> 6) & 0x3F));
+            bytes[written + 2] = static_cast<unsigned char>(0x80 | (unit & 0x3F));
+            break;
+        case 4: {
+            unsigned int low = static_cast<unsigned short>(src[i + 1]);
+            unsigned int code_point = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+            bytes[written] = static_cast<unsigned char>(0xF0 | (code_point >> 18));
+            bytes[written + 1] = static_cast<unsigned char>(0x80 | ((code_point >> 12) & 0x3F));
+            bytes[written + 2] = static_cast<unsigned char>(0x80 | ((code_point >> 6) & 0x3F));
+            bytes[written + 3] = static_cast<unsigned char>(0x80 | (code_point & 0x3F));
+            break;
+        }
+        default:
+            break;
+        }
+        written += size;
+        i += consumed;
+    }
+    return written;
+}
+
+/*!
+ * @brief Converts UTF-8 that arrives in pieces, such as the chunks of a file, to UTF-16
+ * @details A piece may end partway through a code point. The bytes of the cut-off sequence are held back, at most
+ * three of them, and decoded with the start of the next piece. Nothing else is buffered, so the memory used does not
+ * depend on the length of the input. Once the input is found not to be well-formed, the decoder stays failed until
+ * reset().
+ */
+class utf8_decoder
+{
+  public:
+    /*!
+     * @brief Units convert() may write for len bytes: at most one per byte, plus one per held-back byte
+     */
+    static constexpr std::size_t max_units(std::size_t len) noexcept
+    {
+        return len + 3;
+    }
+
+    /*!
+     * @brief Converts the next piece of the input
+     * @param src The next bytes of the input
+     * @param len Number of bytes in src
+     * @param dst Storage for at least max_units(len) units
+     * @return The number of units written, or invalid if the input is not well-formed UTF-8
+     */
+    std::size_t convert(const char *src, std::size_t len, short *dst) noexcept
+    {
+        if (_failed)
+        {
+            return invalid;
+        }
+        std::size_t i = 0;
+        std::size_t written = 0;
+        if (_held_size != 0)
+        {
+            // Complete the held-back sequence from the front of this piece
+            while (_held_size < _held_need && _held_size < sizeof(_held) && i < len)
+            {
+                unsigned char byte = static_cast<unsigned char>(src[i]);
+                if (!detail::is_continuation(byte))
+                {
+                    return fail();
+                }
+                _held[_held_size++] = byte;
+                ++i;
+            }
+            if (_held_size < _held_need)
+            {
+                return 0;
+            }
+            if (detail::decode_sequence(_held, 0, _held_size, dst, written) == 0)
+            {
+                return fail();
+            }
+            _held_size = 0;
+        }
+        std::size_t end = len - cut_off_tail(src + i, len - i);
+        std::size_t converted = utf8_to_utf16(src + i, end - i, dst + written);
+        if (converted == invalid)
+        {
+            return fail();
+        }
+        for (; end < len; ++end)
+        {
+            _held[_held_size++] = static_cast<unsigned char>(src[end]);
+        }
+        if (_held_size != 0)
+        {
+            _held_need = sequence_length(_held[0]);
+        }
+        return written + converted;
+    }
+
+    /*!
+     * @brief Ends the input
+     * @return true if every piece was well-formed and the last one did not stop partway through a code point
+     */
+    bool finish() noexcept
+    {
+        if (_held_size != 0)
+        {
+            fail();
+        }
+        return !_failed;
+    }
+
+    bool failed() const noexcept
+    {
+        return _failed;
+    }
+
+    //! Forgets any held-back bytes and failure, to start on a new input.
+    void reset() noexcept
+    {
+        _held_size = 0;
+        _failed = false;
+    }
+
+  private:
+    unsigned char _held[4] = {}; ///< Start of a sequence cut off by the end of the last piece.
+    std::size_t _held_size = 0;  ///< Number of bytes in _held.
+    std::size_t _held_need = 0;  ///< Length of the whole sequence that starts in _held.
+    bool _failed = false;        ///< Whether ill-formed input has been seen.
+
+    std::size_t fail() noexcept
+    {
+        _held_size = 0;
+        _failed = true;
+        return invalid;
+    }
+
+    //! Length of the sequence a lead byte starts, or 0 for bytes that never start one.
+    static constexpr std::size_t sequence_length(unsigned int lead) noexcept
+    {
+        if (lead >= 0xC2 && lead < 0xE0)
+        {
+            return 2;
+        }
+        if (lead >= 0xE0 && lead < 0xF0)
+        {
+            return 3;
+        }
+        return lead >= 0xF0 && lead < 0xF5 ? 4 : 0;
+    }
+
+    /*!
+     * @brief Number of bytes at the end of src that start a sequence too long to fit in it
+     * @details Only the last three bytes can; anything ill-formed is left for the converter to reject.
+     */
+    static std::size_t cut_off_tail(const char *src, std::size_t len) noexcept
+    {
+        for (std::size_t back = 1; back <= 3 && back <= len; ++back)
+        {
+            unsigned int byte = static_cast<unsigned char>(src[len - back]);
+            if (!detail::is_continuation(byte))
+            {
+                return sequence_length(byte) > back ? back : 0;
+            }
+        }
+        return 0;
+    }
+};
+} // namespace utf
+} // namespace std
+#endif
@@ -19,6 +19,13 @@ template<class T> constexpr T &&forward(std::remove_reference_t<T> &&t) noexcept
     return static_cast<T &&>(t);
 }
 
+template<class T, class U = T> constexpr T exchange(T &object, U &&new_value)
+{
+    T old_value = std::move(object);
+    object = std::forward<U>(new_value);
+    return old_value;
+}
+
 template<class InputIt, class OutputIt> constexpr OutputIt copy(InputIt first, InputIt last, OutputIt d_first)
 {
     for (; first != last; (void)++first, (void)++d_first)
@@ -44,5 +51,94 @@ constexpr void fill(ForwardIt first, ForwardIt last, const T &value)
     for (; first != last; ++first)
         *first = value;
 }
+
+/*!
+ * @brief An empty type, the value of a result that only says whether something succeeded
+ */
+struct monostate
+{
+    friend constexpr bool operator==(monostate, monostate) noexcept
+    {
+        return true;
+    }
+};
+
+/*!
+ * @brief Two values of possibly different types, the element of the map containers
+ * @tparam T1 The type of first
+ * @tparam T2 The type of second
+ */
+template<typename T1, typename T2> struct pair
+{
+    using first_type = T1;
+    using second_type = T2;
+
+    T1 first{};
+    T2 second{};
+
+    constexpr pair() = default;
+    constexpr pair(const pair &) = default;
+    constexpr pair(pair &&) = default;
+    constexpr pair &operator=(const pair &) = default;
+    constexpr pair &operator=(pair &&) = default;
+
+    constexpr pair(const T1 &a, const T2 &b)
+        : first(a)
+        , second(b)
+    {
+    }
+
+    template<typename U1, typename U2>
+    constexpr pair(U1 &&a, U2 &&b)
+        : first(std::forward<U1>(a))
+        , second(std::forward<U2>(b))
+    {
+    }
+
+    template<typename U1, typename U2>
+    constexpr pair(const pair<U1, U2> &other)
+        : first(other.first)
+        , second(other.second)
+    {
+    }
+
+    template<typename U1, typename U2>
+    constexpr pair(pair<U1, U2> &&other)
+        : first(std::forward<U1>(other.first))
+        , second(std::forward<U2>(other.second))
+    {
+    }
+
+    constexpr bool operator==(const pair &other) const
+    {
+        return first == other.first && second == other.second;
+    }
+
+    constexpr bool operator!=(const pair &other) const
+    {
+        return !(*this == other);
+    }
+
+    constexpr bool operator<(const pair &other) const
+    {
+        return first < other.first || (!(other.first < first) && second < other.second);
+    }
+};
+
+template<typename T1, typename T2>
+constexpr pair<remove_cv_t<remove_reference_t<T1>>, remove_cv_t<remove_reference_t<T2>>> make_pair(T1 &&a, T2 &&b)
+{
+    return {std::forward<T1>(a), std::forward<T2>(b)};
+}
+
+/*!
+ * @brief A pair relocates trivially when both of its members do, const or not
+ */
+template<typename T1, typename T2>
+struct is_trivially_relocatable<pair<T1, T2>>
+    : integral_constant<bool,
+                        is_trivially_relocatable_v<remove_cv_t<T1>> && is_trivially_relocatable_v<remove_cv_t<T2>>>
+{
+};
 } // namespace std
-#endif
\ No newline at end of file
+#endif
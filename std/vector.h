@@ -12,32 +12,46 @@
 #define VECTOR_H
 
 #include <algorithm.h>
+#include <bounds_check.h>
+#include <expected.h>
 #include <initializer_list.h>
 #include <iterator.h>
+#include <memory.h>
+#include <growth_policy.h>
+#include <memory_resource.h>
 #include <stddef.h>
 #include <stdexcept.h>
+#include <trace.h>
 #include <type_traits.h>
 
 namespace std
 {
 
+namespace detail
+{
 /**
- * @brief A dynamic array that stores elements contiguously.
+ * @brief The storage, growth and element access shared by vector and small_vector.
  *
- * This template class provides a simplified version of the standard
- * vector container. Elements are stored in a contiguous block of memory
- * and the container supports dynamic resizing, random access, and efficient
- * insertion/removal at the end.
+ * Everything that only needs the elements, their count and the capacity lives here, so both containers grow,
+ * relocate, insert and erase with the same code and have the same member functions. Derived decides what _data
+ * points at when it holds no block from the allocator: nullptr for vector, the inline buffer for small_vector. It
+ * provides has_block(), whether _data came from the allocator, and reset_storage(), which points _data back at that
+ * storage without touching the old one.
  *
  * @tparam T Type of elements stored in the vector. Must not be void.
+ * @tparam Allocator Allocator used for the element storage.
+ * @tparam Growth Policy for the capacity to grow to, see growth_policy.h.
+ * @tparam Derived The container built on this class.
  */
-template<typename T> class vector final
+template<typename T, typename Allocator, typename Growth, typename Derived> class vector_base
 {
     static_assert(!std::is_void<T>::value, "vector cannot be instantiated with void type");
 
   public:
     /// Element type.
     using value_type = T;
+    /// Allocator type.
+    using allocator_type = Allocator;
     /// Unsigned integral type.
     using size_type = size_t;
     /// Reference to an element.
@@ -54,143 +68,73 @@ template<typename T> class vector final
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
     /**
-     * @brief Default constructor.
-     *
-     * Constructs an empty vector with no elements.
-     */
-    constexpr vector() = default;
-
-    /**
-     * @brief Constructs a vector with a specified number of copies of a value.
-     *
-     * @param count Number of elements to initialize.
-     * @param value Value to assign to each element (default is a default-constructed T).
-     *
-     * If count is zero, no memory is allocated.
-     */
-    constexpr explicit vector(size_type count, const T &value = T()) noexcept
-        : _size{count}
-        , _capacity{count}
-    {
-        if (_size > 0)
-        {
-            _data = new T[_size];
-            for (size_type i = 0; i < _size; i++)
-            {
-                _data[i] = value;
-            }
-            return;
-        }
-        _data = nullptr;
-    }
-
-    /**
-     * @brief Copy constructor.
+     * @brief Replaces the contents with count copies of value.
      *
-     * Constructs a new vector as a copy of the provided vector.
+     * The storage is reused when it is large enough, otherwise it is replaced by a block of exactly count elements.
      *
-     * @param other The vector to copy.
+     * @param count Number of elements.
+     * @param value Value to copy into each element; it may be an element of this vector.
      */
-    constexpr vector(const vector &other) noexcept
-        : _size{other._size}
-        , _capacity{other._capacity}
+    void assign(size_type count, const T &value)
     {
-        if (_size > 0)
+        T copy(value);
+        std::destroy(_data, _data + _size);
+        _size = 0;
+        if (count > _capacity)
         {
-            _data = new T[_size];
-            for (size_type i = 0; i < _size; i++)
-            {
-                _data[i] = other._data[i];
-            }
-            return;
+            reallocate(count);
         }
-        _data = nullptr;
+        std::uninitialized_fill_n(_data, count, copy);
+        _size = count;
     }
 
     /**
-     * @brief Move constructor.
-     *
-     * Constructs a vector by transferring the resources from another vector.
+     * @brief Replaces the contents with copies of the elements in [first, last).
      *
-     * @param other The vector to move from.
+     * The range must not point into this vector.
      *
-     * After the move, the other vector is left in a valid, empty state.
+     * @param first Beginning of the range to copy.
+     * @param last End of the range to copy.
      */
-    constexpr vector(vector &&other) noexcept
-        : _size{other._size}
-        , _capacity{other._capacity}
-        , _data{other._data}
+    template<class InputIter>
+        requires(!std::is_integral_v<InputIter>)
+    void assign(InputIter first, InputIter last)
     {
-        other._data = nullptr;
-        other._size = 0;
-        other._capacity = 0;
-    }
-
-    constexpr vector(std::initializer_list<T> list) noexcept
-        : _size{list.size()}
-        , _capacity{list.size()}
-    {
-        _data = new T[_size];
-        size_type i = 0;
-        for (auto item : list)
+        size_type count = static_cast<size_type>(std::distance(first, last));
+        std::destroy(_data, _data + _size);
+        _size = 0;
+        if (count > _capacity)
         {
-            _data[i++] = item;
+            reallocate(count);
         }
+        std::uninitialized_copy(first, last, _data);
+        _size = count;
     }
 
     /**
-     * @brief Destructor.
-     *
-     * Releases all memory allocated for the vector.
+     * @brief Replaces the contents with copies of the elements of an initializer list.
      */
-    ~vector()
+    void assign(std::initializer_list<T> il)
     {
-        if (_data != nullptr)
-        {
-            delete[] _data;
-        }
+        assign(il.begin(), il.end());
     }
 
     /**
-     * @brief Copy assignment operator.
+     * @brief Replaces the contents with copies of the elements of range.
      *
-     * Replaces the contents with a copy of the contents of another vector.
-     *
-     * @param other The vector to copy from.
-     * @return Reference to this vector.
+     * @tparam Range Any type with begin() and end() members, such as another container.
      */
-    constexpr vector &operator=(const vector &other) noexcept
+    template<class Range> void assign_range(const Range &range)
     {
-        if (this != &other)
-        {
-            vector temp(other);
-            swap(temp);
-        }
-        return *this;
+        assign(range.begin(), range.end());
     }
 
     /**
-     * @brief Move assignment operator.
-     *
-     * Replaces the contents by moving the contents from another vector.
-     *
-     * @param other The vector to move from.
-     * @return Reference to this vector.
+     * @brief Returns a copy of the allocator.
      */
-    constexpr vector &operator=(vector &&other) noexcept
+    constexpr allocator_type get_allocator() const noexcept
     {
-        if (this != &other)
-        {
-            swap(other);
-        }
-        return *this;
-    }
-
-    constexpr vector &operator=(std::initializer_list<T> list) noexcept
-    {
-        vector temp(list);
-        swap(temp);
-        return *this;
+        return _alloc;
     }
 
     // Capacity functions
@@ -239,37 +183,45 @@ template<typename T> class vector final
      * @brief Reserves storage.
      *
      * Increases the capacity of the vector to at least new_cap. If new_cap is greater than the current capacity,
-     * additional memory is allocated.
+     * additional memory is allocated, rounded up as the growth policy asks (not at all for the default policy).
      *
      * @param new_cap The new capacity to reserve.
      */
     void reserve(size_type new_cap) noexcept
     {
-        ensure_capacity(new_cap);
+        if (new_cap > _capacity)
+        {
+            reallocate(Growth::round(new_cap, sizeof(T)));
+        }
     }
 
     /**
-     * @brief Shrinks the capacity to fit the current size.
+     * @brief Reserves storage for exactly new_cap elements.
      *
-     * Requests the container to reduce its capacity to fit its size.
+     * Like reserve(), but the capacity becomes new_cap itself whatever the growth policy.
+     *
+     * @param new_cap The new capacity to reserve.
      */
-    void shrink_to_fit() noexcept
+    void reserve_exact(size_type new_cap) noexcept
     {
-        ensure_capacity(_size);
-        _capacity = _size;
+        if (new_cap > _capacity)
+        {
+            reallocate(new_cap);
+        }
     }
-    
+
     /**
      * @brief Provides unchecked access to the element at specified position.
      *
      * @param pos Position of the element.
      * @return Reference to the element at position pos.
      *
-     * Calling operator[] on an out-of-range index results in undefined behavior.
+     * Calling operator[] on an out-of-range index results in undefined behavior; it is never checked, whatever
+     * STD_BOUNDS_CHECK says, so loops over it carry no branch.
      */
     reference operator[](size_type pos) noexcept
     {
-        return at(pos);
+        return _data[pos];
     }
 
     /**
@@ -282,7 +234,7 @@ template<typename T> class vector final
      */
     const_reference operator[](size_type pos) const noexcept
     {
-        return at(pos);
+        return _data[pos];
     }
 
     /**
@@ -298,12 +250,9 @@ template<typename T> class vector final
      */
     constexpr iterator insert(const_iterator position, const T &x)
     {
-        size_type pos_index = std::distance(cbegin(), position);
-        ensure_capacity(_size + 1);
-        std::move_backward(_data + pos_index, _data + _size, _data + _size + 1);
-        _data[pos_index] = x;
-        ++_size;
-        return _data + pos_index;
+        // Copy first, x may live inside this vector and be moved by the gap
+        T copy(x);
+        return insert(position, std::move(copy));
     }
 
     /**
@@ -319,10 +268,9 @@ template<typename T> class vector final
      */
     constexpr iterator insert(const_iterator position, T &&x)
     {
-        size_type pos_index = static_cast<size_type>(std::distance(cbegin(), position));
-        ensure_capacity(_size + 1);
-        std::move_backward(_data + pos_index, _data + _size, _data + _size + 1);
-        _data[pos_index] = std::move(x);
+        size_type pos_index = static_cast<size_type>(position - cbegin());
+        open_gap(pos_index, 1);
+        std::construct_at(_data + pos_index, std::move(x));
         ++_size;
         return _data + pos_index;
     }
@@ -341,10 +289,10 @@ template<typename T> class vector final
      */
     constexpr iterator insert(const_iterator position, size_type n, const T &x)
     {
-        size_type pos_index = std::distance(cbegin(), position);
-        ensure_capacity(_size + n);
-        std::move_backward(_data + pos_index, _data + _size, _data + _size + n);
-        std::fill(_data + pos_index, _data + pos_index + n, x);
+        size_type pos_index = static_cast<size_type>(position - cbegin());
+        T copy(x);
+        open_gap(pos_index, n);
+        std::uninitialized_fill_n(_data + pos_index, n, copy);
         _size += n;
         return _data + pos_index;
     }
@@ -363,11 +311,10 @@ template<typename T> class vector final
      */
     template<class InputIter> constexpr iterator insert(const_iterator position, InputIter first, InputIter last)
     {
-        size_type pos_index = std::distance(cbegin(), position);
-        size_type n = std::distance(first, last);
-        ensure_capacity(_size + n);
-        std::move_backward(_data + pos_index, _data + _size, _data + _size + n);
-        std::copy(first, last, _data + pos_index);
+        size_type pos_index = static_cast<size_type>(position - cbegin());
+        size_type n = static_cast<size_type>(std::distance(first, last));
+        open_gap(pos_index, n);
+        std::uninitialized_copy(first, last, _data + pos_index);
         _size += n;
         return _data + pos_index;
     }
@@ -388,6 +335,33 @@ template<typename T> class vector final
         return insert(position, il.begin(), il.end());
     }
 
+    /**
+     * @brief Inserts copies of the elements of range at the specified position.
+     *
+     * The storage grows at most once and the elements after position are relocated once, with a single memmove for
+     * trivially relocatable types; a contiguous range of trivially copyable elements is copied with one memcpy.
+     *
+     * @tparam Range Any type with begin() and end() members, such as another container.
+     * @param position Position of the element to insert before.
+     * @param range The elements to insert; they must not be elements of this vector.
+     * @return Iterator pointing to the first inserted element.
+     */
+    template<class Range> iterator insert_range(const_iterator position, const Range &range)
+    {
+        return insert(position, range.begin(), range.end());
+    }
+
+    /**
+     * @brief Appends copies of the elements of range, growing the storage at most once.
+     *
+     * @tparam Range Any type with begin() and end() members, such as another container.
+     * @param range The elements to append; they must not be elements of this vector.
+     */
+    template<class Range> void append_range(const Range &range)
+    {
+        insert(cend(), range.begin(), range.end());
+    }
+
     /**
      * @brief Erase an element at specified position.
      *
@@ -398,11 +372,76 @@ template<typename T> class vector final
      */
     void erase(size_type pos)
     {
-        for (size_type i = pos; i < _size - 1; i++)
+        std::destroy_at(_data + pos);
+        std::uninitialized_relocate(_data + pos + 1, _data + _size, _data + pos);
+        _size--;
+    }
+
+    /**
+     * @brief Erase the element at the specified iterator position.
+     *
+     * @param pos Iterator to the element to erase.
+     * @return Iterator following the removed element.
+     *
+     * The elements after pos are relocated one slot to the left.
+     */
+    iterator erase(const_iterator pos)
+    {
+        size_type index = static_cast<size_type>(pos - cbegin());
+        erase(index);
+        return _data + index;
+    }
+
+    /**
+     * @brief Erase the elements in [first, last).
+     *
+     * @param first Iterator to the first element to erase.
+     * @param last Iterator past the last element to erase.
+     * @return Iterator following the last removed element.
+     *
+     * The elements after last are relocated to first in one pass, a single memmove for trivially relocatable types.
+     */
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_type index = static_cast<size_type>(first - cbegin());
+        size_type end_index = static_cast<size_type>(last - cbegin());
+        if (index != end_index)
         {
-            _data[i] = _data[i + 1];
+            std::destroy(_data + index, _data + end_index);
+            std::uninitialized_relocate(_data + end_index, _data + _size, _data + index);
+            _size -= end_index - index;
         }
-        _size--;
+        return _data + index;
+    }
+
+    /**
+     * @brief Erase an element at specified position by moving the last element into its place.
+     *
+     * @param pos Position of the element to erase.
+     *
+     * Runs in constant time but does not keep the order of the elements.
+     */
+    void swap_and_pop(size_type pos)
+    {
+        std::destroy_at(_data + pos);
+        --_size;
+        if (pos != _size)
+        {
+            std::uninitialized_relocate(_data + _size, _data + _size + 1, _data + pos);
+        }
+    }
+
+    /**
+     * @brief Erase the element at the specified iterator position by moving the last element into its place.
+     *
+     * @param pos Iterator to the element to erase.
+     * @return Iterator to the element that took the place of the removed one, or end().
+     */
+    iterator swap_and_pop(const_iterator pos)
+    {
+        size_type index = static_cast<size_type>(pos - cbegin());
+        swap_and_pop(index);
+        return _data + index;
     }
 
     /**
@@ -411,14 +450,12 @@ template<typename T> class vector final
      * @param pos Position of the element.
      * @return Reference to the element at position pos.
      *
-     * If pos is not within the range of the vector, a fatal error is logged.
+     * If pos is not within the range of the vector, the access fails as STD_BOUNDS_CHECK says: by default it
+     * throws std::out_of_range. See bounds_check.h.
      */
-    reference at(size_type pos)
+    reference at(size_type pos) noexcept(!std::detail::bounds_check_throws)
     {
-        if (pos >= _size)
-        {
-            throw std::out_of_range();
-        }
+        std::detail::check_bounds(pos < _size);
         return _data[pos];
     }
 
@@ -428,15 +465,39 @@ template<typename T> class vector final
      * @param pos Position of the element.
      * @return Const reference to the element at position pos.
      *
-     * If pos is not within the range of the vector, a fatal error is logged.
+     * If pos is not within the range of the vector, the access fails as STD_BOUNDS_CHECK says.
+     */
+    const_reference at(size_type pos) const noexcept(!std::detail::bounds_check_throws)
+    {
+        std::detail::check_bounds(pos < _size);
+        return _data[pos];
+    }
+
+    /**
+     * @brief Provides access to the element at specified position, reporting a bad position without throwing.
+     *
+     * @param pos Position of the element.
+     * @return A pointer to the element at position pos, or the std::out_of_range that at() would throw.
      */
-    const_reference at(size_type pos) const
+    std::Expected<T *, std::out_of_range> try_at(size_type pos) noexcept
     {
         if (pos >= _size)
         {
-            throw std::out_of_range();
+            return std::Expected<T *, std::out_of_range>::Unexpected(std::out_of_range());
         }
-        return _data[pos];
+        return _data + pos;
+    }
+
+    /**
+     * @brief Provides access to the element at specified position, reporting a bad position without throwing.
+     */
+    std::Expected<const T *, std::out_of_range> try_at(size_type pos) const noexcept
+    {
+        if (pos >= _size)
+        {
+            return std::Expected<const T *, std::out_of_range>::Unexpected(std::out_of_range());
+        }
+        return _data + pos;
     }
 
     /**
@@ -588,11 +649,12 @@ template<typename T> class vector final
      *
      * @return Reference to the first element in the vector.
      *
-     * Calling front() on an empty vector results in undefined behavior.
+     * Calling front() on an empty vector fails as STD_BOUNDS_CHECK says, see bounds_check.h.
      */
-    reference front() noexcept
+    reference front() noexcept(!std::detail::bounds_check_throws)
     {
-        return at(0);
+        std::detail::check_bounds(_size != 0);
+        return _data[0];
     }
 
     /**
@@ -600,11 +662,12 @@ template<typename T> class vector final
      *
      * @return Const reference to the first element in the vector.
      *
-     * Calling front() on an empty vector results in undefined behavior.
+     * Calling front() on an empty vector fails as STD_BOUNDS_CHECK says, see bounds_check.h.
      */
-    const_reference front() const noexcept
+    const_reference front() const noexcept(!std::detail::bounds_check_throws)
     {
-        return at(0);
+        std::detail::check_bounds(_size != 0);
+        return _data[0];
     }
 
     /**
@@ -612,11 +675,12 @@ template<typename T> class vector final
      *
      * @return Reference to the last element in the vector.
      *
-     * Calling back() on an empty vector results in undefined behavior.
+     * Calling back() on an empty vector fails as STD_BOUNDS_CHECK says, see bounds_check.h.
      */
-    reference back() noexcept
+    reference back() noexcept(!std::detail::bounds_check_throws)
     {
-        return at(_size - 1);
+        std::detail::check_bounds(_size != 0);
+        return _data[_size - 1];
     }
 
     /**
@@ -624,11 +688,12 @@ template<typename T> class vector final
      *
      * @return Const reference to the last element in the vector.
      *
-     * Calling back() on an empty vector results in undefined behavior.
+     * Calling back() on an empty vector fails as STD_BOUNDS_CHECK says, see bounds_check.h.
      */
-    const_reference back() const noexcept
+    const_reference back() const noexcept(!std::detail::bounds_check_throws)
     {
-        return at(_size - 1);
+        std::detail::check_bounds(_size != 0);
+        return _data[_size - 1];
     }
 
     /**
@@ -656,18 +721,15 @@ template<typename T> class vector final
     /**
      * @brief Clears the contents of the vector.
      *
-     * Erases all elements and deallocates memory. After a call to clear(),
-     * size() and capacity() both return 0.
+     * Erases all elements and deallocates memory. After a call to clear(), size() is 0 and so is capacity() for a
+     * vector; a small_vector is back on its inline buffer.
      */
     void clear() noexcept
     {
+        std::destroy(_data, _data + _size);
+        release_block();
+        derived().reset_storage();
         _size = 0;
-        _capacity = 0;
-        if (_data != nullptr)
-        {
-            delete[] _data;
-        }
-        _data = nullptr;
     }
 
     /**
@@ -679,8 +741,7 @@ template<typename T> class vector final
      */
     void push_back(const T &value)
     {
-        ensure_capacity(_size + 1);
-        _data[_size++] = value;
+        emplace_back(value);
     }
 
     /**
@@ -695,9 +756,31 @@ template<typename T> class vector final
     {
         if (_size == _capacity)
         {
-            reserve(_capacity == 0 ? 1 : _capacity * 2);
+            size_type new_cap = grown_capacity(_size + 1);
+            if (expand_in_place(new_cap))
+            {
+                std::construct_at(_data + _size, std::forward<Args>(args)...);
+            }
+            else if constexpr (can_reallocate)
+            {
+                // The arguments may refer to current elements, which reallocating can move
+                alignas(T) unsigned char staged[sizeof(T)];
+                T *value = std::construct_at(reinterpret_cast<T *>(staged), std::forward<Args>(args)...);
+                reallocate(new_cap);
+                std::uninitialized_relocate(value, value + 1, _data + _size);
+            }
+            else
+            {
+                // Construct into the new block before relocating, the arguments may refer to current elements
+                T *new_ptr = allocate(new_cap);
+                std::construct_at(new_ptr + _size, std::forward<Args>(args)...);
+                adopt(new_ptr, new_cap);
+            }
+        }
+        else
+        {
+            std::construct_at(_data + _size, std::forward<Args>(args)...);
         }
-        new (_data + _size) T(static_cast<Args &&>(args)...);
         ++_size;
     }
 
@@ -710,8 +793,7 @@ template<typename T> class vector final
      */
     void push_back(T &&value)
     {
-        ensure_capacity(_size + 1);
-        _data[_size++] = value;
+        emplace_back(std::move(value));
     }
 
     /**
@@ -724,6 +806,7 @@ template<typename T> class vector final
         if (_size > 0)
         {
             --_size;
+            std::destroy_at(_data + _size);
         }
     }
 
@@ -740,51 +823,199 @@ template<typename T> class vector final
     {
         if (count > _size)
         {
-            while (_size < count)
-            {
-                push_back(value);
-            }
+            T copy(value);
+            ensure_capacity(count);
+            std::uninitialized_fill_n(_data + _size, count - _size, copy);
         }
         else
         {
-            while (_size > count)
-            {
-                pop_back();
-            }
+            std::destroy(_data + count, _data + _size);
         }
+        _size = count;
     }
 
     /**
-     * @brief Swaps the contents with another vector.
+     * @brief Resizes the vector to contain count elements, default-initializing new ones.
      *
-     * @param other The vector to swap with.
+     * For trivial types the new elements are left uninitialized, so they can be filled in through data(), e.g. by a
+     * bulk read, without first being zeroed.
      *
-     * Exchanges the underlying data pointers and the size/capacity values.
+     * @param count The new size of the vector.
      */
-    void swap(vector &other) noexcept
+    void resize_for_overwrite(size_type count)
     {
-        std::swap(_data, other._data);
-        size_type temp_size = _size;
-        size_type temp_capacity = _capacity;
+        if (count > _size)
+        {
+            ensure_capacity(count);
+            for (T *slot = _data + _size; slot != _data + count; ++slot)
+            {
+                ::new (static_cast<void *>(slot)) T;
+            }
+        }
+        else
+        {
+            std::destroy(_data + count, _data + _size);
+        }
+        _size = count;
+    }
 
-        _size = other._size;
-        _capacity = other._capacity;
+  protected:
+    constexpr vector_base() = default;
 
-        other._size = temp_size;
-        other._capacity = temp_capacity;
+    constexpr explicit vector_base(const Allocator &alloc) noexcept
+        : _alloc{alloc}
+    {
     }
 
-  private:
-    T *_data = nullptr;      ///< Pointer to the dynamically allocated array of elements.
+    vector_base(const vector_base &) = delete;
+    vector_base &operator=(const vector_base &) = delete;
+
+    /**
+     * @brief Not virtual and protected: a container is never destroyed through this class, and destroys its elements
+     * itself.
+     */
+    ~vector_base() = default;
+
+    T *_data = nullptr;      ///< Pointer to the uninitialized storage holding the elements.
     size_type _size = 0;     ///< The number of elements in the vector.
     size_type _capacity = 0; ///< The current allocated capacity.
+    STD_NO_UNIQUE_ADDRESS Allocator _alloc{}; ///< Source of the element storage.
+
+    constexpr Derived &derived() noexcept
+    {
+        return static_cast<Derived &>(*this);
+    }
+
+    constexpr const Derived &derived() const noexcept
+    {
+        return static_cast<const Derived &>(*this);
+    }
+
+    /**
+     * @brief Allocates uninitialized storage for count elements.
+     */
+    T *allocate(size_type count)
+    {
+        return std::allocator_traits<Allocator>::allocate(_alloc, count);
+    }
+
+    /**
+     * @brief Releases storage of count elements obtained from allocate(). The elements must already be destroyed or
+     * relocated.
+     */
+    void deallocate(T *ptr, size_type count) noexcept
+    {
+        std::allocator_traits<Allocator>::deallocate(_alloc, ptr, count);
+    }
+
+    /**
+     * @brief Releases the current block if it came from allocate(). The elements must already be destroyed or
+     * relocated.
+     */
+    void release_block() noexcept
+    {
+        if (derived().has_block())
+        {
+            deallocate(_data, _capacity);
+        }
+    }
+
+    /**
+     * @brief Computes the capacity to grow to so that at least required elements fit.
+     */
+    size_type grown_capacity(size_type required) const noexcept
+    {
+        return Growth::grow(_capacity, required, sizeof(T));
+    }
+
+    /// True when the allocator can move a block without copying it and the elements may be moved bytewise.
+    static constexpr bool can_reallocate =
+        std::is_trivially_relocatable_v<T> && std::allocator_traits<Allocator>::can_reallocate;
+
+    /**
+     * @brief Reports the storage changing to new_cap elements to the allocation stats, see alloc_stats.h.
+     */
+    void note_growth(size_type new_cap, bool in_place) const noexcept
+    {
+        std::detail::alloc_note_growth(_size * sizeof(T), _capacity * sizeof(T), new_cap * sizeof(T), in_place);
+    }
+
+    /**
+     * @brief Grows the current block to new_cap elements where it is, if the allocator can.
+     */
+    bool expand_in_place(size_type new_cap) noexcept
+    {
+        if (derived().has_block() && std::allocator_traits<Allocator>::try_expand(_alloc, _data, _capacity, new_cap))
+        {
+            note_growth(new_cap, true);
+            _capacity = new_cap;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Relocates the current elements into new_ptr and makes it the vector's storage.
+     */
+    void adopt(T *new_ptr, size_type new_cap) noexcept
+    {
+        note_growth(new_cap, false);
+        std::uninitialized_relocate(_data, _data + _size, new_ptr);
+        release_block();
+        _data = new_ptr;
+        _capacity = new_cap;
+    }
+
+    /**
+     * @brief Moves the elements to a block of exactly new_cap elements, releasing it if new_cap is zero.
+     *
+     * The block is resized by the allocator where it can be, which leaves the elements in place or moves them
+     * without a copy through this vector.
+     */
+    void reallocate(size_type new_cap) noexcept
+    {
+        STD_TRACE_SCOPE_VALUE("vector reallocate", new_cap * sizeof(T));
+        if (new_cap == 0)
+        {
+            release_block();
+            derived().reset_storage();
+            return;
+        }
+        if ((new_cap > _capacity && expand_in_place(new_cap)) || (_size > 0 && resize_block(new_cap)))
+        {
+            return;
+        }
+        adopt(allocate(new_cap), new_cap);
+    }
+
+    /**
+     * @brief Has the allocator resize the block to new_cap elements, moving it if needed, when can_reallocate.
+     */
+    bool resize_block(size_type new_cap) noexcept
+    {
+        if constexpr (can_reallocate)
+        {
+            T *resized = derived().has_block()
+                             ? std::allocator_traits<Allocator>::reallocate(_alloc, _data, _capacity, new_cap)
+                             : nullptr;
+            if (resized != nullptr)
+            {
+                note_growth(new_cap, false);
+                _data = resized;
+                _capacity = new_cap;
+                return true;
+            }
+        }
+        (void)new_cap;
+        return false;
+    }
 
     /**
      * @brief Ensures that the vector has at least new_capacity storage.
      *
-     * If new_capacity is greater than the current capacity, a new block of memory is allocated,
-     * the existing elements are copied using memcpy (assuming trivially copyable types),
-     * and the old memory is released.
+     * If new_capacity is greater than the current capacity, a new block of uninitialized memory is
+     * allocated, the existing elements are relocated into it and the old block is released without
+     * running any destructors on the moved-from storage.
      *
      * @param new_capacity The required minimum capacity.
      */
@@ -792,22 +1023,363 @@ template<typename T> class vector final
     {
         if (new_capacity > _capacity)
         {
-            size_type new_cap = (_capacity == 0) ? 8 : _capacity * 2;
-            if (new_cap < new_capacity)
-            {
-                new_cap = new_capacity;
-            }
+            reallocate(grown_capacity(new_capacity));
+        }
+    }
 
-            T *new_ptr = new T[new_cap];
-            if (_data != nullptr && _size > 0)
+    /**
+     * @brief Opens a gap of n uninitialized slots at pos, growing the storage if needed.
+     *
+     * The elements from pos onwards are relocated n slots to the right. The caller must construct
+     * the n new elements and update _size.
+     */
+    void open_gap(size_type pos, size_type n)
+    {
+        if (_size + n > _capacity)
+        {
+            size_type new_cap = grown_capacity(_size + n);
+            STD_TRACE_SCOPE_VALUE("vector reallocate", new_cap * sizeof(T));
+            if (expand_in_place(new_cap) || resize_block(new_cap))
             {
-                memcpy(new_ptr, _data, _size * sizeof(T));
+                std::uninitialized_relocate_backward(_data + pos, _data + _size, _data + _size + n);
+                return;
             }
-            delete[] _data;
+            // Relocate both halves straight into the new block instead of shifting twice
+            T *new_ptr = allocate(new_cap);
+            note_growth(new_cap, false);
+            std::uninitialized_relocate(_data, _data + pos, new_ptr);
+            std::uninitialized_relocate(_data + pos, _data + _size, new_ptr + pos + n);
+            release_block();
             _data = new_ptr;
             _capacity = new_cap;
+            return;
+        }
+        std::uninitialized_relocate_backward(_data + pos, _data + _size, _data + _size + n);
+    }
+};
+} // namespace detail
+
+/**
+ * @brief A dynamic array that stores elements contiguously.
+ *
+ * This template class provides a simplified version of the standard
+ * vector container. Elements are stored in a contiguous block of memory
+ * and the container supports dynamic resizing, random access, and efficient
+ * insertion/removal at the end.
+ *
+ * Storage beyond size() is left uninitialized, so growing never constructs
+ * unused capacity. Elements are relocated when the storage grows: a single
+ * memcpy for trivially relocatable types, move construction plus destruction
+ * for everything else.
+ *
+ * All storage is obtained from the allocator. The default std::allocator
+ * forwards to the global operator new[] and so to the os:: hooks; it is
+ * stateless and takes up no space in the vector.
+ *
+ * @tparam T Type of elements stored in the vector. Must not be void.
+ * When the storage runs out it grows as the Growth policy decides, see
+ * growth_policy.h. An allocator that can resize a block in place, or move it
+ * without copying the way mremap does, is asked to first: for any element
+ * type if the block stays where it is, for trivially relocatable ones also if
+ * it moves.
+ *
+ * @tparam Allocator Allocator used for the element storage.
+ * @tparam Growth Policy for the capacity to grow to.
+ */
+template<typename T, typename Allocator = std::allocator<T>, typename Growth = std::default_growth>
+class vector final : public detail::vector_base<T, Allocator, Growth, vector<T, Allocator, Growth>>
+{
+    using base = detail::vector_base<T, Allocator, Growth, vector<T, Allocator, Growth>>;
+    friend base;
+
+  public:
+    using typename base::size_type;
+
+    /**
+     * @brief Default constructor.
+     *
+     * Constructs an empty vector with no elements.
+     */
+    constexpr vector() = default;
+
+    /**
+     * @brief Constructs an empty vector that allocates from alloc.
+     *
+     * @param alloc The allocator to use for all allocations.
+     */
+    constexpr explicit vector(const Allocator &alloc) noexcept
+        : base(alloc)
+    {
+    }
+
+    /**
+     * @brief Constructs a vector with a specified number of copies of a value.
+     *
+     * @param count Number of elements to initialize.
+     * @param value Value to assign to each element (default is a default-constructed T).
+     * @param alloc The allocator to use for all allocations.
+     *
+     * If count is zero, no memory is allocated.
+     */
+    constexpr explicit vector(size_type count, const T &value = T(), const Allocator &alloc = Allocator()) noexcept
+        : base(alloc)
+    {
+        if (count > 0)
+        {
+            _data = this->allocate(count);
+            _capacity = count;
+            std::uninitialized_fill_n(_data, count, value);
+            _size = count;
+        }
+    }
+
+    /**
+     * @brief Copy constructor.
+     *
+     * Constructs a new vector as a copy of the provided vector. The allocator is
+     * chosen by allocator_traits::select_on_container_copy_construction().
+     *
+     * @param other The vector to copy.
+     */
+    constexpr vector(const vector &other) noexcept
+        : vector(other, std::allocator_traits<Allocator>::select_on_container_copy_construction(other._alloc))
+    {
+    }
+
+    /**
+     * @brief Copy constructor with an explicit allocator.
+     *
+     * @param other The vector to copy.
+     * @param alloc The allocator to use for all allocations.
+     */
+    constexpr vector(const vector &other, const Allocator &alloc) noexcept
+        : base(alloc)
+    {
+        if (other._size > 0)
+        {
+            _data = this->allocate(other._size);
+            _capacity = other._size;
+            std::uninitialized_copy(other._data, other._data + other._size, _data);
+            _size = other._size;
+        }
+    }
+
+    /**
+     * @brief Move constructor.
+     *
+     * Constructs a vector by transferring the resources from another vector.
+     *
+     * @param other The vector to move from.
+     *
+     * After the move, the other vector is left in a valid, empty state.
+     */
+    constexpr vector(vector &&other) noexcept
+        : base(other._alloc)
+    {
+        swap(other);
+    }
+
+    constexpr vector(std::initializer_list<T> list, const Allocator &alloc = Allocator()) noexcept
+        : base(alloc)
+    {
+        if (list.size() > 0)
+        {
+            _data = this->allocate(list.size());
+            _capacity = list.size();
+            std::uninitialized_copy(list.begin(), list.end(), _data);
+            _size = list.size();
         }
     }
+
+    /**
+     * @brief Destructor.
+     *
+     * Releases all memory allocated for the vector.
+     */
+    ~vector()
+    {
+        if (_data != nullptr)
+        {
+            std::destroy(_data, _data + _size);
+            this->deallocate(_data, _capacity);
+        }
+    }
+
+    /**
+     * @brief Copy assignment operator.
+     *
+     * Replaces the contents with a copy of the contents of another vector.
+     * This vector keeps its allocator.
+     *
+     * @param other The vector to copy from.
+     * @return Reference to this vector.
+     */
+    constexpr vector &operator=(const vector &other) noexcept
+    {
+        if (this != &other)
+        {
+            vector temp(other, _alloc);
+            swap(temp);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief Move assignment operator.
+     *
+     * Replaces the contents by moving the contents from another vector.
+     * The storage is taken over when both allocators compare equal; otherwise
+     * the elements are relocated into storage from this vector's allocator.
+     *
+     * @param other The vector to move from.
+     * @return Reference to this vector.
+     */
+    constexpr vector &operator=(vector &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (_alloc == other._alloc)
+            {
+                swap(other);
+            }
+            else
+            {
+                this->clear();
+                if (other._size > 0)
+                {
+                    _data = this->allocate(other._size);
+                    _capacity = other._size;
+                    std::uninitialized_relocate(other._data, other._data + other._size, _data);
+                    _size = other._size;
+                    other._size = 0;
+                }
+                other.clear();
+            }
+        }
+        return *this;
+    }
+
+    constexpr vector &operator=(std::initializer_list<T> list) noexcept
+    {
+        vector temp(list, _alloc);
+        swap(temp);
+        return *this;
+    }
+
+    /**
+     * @brief Shrinks the capacity to fit the current size.
+     *
+     * Requests the container to reduce its capacity to fit its size.
+     */
+    void shrink_to_fit() noexcept
+    {
+        if (_capacity > _size)
+        {
+            this->reallocate(_size);
+        }
+    }
+
+    /**
+     * @brief Swaps the contents with another vector.
+     *
+     * @param other The vector to swap with.
+     *
+     * Exchanges the underlying data pointers, the size/capacity values and the allocators.
+     */
+    void swap(vector &other) noexcept
+    {
+        std::swap(_data, other._data);
+        std::swap(_alloc, other._alloc);
+        size_type temp_size = _size;
+        size_type temp_capacity = _capacity;
+
+        _size = other._size;
+        _capacity = other._capacity;
+
+        other._size = temp_size;
+        other._capacity = temp_capacity;
+    }
+
+  private:
+    using base::_alloc;
+    using base::_capacity;
+    using base::_data;
+    using base::_size;
+
+    //! A vector owns every block it points at; an empty one may hold nullptr instead.
+    constexpr bool has_block() const noexcept
+    {
+        return _data != nullptr;
+    }
+
+    constexpr void reset_storage() noexcept
+    {
+        _data = nullptr;
+        _capacity = 0;
+    }
+};
+
+/**
+ * @brief Erases every element of a vector or small_vector for which pred returns true, keeping the order of the
+ * others.
+ *
+ * The kept elements are moved down in one pass and the tail is erased at once.
+ *
+ * @return The number of elements erased.
+ */
+template<typename T, typename Allocator, typename Growth, typename Derived, typename Predicate>
+size_t erase_if(detail::vector_base<T, Allocator, Growth, Derived> &v, Predicate pred)
+{
+    T *first = v.begin();
+    T *last = v.end();
+    while (first != last && !pred(*first))
+    {
+        ++first;
+    }
+    if (first == last)
+    {
+        return 0;
+    }
+    for (T *it = first + 1; it != last; ++it)
+    {
+        if (!pred(*it))
+        {
+            *first = std::move(*it);
+            ++first;
+        }
+    }
+    size_t erased = static_cast<size_t>(last - first);
+    v.erase(first, last);
+    return erased;
+}
+
+/**
+ * @brief Erases every element of a vector or small_vector equal to value, keeping the order of the others.
+ *
+ * @return The number of elements erased.
+ */
+template<typename T, typename Allocator, typename Growth, typename Derived, typename U>
+size_t erase(detail::vector_base<T, Allocator, Growth, Derived> &v, const U &value)
+{
+    return erase_if(v, [&value](const T &element) { return element == value; });
+}
+
+/**
+ * @brief A vector only owns its elements through a pointer, so it can be relocated with memcpy as long as its
+ * allocator can.
+ */
+template<typename T, typename Allocator, typename Growth>
+struct is_trivially_relocatable<vector<T, Allocator, Growth>>
+    : integral_constant<bool, is_trivially_relocatable_v<Allocator>>
+{
 };
+
+namespace pmr
+{
+/**
+ * @brief A vector that allocates from a memory_resource.
+ */
+template<typename T> using vector = std::vector<T, polymorphic_allocator<T>>;
+} // namespace pmr
 } // namespace std
 #endif
@@ -0,0 +1,203 @@
+#include <algorithm.h>
+#include <cstring.h>
+#include "test.h"
+
+static unsigned char buffer_a[512];
+static unsigned char buffer_b[512];
+
+static void fill_pattern(unsigned char *buf, unsigned long size)
+{
+    for (unsigned long i = 0; i < size; i++)
+    {
+        buf[i] = static_cast<unsigned char>(i * 7 + 3);
+    }
+}
+
+void test_memcpy()
+{
+    for (unsigned long size = 0; size < 300; size += 13)
+    {
+        fill_pattern(buffer_a, sizeof(buffer_a));
+        std::memset(buffer_b, 0, sizeof(buffer_b));
+        std::memcpy(buffer_b + 3, buffer_a + 1, size);
+        for (unsigned long i = 0; i < size; i++)
+        {
+            TEST_CHECK(buffer_b[i + 3] == buffer_a[i + 1]);
+        }
+        TEST_CHECK(buffer_b[size + 3] == 0);
+    }
+}
+
+void test_memmove_overlap()
+{
+    fill_pattern(buffer_a, sizeof(buffer_a));
+    std::memmove(buffer_a + 5, buffer_a, 200);
+    for (unsigned long i = 0; i < 200; i++)
+    {
+        TEST_CHECK(buffer_a[i + 5] == static_cast<unsigned char>(i * 7 + 3));
+    }
+    fill_pattern(buffer_a, sizeof(buffer_a));
+    std::memmove(buffer_a, buffer_a + 37, 200);
+    for (unsigned long i = 0; i < 200; i++)
+    {
+        TEST_CHECK(buffer_a[i] == static_cast<unsigned char>((i + 37) * 7 + 3));
+    }
+}
+
+void test_memset()
+{
+    std::memset(buffer_a, 0, sizeof(buffer_a));
+    std::memset(buffer_a + 1, 0xAB, 100);
+    TEST_CHECK(buffer_a[0] == 0);
+    TEST_CHECK(buffer_a[1] == 0xAB);
+    TEST_CHECK(buffer_a[100] == 0xAB);
+    TEST_CHECK(buffer_a[101] == 0);
+}
+
+void test_memcmp()
+{
+    fill_pattern(buffer_a, sizeof(buffer_a));
+    fill_pattern(buffer_b, sizeof(buffer_b));
+    TEST_CHECK(std::memcmp(buffer_a, buffer_b, 300) == 0);
+    buffer_b[150] = static_cast<unsigned char>(buffer_a[150] + 1);
+    TEST_CHECK(std::memcmp(buffer_a, buffer_b, 300) == -1);
+    TEST_CHECK(std::memcmp(buffer_b, buffer_a, 300) == 1);
+    TEST_CHECK(std::memcmp(buffer_a, buffer_b, 150) == 0);
+}
+
+void test_strlen()
+{
+    TEST_CHECK(strlen("") == 0);
+    TEST_CHECK(strlen("hello") == 5);
+    TEST_CHECK(strlen("a string that is longer than one vector register") == 48);
+}
+
+void test_strcmp()
+{
+    TEST_CHECK(strcmp("abc", "abc") == 0);
+    TEST_CHECK(strcmp("abc", "abd") < 0);
+    TEST_CHECK(strcmp("b", "abc") > 0);
+    TEST_CHECK(strcmp("ab", "abc") < 0);
+    TEST_CHECK(strcmp("a string that is longer than one vector register!",
+                      "a string that is longer than one vector register?") < 0);
+}
+
+static int sort_values[2000];
+
+static unsigned next_random(unsigned &state)
+{
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+static bool is_sorted_ascending(const int *first, const int *last)
+{
+    for (const int *it = first + 1; it < last; ++it)
+    {
+        if (*it < *(it - 1))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_sort()
+{
+    const unsigned long count = sizeof(sort_values) / sizeof(sort_values[0]);
+    unsigned state = 12345;
+    for (unsigned long i = 0; i < count; i++)
+    {
+        sort_values[i] = static_cast<int>(next_random(state) % 1000) - 500;
+    }
+    std::sort(sort_values, sort_values + count);
+    TEST_CHECK(is_sorted_ascending(sort_values, sort_values + count));
+
+    for (unsigned long i = 0; i < count; i++)
+    {
+        sort_values[i] = static_cast<int>(count - i);
+    }
+    std::sort(sort_values, sort_values + count);
+    TEST_CHECK(is_sorted_ascending(sort_values, sort_values + count) && sort_values[0] == 1);
+    std::sort(sort_values, sort_values + count, std::greater<>());
+    TEST_CHECK(sort_values[0] == static_cast<int>(count) && sort_values[count - 1] == 1);
+
+    for (unsigned long i = 0; i < count; i++)
+    {
+        sort_values[i] = 7;
+    }
+    std::sort(sort_values, sort_values + count);
+    TEST_CHECK(sort_values[0] == 7 && sort_values[count - 1] == 7);
+
+    // A comparator the branchless path does not apply to
+    for (unsigned long i = 0; i < count; i++)
+    {
+        sort_values[i] = static_cast<int>(next_random(state) % 100000);
+    }
+    std::sort(sort_values, sort_values + count, [](int a, int b) { return a % 10 < b % 10; });
+    for (unsigned long i = 1; i < count; i++)
+    {
+        TEST_CHECK(sort_values[i - 1] % 10 <= sort_values[i] % 10);
+    }
+}
+
+struct sort_record
+{
+    int key;
+    int order;
+};
+
+void test_stable_sort()
+{
+    static sort_record records[500];
+    const unsigned long count = sizeof(records) / sizeof(records[0]);
+    unsigned state = 99;
+    for (unsigned long i = 0; i < count; i++)
+    {
+        records[i] = {static_cast<int>(next_random(state) % 16), static_cast<int>(i)};
+    }
+    std::stable_sort(records, records + count,
+                     [](const sort_record &a, const sort_record &b) { return a.key < b.key; });
+    for (unsigned long i = 1; i < count; i++)
+    {
+        TEST_CHECK(records[i - 1].key < records[i].key ||
+                   (records[i - 1].key == records[i].key && records[i - 1].order < records[i].order));
+    }
+}
+
+void test_partial_sort()
+{
+    const unsigned long count = 1000;
+    unsigned state = 7;
+    for (unsigned long i = 0; i < count; i++)
+    {
+        sort_values[i] = static_cast<int>(next_random(state) % 5000);
+    }
+    std::partial_sort(sort_values, sort_values + 10, sort_values + count);
+    TEST_CHECK(is_sorted_ascending(sort_values, sort_values + 10));
+    for (unsigned long i = 10; i < count; i++)
+    {
+        TEST_CHECK(sort_values[i] >= sort_values[9]);
+    }
+
+    for (unsigned long i = 0; i < count; i++)
+    {
+        sort_values[i] = static_cast<int>(next_random(state) % 5000);
+    }
+    int *nth = sort_values + 333;
+    std::nth_element(sort_values, nth, sort_values + count);
+    for (int *it = sort_values; it < sort_values + count; ++it)
+    {
+        TEST_CHECK(it < nth ? *it <= *nth : *it >= *nth);
+    }
+}
+
+TEST("memcpy", memcpy_test, test_memcpy);
+TEST("memmove overlap", memmove_overlap_test, test_memmove_overlap);
+TEST("memset", memset_test, test_memset);
+TEST("memcmp", memcmp_test, test_memcmp);
+TEST("strlen", strlen_test, test_strlen);
+TEST("strcmp", strcmp_test, test_strcmp);
+TEST("sort", sort_test, test_sort);
+TEST("stable sort", stable_sort_test, test_stable_sort);
+TEST("partial sort", partial_sort_test, test_partial_sort);
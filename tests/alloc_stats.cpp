@@ -0,0 +1,89 @@
+#include <new.h>
+#include <string.h>
+#include <vector.h>
+#include "test.h"
+#if defined(STD_ENABLE_ALLOC_STATS)
+
+void test_alloc_stats_counters()
+{
+    std::alloc_stats::counters before = std::alloc_stats::snapshot();
+    void *block = ::operator new(100);
+    std::alloc_stats::counters during = std::alloc_stats::snapshot();
+    TEST_CHECK(during.allocations == before.allocations + 1 && during.current_bytes == before.current_bytes + 100);
+    TEST_CHECK(during.peak_bytes >= during.current_bytes && during.total_bytes == before.total_bytes + 100);
+    TEST_CHECK(std::alloc_stats::bucket_of(100) == 7 && std::alloc_stats::bucket_of(128) == 7 &&
+               std::alloc_stats::bucket_of(129) == 8 && std::alloc_stats::bucket_of(1) == 0);
+    TEST_CHECK(during.histogram[7] == before.histogram[7] + 1);
+    ::operator delete(block);
+    std::alloc_stats::counters after = std::alloc_stats::snapshot();
+    TEST_CHECK(after.frees == before.frees + 1 && after.current_bytes == before.current_bytes);
+
+    // The header in front of the block must not break its alignment
+    void *aligned = ::operator new(40, std::align_val_t(256));
+    TEST_CHECK((reinterpret_cast<unsigned long>(aligned) & 255) == 0);
+    ::operator delete(aligned, std::align_val_t(256));
+    TEST_CHECK(std::alloc_stats::snapshot().current_bytes == before.current_bytes);
+}
+
+void test_alloc_stats_tags()
+{
+    std::alloc_stats::tag_counters before = std::alloc_stats::tag("alloc stats test");
+    std::alloc_stats::counters totals = std::alloc_stats::snapshot();
+    {
+        STD_ALLOC_TAG("alloc stats test");
+        std::vector<int> numbers;
+        for (int i = 0; i < 100; i++)
+        {
+            numbers.push_back(i);
+        }
+        {
+            STD_ALLOC_TAG("alloc stats inner");
+            std::string text("a string long enough to live on the heap");
+            text.append(" and then some more to make it grow");
+        }
+        std::alloc_stats::tag_counters during = std::alloc_stats::tag("alloc stats test");
+        TEST_CHECK(during.current_bytes == numbers.capacity() * sizeof(int) && during.allocations > before.allocations);
+        TEST_CHECK(during.growths > before.growths);
+    }
+    std::alloc_stats::tag_counters after = std::alloc_stats::tag("alloc stats test");
+    TEST_CHECK(after.current_bytes == 0 && after.frees == after.allocations);
+    std::alloc_stats::tag_counters inner = std::alloc_stats::tag("alloc stats inner");
+    TEST_CHECK(inner.allocations >= 1 && inner.growths >= 1 && inner.current_bytes == 0);
+
+    std::alloc_stats::counters now = std::alloc_stats::snapshot();
+    TEST_CHECK(now.growths > totals.growths && now.slack_bytes >= totals.slack_bytes);
+    TEST_CHECK(std::alloc_stats::tag("never used").allocations == 0);
+}
+
+static unsigned long dumped_lines = 0;
+static bool dumped_tag = false;
+
+static void count_line(const char *line)
+{
+    dumped_lines++;
+    const char expected[] = "  tag alloc stats test:";
+    unsigned long i = 0;
+    for (; expected[i] != '\0' && line[i] == expected[i]; i++)
+    {
+    }
+    dumped_tag = dumped_tag || expected[i] == '\0';
+}
+
+void test_alloc_stats_dump()
+{
+    {
+        STD_ALLOC_TAG("alloc stats test");
+        std::vector<int> numbers(10);
+    }
+    std::alloc_stats::dump(count_line);
+    TEST_CHECK(dumped_lines >= 3 && dumped_tag);
+
+    std::alloc_stats::reset();
+    std::alloc_stats::counters reset = std::alloc_stats::snapshot();
+    TEST_CHECK(reset.allocations == 0 && reset.growths == 0 && reset.peak_bytes == reset.current_bytes);
+}
+
+TEST("alloc stats counters", alloc_stats_counters, test_alloc_stats_counters);
+TEST("alloc stats tags", alloc_stats_tags, test_alloc_stats_tags);
+TEST("alloc stats dump", alloc_stats_dump, test_alloc_stats_dump);
+#endif
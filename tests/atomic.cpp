@@ -0,0 +1,200 @@
+#include <atomic.h>
+#include <concurrent_queue.h>
+#include <memory_resource.h>
+#include <string.h>
+#include <thread.h>
+#include <vector.h>
+#include "test.h"
+
+//! Whether value can be stored to or incremented through an A &.
+template<typename A> concept modifiable = requires(A &value) {
+    value.store(1);
+    ++value;
+};
+
+void test_atomic()
+{
+    std::atomic<int> counter(5);
+    TEST_CHECK(counter.load() == 5 && counter.fetch_add(3) == 5 && ++counter == 9 && counter-- == 9);
+    TEST_CHECK((counter |= 0x10) == 0x18 && (counter &= 0x1C) == 0x18 && counter.exchange(1) == 0x18);
+    int expected = 2;
+    TEST_CHECK(!counter.compare_exchange_strong(expected, 7) && expected == 1);
+    TEST_CHECK(counter.compare_exchange_strong(expected, 7, std::memory_order_acq_rel) && counter == 7);
+    TEST_CHECK(std::atomic<int>::is_always_lock_free && counter.is_lock_free());
+
+    long values[4] = {10, 20, 30, 40};
+    std::atomic<long *> cursor(values);
+    TEST_CHECK(*cursor.fetch_add(2) == 10 && *cursor.load() == 30 && *--cursor == 20);
+
+    // Any trivially copyable type, copied whole
+    struct pair
+    {
+        int first;
+        int second;
+    };
+    std::atomic<pair> both(pair{1, 2});
+    pair old = both.exchange(pair{3, 4}, std::memory_order_relaxed);
+    TEST_CHECK(old.first == 1 && both.load().second == 4);
+    TEST_CHECK(std::atomic<pair>::required_alignment == 8);
+
+    unsigned long plain = 40;
+    std::atomic_ref<unsigned long> ref(plain);
+    ref += 2;
+    TEST_CHECK(ref.load(std::memory_order_acquire) == 42 && plain == 42);
+    // An atomic_ref is a handle, so a const one still modifies its object; a const atomic can only be loaded
+    const std::atomic_ref<unsigned long> handle(plain);
+    TEST_CHECK(handle.fetch_sub(2) == 42 && plain == 40);
+    static_assert(modifiable<std::atomic<int>> && modifiable<const std::atomic_ref<int>>);
+    static_assert(!modifiable<const std::atomic<int>>);
+
+    std::atomic_flag flag;
+    TEST_CHECK(!flag.test_and_set() && flag.test_and_set() && flag.test());
+    flag.clear(std::memory_order_release);
+    TEST_CHECK(!flag.test());
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void test_spsc_queue()
+{
+    std::spsc_queue<std::string> queue(3);
+    TEST_CHECK(queue.capacity() == 4 && queue.empty());
+    TEST_CHECK(queue.try_push(std::string("a string long enough to live on the heap")));
+    TEST_CHECK(queue.try_emplace("b") && queue.try_emplace("c") && queue.try_emplace("d") && !queue.try_emplace("e"));
+    std::string out;
+    TEST_CHECK(queue.try_pop(out) && out == std::string("a string long enough to live on the heap"));
+
+    std::string batch[3] = {std::string("e"), std::string("f"), std::string("g")};
+    TEST_CHECK(queue.push_batch(batch, 3) == 1 && queue.size_approx() == 4);
+    std::vector<std::string> popped(8);
+    TEST_CHECK(queue.pop_batch(popped.begin(), 8) == 4 && popped[0] == std::string("b") &&
+               popped[3] == std::string("e"));
+    TEST_CHECK(queue.empty() && !queue.try_pop(out) && queue.pop_batch(popped.begin(), 8) == 0);
+
+    // The ring wraps many times over; values left in it are destroyed with it
+    std::spsc_queue<std::string> leftover(2);
+    for (int i = 0; i < 100; i++)
+    {
+        TEST_CHECK(leftover.try_emplace("x") && leftover.try_pop(out));
+    }
+    TEST_CHECK(leftover.try_emplace("a string long enough to live on the heap"));
+}
+
+void test_mpmc_queue()
+{
+    std::pmr::monotonic_buffer_resource arena;
+    std::mpmc_queue<int, std::pmr::polymorphic_allocator<int>> queue(1, &arena);
+    TEST_CHECK(queue.capacity() == 2 && queue.try_push(1) && queue.try_push(2) && !queue.try_push(3));
+    int out = 0;
+    TEST_CHECK(queue.try_pop(out) && out == 1 && queue.try_push(3) && queue.size_approx() == 2);
+
+    std::mpmc_queue<int> wide(8);
+    int values[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    TEST_CHECK(wide.push_batch(values, 5) == 5 && wide.push_batch(values + 5, 5) == 3);
+    int popped[10] = {};
+    TEST_CHECK(wide.pop_batch(popped, 6) == 6 && popped[5] == 5 && wide.pop_batch(popped, 6) == 2 && popped[1] == 7);
+    TEST_CHECK(wide.empty() && !wide.try_pop(out) && wide.pop_batch(popped, 4) == 0);
+}
+
+#if defined(STD_HAS_OS_THREADS)
+namespace
+{
+constexpr unsigned long queue_items = 200000;
+
+struct mpmc_run
+{
+    std::mpmc_queue<unsigned long> queue{64};
+    std::atomic<unsigned long> produced{0};
+    std::atomic<unsigned long> consumed{0};
+    std::atomic<unsigned long> sum{0};
+};
+
+void produce(void *argument)
+{
+    mpmc_run &run = *static_cast<mpmc_run *>(argument);
+    unsigned long value;
+    while ((value = run.produced.fetch_add(1, std::memory_order_relaxed)) < queue_items)
+    {
+        while (!run.queue.try_push(value + 1))
+        {
+            std::detail::cpu_relax();
+        }
+    }
+}
+
+void consume(void *argument)
+{
+    mpmc_run &run = *static_cast<mpmc_run *>(argument);
+    unsigned long batch[16];
+    while (run.consumed.load(std::memory_order_relaxed) < queue_items)
+    {
+        std::size_t count = run.queue.pop_batch(batch, 16);
+        unsigned long total = 0;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            total += batch[i];
+        }
+        run.sum.fetch_add(total, std::memory_order_relaxed);
+        run.consumed.fetch_add(count, std::memory_order_relaxed);
+    }
+}
+
+struct spsc_run
+{
+    std::spsc_queue<unsigned long> queue{128};
+    bool in_order = true;
+};
+
+void produce_in_order(void *argument)
+{
+    spsc_run &run = *static_cast<spsc_run *>(argument);
+    unsigned long batch[8];
+    for (unsigned long next = 0; next < queue_items;)
+    {
+        for (unsigned long i = 0; i < 8; i++)
+        {
+            batch[i] = next + i;
+        }
+        unsigned long wanted = queue_items - next < 8 ? queue_items - next : 8;
+        next += run.queue.push_batch(batch, wanted);
+    }
+}
+} // namespace
+
+void test_queue_threads()
+{
+    mpmc_run *run = new mpmc_run;
+    void *threads[4];
+    threads[0] = os::thread_spawn(&produce, run);
+    threads[1] = os::thread_spawn(&produce, run);
+    threads[2] = os::thread_spawn(&consume, run);
+    threads[3] = os::thread_spawn(&consume, run);
+    for (void *thread : threads)
+    {
+        os::thread_join(thread);
+    }
+    TEST_CHECK(run->consumed.load() == queue_items && run->queue.empty());
+    TEST_CHECK(run->sum.load() == queue_items * (queue_items + 1) / 2);
+    delete run;
+
+    spsc_run *ordered = new spsc_run;
+    void *producer = os::thread_spawn(&produce_in_order, ordered);
+    unsigned long value = 0;
+    for (unsigned long expected = 0; expected < queue_items;)
+    {
+        if (ordered->queue.try_pop(value))
+        {
+            ordered->in_order = ordered->in_order && value == expected;
+            expected++;
+        }
+    }
+    os::thread_join(producer);
+    TEST_CHECK(ordered->in_order && ordered->queue.empty());
+    delete ordered;
+}
+
+TEST("queue threads", queue_threads, test_queue_threads);
+#endif
+
+TEST("atomic", atomics, test_atomic);
+TEST("spsc queue", spsc, test_spsc_queue);
+TEST("mpmc queue", mpmc, test_mpmc_queue);
@@ -0,0 +1,205 @@
+#include <charconv.h>
+#include <cstring.h>
+#include <format.h>
+#include <new.h>
+#include <string.h>
+#include "test.h"
+
+namespace
+{
+//! Formats value with to_chars() and compares the text.
+template<typename... Format> bool writes(const char *expected, Format... value_and_format)
+{
+    char buffer[400];
+    std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value_and_format...);
+    std::size_t length = strlen(expected);
+    return result.ec == std::errc{} && static_cast<std::size_t>(result.ptr - buffer) == length &&
+           std::memcmp(buffer, expected, length) == 0;
+}
+
+//! Compares bit patterns, which also tells zeros of either sign apart and matches NaNs.
+template<typename T> bool same_bits(T a, T b)
+{
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+template<typename T> bool parses(const char *text, T expected, std::size_t consumed)
+{
+    T value{};
+    std::from_chars_result result = std::from_chars(text, text + strlen(text), value);
+    return result.ec == std::errc{} && result.ptr == text + consumed && same_bits(value, expected);
+}
+
+template<typename T, typename Bits> bool round_trips(Bits bits)
+{
+    T value;
+    __builtin_memcpy(&value, &bits, sizeof(value));
+    char buffer[64];
+    char *end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+    T parsed;
+    std::from_chars_result result = std::from_chars(buffer, end, parsed);
+    Bits parsed_bits;
+    __builtin_memcpy(&parsed_bits, &parsed, sizeof(parsed_bits));
+    return result.ec == std::errc{} && result.ptr == end && parsed_bits == bits;
+}
+
+//! Collects what a sink flushes, counting the calls.
+struct flushed_output
+{
+    char data[256];
+    std::size_t size = 0;
+    int calls = 0;
+
+    static void append(void *context, const char *bytes, std::size_t count)
+    {
+        flushed_output *output = static_cast<flushed_output *>(context);
+        __builtin_memcpy(output->data + output->size, bytes, count);
+        output->size += count;
+        output->calls++;
+    }
+
+    bool equals(const char *expected) const
+    {
+        return size == strlen(expected) && std::memcmp(data, expected, size) == 0;
+    }
+};
+} // namespace
+
+void test_charconv_integers()
+{
+    TEST_CHECK(writes("0", 0) && writes("-1234567", -1234567) && writes("18446744073709551615", ~0ull));
+    TEST_CHECK(writes("-9223372036854775808", -9223372036854775807ll - 1) &&
+               writes("-128", static_cast<signed char>(-128)));
+    TEST_CHECK(writes("ff", 255, 16) && writes("101", 5u, 2) && writes("-z", -35, 36) && writes("777", 511, 8));
+
+    char small[3];
+    std::to_chars_result full = std::to_chars(small, small + sizeof(small), 1000);
+    TEST_CHECK(full.ec == std::errc::value_too_large && full.ptr == small + sizeof(small));
+    TEST_CHECK(std::to_chars(small, small, -1).ec == std::errc::value_too_large);
+
+    TEST_CHECK(parses("12345xyz", 12345, 5) && parses("-0x1", 0, 2) &&
+               parses("-128", static_cast<signed char>(-128), 4));
+    unsigned int hex = 0;
+    const char *text = "FFfe";
+    TEST_CHECK(std::from_chars(text, text + 4, hex, 16).ptr == text + 4 && hex == 0xFFFE);
+
+    unsigned char byte = 7;
+    text = "256 ";
+    std::from_chars_result range = std::from_chars(text, text + 4, byte);
+    TEST_CHECK(range.ec == std::errc::result_out_of_range && range.ptr == text + 3 && byte == 7);
+    text = "-1";
+    std::from_chars_result sign = std::from_chars(text, text + 2, hex);
+    TEST_CHECK(sign.ec == std::errc::invalid_argument && sign.ptr == text && hex == 0xFFFE);
+    long long wide = 0;
+    text = "-9223372036854775808";
+    TEST_CHECK(std::from_chars(text, text + strlen(text), wide).ec == std::errc{} &&
+               wide == -9223372036854775807ll - 1);
+    text = "9223372036854775808";
+    TEST_CHECK(std::from_chars(text, text + strlen(text), wide).ec == std::errc::result_out_of_range);
+}
+
+void test_charconv_floating_point()
+{
+    // Shortest digits, in whichever of fixed and scientific is shorter
+    TEST_CHECK(writes("0.1", 0.1) && writes("0.3", 0.3f) && writes("123456", 123456.0) && writes("1e+05", 1e5));
+    TEST_CHECK(writes("1e-07", 1e-7) && writes("-0", -0.0) && writes("5e-324", 5e-324) && writes("1e+10", 1e10f));
+    TEST_CHECK(writes("1.7976931348623157e+308", 1.7976931348623157e308) && writes("3.4028235e+38", 3.4028235e38f));
+    TEST_CHECK(writes("inf", __builtin_inf()) && writes("-inf", -__builtin_inf()) && writes("nan", __builtin_nan("")));
+
+    TEST_CHECK(writes("1e-01", 0.1, std::chars_format::scientific) &&
+               writes("0e+00", 0.0, std::chars_format::scientific));
+    TEST_CHECK(writes("1.234567e+06", 1234567.0, std::chars_format::general) &&
+               writes("100000", 1e5, std::chars_format::general) &&
+               writes("0.0001234", 0.0001234, std::chars_format::general));
+    // Fixed notation spells out the exact integer once the shortest digits stop covering it
+    TEST_CHECK(writes("99999999999999991611392", 1e23, std::chars_format::fixed) &&
+               writes("0.000001", 1e-6, std::chars_format::fixed));
+
+    char small[4];
+    TEST_CHECK(std::to_chars(small, small + sizeof(small), 0.125).ec == std::errc::value_too_large);
+
+    TEST_CHECK(parses("1e23", 1e23, 4) && parses("2.2250738585072011e-308", 2.2250738585072011e-308, 23));
+    TEST_CHECK(parses("1.5x", 1.5, 3) && parses("-.5e1", -5.0, 5) && parses("7.e", 7.0, 2) &&
+               parses("INFINITY", __builtin_inf(), 8));
+    // Halfway between two doubles rounds to even, unless digits past the halfway point push it up
+    TEST_CHECK(parses("9007199254740993", 9007199254740992.0, 16) &&
+               parses("9007199254740993.00000000000000000000001", 9007199254740994.0, 40));
+    TEST_CHECK(parses("3.4028235677973366e38", 3.4028235e38f, 21) && parses("1.4e-45", 1.4e-45f, 7));
+
+    double value = 2.0;
+    const char *text = "1e-400";
+    TEST_CHECK(std::from_chars(text, text + 6, value).ec == std::errc::result_out_of_range && same_bits(value, 2.0));
+    text = "0.1e1000";
+    TEST_CHECK(std::from_chars(text, text + 8, value).ec == std::errc::result_out_of_range && same_bits(value, 2.0));
+    text = "nan(123)";
+    TEST_CHECK(std::from_chars(text, text + 8, value).ptr == text + 8 && same_bits(value, __builtin_nan("")));
+    text = "1e5";
+    TEST_CHECK(std::from_chars(text, text + 3, value, std::chars_format::fixed).ptr == text + 1 &&
+               same_bits(value, 1.0));
+    TEST_CHECK(std::from_chars(text, text + 1, value, std::chars_format::scientific).ec == std::errc::invalid_argument);
+    text = "-e5";
+    TEST_CHECK(std::from_chars(text, text + 3, value).ec == std::errc::invalid_argument);
+
+    // Every value written comes back bit for bit
+    unsigned long long state = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < 20000; i++)
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        unsigned long long bits = state ^ (state >> 29);
+        if ((bits & 0x7FF0000000000000ull) != 0x7FF0000000000000ull)
+        {
+            TEST_CHECK(round_trips<double>(bits));
+        }
+        unsigned int narrow = static_cast<unsigned int>(bits >> 32);
+        if ((narrow & 0x7F800000u) != 0x7F800000u)
+        {
+            TEST_CHECK(round_trips<float>(narrow));
+        }
+    }
+}
+
+void test_format()
+{
+    char buffer[64];
+    std::format_to_n_result<char *> result =
+        std::format_to_n(buffer, sizeof(buffer), "x={} y={:x} z={:05}|{:*^7}|{}|{:e}", 42, 255u, -3, "ab", 1.5, 0.25f);
+    TEST_CHECK(result.size == 37 && std::memcmp(buffer, "x=42 y=ff z=-0003|**ab***|1.5|2.5e-01", 37) == 0);
+
+    std::string text("b\xC3\xA9");
+    result = std::format_to_n(buffer, sizeof(buffer), "{1}{0:>3} {{}} {2} {3:X}", 'a', text, true, 48879);
+    TEST_CHECK(result.out == buffer + 19 && std::memcmp(buffer, "b\xC3\xA9  a {} true BEEF", 19) == 0);
+
+    // Output that does not fit is dropped but still counted
+    result = std::format_to_n(buffer, 4, "{}", 123456);
+    TEST_CHECK(result.out == buffer + 4 && result.size == 6 && std::memcmp(buffer, "1234", 4) == 0);
+    TEST_EXCEPTION(std::format_to_n(buffer, sizeof(buffer), "{} {}", 1), std::invalid_argument);
+
+    flushed_output output;
+    {
+#if defined(STD_ENABLE_ALLOC_STATS)
+        std::alloc_stats::counters before = std::alloc_stats::snapshot();
+#endif
+        std::buffered_sink<> sink(&flushed_output::append, &output);
+        std::format_to(sink, "[{:>6}] {}: took {} ms\n", "info", "request served", 12.5);
+        TEST_CHECK(output.calls == 0);
+#if defined(STD_ENABLE_ALLOC_STATS)
+        TEST_CHECK(std::alloc_stats::snapshot().allocations == before.allocations);
+#endif
+    }
+    // A whole line reaches the output in one flush
+    TEST_CHECK(output.calls == 1 && output.equals("[  info] request served: took 12.5 ms\n"));
+
+    flushed_output batches;
+    {
+        std::buffered_sink<8> sink(&flushed_output::append, &batches);
+        std::format_to(sink, "{}{}", "abcde", "fghij");
+        TEST_CHECK(batches.calls == 1 && sink.size() == 5);
+        std::format_to(sink, "{}", "a piece longer than the buffer");
+        TEST_CHECK(batches.calls == 3 && sink.size() == 0);
+    }
+    TEST_CHECK(batches.equals("abcdefghija piece longer than the buffer"));
+}
+
+TEST("charconv integers", charconv_integers, test_charconv_integers);
+TEST("charconv floating point", charconv_floating_point, test_charconv_floating_point);
+TEST("format", format, test_format);
@@ -0,0 +1,114 @@
+#include <algorithm.h>
+#include <deque.h>
+#include <memory_resource.h>
+#include <numeric.h>
+#include <segmented_vector.h>
+#include <string.h>
+#include "test.h"
+
+void test_segmented_vector()
+{
+    std::segmented_vector<int, 4> values;
+    int &first = values.emplace_back(0);
+    const int *address = &first;
+    for (int i = 1; i < 10; i++)
+    {
+        values.push_back(i);
+    }
+    // Growing never moved the first element
+    TEST_CHECK(&values[0] == address && values.size() == 10 && values.chunk_count() == 3 && values.back() == 9);
+    TEST_CHECK(values.end() - values.begin() == 10 && values.begin()[6] == 6);
+    TEST_CHECK(std::accumulate(values.cbegin(), values.cend(), 0) == 45);
+    // An iterator outlives the pushes that grow the chunk index
+    std::segmented_vector<int, 4>::iterator seventh = values.begin() + 6;
+    std::segmented_vector<int, 4>::const_iterator constant = seventh;
+    for (int i = 10; i < 40; i++)
+    {
+        values.push_back(i);
+    }
+    TEST_CHECK(values.chunk_count() == 10 && *seventh == 6 && seventh[33] == 39 && *constant == 6);
+    values.resize(10);
+
+    std::size_t runs = 0;
+    int sum = 0;
+    values.for_each_chunk([&](const int *data, std::size_t count) {
+        runs++;
+        for (std::size_t i = 0; i < count; i++)
+        {
+            sum += data[i];
+        }
+    });
+    TEST_CHECK(runs == 3 && sum == 45);
+
+    values.pop_back();
+    values.pop_back();
+    values.shrink_to_fit();
+    TEST_CHECK(values.size() == 8 && values.chunk_count() == 2 && values.capacity() == 8);
+
+    std::segmented_vector<int, 4> copy(values);
+    std::segmented_vector<int, 4>::const_iterator it = copy.begin();
+    TEST_CHECK(copy.size() == 8 && it[7] == 7 && &copy[0] != &values[0]);
+    std::segmented_vector<int, 4> moved(std::move(values));
+    TEST_CHECK(&moved[0] == address && values.empty());
+
+    std::pmr::monotonic_buffer_resource arena;
+    std::segmented_vector<std::string, 2, std::pmr::polymorphic_allocator<std::string>> strings(&arena);
+    strings.resize(3, std::string("a string long enough to live on the heap"));
+    strings.emplace_back("b");
+    TEST_CHECK(strings.size() == 4 && strings[1] == strings[0] && strings.at(3) == std::string("b"));
+}
+
+void test_deque()
+{
+    std::deque<int, 4> values;
+    int &middle = values.emplace_back(0);
+    for (int i = 1; i <= 10; i++)
+    {
+        values.push_back(i);
+        values.push_front(-i);
+    }
+    // Pushing at either end never moved an element
+    TEST_CHECK(&values[10] == &middle && middle == 0 && values.size() == 21);
+    TEST_CHECK(values.front() == -10 && values.back() == 10);
+    TEST_CHECK(values.end() - values.begin() == 21 && values.begin()[3] == -7);
+    std::sort(values.begin(), values.end(), [](int a, int b) { return a > b; });
+    TEST_CHECK(values.front() == 10 && values[10] == 0 && values.back() == -10);
+
+    int sum = 0;
+    values.for_each_chunk([&](int *data, std::size_t count) {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            sum += data[i];
+        }
+    });
+    TEST_CHECK(sum == 0);
+
+    // Used as a FIFO, chunks are recycled and the footprint stays bounded
+    std::deque<std::string, 4> fifo;
+    for (int i = 0; i < 1000; i++)
+    {
+        fifo.emplace_back("a string long enough to live on the heap");
+        fifo.emplace_back("b");
+        fifo.pop_front();
+    }
+    TEST_CHECK(fifo.size() == 1000 && fifo.back() == std::string("b") && fifo.chunk_count() <= 1000 / 4 + 2);
+    while (fifo.size() > 1)
+    {
+        fifo.pop_front();
+    }
+    TEST_CHECK(fifo.chunk_count() <= 3);
+    fifo.shrink_to_fit();
+    TEST_CHECK(fifo.chunk_count() == 1 && fifo.back() == std::string("b"));
+
+    std::deque<int, 4> copy(values);
+    copy.pop_back();
+    copy.pop_front();
+    TEST_CHECK(copy.size() == 19 && copy.front() == 9 && copy.at(18) == -9 && values.size() == 21);
+    copy.clear();
+    TEST_CHECK(copy.empty() && copy.chunk_count() == 1);
+    copy = std::move(values);
+    TEST_CHECK(&copy[10] == &middle && values.empty());
+}
+
+TEST("segmented vector", segmented_vector, test_segmented_vector);
+TEST("deque", deque, test_deque);
@@ -0,0 +1,77 @@
+#include <execution.h>
+#include <vector.h>
+#include "test.h"
+
+static const unsigned long parallel_size = 200000;
+
+void test_parallel_transform()
+{
+    std::vector<int> values(parallel_size, 0);
+    std::fill(std::execution::par, values.begin(), values.end(), 3);
+    TEST_CHECK(values[0] == 3 && values[parallel_size - 1] == 3);
+
+    std::vector<long> squares(parallel_size, 0);
+    for (unsigned long i = 0; i < parallel_size; i++)
+    {
+        values[i] = static_cast<int>(i);
+    }
+    std::transform(std::execution::par_unseq, values.begin(), values.end(), squares.begin(),
+                   [](int x) { return static_cast<long>(x) * x; });
+    TEST_CHECK(squares[1000] == 1000000 && squares[parallel_size - 1] == 199999L * 199999L);
+
+    std::vector<int> copied(parallel_size, 0);
+    TEST_CHECK(std::copy(std::execution::par, values.begin(), values.end(), copied.begin()) == copied.end());
+    TEST_CHECK(copied[12345] == 12345 && copied[parallel_size - 1] == static_cast<int>(parallel_size - 1));
+
+    long visited = 0;
+    std::for_each(std::execution::par, values.begin(), values.end(),
+                  [&](int x) { __atomic_fetch_add(&visited, x, __ATOMIC_RELAXED); });
+    TEST_CHECK(visited == 199999L * 200000 / 2);
+}
+
+void test_parallel_reduce()
+{
+    std::vector<long> values(parallel_size, 0);
+    for (unsigned long i = 0; i < parallel_size; i++)
+    {
+        values[i] = static_cast<long>(i % 1000);
+    }
+    TEST_CHECK(std::reduce(std::execution::par, values.begin(), values.end()) == 999L * 1000 / 2 * 200);
+    TEST_CHECK(std::reduce(std::execution::seq, values.begin(), values.end(), 5L) == 999L * 1000 / 2 * 200 + 5);
+    long largest = std::reduce(std::execution::par, values.begin(), values.end(), 0L,
+                               [](long a, long b) { return a > b ? a : b; });
+    TEST_CHECK(largest == 999);
+
+    // A parallel call from inside a parallel algorithm runs on the calling thread
+    std::vector<int> counts(64, 0);
+    std::for_each(std::execution::par, counts.begin(), counts.end(), [](int &count) {
+        std::vector<int> inner(8192, 1);
+        count = std::reduce(std::execution::par, inner.begin(), inner.end());
+    });
+    TEST_CHECK(counts[0] == 8192 && counts[63] == 8192);
+}
+
+void test_parallel_sort()
+{
+    std::vector<int> values(parallel_size, 0);
+    unsigned state = 2024;
+    for (unsigned long i = 0; i < parallel_size; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        values[i] = static_cast<int>(state >> 8);
+    }
+    std::sort(std::execution::par, values.begin(), values.end());
+    for (unsigned long i = 1; i < parallel_size; i++)
+    {
+        TEST_CHECK(values[i - 1] <= values[i]);
+    }
+    std::sort(std::execution::par_unseq, values.begin(), values.end(), std::greater<>());
+    for (unsigned long i = 1; i < parallel_size; i++)
+    {
+        TEST_CHECK(values[i - 1] >= values[i]);
+    }
+}
+
+TEST("parallel transform", parallel_transform_test, test_parallel_transform);
+TEST("parallel reduce", parallel_reduce_test, test_parallel_reduce);
+TEST("parallel sort", parallel_sort_test, test_parallel_sort);
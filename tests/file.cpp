@@ -0,0 +1,105 @@
+#include <cstring.h>
+#include <file.h>
+#include <string.h>
+#include <utf.h>
+#include "test.h"
+
+namespace
+{
+// Sequences of every length, so that some split always lands inside each of them: é, € and 😀
+const char sample[] = "a\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80z";
+constexpr std::size_t sample_length = sizeof(sample) - 1;
+
+bool same_units(const short *units, std::size_t count, const short *expected, std::size_t expected_count)
+{
+    return count == expected_count && std::memcmp(units, expected, count * sizeof(short)) == 0;
+}
+} // namespace
+
+void test_utf8_decoder()
+{
+    short whole[sample_length];
+    std::size_t expected = std::utf::utf8_to_utf16(sample, sample_length, whole);
+
+    for (std::size_t split = 0; split <= sample_length; split++)
+    {
+        std::utf::utf8_decoder decoder;
+        short units[std::utf::utf8_decoder::max_units(sample_length)];
+        std::size_t first = decoder.convert(sample, split, units);
+        std::size_t second = decoder.convert(sample + split, sample_length - split, units + first);
+        TEST_CHECK(first != std::utf::invalid && second != std::utf::invalid && decoder.finish());
+        TEST_CHECK(same_units(units, first + second, whole, expected));
+    }
+
+    // One byte at a time, so the four-byte sequence is carried across three pieces
+    std::utf::utf8_decoder decoder;
+    short units[std::utf::utf8_decoder::max_units(sample_length)];
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < sample_length; i++)
+    {
+        count += decoder.convert(sample + i, 1, units + count);
+    }
+    TEST_CHECK(decoder.finish() && same_units(units, count, whole, expected));
+
+    // Input that stops inside a sequence, and a sequence broken off by the next piece
+    decoder.reset();
+    TEST_CHECK(decoder.convert(sample, 5, units) == 3 && !decoder.finish() && decoder.failed());
+    decoder.reset();
+    TEST_CHECK(decoder.convert("\xE2\x82", 2, units) == 0 && decoder.convert("A", 1, units) == std::utf::invalid);
+    TEST_CHECK(decoder.convert("A", 1, units) == std::utf::invalid && !decoder.finish());
+    decoder.reset();
+    TEST_CHECK(decoder.convert("\xF0\x9F", 2, units) == 0 && decoder.convert("\x98\x80", 2, units) == 2 &&
+               decoder.finish() && units[0] == static_cast<short>(0xD83D));
+}
+
+#if defined(STD_HAS_OS_FILES)
+void test_mapped_file()
+{
+    std::mapped_file file(__FILE__);
+    TEST_CHECK(file.is_open() && file.size() > 0);
+    TEST_CHECK(file.view().contains("void test_mapped_file()"));
+
+    std::mapped_file moved(std::move(file));
+    TEST_CHECK(!file && moved && moved.view().contains("TEST(\"mapped file\""));
+    moved.close();
+    TEST_CHECK(!moved.is_open() && moved.size() == 0);
+
+    std::mapped_file missing("/nonexistent/portable_std/file");
+    TEST_CHECK(!missing.is_open() && !missing.open("/nonexistent/portable_std/file"));
+}
+
+void test_utf8_reader()
+{
+    std::mapped_file file(__FILE__);
+    std::string expected(file.data(), static_cast<std::string::ssize_type>(file.size()));
+
+    // Small chunks split the non-ASCII text in this file's first comment every way there is
+    for (std::size_t chunk_size = 1; chunk_size <= 7; chunk_size++)
+    {
+        std::utf8_reader reader(__FILE__, chunk_size);
+        TEST_CHECK(reader.is_open());
+        std::string streamed;
+        while (reader.next())
+        {
+            streamed.append(reader.units());
+        }
+        TEST_CHECK(!reader.failed() && !reader.is_open() && streamed == expected);
+    }
+
+    std::utf8_reader reader(__FILE__);
+    std::size_t chunks = 0;
+    while (reader.next())
+    {
+        chunks++;
+    }
+    TEST_CHECK(chunks == 1 && !reader.failed());
+
+    std::utf8_reader missing("/nonexistent/portable_std/file");
+    TEST_CHECK(!missing.is_open() && !missing.next() && !missing.failed());
+}
+
+TEST("mapped file", mapped_file, test_mapped_file);
+TEST("utf8 reader", utf8_reader, test_utf8_reader);
+#endif
+
+TEST("utf8 decoder", utf8_decoder, test_utf8_decoder);
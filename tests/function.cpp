@@ -0,0 +1,159 @@
+#include <inplace_function.h>
+#include <string.h>
+#include "test.h"
+
+namespace
+{
+int twice(int value)
+{
+    return value * 2;
+}
+
+struct counted
+{
+    static inline int alive = 0;
+    int offset;
+
+    explicit counted(int value)
+        : offset(value)
+    {
+        alive++;
+    }
+
+    counted(const counted &other)
+        : offset(other.offset)
+    {
+        alive++;
+    }
+
+    counted(counted &&other) noexcept
+        : offset(other.offset)
+    {
+        alive++;
+    }
+
+    ~counted()
+    {
+        alive--;
+    }
+
+    int operator()(int value) const
+    {
+        return value + offset;
+    }
+};
+
+//! Owns a heap int, like a unique_ptr<int>.
+struct owner
+{
+    int *value;
+
+    explicit owner(int initial)
+        : value(new int(initial))
+    {
+    }
+
+    owner(owner &&other) noexcept
+        : value(other.value)
+    {
+        other.value = nullptr;
+    }
+
+    owner(const owner &) = delete;
+    owner &operator=(const owner &) = delete;
+
+    ~owner()
+    {
+        delete value;
+    }
+};
+
+int apply(const std::inplace_function<int(int)> &function, int value)
+{
+    return function(value);
+}
+} // namespace
+
+void test_inplace_function()
+{
+    std::inplace_function<int(int)> empty;
+    TEST_CHECK(!empty && empty == nullptr);
+
+    std::inplace_function<int(int)> pointer = twice;
+    TEST_CHECK(pointer && pointer(21) == 42 && apply(&twice, 4) == 8);
+    int (*null_pointer)(int) = nullptr;
+    std::inplace_function<int(int)> from_null = null_pointer;
+    TEST_CHECK(!from_null);
+
+    int base = 10;
+    int calls = 0;
+    std::inplace_function<int(int)> adder = [&base, &calls](int value) {
+        calls++;
+        return base + value;
+    };
+    std::inplace_function<int(int)> copy = adder;
+    TEST_CHECK(adder(1) == 11 && copy(2) == 12 && calls == 2);
+
+    {
+        std::inplace_function<int(int)> holder = counted(5);
+        std::inplace_function<int(int)> other = holder;
+        TEST_CHECK(counted::alive == 2 && other(1) == 6);
+        std::inplace_function<int(int)> moved = std::move(holder);
+        TEST_CHECK(counted::alive == 2 && !holder && moved(2) == 7);
+        moved.swap(copy);
+        TEST_CHECK(moved(3) == 13 && copy(3) == 8);
+        copy = nullptr;
+        TEST_CHECK(counted::alive == 1);
+    }
+    TEST_CHECK(counted::alive == 0);
+
+    std::string text("a string long enough to live on the heap");
+    std::inplace_function<void(std::string &), 64> append = [text](std::string &out) { out += text; };
+    std::string out;
+    append(out);
+    TEST_CHECK(out == text);
+}
+
+void test_move_only_function()
+{
+    std::move_only_function<int(int)> empty;
+    TEST_CHECK(!empty);
+    empty = twice;
+    TEST_CHECK(empty(5) == 10);
+
+    // A lambda capturing move-only state
+    owner owned(7);
+    std::move_only_function<int(int)> holder = [owned = std::move(owned)](int value) { return *owned.value + value; };
+    TEST_CHECK(holder(1) == 8);
+    std::move_only_function<int(int)> moved = std::move(holder);
+    TEST_CHECK(!holder && moved(2) == 9);
+
+    // Too large for the inline buffer, so it lives on the heap and the wrapper moves a pointer
+    long wide[6] = {1, 2, 3, 4, 5, 6};
+    auto sum = [wide](int value) {
+        long total = value;
+        for (long part : wide)
+        {
+            total += part;
+        }
+        return static_cast<int>(total);
+    };
+    static_assert(!std::move_only_function<int(int)>::stores_inline<decltype(sum)>);
+    static_assert(std::move_only_function<int(int)>::stores_inline<int (*)(int)>);
+    std::move_only_function<int(int)> large = sum;
+    std::move_only_function<int(int)> large_moved = std::move(large);
+    TEST_CHECK(large_moved(0) == 21);
+
+    {
+        std::move_only_function<int(int)> inline_counted = counted(1);
+        std::move_only_function<int(int)> relocated = std::move(inline_counted);
+        TEST_CHECK(counted::alive == 1 && relocated(1) == 2);
+        relocated.swap(large_moved);
+        TEST_CHECK(relocated(1) == 22 && large_moved(1) == 2);
+    }
+    large_moved = nullptr;
+    TEST_CHECK(counted::alive == 0);
+}
+
+TEST("inplace function", inplace_function, test_inplace_function);
+TEST("move only function", move_only_function, test_move_only_function);
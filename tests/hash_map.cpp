@@ -0,0 +1,140 @@
+#include <flat_hash_map.h>
+#include <flat_hash_set.h>
+#include <memory_resource.h>
+#include <string.h>
+#include "test.h"
+
+void test_hash_map_basic()
+{
+    std::flat_hash_map<int, int> map;
+    TEST_CHECK(map.empty() && map.bucket_count() == 0 && map.find(1) == map.end());
+    for (int i = 0; i < 1000; i++)
+    {
+        TEST_CHECK(map.insert({i, i * 2}).second);
+    }
+    TEST_CHECK(map.size() == 1000 && !map.insert({5, 0}).second && map.at(5) == 10);
+    TEST_CHECK(map.load_factor() <= map.max_load_factor());
+
+    map[2000] = 7;
+    map[5] += 1;
+    TEST_CHECK(map.size() == 1001 && map[2000] == 7 && map[5] == 11);
+    TEST_CHECK(!map.try_emplace(5, 99).second && map.insert_or_assign(5, 99).first->second == 99);
+    TEST_EXCEPTION(map.at(-1), std::out_of_range);
+
+    long sum = 0;
+    for (const auto &entry : map)
+    {
+        sum += entry.first;
+    }
+    TEST_CHECK(sum == 999L * 1000 / 2 + 2000);
+
+    for (int i = 0; i < 1000; i += 2)
+    {
+        TEST_CHECK(map.erase(i) == 1);
+    }
+    TEST_CHECK(map.erase(0) == 0 && map.size() == 501);
+    for (int i = 0; i < 1000; i++)
+    {
+        TEST_CHECK(map.contains(i) == (i % 2 == 1));
+    }
+
+    std::flat_hash_map<int, int> copy = map;
+    TEST_CHECK(copy == map && copy.count(999) == 1);
+    copy.erase(copy.find(999));
+    TEST_CHECK(!(copy == map) && copy.size() == 500);
+}
+
+void test_hash_map_churn()
+{
+    // Erasing and inserting at a steady size must not fill the table with tombstones and keep growing it
+    std::flat_hash_map<unsigned, unsigned> map;
+    map.reserve(100);
+    std::size_t buckets = map.bucket_count();
+    for (unsigned i = 0; i < 100; i++)
+    {
+        map.emplace(i, i);
+    }
+    for (unsigned i = 100; i < 100000; i++)
+    {
+        TEST_CHECK(map.erase(i - 100) == 1);
+        map.emplace(i, i);
+    }
+    TEST_CHECK(map.size() == 100 && map.bucket_count() == buckets);
+    for (unsigned i = 99900; i < 100000; i++)
+    {
+        TEST_CHECK(map.at(i) == i);
+    }
+
+    std::size_t erased = 0;
+    for (auto it = map.begin(); it != map.end();)
+    {
+        if (it->first % 3 == 0)
+        {
+            it = map.erase(it);
+            erased++;
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    TEST_CHECK(map.size() == 100 - erased);
+    map.rehash(0);
+    TEST_CHECK(map.bucket_count() <= buckets && map.size() == 100 - erased && map.contains(99901));
+    map.clear();
+    TEST_CHECK(map.empty() && map.begin() == map.end());
+}
+
+void test_hash_map_string_keys()
+{
+    std::flat_hash_map<std::string, int> map;
+    map.try_emplace("alpha", 1);
+    map["beta"] = 2;
+    map.emplace(std::string("a string long enough to live on the heap"), 3);
+
+    // Views into other strings are looked up without building a key
+    const std::string text("alpha beta gamma a string long enough to live on the heap");
+    std::string_view view = text.substr_view(0, 5);
+    TEST_CHECK(map.find(view) != map.end() && map.find(view)->second == 1);
+    TEST_CHECK(map.contains(text.substr_view(6, 10)) && !map.contains(text.substr_view(11, 16)));
+    TEST_CHECK(map.at(text.substr_view(17, 57)) == 3);
+    TEST_CHECK(map.erase(text.substr_view(6, 10)) == 1 && map.size() == 2);
+    TEST_CHECK(std::hash<std::string>()(std::string("alpha")) == std::hash<std::string_view>()(view));
+
+    std::flat_hash_map<std::string, int> moved = std::move(map);
+    TEST_CHECK(map.empty() && moved.size() == 2 && moved["alpha"] == 1);
+
+    // Between unequal allocators the elements are moved into new storage, which may throw
+    using pmr_map = std::flat_hash_map<int, int, std::hash<int>, std::equal_to<>,
+                                       std::pmr::polymorphic_allocator<std::pair<const int, int>>>;
+    std::pmr::monotonic_buffer_resource first;
+    std::pmr::monotonic_buffer_resource second;
+    pmr_map source(&first);
+    pmr_map target(&second);
+    static_assert(noexcept(moved = std::move(map)) && !noexcept(target = std::move(source)));
+    source[1] = 10;
+    source[2] = 20;
+    target = std::move(source);
+    TEST_CHECK(source.empty() && target.size() == 2 && target[2] == 20);
+}
+
+void test_hash_set()
+{
+    std::flat_hash_set<int> set = {3, 1, 4, 1, 5, 9, 2, 6};
+    TEST_CHECK(set.size() == 7 && set.contains(9) && !set.contains(7));
+    TEST_CHECK(!set.insert(4).second && set.insert(7).second);
+    TEST_CHECK(set.erase(1) == 1 && set.erase(1) == 0);
+    set.reserve(1000);
+    TEST_CHECK(set.bucket_count() >= 1000 && set.size() == 7 && set.contains(6));
+
+    std::flat_hash_set<std::string> words;
+    words.insert("one");
+    words.emplace("two");
+    const std::string probe("two three");
+    TEST_CHECK(words.contains(probe.substr_view(0, 3)) && words.count(probe.substr_view(4, 9)) == 0);
+}
+
+TEST("hash map", hash_map_test, test_hash_map_basic);
+TEST("hash map churn", hash_map_churn_test, test_hash_map_churn);
+TEST("hash map string keys", hash_map_string_keys_test, test_hash_map_string_keys);
+TEST("hash set", hash_set_test, test_hash_set);
@@ -0,0 +1,109 @@
+#include <flat_hash_map.h>
+#include <interner.h>
+#include <string.h>
+#include <string_builder.h>
+#include "test.h"
+
+namespace
+{
+//! Builds the name "identifier_<index>".
+std::string name(unsigned int index)
+{
+    return (std::string_builder() << "identifier_" << index).build();
+}
+} // namespace
+
+void test_interner()
+{
+    std::interner names;
+    std::string first("request_id");
+    std::atom id = names.intern(first);
+    std::atom again = names.intern(std::string("request_id"));
+    std::atom other = names.intern(std::string("response_id"));
+    TEST_CHECK(id == again && id != other && names.size() == 2);
+
+    // The view is the interned copy, not the string it was interned from
+    TEST_CHECK(id.view() == first.view() && id.view().data() == again.view().data() &&
+               id.view().data() != first.view().data());
+    TEST_CHECK(id.hash() == std::hash<std::string_view>()(first.view()) && id.size() == first.size());
+    TEST_CHECK(id.hashed() == std::hashed_string_view(first.view()));
+
+    TEST_CHECK(names.find(std::string("response_id")) == other && names.find(std::string("missing")).empty());
+    std::atom empty = names.intern(std::string());
+    TEST_CHECK(empty == std::atom() && empty.view().empty() && names.size() == 2);
+    TEST_CHECK(empty.hash() == std::hash<std::string_view>()(std::string_view()));
+
+    // Enough strings to grow the table several times; every atom stays where it was
+    std::atom atoms[1000];
+    for (unsigned int i = 0; i < 1000; i++)
+    {
+        atoms[i] = names.intern(name(i));
+    }
+    TEST_CHECK(names.size() == 1002 && names.intern(first) == id);
+    for (unsigned int i = 0; i < 1000; i++)
+    {
+        TEST_CHECK(names.intern(name(i)) == atoms[i] && atoms[i].view() == name(i).view());
+    }
+
+    std::flat_hash_map<std::atom, int> counts;
+    counts[id]++;
+    counts[again]++;
+    counts[other]++;
+    TEST_CHECK(counts.size() == 2 && counts[id] == 2);
+}
+
+#if defined(STD_HAS_OS_THREADS)
+namespace
+{
+constexpr unsigned int shared_names = 2000;
+
+struct intern_run
+{
+    std::interner names;
+    std::atom seen[4][shared_names];
+    std::atomic<unsigned int> next_thread{0};
+};
+
+void intern_all(void *argument)
+{
+    intern_run &run = *static_cast<intern_run *>(argument);
+    unsigned int thread = run.next_thread.fetch_add(1, std::memory_order_relaxed);
+    // Each thread walks the names from a different start, so some race to add the same name
+    for (unsigned int i = 0; i < shared_names; i++)
+    {
+        unsigned int index = (i + thread * 500) % shared_names;
+        run.seen[thread][index] = run.names.intern(name(index));
+    }
+#if defined(STD_ENABLE_MEMORY_POOL)
+    std::memory_pool::flush_thread_cache();
+#endif
+}
+} // namespace
+
+void test_interner_threads()
+{
+    intern_run *run = new intern_run;
+    void *threads[4];
+    for (void *&thread : threads)
+    {
+        thread = os::thread_spawn(&intern_all, run);
+    }
+    for (void *thread : threads)
+    {
+        os::thread_join(thread);
+    }
+    TEST_CHECK(run->names.size() == shared_names);
+    bool same = true;
+    for (unsigned int i = 0; i < shared_names; i++)
+    {
+        same = same && run->seen[0][i] == run->seen[1][i] && run->seen[0][i] == run->seen[2][i] &&
+               run->seen[0][i] == run->seen[3][i] && run->seen[0][i].view() == name(i).view();
+    }
+    TEST_CHECK(same);
+    delete run;
+}
+
+TEST("interner threads", interner_threads, test_interner_threads);
+#endif
+
+TEST("interner", interner, test_interner);
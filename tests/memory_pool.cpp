@@ -0,0 +1,70 @@
+#include <new.h>
+#include <vector.h>
+#include "test.h"
+#if defined(STD_ENABLE_MEMORY_POOL)
+
+static bool is_aligned(const void *ptr, unsigned long alignment)
+{
+    return (reinterpret_cast<unsigned long>(ptr) & (alignment - 1)) == 0;
+}
+
+void test_pool_size_classes()
+{
+    for (unsigned long size = 1; size <= std::memory_pool::max_small_size; size = size * 3 / 2 + 1)
+    {
+        void *block = std::memory_pool::allocate(size);
+        TEST_CHECK(block != nullptr);
+        TEST_CHECK(is_aligned(block, __STDCPP_DEFAULT_NEW_ALIGNMENT__));
+        std::memset(block, 0xA5, size);
+        std::memory_pool::deallocate(block);
+        // The thread cache hands the block straight back
+        TEST_CHECK(std::memory_pool::allocate(size) == block);
+        std::memory_pool::deallocate(block);
+    }
+}
+
+void test_pool_large_and_aligned()
+{
+    void *large = std::memory_pool::allocate(100000);
+    TEST_CHECK(large != nullptr);
+    std::memset(large, 0, 100000);
+    std::memory_pool::deallocate(large);
+
+    for (unsigned long alignment = 32; alignment <= 256 * 1024; alignment *= 2)
+    {
+        void *block = std::memory_pool::allocate(40, alignment);
+        TEST_CHECK(block != nullptr);
+        TEST_CHECK(is_aligned(block, alignment));
+        std::memory_pool::deallocate(block);
+    }
+}
+
+void test_pool_containers()
+{
+    {
+        std::vector<int> v;
+        for (int i = 0; i < 10000; i++)
+        {
+            v.push_back(i);
+        }
+        TEST_CHECK(v[9999] == 9999);
+    }
+    void *blocks[200];
+    for (void *&block : blocks)
+    {
+        block = ::operator new(24);
+    }
+    for (void *block : blocks)
+    {
+        ::operator delete(block);
+    }
+    std::memory_pool::flush_thread_cache();
+    void *after = ::operator new(24);
+    TEST_CHECK(after != nullptr);
+    ::operator delete(after);
+}
+
+TEST("pool size classes", pool_size_classes, test_pool_size_classes);
+TEST("pool large and aligned", pool_large_and_aligned, test_pool_large_and_aligned);
+TEST("pool containers", pool_containers, test_pool_containers);
+#endif
@@ -1,5 +1,22 @@
+#include <clock.h>
+#include <file.h>
 #include <new.h>
+#include <thread.h>
 #include <cstdlib> // link to the os for now this is the only mixing used for now
+#include <time.h>
+#if defined(STD_HAS_OS_THREADS)
+#    include <pthread.h>
+#    include <unistd.h>
+#endif
+#if defined(STD_HAS_OS_REALLOC)
+#    include <malloc.h>
+#endif
+#if defined(STD_HAS_OS_FILES)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
 namespace os
 {
     void *operator_new(std::size_t size)
@@ -13,7 +30,8 @@ namespace os
     }
     void *operator_new_aligned(std::size_t size, std::size_t alignment)
     {
-        return aligned_alloc(alignment, size);
+        // aligned_alloc wants the size to be a multiple of the alignment
+        return aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
     }
     void operator_delete(void *ptr)
     {
@@ -23,5 +41,157 @@ namespace os
     {
         free(ptr);
     }
+    unsigned long long clock_ns()
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<unsigned long long>(now.tv_sec) * 1000000000ull +
+               static_cast<unsigned long long>(now.tv_nsec);
+    }
+#if defined(STD_HAS_OS_REALLOC)
+    void *operator_realloc(void *ptr, std::size_t size)
+    {
+        return realloc(ptr, size);
+    }
+    bool try_expand(void *ptr, std::size_t size)
+    {
+        // malloc rounds blocks up to its size classes, so the slack past the requested size is free to take
+        return size <= malloc_usable_size(ptr);
+    }
+#endif
+#if defined(STD_ENABLE_MEMORY_POOL) && !defined(STD_MEMORY_POOL_THREAD_LOCAL)
+    void **thread_cache_slot()
+    {
+        static thread_local void *slot = nullptr;
+        return &slot;
+    }
+#endif
+#if defined(STD_HAS_OS_THREADS)
+    struct thread_start
+    {
+        void (*entry)(void *);
+        void *argument;
+    };
+
+    static void *thread_main(void *start)
+    {
+        thread_start copy = *static_cast<thread_start *>(start);
+        free(start);
+        copy.entry(copy.argument);
+        return nullptr;
+    }
+
+    void *thread_spawn(void (*entry)(void *), void *argument)
+    {
+        pthread_t *thread = static_cast<pthread_t *>(malloc(sizeof(pthread_t)));
+        thread_start *start = static_cast<thread_start *>(malloc(sizeof(thread_start)));
+        if (thread == nullptr || start == nullptr)
+        {
+            free(thread);
+            free(start);
+            return nullptr;
+        }
+        *start = {entry, argument};
+        if (pthread_create(thread, nullptr, &thread_main, start) != 0)
+        {
+            free(thread);
+            free(start);
+            return nullptr;
+        }
+        return thread;
+    }
+
+    void thread_join(void *thread)
+    {
+        pthread_join(*static_cast<pthread_t *>(thread), nullptr);
+        free(thread);
+    }
+
+    unsigned int thread_count()
+    {
+        // At least four, so the worker threads are exercised on single-core machines too
+        long count = sysconf(_SC_NPROCESSORS_ONLN);
+        return count > 4 ? static_cast<unsigned int>(count) : 4u;
+    }
+
+    // One mutex and condition variable for every address is enough for the tests
+    struct wait_state
+    {
+        pthread_mutex_t mutex;
+        pthread_cond_t cond;
+
+        wait_state()
+        {
+            pthread_mutex_init(&mutex, nullptr);
+            pthread_cond_init(&cond, nullptr);
+        }
+    };
+
+    static wait_state &waits()
+    {
+        static wait_state state;
+        return state;
+    }
+
+    void thread_wait(unsigned int *address, unsigned int expected)
+    {
+        wait_state &state = waits();
+        pthread_mutex_lock(&state.mutex);
+        while (__atomic_load_n(address, __ATOMIC_ACQUIRE) == expected)
+        {
+            pthread_cond_wait(&state.cond, &state.mutex);
+        }
+        pthread_mutex_unlock(&state.mutex);
+    }
+
+    void thread_wake_all(unsigned int *)
+    {
+        wait_state &state = waits();
+        pthread_mutex_lock(&state.mutex);
+        pthread_cond_broadcast(&state.cond);
+        pthread_mutex_unlock(&state.mutex);
+    }
+#endif
+#if defined(STD_HAS_OS_FILES)
+    // The handle is the descriptor plus one, so descriptor 0 is not mistaken for nullptr
+    static int descriptor(void *file)
+    {
+        return static_cast<int>(reinterpret_cast<intptr_t>(file) - 1);
+    }
+
+    void *file_open(const char *path)
+    {
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        return fd < 0 ? nullptr : reinterpret_cast<void *>(static_cast<intptr_t>(fd) + 1);
+    }
+
+    void file_close(void *file)
+    {
+        close(descriptor(file));
+    }
+
+    unsigned long long file_size(void *file)
+    {
+        struct stat info;
+        return fstat(descriptor(file), &info) == 0 ? static_cast<unsigned long long>(info.st_size) : 0;
+    }
+
+    std::size_t file_read(void *file, void *buffer, std::size_t size)
+    {
+        ssize_t count = read(descriptor(file), buffer, size);
+        return count < 0 ? static_cast<std::size_t>(-1) : static_cast<std::size_t>(count);
+    }
+
+    const void *file_map(void *file, std::size_t size)
+    {
+        void *address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor(file), 0);
+        return address == MAP_FAILED ? nullptr : address;
+    }
+
+    void file_unmap(const void *address, std::size_t size)
+    {
+        munmap(const_cast<void *>(address), size);
+    }
+#endif
 
 } // namespace os
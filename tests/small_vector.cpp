@@ -0,0 +1,123 @@
+#include <memory_resource.h>
+#include <small_vector.h>
+#include <string.h>
+#include "test.h"
+
+static unsigned long sum_all(const std::small_vector_base<int> &values)
+{
+    unsigned long sum = 0;
+    for (int value : values)
+    {
+        sum += static_cast<unsigned long>(value);
+    }
+    return sum;
+}
+
+void test_small_vector_inline()
+{
+    std::small_vector<int, 8> v;
+    TEST_CHECK(v.empty() && v.capacity() == 8 && v.is_small());
+    const unsigned char *object = reinterpret_cast<const unsigned char *>(&v);
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(v.data());
+    TEST_CHECK(data >= object && data + 8 * sizeof(int) <= object + sizeof(v));
+
+    for (int i = 0; i < 8; i++)
+    {
+        v.push_back(i);
+    }
+    TEST_CHECK(v.is_small() && v.size() == 8);
+    v.insert(v.begin() + 2, 100);
+    TEST_CHECK(!v.is_small() && v.size() == 9 && v[2] == 100 && v[8] == 7);
+    TEST_CHECK(sum_all(v) == 128);
+
+    v.erase(v.begin() + 2);
+    v.pop_back();
+    v.shrink_to_fit();
+    TEST_CHECK(v.is_small() && v.size() == 7 && v.back() == 6);
+    if constexpr (std::detail::bounds_check_throws)
+    {
+        TEST_EXCEPTION(v.at(7), std::out_of_range);
+    }
+    v.clear();
+    TEST_CHECK(v.empty() && v.is_small());
+}
+
+void test_small_vector_move()
+{
+    std::small_vector<std::string, 2> small = {std::string("a"), std::string("b")};
+    std::small_vector<std::string, 2> moved(std::move(small));
+    TEST_CHECK(moved.size() == 2 && moved[1] == std::string("b") && moved.is_small());
+    TEST_CHECK(small.empty());
+
+    std::small_vector<std::string, 2> heap = {std::string("x"), std::string("y"), std::string("z")};
+    const std::string *storage = heap.data();
+    std::small_vector<std::string, 4> stolen(std::move(static_cast<std::small_vector_base<std::string> &>(heap)));
+    TEST_CHECK(stolen.data() == storage && stolen.size() == 3);
+    TEST_CHECK(heap.empty() && heap.is_small());
+
+    moved.swap(stolen);
+    TEST_CHECK(moved.size() == 3 && moved[2] == std::string("z"));
+    TEST_CHECK(stolen.size() == 2 && stolen[0] == std::string("a") && stolen.is_small());
+
+    std::small_vector<std::string, 4> copy(moved);
+    copy = stolen;
+    TEST_CHECK(copy.size() == 2 && copy[1] == std::string("b") && moved.size() == 3);
+}
+
+//! Whether To can be constructed from from without throwing.
+template<typename To, typename From> bool moves_without_throwing(From &&from)
+{
+    return noexcept(To(static_cast<From &&>(from)));
+}
+
+// The member functions come from the same base as vector's
+void test_small_vector_api()
+{
+    std::small_vector<int, 4> v = {1, 2, 3};
+    std::small_vector<int, 4> more = {4, 5, 6, 7};
+    v.append_range(more);
+    TEST_CHECK(!v.is_small() && v.size() == 7 && v.capacity() == 8 && v[6] == 7);
+    v.erase(v.begin() + 1, v.begin() + 3);
+    TEST_CHECK(v.size() == 5 && v[0] == 1 && v[1] == 4 && v.back() == 7);
+    TEST_CHECK(std::erase_if(v, [](int value) { return value % 2 == 0; }) == 2 && v.size() == 3 && v[1] == 5);
+    v.swap_and_pop(v.begin());
+    TEST_CHECK(v.size() == 2 && v[0] == 7 && v[1] == 5);
+    TEST_CHECK(*v.try_at(1).value() == 5 && !v.try_at(2).has_value());
+
+    std::small_vector<int, 2> front = {8, 9};
+    v.insert_range(v.begin(), front);
+    v.shrink_to_fit();
+    TEST_CHECK(v.is_small() && v.size() == 4 && v[0] == 8 && v[3] == 5);
+    v.resize_for_overwrite(6);
+    v[4] = 10;
+    v[5] = 11;
+    TEST_CHECK(v.size() == 6 && v[5] == 11);
+    v.assign(3, 42);
+    TEST_CHECK(v.size() == 3 && v[2] == 42);
+    v.reserve_exact(13);
+    TEST_CHECK(v.capacity() == 13 && !v.is_small() && v[0] == 42);
+}
+
+void test_small_vector_allocator()
+{
+    alignas(16) static unsigned char arena[4096];
+    std::pmr::monotonic_buffer_resource resource(arena, sizeof(arena));
+    std::small_vector<int, 2, std::pmr::polymorphic_allocator<int>, std::fixed_growth<10>> v(&resource);
+    v.push_back(1);
+    v.push_back(2);
+    TEST_CHECK(v.is_small() && v.get_allocator().resource() == &resource);
+    v.push_back(3);
+    const unsigned char *data = reinterpret_cast<const unsigned char *>(v.data());
+    TEST_CHECK(!v.is_small() && v.capacity() == 20 && data >= arena && data < arena + sizeof(arena));
+
+    // Same N: never allocates, so the move constructor is noexcept; other N may have to
+    using strings = std::small_vector<std::string, 2>;
+    strings same;
+    std::small_vector_base<std::string> &any = same;
+    TEST_CHECK(moves_without_throwing<strings>(std::move(same)) && !moves_without_throwing<strings>(std::move(any)));
+}
+
+TEST("small vector inline", small_vector_inline, test_small_vector_inline);
+TEST("small vector api", small_vector_api, test_small_vector_api);
+TEST("small vector allocator", small_vector_allocator, test_small_vector_allocator);
+TEST("small vector move", small_vector_move, test_small_vector_move);
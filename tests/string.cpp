@@ -0,0 +1,311 @@
+#include <fixed_string.h>
+#include <flat_hash_map.h>
+#include <hashed_string.h>
+#include <memory_resource.h>
+#include <string.h>
+#include <search.h>
+#include <string_builder.h>
+#include <string_view.h>
+#include "test.h"
+
+class counting_resource final : public std::pmr::memory_resource
+{
+  public:
+    unsigned long allocations = 0;
+
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+void test_small_string()
+{
+    counting_resource resource;
+    std::pmr::string empty(&resource);
+    TEST_CHECK(empty.size() == 0);
+    TEST_CHECK(empty.capacity() == std::pmr::string::inline_capacity);
+
+    std::pmr::string small("hello", -1, &resource);
+    TEST_CHECK(small.size() == 5);
+    TEST_CHECK(small[0] == 'h' && small[4] == 'o');
+    std::pmr::string copy(small, &resource);
+    std::pmr::string moved(std::move(small));
+    TEST_CHECK(copy == moved);
+    TEST_CHECK(*copy.try_at(4).value() == 'o' && !copy.try_at(5).has_value() && copy.back() == 'o');
+    TEST_CHECK(small.empty());
+    TEST_CHECK(resource.allocations == 0);
+    static_assert(sizeof(std::string) == 3 * sizeof(void *));
+}
+
+void test_small_to_heap()
+{
+    counting_resource resource;
+    std::pmr::string str(&resource);
+    for (unsigned long i = 0; i < std::pmr::string::inline_capacity; ++i)
+    {
+        str.push_back(static_cast<short>('a' + i));
+    }
+    TEST_CHECK(resource.allocations == 0);
+    str.push_back('z');
+    TEST_CHECK(resource.allocations == 1);
+    TEST_CHECK(str.size() == std::pmr::string::inline_capacity + 1);
+    TEST_CHECK(str[0] == 'a' && str[str.size() - 1] == 'z');
+
+    str.erase(0, 4);
+    str.shrink_to_fit();
+    TEST_CHECK(str.capacity() == std::pmr::string::inline_capacity);
+    TEST_CHECK(str[0] == 'e' && str[str.size() - 1] == 'z');
+}
+
+void test_string_view()
+{
+    counting_resource resource;
+    std::pmr::string str("Hello, World!", -1, &resource);
+    TEST_CHECK(str.find("World") == 7);
+    TEST_CHECK(str.rfind("o") == 8);
+    TEST_CHECK(str.find("world") == std::pmr::string::npos);
+    TEST_CHECK(str.start_with("Hello") && str.end_with("!"));
+    TEST_CHECK(str.find_first_of(", ") == 5);
+    TEST_CHECK(str.compare("Hello") > 0 && str.compare("Z") < 0);
+    TEST_CHECK(resource.allocations == 1);
+
+    std::string_view world = str.substr_view(7, 12);
+    TEST_CHECK(world.size() == 5 && world.data() == str.data() + 7);
+    TEST_CHECK(str.find(world) == 7);
+    TEST_CHECK(world.substr(1, 3) == str.substr_view(8, 11));
+    TEST_CHECK(str.view().starts_with(str.substr_view(0, 5)));
+    TEST_CHECK(resource.allocations == 1);
+
+    std::string copy(world);
+    TEST_CHECK(copy.view() == world);
+    copy.append(copy);
+    TEST_CHECK(copy.size() == 10 && copy.end_with("WorldWorld"));
+
+    std::u8string_view bytes("key=value");
+    TEST_CHECK(bytes.find('=') == 3);
+    TEST_CHECK(bytes.substr(4) == std::u8string_view("value"));
+    TEST_EXCEPTION(bytes.substr(10), std::out_of_range);
+}
+
+void test_utf8_conversion()
+{
+    // Long enough to take the vector path, with multi-byte sequences straddling block boundaries
+    const char *text = "config_value = 42; caf\xC3\xA9 \xE4\xB8\xAD\xE6\x96\x87 and an emoji "
+                       "\xF0\x9F\x98\x80 at the end";
+    std::string str(text);
+    TEST_CHECK(str.size() == strlen(text) - 1 - 4 - 2);
+    TEST_CHECK(str.find("caf") == 19 && str[22] == 0xE9);
+    TEST_CHECK(static_cast<unsigned short>(str[24]) == 0x4E2D && static_cast<unsigned short>(str[25]) == 0x6587);
+    unsigned long emoji = str.find(" at the end") - 2;
+    TEST_CHECK(static_cast<unsigned short>(str[emoji]) == 0xD83D);
+    TEST_CHECK(static_cast<unsigned short>(str[emoji + 1]) == 0xDE00);
+
+    // Ill-formed UTF-8 (an overlong slash, a lone continuation byte) is read as Latin-1
+    std::string latin1("\xC0\xAF and \x80");
+    TEST_CHECK(latin1.size() == 8 && latin1[0] == 0xC0 && latin1[7] == 0x80);
+
+    std::string appended("key");
+    appended.append(" = ");
+    appended += "\xC3\xA9";
+    TEST_CHECK(appended.size() == 7 && appended.start_with("key = ") && appended[6] == 0xE9);
+}
+
+void test_utf8_encoding()
+{
+    const char *text = "plain ascii text that fills a few vector blocks, caf\xC3\xA9 \xE4\xB8\xAD \xF0\x9F\x98\x80!";
+    std::string str(text);
+    TEST_CHECK(str.utf8_size() == strlen(text));
+
+    std::throw_away_string utf8 = str.throw_away();
+    TEST_CHECK(utf8.size() == strlen(text));
+    TEST_CHECK(std::memcmp(utf8.c_str(), text, strlen(text) + 1) == 0);
+
+    char buffer[128];
+    TEST_CHECK(str.encode_utf8_into(buffer, sizeof(buffer)) == strlen(text));
+    TEST_CHECK(strcmp(buffer, text) == 0);
+
+    // A buffer that ends inside the emoji is cut before it
+    unsigned long emoji = strlen(text) - 5;
+    TEST_CHECK(str.encode_utf8_into(buffer, emoji + 3) == emoji);
+    TEST_CHECK(buffer[emoji] == '\0');
+    TEST_CHECK(str.encode_utf8_into(buffer, 0) == 0);
+}
+
+void test_search()
+{
+    std::string log("2024-01-01 INFO request served in 12ms; 2024-01-01 WARN slow request served in 950ms; "
+                    "2024-01-02 INFO request served in 9ms \xE2\x9C\x93");
+    TEST_CHECK(log.find("WARN") == 51);
+    TEST_CHECK(log.rfind("INFO") == 97);
+    TEST_CHECK(log.rfind("INFO", 96) == 11);
+    TEST_CHECK(log.find("served in 950ms; 2024-01-02 INFO request") == 69);
+    TEST_CHECK(log.rfind("2024-01-01 WARN slow request served in 950ms") == 40);
+    TEST_CHECK(log.find("served in 951ms; 2024-01-02 INFO request") == std::string::npos);
+    TEST_CHECK(log.find_first_of(";") == 38);
+    TEST_CHECK(log.find_last_of(";") == 84);
+    TEST_CHECK(static_cast<unsigned short>(log[log.find_first_of("\xE2\x9C\x93")]) == 0x2713);
+    TEST_CHECK(log.find_last_of("0123456789", 39) == 35);
+
+    std::string needle("request served in");
+    std::searcher searcher(needle);
+    unsigned long hits = 0;
+    for (unsigned long pos = searcher.find(log); pos != std::searcher::npos; pos = searcher.find(log, pos + 1))
+    {
+        ++hits;
+    }
+    TEST_CHECK(hits == 3);
+    std::string long_needle("slow request served in 950ms; 2024-01-02");
+    std::searcher long_searcher(long_needle);
+    TEST_CHECK(long_searcher.find(log) == 56 && long_searcher.find(log, 57) == std::searcher::npos);
+}
+
+void test_string_hash()
+{
+    std::hash<std::string> hasher;
+    std::string text("the quick brown fox jumps over the lazy dog, again and again and again, until the dog gets up "
+                     "and walks away from the fox, who is left to jump over nothing at all for the rest of the day");
+    TEST_CHECK(text.size() * sizeof(short) > std::detail::hash_crc_threshold);
+    const std::string copy(text);
+    TEST_CHECK(hasher(text) == hasher(copy) && hasher(text) == std::hash<std::string_view>()(text));
+
+    // Every length takes a different path through the short, block and tail reads; none may collide here
+    std::size_t hashes[180];
+    for (unsigned long length = 0; length < 180; length++)
+    {
+        hashes[length] = hasher(text.substr_view(0, length));
+        for (unsigned long other = 0; other < length; other++)
+        {
+            TEST_CHECK(hashes[other] != hashes[length]);
+        }
+    }
+    std::string flipped(text);
+    flipped[150] = static_cast<short>(flipped[150] ^ 1);
+    TEST_CHECK(hasher(flipped) != hasher(text));
+    TEST_CHECK(hasher(std::string("ab")) != hasher(std::string("ba")));
+}
+
+void test_hashed_string()
+{
+    std::hashed_string key("session");
+    TEST_CHECK(key.hash() == std::hash<std::string_view>()(key.view()));
+    TEST_CHECK(key == std::hashed_string("session") && !(key == std::hashed_string("sessions")));
+
+    std::flat_hash_map<std::hashed_string, int> map;
+    map.emplace(key, 1);
+    map.emplace(std::hashed_string("user"), 2);
+    const std::string user("user");
+    std::hashed_string_view probe(user.view());
+    TEST_CHECK(map.find(probe) != map.end() && map.find(probe)->second == 2);
+    TEST_CHECK(map.contains(user.view()) && !map.contains(std::hashed_string_view(key.view().substr(1))));
+    TEST_CHECK(map.at(key) == 1 && map.erase(probe) == 1 && map.size() == 1);
+    TEST_CHECK(key.release() == std::string("session") && key.empty() && key == std::hashed_string());
+}
+
+void test_string_builder()
+{
+    counting_resource resource;
+    std::pmr::string name("a name long enough for the heap", -1, &resource);
+    resource.allocations = 0;
+
+    std::basic_string_builder<std::pmr::polymorphic_allocator<short>> builder(&resource);
+    builder << "id=" << -1234567 << ' ' << name << name.view().substr(2, 4) << static_cast<short>(0x2713);
+    builder.append(0ull).append(18446744073709551615ull).append("\xC3\xA9");
+    TEST_CHECK(builder.piece_count() == 9 && resource.allocations == 0);
+    std::pmr::string built = builder.build();
+    TEST_CHECK(resource.allocations == 1 && built.capacity() == builder.length_bound());
+    std::string expected("id=-1234567 a name long enough for the heapname\xE2\x9C\x93" "018446744073709551615\xC3\xA9");
+    TEST_CHECK(built.size() == expected.size() && built.view() == expected.view());
+
+    std::string joined = std::concat("x=", 42, ", y=", -7, std::string("; a temporary string is fine here"), '!');
+    TEST_CHECK(joined == std::string("x=42, y=-7; a temporary string is fine here!"));
+    TEST_CHECK(joined.capacity() == joined.size());
+
+    // operator+ sizes its result once, and appends in place to a temporary on its left
+    std::pmr::string left("left ", -1, &resource);
+    resource.allocations = 0;
+    std::pmr::string sum = left + name;
+    TEST_CHECK(resource.allocations == 1 && sum.capacity() == sum.size());
+    std::pmr::string chain = left + name + "!" + left;
+    TEST_CHECK(chain == std::pmr::string("left a name long enough for the heap!left ", -1, &resource));
+}
+
+using namespace std::literals;
+
+// Transcoded by the compiler; the views below point into the template argument objects
+constexpr std::fixed_string accent_key = "caf\xC3\xA9 \xF0\x9F\x98\x80";
+static_assert(accent_key.size() == 7 && accent_key.capacity() == 10);
+static_assert(accent_key[3] == static_cast<short>(0xE9) && accent_key[5] == static_cast<short>(0xD83D));
+static_assert(std::fixed_string("\xFF\xFE").size() == 2, "ill-formed UTF-8 is read as Latin-1");
+constexpr std::string_view constant_keys[] = {"width"_fs, "height"_fs, "depth"_fs};
+static_assert(constant_keys[1].size() == 6 && constant_keys[1].starts_with("he"_fs));
+static_assert("width"_fs.data() == constant_keys[0].data(), "the literal names one object");
+
+constexpr std::inplace_string<8> make_constant()
+{
+    std::inplace_string<8> text("ab");
+    text += static_cast<short>('c');
+    text.append(std::string_view("de"_fs));
+    return text;
+}
+static_assert(make_constant() == "abcde"_fs && !make_constant().try_append(std::u8string_view("overflow")));
+
+void test_fixed_string()
+{
+    constexpr auto key = "session"_fs;
+    const std::string session("session");
+    TEST_CHECK(key == session && session == key && key.view() == session.view());
+    TEST_CHECK(std::hash<std::fixed_string<7>>()(key) == std::hash<std::string>()(session));
+    TEST_CHECK(key.find("ss"_fs) == 2 && key.rfind("s"_fs) == 3 && key.find(static_cast<short>('i')) == 4);
+    TEST_CHECK(key.contains("ion"_fs) && key.ends_with("ion"_fs));
+    TEST_CHECK(key.compare(session) == 0 && "abc"_fs < "abd"_fs && !(session < key));
+
+    // Constant keys find std::string keys without building a string
+    std::flat_hash_map<std::string, int> map;
+    map.emplace(std::string("width"), 1);
+    map.emplace(std::string("height"), 2);
+    TEST_CHECK(map.find(constant_keys[1]) != map.end() && map.find(constant_keys[1])->second == 2);
+    TEST_CHECK(map.contains("width"_fs) && !map.contains(constant_keys[2]));
+
+    std::inplace_string<4> small("h\xC3\xA9");
+    TEST_CHECK(small.size() == 2 && small[1] == static_cast<short>(0xE9) && small.c_str()[2] == 0);
+    TEST_CHECK(small.try_append(std::u8string_view("ll")) && small.size() == 4);
+    TEST_CHECK(!small.try_push_back(static_cast<short>('o')) && !small.try_append(std::u8string_view("\xC3\xA9")));
+    TEST_CHECK(small.size() == 4 && small.c_str()[4] == 0);
+    small.pop_back();
+    small.back() = static_cast<short>('y');
+    TEST_CHECK(small == std::string("h\xC3\xA9y"));
+    TEST_EXCEPTION(small.append("too long"), std::length_error);
+    TEST_CHECK(small.size() == 3);
+    // Three bytes of UTF-8 that make one unit fit where three Latin-1 units would not
+    std::inplace_string<1> one("\xE2\x9C\x93");
+    TEST_CHECK(one.size() == 1 && one[0] == static_cast<short>(0x2713));
+    TEST_CHECK(!one.try_append(std::u8string_view("\xE2\x9C")) && one.size() == 1);
+    one.clear();
+    one.pop_back();
+    TEST_CHECK(one.empty() && one.c_str()[0] == 0);
+    TEST_CHECK(one.empty() && one.try_append(std::u8string_view("\xFF")) && one[0] == static_cast<short>(0xFF));
+}
+
+TEST("small string", small_string, test_small_string);
+TEST("small string to heap", small_to_heap, test_small_to_heap);
+TEST("string view", string_view, test_string_view);
+TEST("utf8 conversion", utf8_conversion, test_utf8_conversion);
+TEST("utf8 encoding", utf8_encoding, test_utf8_encoding);
+TEST("search", search, test_search);
+TEST("string builder", string_builder, test_string_builder);
+TEST("string hash", string_hash, test_string_hash);
+TEST("hashed string", hashed_string, test_hashed_string);
+TEST("fixed string", fixed_string, test_fixed_string);
@@ -0,0 +1,91 @@
+#include <atomic.h>
+#include <task.h>
+#include "test.h"
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ < 13
+// GCC 12 lowers every coroutine body with a literal 0 for a null pointer
+#    pragma GCC diagnostic ignored "-Wzero-as-null-pointer-constant"
+#endif
+
+namespace
+{
+using fib_task = std::task<unsigned long, int>;
+
+fib_task fibonacci(std::task_scheduler &scheduler, unsigned int n)
+{
+    if (n < 2)
+    {
+        co_return n;
+    }
+    if (n < 12)
+    {
+        // Small enough to run inline: co_await starts the child on this thread
+        auto a = co_await fibonacci(scheduler, n - 1);
+        auto b = co_await fibonacci(scheduler, n - 2);
+        co_return a.value() + b.value();
+    }
+    fib_task left = scheduler.spawn(fibonacci(scheduler, n - 1));
+    auto right = co_await fibonacci(scheduler, n - 2);
+    auto first = co_await left;
+    co_return first.value() + right.value();
+}
+
+std::task<int, int> parse_digit(char c)
+{
+    if (c < '0' || c > '9')
+    {
+        co_return std::unexpected(static_cast<int>(c));
+    }
+    co_return c - '0';
+}
+
+std::task<int, int> sum_digits(const char *digits)
+{
+    int total = 0;
+    for (; *digits != 0; ++digits)
+    {
+        auto digit = co_await parse_digit(*digits);
+        if (!digit.has_value())
+        {
+            co_return std::unexpected(digit.error());
+        }
+        total += digit.value();
+    }
+    co_return total;
+}
+
+std::task<void, int> count_on_pool(std::task_scheduler &scheduler, std::atomic<int> &hops)
+{
+    for (int i = 0; i < 100; ++i)
+    {
+        co_await scheduler.schedule();
+        hops.fetch_add(1, std::memory_order_relaxed);
+    }
+    co_return {};
+}
+} // namespace
+
+void test_task()
+{
+    std::task_scheduler scheduler;
+    auto fib = scheduler.block_on(fibonacci(scheduler, 24));
+    TEST_CHECK(fib.has_value() && fib.value() == 46368);
+
+    auto sum = scheduler.block_on(sum_digits("12345"));
+    TEST_CHECK(sum.has_value() && sum.value() == 15);
+    auto failed = scheduler.block_on(sum_digits("12x45"));
+    TEST_CHECK(!failed.has_value() && failed.error() == 'x');
+}
+
+void test_task_schedule()
+{
+    std::task_scheduler scheduler(2);
+    std::atomic<int> hops(0);
+    auto first = scheduler.spawn(count_on_pool(scheduler, hops));
+    auto second = scheduler.spawn(count_on_pool(scheduler, hops));
+    TEST_CHECK(scheduler.block_on(std::move(first)).has_value() && scheduler.block_on(std::move(second)).has_value());
+    TEST_CHECK(hops.load() == 200);
+}
+
+TEST("task", task, test_task);
+TEST("task schedule", task_schedule, test_task_schedule);
@@ -0,0 +1,150 @@
+#include <algorithm.h>
+#include <cstring.h>
+#include <string.h>
+#include <string_view.h>
+#include <trace.h>
+#include <vector.h>
+#include "test.h"
+
+#if defined(STD_ENABLE_TRACE)
+#    include <thread.h>
+
+namespace
+{
+std::trace::event events[4 * std::trace::ring_size];
+
+bool named(const std::trace::event &recorded, const char *name)
+{
+    return std::u8string_view(recorded.name) == std::u8string_view(name);
+}
+
+//! The most recent event called name, or nullptr if there is none.
+const std::trace::event *latest(std::size_t count, const char *name)
+{
+    const std::trace::event *found = nullptr;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        if (named(events[i], name))
+        {
+            found = &events[i];
+        }
+    }
+    return found;
+}
+
+//! Collects what write_chrome_json() and dump() write.
+struct written_text
+{
+    char data[64 * 1024];
+    std::size_t size = 0;
+    int calls = 0;
+
+    static void append(void *context, const char *bytes, std::size_t count)
+    {
+        written_text *text = static_cast<written_text *>(context);
+        if (text->size + count < sizeof(text->data))
+        {
+            __builtin_memcpy(text->data + text->size, bytes, count);
+            text->size += count;
+        }
+        text->calls++;
+    }
+
+    bool contains(const char *part) const
+    {
+        return std::u8string_view(data, size).find(std::u8string_view(part)) != std::u8string_view::npos;
+    }
+};
+
+written_text printed;
+
+void print_line(const char *line)
+{
+    written_text::append(&printed, line, strlen(line));
+}
+
+#    if defined(STD_HAS_OS_THREADS)
+void trace_other_thread(void *)
+{
+    STD_TRACE_SCOPE_VALUE("other thread", 7);
+}
+#    endif
+} // namespace
+
+void test_trace()
+{
+    std::trace::reset();
+    TEST_CHECK(std::trace::collect(events, 4 * std::trace::ring_size) == 0);
+    {
+        STD_TRACE_SCOPE_VALUE("test scope", 42);
+        std::vector<int> numbers;
+        numbers.reserve(100);
+        for (int i = 0; i < 100; i++)
+        {
+            numbers.push_back(100 - i);
+        }
+        std::sort(numbers.begin(), numbers.end());
+        std::string text("some text that will not fit in the small buffer");
+        TEST_CHECK(text.find(std::string("small")) != std::string::npos);
+    }
+    std::size_t count = std::trace::collect(events, 4 * std::trace::ring_size);
+    const std::trace::event *scope = latest(count, "test scope");
+    const std::trace::event *growth = latest(count, "vector reallocate");
+    const std::trace::event *sorted = latest(count, "sort");
+    TEST_CHECK(scope != nullptr && scope->value == 42 && growth != nullptr && growth->value == 100 * sizeof(int));
+    TEST_CHECK(sorted != nullptr && sorted->value == 100 && latest(count, "utf8 to utf16") != nullptr);
+    TEST_CHECK(latest(count, "find") != nullptr && latest(count, "string reallocate") != nullptr);
+    // The outer scope spans everything inside it
+    TEST_CHECK(scope->start_ns <= growth->start_ns && scope->thread == sorted->thread &&
+               scope->start_ns + scope->duration_ns >= sorted->start_ns + sorted->duration_ns);
+
+    printed.size = 0;
+    std::trace::dump(&print_line);
+    TEST_CHECK(printed.contains("trace: thread ") && printed.contains(" test scope ") &&
+               printed.contains(" ns, value 42\n"));
+
+    written_text *json = new written_text;
+    std::trace::write_chrome_json(&written_text::append, json);
+    const char *start = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n{\"name\":";
+    TEST_CHECK(json->size > strlen(start) && std::memcmp(json->data, start, strlen(start)) == 0);
+    TEST_CHECK(json->contains("{\"name\":\"test scope\",\"cat\":\"std\",\"ph\":\"X\",\"pid\":1,\"tid\":") &&
+               json->contains(",\"args\":{\"value\":42}}") &&
+               std::memcmp(json->data + json->size - 4, "\n]}\n", 4) == 0);
+    delete json;
+
+    // A full ring keeps the newest events
+    std::trace::reset();
+    for (std::size_t i = 0; i < std::trace::ring_size + 10; i++)
+    {
+        STD_TRACE_SCOPE_VALUE("wrap", i);
+    }
+    count = std::trace::collect(events, 4 * std::trace::ring_size);
+    TEST_CHECK(count == std::trace::ring_size && events[0].value == 10 &&
+               events[count - 1].value == std::trace::ring_size + 9);
+
+#    if defined(STD_HAS_OS_THREADS)
+    std::trace::reset();
+    os::thread_join(os::thread_spawn(&trace_other_thread, nullptr));
+    {
+        STD_TRACE_SCOPE("this thread");
+    }
+    count = std::trace::collect(events, 4 * std::trace::ring_size);
+    const std::trace::event *other = latest(count, "other thread");
+    const std::trace::event *own = latest(count, "this thread");
+    TEST_CHECK(count == 2 && other != nullptr && other->value == 7 && own != nullptr && other->thread != own->thread);
+#    endif
+}
+#else
+void test_trace()
+{
+    // Compiled out, a scope does not even evaluate its value
+    int evaluated = 0;
+    {
+        STD_TRACE_SCOPE("nothing");
+        STD_TRACE_SCOPE_VALUE("nothing either", ++evaluated);
+    }
+    TEST_CHECK(evaluated == 0);
+}
+#endif
+
+TEST("trace", trace, test_trace);
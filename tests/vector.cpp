@@ -31,7 +31,32 @@ void test_at()
     TEST_CHECK(v.at(0) == 1);
     TEST_CHECK(v.at(1) == 2);
     TEST_CHECK(v.at(2) == 3);
-    TEST_EXCEPTION(v.at(3), std::out_of_range);
+    if constexpr (std::detail::bounds_check_throws)
+    {
+        TEST_EXCEPTION(v.at(3), std::out_of_range);
+    }
+}
+
+void test_unchecked_access()
+{
+    std::vector<int> v = {1, 2, 3};
+    static_assert(noexcept(v[0]), "operator[] is never checked");
+    static_assert(noexcept(v.at(0)) == !std::detail::bounds_check_throws);
+    TEST_CHECK(v[2] == 3 && v.front() == 1 && v.back() == 3);
+
+    auto found = v.try_at(1);
+    TEST_CHECK(found.has_value() && *found.value() == 2);
+    auto missing = v.try_at(3);
+    TEST_CHECK(!missing && missing.has_error());
+    const std::vector<int> &view = v;
+    TEST_CHECK(view.try_at(0).has_value() && !view.try_at(100).has_value());
+
+    std::vector<int> empty;
+    if constexpr (std::detail::bounds_check_throws)
+    {
+        TEST_EXCEPTION(empty.front(), std::out_of_range);
+        TEST_EXCEPTION(empty.back(), std::out_of_range);
+    }
 }
 
 void test_operator_square_bracket()
@@ -85,6 +110,10 @@ void test_max_size(void)
 {
     std::vector<int> v;
     TEST_CHECK(v.max_size() > 0);
+    std::allocator<int> alloc;
+    TEST_CHECK(alloc.max_size() == static_cast<std::size_t>(-1) / sizeof(int));
+    // The byte count would wrap around to a small request
+    TEST_EXCEPTION((void)alloc.allocate(alloc.max_size() + 1), std::length_error);
 }
 
 void test_resize(void)
@@ -176,11 +205,215 @@ void test_emplace_back(void)
     TEST_CHECK(v[0] == "hello");
 }
 
+struct counted
+{
+    static inline int constructed = 0;
+    static inline int destroyed = 0;
+    int value;
+    counted(int v)
+        : value(v)
+    {
+        ++constructed;
+    }
+    counted(const counted &other)
+        : value(other.value)
+    {
+        ++constructed;
+    }
+    counted(counted &&other) noexcept
+        : value(other.value)
+    {
+        ++constructed;
+    }
+    counted &operator=(const counted &) = default;
+    ~counted()
+    {
+        ++destroyed;
+    }
+};
+
+void test_relocation(void)
+{
+    {
+        std::vector<counted> v;
+        for (int i = 0; i < 100; i++)
+        {
+            v.emplace_back(i);
+        }
+        TEST_CHECK(counted::constructed - counted::destroyed == 100);
+        v.erase(v.begin() + 10);
+        v.insert(v.begin(), counted(-1));
+        TEST_CHECK(v[0].value == -1);
+        TEST_CHECK(v[11].value == 11);
+        TEST_CHECK(counted::constructed - counted::destroyed == 100);
+    }
+    TEST_CHECK(counted::constructed == counted::destroyed);
+}
+
+void test_memory_resource(void)
+{
+    alignas(16) static unsigned char arena[4096];
+    std::pmr::monotonic_buffer_resource resource(arena, sizeof(arena));
+    {
+        std::pmr::vector<int> v(&resource);
+        for (int i = 0; i < 100; i++)
+        {
+            v.push_back(i);
+        }
+        TEST_CHECK(v[99] == 99);
+        const unsigned char *first = reinterpret_cast<const unsigned char *>(v.data());
+        TEST_CHECK(first >= arena && first < arena + sizeof(arena));
+        std::pmr::vector<int> copy(v, &resource);
+        TEST_CHECK(copy[50] == 50);
+        TEST_CHECK(copy.get_allocator().resource() == &resource);
+    }
+    TEST_CHECK(sizeof(std::vector<int>) == 3 * sizeof(void *));
+}
+
+void test_range_erase(void)
+{
+    std::vector<int> v = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    TEST_CHECK(*v.erase(v.begin() + 2, v.begin() + 5) == 5 && v.size() == 7 && v[1] == 1 && v[2] == 5);
+    TEST_CHECK(v.erase(v.begin() + 3, v.begin() + 3) == v.begin() + 3 && v.size() == 7);
+    TEST_CHECK(std::erase_if(v, [](int x) { return x % 2 == 1; }) == 4);
+    TEST_CHECK(v.size() == 3 && v[0] == 0 && v[1] == 6 && v[2] == 8);
+    TEST_CHECK(std::erase(v, 6) == 1 && std::erase(v, 6) == 0 && v.size() == 2 && v[1] == 8);
+
+    std::vector<std::string> words = {"keep", "drop", "keep too", "drop", "drop", "last"};
+    TEST_CHECK(std::erase(words, std::string("drop")) == 3);
+    TEST_CHECK(words.size() == 3 && words[1] == std::string("keep too") && words[2] == std::string("last"));
+    words.erase(words.begin(), words.end());
+    TEST_CHECK(words.empty());
+}
+
+void test_bulk_insert(void)
+{
+    std::vector<int> v = {1, 2};
+    std::vector<int> more = {3, 4, 5, 6, 7, 8, 9, 10, 11};
+    v.append_range(more);
+    TEST_CHECK(v.size() == 11 && v[2] == 3 && v[10] == 11);
+    std::vector<int> front = {-1, 0};
+    TEST_CHECK(*v.insert_range(v.begin(), front) == -1 && v.size() == 13 && v[1] == 0 && v[2] == 1);
+
+    v.assign(3, 7);
+    TEST_CHECK(v.size() == 3 && v[0] == 7 && v[2] == 7);
+    v.assign({4, 5});
+    TEST_CHECK(v.size() == 2 && v[1] == 5);
+    v.assign_range(more);
+    TEST_CHECK(v.size() == more.size() && v[8] == 11);
+    v.assign(40, v[0]);
+    TEST_CHECK(v.size() == 40 && v.capacity() == 40 && v[39] == 3);
+
+    std::vector<std::string> names = {"a"};
+    std::vector<std::string> extra = {"b", "c"};
+    names.append_range(extra);
+    names.insert_range(names.begin() + 1, extra);
+    TEST_CHECK(names.size() == 5 && names[1] == std::string("b") && names[3] == std::string("b"));
+}
+
+void test_swap_and_pop(void)
+{
+    std::vector<int> v = {10, 11, 12, 13};
+    v.swap_and_pop(1);
+    TEST_CHECK(v.size() == 3 && v[1] == 13 && v[2] == 12);
+    TEST_CHECK(v.swap_and_pop(v.end() - 1) == v.end() && v.size() == 2);
+
+    std::vector<std::string> names = {"first", "second", "third"};
+    TEST_CHECK(*names.swap_and_pop(names.begin()) == std::string("third") && names.size() == 2);
+}
+
+void test_resize_for_overwrite(void)
+{
+    std::vector<unsigned char> bytes;
+    bytes.resize_for_overwrite(64);
+    TEST_CHECK(bytes.size() == 64 && bytes.capacity() >= 64);
+    for (unsigned long i = 0; i < bytes.size(); i++)
+    {
+        bytes.data()[i] = static_cast<unsigned char>(i);
+    }
+    bytes.resize_for_overwrite(16);
+    TEST_CHECK(bytes.size() == 16 && bytes[15] == 15);
+
+    std::vector<std::string> names;
+    names.resize_for_overwrite(3);
+    TEST_CHECK(names.size() == 3 && names[2].empty());
+}
+
+void test_growth_policy(void)
+{
+    std::vector<int, std::allocator<int>, std::fixed_growth<100>> fixed;
+    fixed.push_back(1);
+    TEST_CHECK(fixed.capacity() == 100);
+    for (int i = 1; i < 150; i++)
+    {
+        fixed.push_back(i);
+    }
+    TEST_CHECK(fixed.size() == 150 && fixed.capacity() == 200 && fixed[149] == 149);
+    fixed.reserve(250);
+    TEST_CHECK(fixed.capacity() == 300);
+    fixed.reserve_exact(301);
+    TEST_CHECK(fixed.capacity() == 301 && fixed[0] == 1);
+
+    std::vector<int, std::allocator<int>, std::one_and_a_half_growth> slow;
+    slow.reserve_exact(10);
+    slow.resize(10);
+    slow.push_back(10);
+    TEST_CHECK(slow.capacity() == 15 && slow.size() == 11);
+    // From a capacity below the denominator growth still makes progress instead of saturating
+    TEST_CHECK(std::one_and_a_half_growth::grow(1, 2, sizeof(int)) == 2);
+    TEST_CHECK(std::page_growth<>::grow(1, 2, sizeof(int)) == 2);
+    std::vector<int, std::allocator<int>, std::one_and_a_half_growth> single;
+    single.reserve_exact(1);
+    single.push_back(1);
+    single.push_back(2);
+    single.push_back(3);
+    TEST_CHECK(single.capacity() == 3 && single.size() == 3 && single[2] == 3);
+
+    // Blocks of a page or more come in whole pages; smaller ones are left alone
+    std::vector<int, std::allocator<int>, std::page_growth<>> paged;
+    paged.reserve(10);
+    TEST_CHECK(paged.capacity() == 10);
+    paged.reserve(1025);
+    TEST_CHECK(paged.capacity() == 2048);
+    TEST_CHECK(std::page_growth<>::grow(1024, 1025, sizeof(int)) == 2048);
+}
+
+void test_growth_keeps_elements(void)
+{
+    // Growth may extend the block in place or realloc it; the elements must come through either way
+    std::vector<int> numbers;
+    std::vector<std::string> names;
+    for (int i = 0; i < 5000; i++)
+    {
+        numbers.push_back(i);
+        names.push_back(i % 7 == 0 ? std::string("a name long enough to live on the heap") : std::string("short"));
+    }
+    bool intact = true;
+    for (int i = 0; i < 5000; i++)
+    {
+        intact = intact && numbers[static_cast<unsigned long>(i)] == i;
+    }
+    TEST_CHECK(intact && names[4998] == std::string("a name long enough to live on the heap"));
+    numbers.insert(numbers.begin(), -1);
+    TEST_CHECK(numbers.size() == 5001 && numbers[0] == -1 && numbers[5000] == 4999);
+
+    std::string text;
+    for (int i = 0; i < 1000; i++)
+    {
+        text.append("abcd");
+    }
+    TEST_CHECK(text.size() == 4000 && text.capacity() >= 4000 && text.end_with("abcd"));
+    std::size_t exact = text.capacity() + 1;
+    text.reserve_exact(exact);
+    TEST_CHECK(text.capacity() == exact && text.size() == 4000 && text.start_with("abcdabcd"));
+}
+
 TEST("default constructor", default_constructor, test_default_constructor);
 TEST("constructor with size", constructor_with_size, test_constructor_with_size);
 TEST("constructor with size and value", constructor_with_size_and_value, test_constructor_with_size_and_value);
 TEST("at", at, test_at);
 TEST("operator square bracket", operator_square_bracket, test_operator_square_bracket);
+TEST("unchecked access", unchecked_access, test_unchecked_access);
 TEST("front", front, test_front);
 TEST("back", back, test_back);
 TEST("data", data, test_data);
@@ -193,7 +426,15 @@ TEST("capacity", capacity, test_capacity);
 TEST("clear", clear, test_clear);
 TEST("insert", insert, test_insert);
 TEST("erase", erase, test_erase);
+TEST("range erase", range_erase, test_range_erase);
+TEST("bulk insert", bulk_insert, test_bulk_insert);
+TEST("swap and pop", swap_and_pop, test_swap_and_pop);
+TEST("resize for overwrite", resize_for_overwrite, test_resize_for_overwrite);
+TEST("growth policy", growth_policy, test_growth_policy);
+TEST("growth keeps elements", growth_keeps_elements, test_growth_keeps_elements);
 TEST("push back", push_back, test_push_back);
 TEST("pop back", pop_back, test_pop_back);
 TEST("swap", swap, test_swap);
-TEST("emplace back", emplace_back, test_emplace_back)
+TEST("emplace back", emplace_back, test_emplace_back);
+TEST("relocation", relocation, test_relocation);
+TEST("memory resource", memory_resource, test_memory_resource);